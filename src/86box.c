@@ -77,6 +77,7 @@
 #include <86box/fdd_audio.h>
 #include <86box/fdc_ext.h>
 #include <86box/hdd.h>
+#include <86box/hdd_aio.h>
 #include <86box/hdd_audio.h>
 #include <86box/hdc.h>
 #include <86box/hdc_ide.h>
@@ -90,16 +91,20 @@
 #include <86box/scsi_disk.h>
 #include <86box/thread.h>
 #include <86box/network.h>
+#include <86box/net_switch_hub.h>
 #include <86box/sound.h>
 #include <86box/midi.h>
 #include <86box/video.h>
 #include <86box/ui.h>
 #include <86box/path.h>
+#include <86box/snapshot.h>
 #include <86box/plat.h>
 #include <86box/plat_dir.h>
 #include <86box/version.h>
 #include <86box/gdbstub.h>
 #include <86box/machine_status.h>
+#include <86box/bench.h>
+#include <86box/fbshm.h>
 #include <86box/acpi.h>
 #include <86box/nv/vid_nv_rivatimer.h>
 #include <86box/vfio.h>
@@ -192,9 +197,16 @@ int      confirm_reset                          = 1;              /* (G) enable
 int      confirm_exit                           = 1;              /* (G) enable exit confirmation */
 int      confirm_save                           = 1;              /* (G) enable save confirmation */
 int      chd_precache_level                     = 0;              /* (G) CHD precache level */
+int      chd_cache_hunks                        = 32;             /* (G) CHD decompressed hunks to cache */
+int      hdd_image_cache_size                   = 32;             /* (G) hard disk block cache size in MB */
 int      enable_discord                         = 0;              /* (C) enable Discord integration */
 int      pit_mode                               = -1;             /* (C) force setting PIT mode */
+int      timer_sched                            = 0;              /* (C) timer scheduler backend */
+int      dynarec_cache                          = 0;              /* (C) persistent dynarec warm-start cache */
+int      dynarec_ir_passes                      = -1;             /* (C) mask of dynarec IR optimization passes */
+int      dynarec_compile_budget                 = 32;             /* (C) dynarec blocks recompiled per ms, 0 = unlimited */
 int      fm_driver                              = 0;              /* (C) select FM sound driver */
+int      fm_thread                              = 0;              /* (C) synthesize FM and EMU8000 on their own threads */
 int      open_dir_usr_path                      = 0;              /* (G) default file open dialog directory
                                                                          of usr_path */
 int      video_fullscreen_scale_maximized       = 0;              /* (C) Whether fullscreen scaling settings
@@ -223,6 +235,7 @@ int      portable_mode = 0;                                       /* We are runn
                                                                      (global dirs = exe path) */
 int      global_cfg_overridden = 0;                               /* Global config file was overriden on command line */
 
+int      svga_render_threads = 0;                                 /* (C) SVGA deferred rendering threads */
 int      monitor_edid = 0;                                        /* (C) Which EDID to use. 0=default, 1=custom. */
 char     monitor_edid_path[1024] = { 0 };                         /* (C) Path to custom EDID */
 
@@ -318,8 +331,19 @@ struct accelKey def_acc_keys[NUM_ACCELS] = {
         .name="toggle_osd",
         .desc="Toggle on-screen display",
         .seq="Ctrl+Alt+O"
-    }
-,
+    },
+#ifdef USE_SNAPSHOT
+    {
+        .name="save_state",
+        .desc="Save state",
+        .seq=""
+    },
+    {
+        .name="load_state",
+        .desc="Load state",
+        .seq=""
+    },
+#endif
     {
         .name="exit",
         .desc="Exit",
@@ -749,6 +773,8 @@ pc_show_usage(void)
             "Valid options are:\n\n"
             "-? or --help\t\t\t- show this information\n"
             "-A or --assetpath path\t\t- set 'path' to be asset path\n"
+            "-B or --bench secs\t\t- run for 'secs' emulated seconds, print\n"
+            "\t\t\t\t   statistics as JSON and exit\n"
 #ifdef SHOW_EXTRA_PARAMS
             "-C or --config path\t\t- set 'path' to be config file\n"
 #endif
@@ -761,6 +787,9 @@ pc_show_usage(void)
             "-F or --fullscreen\t\t- start in fullscreen mode\n"
             "-G or --lang langid\t\t- start with specified language\n"
             "\t\t\t\t   (e.g. en-US, or system)\n"
+            "-K or --netbench rate[,size]\t- offer the network cards 'rate' frames\n"
+            "\t\t\t\t   per second of 'size' bytes, instead\n"
+            "\t\t\t\t   of connecting them\n"
 #ifdef SHOW_EXTRA_PARAMS
 #ifdef _WIN32
             "-H or --hwnd id,hwnd\t\t- sends back the main dialog's hwnd\n"
@@ -771,9 +800,17 @@ pc_show_usage(void)
             "-J or --instrument name\t- set 'name' to be the profiling instrument\n"
 #endif
             "-L or --logfile path\t\t- set 'path' to be the logfile\n"
+#ifdef USE_SNAPSHOT
+            "--loadstate path\t\t- load the save state in 'path' at startup\n"
+#endif
             "-M or --missing\t\t- dump missing machines and video cards\n"
             "-N or --noconfirm\t\t- do not ask for confirmation on quit\n"
             "-P or --vmpath path\t\t- set 'path' to be root for vm\n"
+#ifdef __linux__
+            "-Q or --netswitchd [secret]\t- act as the local switch for the other\n"
+            "\t\t\t\t   instances using 'secret', and exit\n"
+            "\t\t\t\t   when interrupted\n"
+#endif
             "-O or --global path\t\t- set 'path' to be global config file\n"
             "-R or --rompath path\t\t- set 'path' to be ROM path\n"
 #ifndef USE_SDL_UI
@@ -782,6 +819,10 @@ pc_show_usage(void)
 #ifdef SHOW_EXTRA_PARAMS
             "-T or --testmode\t\t- test mode: execute the test mode entry\n"
             "\t\t\t\t   point on init/hard reset\n"
+#endif
+#ifndef _WIN32
+            "-U or --fbshm name\t\t- export the screen as shared memory\n"
+            "\t\t\t\t   objects named /name-<monitor>\n"
 #endif
             "-V or --vmname name\t\t- overrides the name of the running VM\n"
 #ifdef _WIN32
@@ -912,6 +953,32 @@ usage:
             else
                 memcpy(vmm_path, vp, strlen(vp) + 1);
 #endif
+        } else if (!strcasecmp(argv[c], "--bench") || !strcasecmp(argv[c], "-B")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            bench_seconds = atoi(argv[++c]);
+            if (bench_seconds <= 0)
+                goto usage;
+        } else if (!strcasecmp(argv[c], "--netbench") || !strcasecmp(argv[c], "-K")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            net_bench_size = 64;
+            if ((sscanf(argv[++c], "%i,%i", &net_bench_rate, &net_bench_size) < 1) || (net_bench_rate <= 0))
+                goto usage;
+#ifdef __linux__
+        } else if (!strcasecmp(argv[c], "--netswitchd") || !strcasecmp(argv[c], "-Q")) {
+            if (((c + 1) < argc) && (argv[c + 1][0] != '-'))
+                net_switch_hub_secret = argv[++c];
+            else
+                net_switch_hub_secret = "";
+#endif
+        } else if (!strcasecmp(argv[c], "--fbshm") || !strcasecmp(argv[c], "-U")) {
+            if (((c + 1) == argc) || (argv[c + 1][0] == '\0') || strchr(argv[c + 1], '/'))
+                goto usage;
+
+            snprintf(fbshm_name, sizeof(fbshm_name), "%s", argv[++c]);
         } else if (!strcasecmp(argv[c], "--fullscreen") || !strcasecmp(argv[c], "-F")) {
             start_in_fullscreen = 1;
         } else if (!strcasecmp(argv[c], "--logfile") || !strcasecmp(argv[c], "-L")) {
@@ -972,6 +1039,14 @@ usage:
             pclog("Drive %c: %s\n", drive + 0x41, fn[(int) drive]);
             free(temp2);
             temp2 = NULL;
+#ifdef USE_SNAPSHOT
+        } else if (!strcasecmp(argv[c], "--loadstate")) {
+            if ((c + 1) == argc)
+                goto usage;
+
+            /* Carried out by the first pc_run(), once the machine is up. */
+            snapshot_request(SNAPSHOT_LOAD, argv[++c]);
+#endif
         } else if (!strcasecmp(argv[c], "--vmname") || !strcasecmp(argv[c], "-V")) {
             if ((c + 1) == argc)
                 goto usage;
@@ -1292,6 +1367,12 @@ usage:
     pclog("# Emulator path: %s\n", exe_path);
     pclog("# Global configuration file: %s\n", global_cfg_path);
 
+    /* Only switch frames between the other instances, if asked to. */
+    if (net_switch_hub_secret != NULL) {
+        net_switch_hub_run(net_switch_hub_secret);
+        return 0;
+    }
+
     /* Initialize the keyboard accelerator list with default values */
     for (int x = 0; x < NUM_ACCELS; x++) {
         strcpy(acc_keys[x].name, def_acc_keys[x].name);
@@ -1361,6 +1442,15 @@ usage:
 
         /* Load the configuration file. */
         config_load();
+
+        /* Keep benchmark runs independent of the host clock. */
+        if (bench_seconds) {
+            time_sync = TIME_SYNC_DISABLED;
+#ifdef USE_NEW_DYNAREC
+            /* Also count the dynarec's inline memory lookup hits. */
+            codegen_mem_stats = 1;
+#endif
+        }
         /* To save the global key binds. */
         config_save_global();
 
@@ -1688,6 +1778,12 @@ pc_reset_hard_close(void)
 {
     ui_sb_set_ready(0);
 
+#ifdef USE_NEW_DYNAREC
+    /* The CPU may change before the cache is next used. */
+    if (dynarec_cache)
+        codegen_cache_close();
+#endif
+
     /* Close all the memory mappings. */
     mem_close();
 
@@ -1933,6 +2029,11 @@ pc_close(UNUSED(thread_t *ptr))
 
     nvr_save();
 
+#ifdef USE_NEW_DYNAREC
+    if (dynarec_cache)
+        codegen_cache_close();
+#endif
+
     plat_mouse_capture(0);
 
     /* Close all the memory mappings. */
@@ -1954,6 +2055,8 @@ pc_close(UNUSED(thread_t *ptr))
 
     video_close();
 
+    fbshm_close();
+
     sound_close();
 
     device_close_all();
@@ -1978,6 +2081,10 @@ pc_close(UNUSED(thread_t *ptr))
 
     scsi_disk_close();
 
+    hdd_aio_close();
+
+    hdd_image_cache_close();
+
     gdbstub_close();
 
 }
@@ -2009,6 +2116,9 @@ pc_run(void)
         pc_reset_hard_init();
     }
 
+    /* Save or load the machine state, between two blocks of code. */
+    snapshot_process();
+
     /* Update the guest-CPU independent timer for devices with independent clock speed */
     rivatimer_update_all();
 
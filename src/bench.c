@@ -0,0 +1,200 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Benchmark runner.
+ *
+ *          Runs the configured machine for a fixed amount of emulated
+ *          time as fast as the host allows, and reports how long that
+ *          took along with the CPU, dynarec and timer statistics, so
+ *          that throughput can be compared between builds.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/version.h>
+#include "cpu.h"
+#ifdef USE_DYNAREC
+#    include "codegen_public.h"
+#endif
+#include <86box/machine.h>
+#include <86box/hdd.h>
+#include <86box/mem.h>
+#include <86box/plat.h>
+#include <86box/timer.h>
+#include <86box/network.h>
+#include <86box/sound.h>
+#include <86box/bench.h>
+#ifdef USE_NEW_DYNAREC
+#    include "codegen.h"
+#    include "codegen_cache.h"
+#endif
+
+int bench_seconds = 0; /* (O) run the benchmark for this many emulated seconds */
+
+/* Print a string as a JSON string literal. */
+static void
+bench_print_string(const char *key, const char *str)
+{
+    printf("  \"%s\": \"", key);
+    for (; *str != '\0'; str++) {
+        if ((*str == '"') || (*str == '\\'))
+            printf("\\%c", *str);
+        else if ((uint8_t) *str < 0x20)
+            printf("\\u%04x", (uint8_t) *str);
+        else
+            putchar(*str);
+    }
+    printf("\",\n");
+}
+
+void
+bench_run(void)
+{
+    const int         frames = bench_seconds * (force_10ms ? 100 : 1000);
+    uint64_t          ins;
+    uint64_t          callbacks;
+    uint64_t          disk_hits;
+    uint64_t          disk_misses;
+#ifdef ENABLE_MEM_LOG
+    uint64_t          page_walks;
+    uint64_t          evictions;
+    uint64_t          cmp_hits;
+    uint64_t          cmp_misses;
+#endif
+    net_bench_stats_t net_start;
+    net_bench_stats_t net;
+    uint32_t          start_ms;
+    uint32_t          wall_ms;
+    int               frame;
+#ifdef USE_DYNAREC
+    uint64_t          marked;
+    uint64_t          compiled;
+    uint64_t          hits;
+    uint64_t          misses;
+#endif
+#ifdef USE_NEW_DYNAREC
+    uint64_t          succ_hits;
+    uint64_t          succ_misses;
+    uint64_t          deferred;
+    uint64_t          mem_hits;
+    uint64_t          mem_misses;
+#endif
+
+    /* Only count what happens during the run. */
+    ins         = cpu_ins_count;
+    callbacks   = timer_callbacks;
+    disk_hits   = hdd_image_cache_hits;
+    disk_misses = hdd_image_cache_misses;
+    net_bench_get_stats(&net_start);
+#ifdef ENABLE_MEM_LOG
+    page_walks = mem_page_walks;
+    evictions  = mem_tlb_evictions;
+    cmp_hits   = mem_cmp_tlb_hits;
+    cmp_misses = mem_cmp_tlb_misses;
+#endif
+#ifdef USE_DYNAREC
+    marked   = codegen_blocks_marked;
+    compiled = codegen_blocks_compiled;
+    hits     = codegen_block_hits;
+    misses   = codegen_block_misses;
+#endif
+#ifdef USE_NEW_DYNAREC
+    succ_hits   = codegen_succ_cache_hits;
+    succ_misses = codegen_succ_cache_misses;
+    deferred    = codegen_blocks_deferred;
+    mem_hits    = codegen_mem_hits;
+    mem_misses  = codegen_mem_misses;
+#endif
+
+    start_ms = plat_get_ticks();
+    for (frame = 0; (frame < frames) && !is_quit && cpu_thread_run; frame++)
+        pc_run();
+    wall_ms = plat_get_ticks() - start_ms;
+    if (wall_ms == 0)
+        wall_ms = 1;
+
+    ins       = cpu_ins_count - ins;
+    callbacks = timer_callbacks - callbacks;
+    net_bench_get_stats(&net);
+
+    printf("{\n");
+    bench_print_string("version", EMU_VERSION_FULL);
+    bench_print_string("machine", machine_get_internal_name());
+    bench_print_string("cpu", cpu_s->name);
+    printf("  \"dynarec\": %i,\n", cpu_use_dynarec);
+    printf("  \"emulated_ms\": %i,\n", frame * (force_10ms ? 10 : 1));
+    printf("  \"wall_ms\": %" PRIu32 ",\n", wall_ms);
+    printf("  \"speed_percent\": %.1f,\n", (frame * (force_10ms ? 10.0 : 1.0) * 100.0) / wall_ms);
+    printf("  \"instructions\": %" PRIu64 ",\n", ins);
+    printf("  \"mips\": %.3f,\n", ins / (wall_ms * 1000.0));
+#ifdef ENABLE_MEM_LOG
+    printf("  \"page_walks\": %" PRIu64 ",\n", mem_page_walks - page_walks);
+    printf("  \"tlb_evictions\": %" PRIu64 ",\n", mem_tlb_evictions - evictions);
+    printf("  \"compare_tlb_hits\": %" PRIu64 ",\n", mem_cmp_tlb_hits - cmp_hits);
+    printf("  \"compare_tlb_misses\": %" PRIu64 ",\n", mem_cmp_tlb_misses - cmp_misses);
+#endif
+#ifdef USE_DYNAREC
+    printf("  \"blocks_marked\": %" PRIu64 ",\n", codegen_blocks_marked - marked);
+    printf("  \"blocks_compiled\": %" PRIu64 ",\n", codegen_blocks_compiled - compiled);
+    printf("  \"block_hits\": %" PRIu64 ",\n", codegen_block_hits - hits);
+    printf("  \"block_misses\": %" PRIu64 ",\n", codegen_block_misses - misses);
+#endif
+#ifdef USE_NEW_DYNAREC
+    printf("  \"successor_cache_hits\": %" PRIu64 ",\n", codegen_succ_cache_hits - succ_hits);
+    printf("  \"successor_cache_misses\": %" PRIu64 ",\n", codegen_succ_cache_misses - succ_misses);
+    printf("  \"blocks_deferred\": %" PRIu64 ",\n", codegen_blocks_deferred - deferred);
+    mem_hits   = codegen_mem_hits - mem_hits;
+    mem_misses = codegen_mem_misses - mem_misses;
+    printf("  \"mem_lookup_hits\": %" PRIu64 ",\n", mem_hits);
+    printf("  \"mem_lookup_misses\": %" PRIu64 ",\n", mem_misses);
+    printf("  \"mem_lookup_hit_percent\": %.2f,\n", (mem_hits + mem_misses) ? ((mem_hits * 100.0) / (mem_hits + mem_misses)) : 0.0);
+    printf("  \"warm_cache_hits\": %i,\n", codegen_cache_hits);
+    printf("  \"warm_cache_misses\": %i,\n", codegen_cache_misses);
+#endif
+    printf("  \"disk_cache_hits\": %" PRIu64 ",\n", hdd_image_cache_hits - disk_hits);
+    printf("  \"disk_cache_misses\": %" PRIu64 ",\n", hdd_image_cache_misses - disk_misses);
+    if (net_bench_rate > 0) {
+        net.rx_offered -= net_start.rx_offered;
+        net.rx_skipped -= net_start.rx_skipped;
+        net.rx_delivered -= net_start.rx_delivered;
+        net.rx_dropped -= net_start.rx_dropped;
+        net.tx_packets -= net_start.tx_packets;
+        net.tx_dropped -= net_start.tx_dropped;
+        net.latency_sum_us -= net_start.latency_sum_us;
+        printf("  \"net_rx_offered\": %" PRIu64 ",\n", net.rx_offered);
+        printf("  \"net_rx_skipped\": %" PRIu64 ",\n", net.rx_skipped);
+        printf("  \"net_rx_delivered\": %" PRIu64 ",\n", net.rx_delivered);
+        printf("  \"net_rx_dropped\": %" PRIu64 ",\n", net.rx_dropped);
+        printf("  \"net_rx_pps\": %.1f,\n", (net.rx_delivered * 1000.0) / wall_ms);
+        printf("  \"net_rx_latency_avg_us\": %.1f,\n", net.rx_delivered ? ((double) net.latency_sum_us / net.rx_delivered) : 0.0);
+        printf("  \"net_rx_latency_max_us\": %" PRIu64 ",\n", net.latency_max_us);
+        printf("  \"net_tx_packets\": %" PRIu64 ",\n", net.tx_packets);
+        printf("  \"net_tx_pps\": %.1f,\n", (net.tx_packets * 1000.0) / wall_ms);
+        printf("  \"net_tx_dropped\": %" PRIu64 ",\n", net.tx_dropped);
+    }
+    printf("  \"sound_mix_4_sources_ns\": %.0f,\n", sound_mix_bench(4));
+    printf("  \"sound_mix_6_sources_ns\": %.0f,\n", sound_mix_bench(6));
+    for (int c = 16; c <= 256; c <<= 2) {
+        printf("  \"timer_list_%i_ns\": %.1f,\n", c, timer_sched_bench(TIMER_SCHED_LIST, c));
+        printf("  \"timer_heap_%i_ns\": %.1f,\n", c, timer_sched_bench(TIMER_SCHED_HEAP, c));
+    }
+    printf("  \"timer_callbacks\": %" PRIu64 "\n", callbacks);
+    printf("}\n");
+    fflush(stdout);
+}
@@ -25,9 +25,7 @@
 #define __STDC_FORMAT_MACROS
 #include <ctype.h>
 #include <inttypes.h>
-#ifdef ENABLE_IMAGE_LOG
-#    include <stdarg.h>
-#endif
+#include <stdarg.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -46,11 +44,13 @@
 #include <libchdr/bitstream.h>
 #include <libchdr/macros.h>
 
+#define HAVE_STDARG_H
 #include <86box/86box.h>
 #include <86box/log.h>
 #include <86box/nvr.h>
 #include <86box/path.h>
 #include <86box/plat.h>
+#include <86box/thread.h>
 #include <86box/bswap.h>
 #include <86box/cdrom.h>
 #include <86box/cdrom_image.h>
@@ -97,6 +97,18 @@ typedef struct TrackEntry_CHD
     uint64_t chd_start; // in bytes.
 } TrackEntry_CHD;
 
+/* Hunks decompressed ahead of a read that missed the cache, or of one that
+   used a hunk decompressed ahead. */
+#define CHD_READ_AHEAD 2
+
+typedef struct chd_hunk_t {
+    int64_t  hunk;       /* -1 if the slot is empty. */
+    uint32_t last_used;
+    int      loading;    /* Being decompressed, not to be touched. */
+    int      read_ahead; /* Decompressed ahead, not used yet. */
+    uint8_t *data;
+} chd_hunk_t;
+
 typedef struct chd_image_t {
     cdrom_t *dev;
     chd_file *img_file;
@@ -108,7 +120,22 @@ typedef struct chd_image_t {
     uint8_t* hunk_bytes;
     uint64_t hunk_size;
 
-    int64_t cur_hunk;
+    /* Decompressed hunk cache, the file itself is only accessed with
+       file_mutex held, the slots with cache_mutex held. */
+    chd_hunk_t *hunks;
+    int         nr_hunks;
+    uint32_t    hunk_clock;
+    mutex_t    *cache_mutex;
+    mutex_t    *file_mutex;
+    thread_t   *ra_thread;
+    event_t    *ra_event;
+    event_t    *ra_done_event;
+    volatile int ra_running;
+    int64_t     ra_hunk;
+    int         ra_count;
+    uint64_t    hits;
+    uint64_t    misses;
+    uint64_t    ra_hits;
 
     uint64_t sectors_per_hunk;
 
@@ -125,6 +152,241 @@ typedef struct chd_image_t {
 
 typedef struct chd_image_t chd_image_t;
 
+#ifdef ENABLE_CHD_LOG
+int chd_do_log = ENABLE_CHD_LOG;
+
+static void
+chd_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (chd_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define chd_log(fmt, ...)
+#endif
+
+/* Called with the cache mutex held. */
+static int
+chd_image_find_hunk(const chd_image_t *img, int64_t hunk)
+{
+    for (int i = 0; i < img->nr_hunks; i++) {
+        if (img->hunks[i].hunk == hunk)
+            return i;
+    }
+
+    return -1;
+}
+
+/* Claims the least recently used slot that is not being loaded, and marks
+   it as loading the given hunk. Called with the cache mutex held. */
+static int
+chd_image_claim_hunk(chd_image_t *img, int64_t hunk, int read_ahead)
+{
+    chd_hunk_t *slot;
+    int         victim = -1;
+
+    for (int i = 0; i < img->nr_hunks; i++) {
+        slot = &img->hunks[i];
+
+        if (slot->loading)
+            continue;
+
+        if (slot->hunk == -1) {
+            victim = i;
+            break;
+        }
+
+        if ((victim == -1) || (slot->last_used < img->hunks[victim].last_used))
+            victim = i;
+    }
+
+    if (victim != -1) {
+        slot             = &img->hunks[victim];
+        slot->hunk       = hunk;
+        slot->loading    = 1;
+        slot->read_ahead = read_ahead;
+        slot->last_used  = ++img->hunk_clock;
+    }
+
+    return victim;
+}
+
+/* Decompresses a hunk into a claimed slot, and publishes or drops it. Called
+   without the cache mutex held, returns with it held. */
+static int
+chd_image_load_hunk(chd_image_t *img, int i)
+{
+    chd_hunk_t *slot = &img->hunks[i];
+    chd_error   res;
+
+    thread_wait_mutex(img->file_mutex);
+    res = chd_read(img->img_file, (uint32_t) slot->hunk, slot->data);
+    thread_release_mutex(img->file_mutex);
+
+    thread_wait_mutex(img->cache_mutex);
+    slot->loading = 0;
+    if (res != CHDERR_NONE) {
+        pclog("Failed to read hunk %" PRId64 "\n", slot->hunk);
+        slot->hunk = -1;
+    }
+    thread_set_event(img->ra_done_event);
+
+    return (res == CHDERR_NONE);
+}
+
+static void
+chd_image_read_ahead_thread(void *priv)
+{
+    chd_image_t *img = (chd_image_t *) priv;
+    int64_t      hunk;
+    int          i;
+
+    while (img->ra_running) {
+        thread_wait_event(img->ra_event, -1);
+        thread_reset_event(img->ra_event);
+
+        thread_wait_mutex(img->cache_mutex);
+        while (img->ra_running && (img->ra_count > 0)) {
+            hunk = img->ra_hunk++;
+            img->ra_count--;
+
+            if ((hunk >= img->header->totalhunks) || (chd_image_find_hunk(img, hunk) != -1))
+                continue;
+
+            i = chd_image_claim_hunk(img, hunk, 1);
+            if (i == -1)
+                break;
+
+            thread_release_mutex(img->cache_mutex);
+            chd_image_load_hunk(img, i);
+        }
+        thread_release_mutex(img->cache_mutex);
+    }
+}
+
+/*
+ * Copies part of a hunk out of the cache, decompressing it first if needed.
+ * The data is copied rather than pointed to, as the audio thread reads from
+ * the same image and may evict the hunk right after.
+ */
+static int
+chd_image_read_hunk(chd_image_t *img, int64_t hunk, uint64_t offset, uint8_t *dst, uint64_t len)
+{
+    chd_hunk_t *slot;
+    int         i;
+    int         ahead;
+
+    if (img->uncompressed) {
+        memcpy(dst, &img->hunk_bytes[(hunk * img->hunk_size) + offset], len);
+        return 1;
+    }
+
+    thread_wait_mutex(img->cache_mutex);
+    while (1) {
+        i = chd_image_find_hunk(img, hunk);
+
+        if ((i != -1) && img->hunks[i].loading) {
+            /* Being read ahead right now, wait for it rather than decompress
+               it twice. */
+            thread_reset_event(img->ra_done_event);
+            thread_release_mutex(img->cache_mutex);
+            thread_wait_event(img->ra_done_event, 10);
+            thread_wait_mutex(img->cache_mutex);
+            continue;
+        }
+
+        if (i != -1) {
+            slot  = &img->hunks[i];
+            ahead = slot->read_ahead;
+            img->hits++;
+            if (ahead)
+                img->ra_hits++;
+            break;
+        }
+
+        i = chd_image_claim_hunk(img, hunk, 0);
+        if (i == -1) {
+            /* Every slot is being loaded, which takes a tiny cache. */
+            thread_release_mutex(img->cache_mutex);
+            thread_wait_event(img->ra_done_event, 10);
+            thread_wait_mutex(img->cache_mutex);
+            continue;
+        }
+
+        img->misses++;
+        thread_release_mutex(img->cache_mutex);
+        if (!chd_image_load_hunk(img, i)) {
+            thread_release_mutex(img->cache_mutex);
+            return 0;
+        }
+        slot  = &img->hunks[i];
+        ahead = 1;
+        break;
+    }
+
+    slot->read_ahead = 0;
+    slot->last_used  = ++img->hunk_clock;
+    memcpy(dst, &slot->data[offset], len);
+
+    /* A miss, or the first use of a hunk read ahead, means a stream is moving
+       forward, so keep decompressing in front of it. */
+    if (ahead) {
+        img->ra_hunk  = hunk + 1;
+        img->ra_count = CHD_READ_AHEAD;
+        thread_set_event(img->ra_event);
+    }
+    thread_release_mutex(img->cache_mutex);
+
+    return 1;
+}
+
+static void
+chd_image_cache_init(chd_image_t *img)
+{
+    img->nr_hunks = MAX(chd_cache_hunks, CHD_READ_AHEAD + 2);
+    img->hunks    = (chd_hunk_t *) calloc(img->nr_hunks, sizeof(chd_hunk_t));
+    for (int i = 0; i < img->nr_hunks; i++) {
+        img->hunks[i].hunk = -1;
+        img->hunks[i].data = (uint8_t *) malloc(img->hunk_size);
+    }
+
+    img->cache_mutex   = thread_create_mutex();
+    img->file_mutex    = thread_create_mutex();
+    img->ra_event      = thread_create_event();
+    img->ra_done_event = thread_create_event();
+    img->ra_running    = 1;
+    img->ra_thread     = thread_create_named(chd_image_read_ahead_thread, img, "chd-readahead");
+}
+
+static void
+chd_image_cache_close(chd_image_t *img)
+{
+    if (img->hunks == NULL)
+        return;
+
+    img->ra_running = 0;
+    thread_set_event(img->ra_event);
+    thread_wait(img->ra_thread);
+
+    chd_log("CHD: %" PRIu64 " hits (%" PRIu64 " read ahead), %" PRIu64 " misses\n",
+            img->hits, img->ra_hits, img->misses);
+
+    thread_destroy_event(img->ra_done_event);
+    thread_destroy_event(img->ra_event);
+    thread_close_mutex(img->file_mutex);
+    thread_close_mutex(img->cache_mutex);
+
+    for (int i = 0; i < img->nr_hunks; i++)
+        free(img->hunks[i].data);
+    free(img->hunks);
+    img->hunks = NULL;
+}
+
 static void
 chd_image_get_raw_track_info(UNUSED(const void *local), int *num, uint8_t *rti)
 {
@@ -321,6 +583,7 @@ static void
 chd_image_close(void *local)
 {
     chd_image_t *img = local;
+    chd_image_cache_close(img);
     if (img->hunk_bytes)
         free(img->hunk_bytes);
     if (img->track_entries)
@@ -378,21 +641,8 @@ chd_image_read_sector_dvd(const void *local, UNUSED(uint8_t *buffer), UNUSED(uin
     int64_t  hunk_to_use      = (chd_offset / 2048) / ioctl->sectors_per_hunk;
     uint64_t offset_from_hunk = chd_offset - hunk_to_use * ioctl->hunk_size;
 
-    if (ioctl->uncompressed) {
-        hunk_to_use      = 0;
-        offset_from_hunk = chd_offset;
-    } else {
-        if (hunk_to_use != ioctl->cur_hunk) {
-            chd_error res = chd_read(ioctl->img_file, (uint32_t) hunk_to_use, ioctl->hunk_bytes);
-            if (res != CHDERR_NONE) {
-                pclog("Failed to read hunk %" PRId64 "\n", hunk_to_use);
-                return 0;
-            }
-            ioctl->cur_hunk = hunk_to_use;
-        }
-    }
-
-    memcpy(&buffer[16], &ioctl->hunk_bytes[offset_from_hunk], 2048);
+    if (!chd_image_read_hunk(ioctl, hunk_to_use, offset_from_hunk, &buffer[16], 2048))
+        return 0;
     /* Sync bytes. */
     buffer[0] = 0x00;
     memset(&(buffer[1]), 0xff, 10);
@@ -481,23 +731,13 @@ chd_image_read_sector(const void *local, UNUSED(uint8_t *buffer), UNUSED(uint32_
         chd_offset = (lba - (chd_track->start + chd_track->pregap)) * 2448 + chd_track->chd_start;
     }
 
+    uint8_t raw[2448] = { 0 };
     int64_t hunk_to_use = (chd_offset / 2448) / ioctl->sectors_per_hunk;
     uint64_t offset_from_hunk = chd_offset - hunk_to_use * ioctl->hunk_size;
 
     if (!in_pregap || (in_pregap && chd_track->pregap_exists_in_file)) {
-        if (ioctl->uncompressed) {
-            hunk_to_use = 0;
-            offset_from_hunk = chd_offset;
-        } else {
-            if (hunk_to_use != ioctl->cur_hunk) {
-                chd_error res = chd_read(ioctl->img_file, (uint32_t)hunk_to_use, ioctl->hunk_bytes);
-                if (res != CHDERR_NONE) {
-                pclog("Failed to read hunk %" PRId64 "\n", hunk_to_use);
-                    return 0;
-                }
-                ioctl->cur_hunk = hunk_to_use;
-            }
-        }
+        if (!chd_image_read_hunk(ioctl, hunk_to_use, offset_from_hunk, raw, MIN(sizeof(raw), ioctl->hunk_size - offset_from_hunk)))
+            return 0;
     }
 
     uint32_t crc = 0;
@@ -508,7 +748,7 @@ chd_image_read_sector(const void *local, UNUSED(uint8_t *buffer), UNUSED(uint32_
             switch(sector_track_type) {
                 case CD_TRACK_MODE1: {
                     if (!in_pregap || (in_pregap && chd_track->pregap_exists_in_file))
-                        memcpy(&buffer[16], &ioctl->hunk_bytes[offset_from_hunk], 2048);
+                        memcpy(&buffer[16], raw, 2048);
                     /* Sync bytes. */
                     buffer[0] = 0x00;
                     memset(&(buffer[1]), 0xff, 10);
@@ -534,7 +774,7 @@ chd_image_read_sector(const void *local, UNUSED(uint8_t *buffer), UNUSED(uint32_
                 }
                 case CD_TRACK_MODE2_FORM1: {
                     if (!in_pregap || (in_pregap && chd_track->pregap_exists_in_file))
-                        memcpy(&buffer[24], &ioctl->hunk_bytes[offset_from_hunk], 2048);
+                        memcpy(&buffer[24], raw, 2048);
                     /* Sync bytes. */
                     buffer[0] = 0x00;
                     memset(&(buffer[1]), 0xff, 10);
@@ -569,7 +809,7 @@ chd_image_read_sector(const void *local, UNUSED(uint8_t *buffer), UNUSED(uint32_
         case 2352:
         {
             if (!in_pregap || (in_pregap && chd_track->pregap_exists_in_file))
-                memcpy(buffer, &ioctl->hunk_bytes[offset_from_hunk], 2352);
+                memcpy(buffer, raw, 2352);
             if (chd_track->audioswap) {
                 for (int i = 0; i < 2352; i += 2) {
                     uint8_t samp_1 = buffer[i];
@@ -582,7 +822,7 @@ chd_image_read_sector(const void *local, UNUSED(uint8_t *buffer), UNUSED(uint32_
         case 2324:
         {
             if (!in_pregap || (in_pregap && chd_track->pregap_exists_in_file))
-                memcpy(&buffer[24], &ioctl->hunk_bytes[offset_from_hunk], 2324);
+                memcpy(&buffer[24], raw, 2324);
             /* Sync bytes. */
             buffer[0] = 0x00;
             memset(&(buffer[1]), 0xff, 10);
@@ -604,7 +844,7 @@ chd_image_read_sector(const void *local, UNUSED(uint8_t *buffer), UNUSED(uint32_
         case 2336:
         {
             if (!in_pregap || (in_pregap && chd_track->pregap_exists_in_file))
-                memcpy(&buffer[16], &ioctl->hunk_bytes[offset_from_hunk], 2336);
+                memcpy(&buffer[16], raw, 2336);
             switch (chd_track->track_type) {
                 case CD_TRACK_MODE2_FORM_MIX:
                 case CD_TRACK_MODE2: {
@@ -629,9 +869,9 @@ chd_image_read_sector(const void *local, UNUSED(uint8_t *buffer), UNUSED(uint32_
 
     if (subchannel_exists) {
         if (subchannel_exists == 2) {
-            sub_to_interleaved(&ioctl->hunk_bytes[offset_from_hunk + sector_sector_size], &buffer[2352]);
+            sub_to_interleaved(&raw[sector_sector_size], &buffer[2352]);
         } else {
-            memcpy(&buffer[2352], &ioctl->hunk_bytes[offset_from_hunk + sector_sector_size], 96);
+            memcpy(&buffer[2352], &raw[sector_sector_size], 96);
         }
         return 1;
     }
@@ -820,9 +1060,7 @@ precache_start:
                     break;
                 }
         }
-        if (!img->uncompressed)
-            img->hunk_bytes = calloc(1, img->header->hunkbytes);
-        else
+        if (img->uncompressed)
             img->hunk_bytes = img->uncompressed_chd_sectors;
 
         if (img->is_dvd) {
@@ -988,7 +1226,8 @@ generate_raw_track_info:
 
         img->dev = dev;
         img->dev->ops = img->is_dvd ? &chd_image_dvd_ops : &chd_image_ops;
-        img->cur_hunk = -1;
+        if (!img->uncompressed)
+            chd_image_cache_init(img);
 
         return img;
     }
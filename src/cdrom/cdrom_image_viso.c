@@ -30,6 +30,9 @@
 #include <string.h>
 #include <sys/types.h>
 #include <time.h>
+#ifndef _WIN32
+#    include <fcntl.h>
+#endif
 #include <86box/86box.h>
 #include <86box/cdrom.h>
 #include <86box/cdrom_image.h>
@@ -65,7 +68,8 @@
     }
 
 #define VISO_SECTOR_SIZE COOKED_SECTOR_SIZE
-#define VISO_OPEN_FILES  32
+#define VISO_OPEN_FILES  64
+#define VISO_EXTENT_SIZE (256 << 10)
 
 enum {
     VISO_CHARSET_D = 0,
@@ -121,13 +125,24 @@ typedef struct {
     uint64_t pt_meta_offsets[2];
     int      format;
     uint8_t  use_version_suffix : 1;
-    size_t   metadata_sectors, all_sectors, entry_map_size, sector_size, file_fifo_pos;
+    size_t   metadata_sectors, all_sectors, file_map_size, sector_size;
     uint8_t *metadata;
 
     track_file_t   tf;
     viso_entry_t  *root_dir;
-    viso_entry_t **entry_map;
-    viso_entry_t  *file_fifo[VISO_OPEN_FILES];
+    viso_entry_t **file_map; /* files with data, in sector order */
+
+    /* Least recently used open files. */
+    int           max_open_files;
+    uint32_t      open_clock;
+    viso_entry_t *open_files[VISO_OPEN_FILES];
+    uint32_t      open_used[VISO_OPEN_FILES];
+
+    /* Extent read last, sequential reads are served from it. */
+    uint8_t      *extent;
+    viso_entry_t *extent_entry;
+    uint64_t      extent_start;
+    size_t        extent_len;
 } viso_t;
 
 static const char rr_eid[]   = "RRIP_1991A"; /* identifiers used in ER field for Rock Ridge */
@@ -674,73 +689,147 @@ viso_compare_entries(const void *a, const void *b)
     return strcmp((*((viso_entry_t **) a))->name_short, (*((viso_entry_t **) b))->name_short);
 }
 
-int
-viso_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count)
+/* Returns the open file of an entry, opening it in place of the least
+   recently used one if needed. */
+static FILE *
+viso_open_file(viso_t *viso, viso_entry_t *entry)
 {
-    track_file_t *tf   = (track_file_t *) priv;
-    viso_t       *viso = (viso_t *) tf->priv;
+    int slot = 0;
 
-    /* Handle reads in a sector by sector basis. */
-    while (count > 0) {
-        /* Determine the current sector, offset and remainder. */
-        size_t sector        = seek / viso->sector_size;
-        size_t sector_offset = seek % viso->sector_size;
-        size_t sector_remain = MIN(count, viso->sector_size - sector_offset);
+    for (int i = 0; i < viso->max_open_files; i++) {
+        if (viso->open_files[i] == entry) {
+            viso->open_used[i] = ++viso->open_clock;
+            return entry->file;
+        }
 
-        /* Handle sector. */
-        if (sector < viso->metadata_sectors) {
-            /* Copy metadata. */
-            memcpy(buffer, viso->metadata + seek, sector_remain);
-        } else {
-            size_t read = 0;
-
-            /* Get the file entry corresponding to this sector. */
-            viso_entry_t *entry = viso->entry_map[sector - viso->metadata_sectors];
-            if (entry) {
-                /* Open file if it's not already open. */
-                if (!entry->file) {
-                    /* Close any existing FIFO entry's file. */
-                    viso_entry_t *other_entry = viso->file_fifo[viso->file_fifo_pos];
-                    if (other_entry && other_entry->file) {
-                        image_viso_log(viso->tf.log, "Closing [%s]...\n", other_entry->path);
-                        fclose(other_entry->file);
-                        other_entry->file = NULL;
-                        image_viso_log(viso->tf.log, "Done\n");
-                    }
+        if (viso->open_files[i] == NULL) {
+            slot = i;
+            break;
+        }
+        if (viso->open_used[i] < viso->open_used[slot])
+            slot = i;
+    }
 
-                    /* Open file. */
-                    image_viso_log(viso->tf.log, "Opening [%s]...\n", entry->path);
-                    if ((entry->file = fopen(entry->path, "rb"))) {
-                        image_viso_log(viso->tf.log, "Done\n");
+    /* Close the file we are replacing. */
+    viso_entry_t *other_entry = viso->open_files[slot];
+    if (other_entry && other_entry->file) {
+        image_viso_log(viso->tf.log, "Closing [%s]...\n", other_entry->path);
+        fclose(other_entry->file);
+        other_entry->file = NULL;
+        image_viso_log(viso->tf.log, "Done\n");
+    }
+    viso->open_files[slot] = NULL;
 
-                        /* Add this entry to the FIFO. */
-                        viso->file_fifo[viso->file_fifo_pos++] = entry;
-                        viso->file_fifo_pos &= (sizeof(viso->file_fifo) / sizeof(viso->file_fifo[0])) - 1;
-                    } else {
-                        image_viso_log(viso->tf.log, "Failed\n");
+    /* Open file. */
+    image_viso_log(viso->tf.log, "Opening [%s]...\n", entry->path);
+    if ((entry->file = plat_fopen64(entry->path, "rb"))) {
+        image_viso_log(viso->tf.log, "Done\n");
 
-                        /* Clear any existing FIFO entry. */
-                        viso->file_fifo[viso->file_fifo_pos] = NULL;
-                    }
-                }
+        /* Reads are done in whole extents, so stdio buffering only adds a copy. */
+        setvbuf(entry->file, NULL, _IONBF, 0);
 
-                /* Read data. */
-                if (!entry->file || (fseeko64(entry->file, seek - entry->data_offset, SEEK_SET) == -1))
-                    return -1;
-                read = fread(buffer, 1, sector_remain, entry->file);
-                if (sector_remain && !read)
-                    return -1;
-            }
+        viso->open_files[slot] = entry;
+        viso->open_used[slot]  = ++viso->open_clock;
+    } else {
+        image_viso_log(viso->tf.log, "Failed\n");
+    }
+
+    return entry->file;
+}
+
+/* Finds the file holding a sector past the metadata, if any. */
+static viso_entry_t *
+viso_find_file(const viso_t *viso, uint64_t seek)
+{
+    size_t lo = 0;
+    size_t hi = viso->file_map_size;
+
+    while (lo < hi) {
+        size_t        mid   = lo + ((hi - lo) / 2);
+        viso_entry_t *entry = viso->file_map[mid];
+
+        if (seek < entry->data_offset)
+            hi = mid;
+        else if (seek >= (entry->data_offset + entry->stats.size))
+            lo = mid + 1;
+        else
+            return entry;
+    }
+
+    return NULL;
+}
+
+/* Reads from a file, through the extent buffer for small reads. Returns the
+   amount of bytes read, which may be less than requested. */
+static size_t
+viso_read_file(viso_t *viso, viso_entry_t *entry, uint64_t offset, uint8_t *buffer, size_t count)
+{
+    FILE *fp;
 
-            /* Fill remainder with 00 bytes if required. */
-            if (read < sector_remain)
-                memset(buffer + read, 0x00, sector_remain - read);
+    if ((entry == viso->extent_entry) && (offset >= viso->extent_start) &&
+        (offset < (viso->extent_start + viso->extent_len))) {
+        count = MIN(count, viso->extent_start + viso->extent_len - offset);
+        memcpy(buffer, viso->extent + (offset - viso->extent_start), count);
+        return count;
+    }
+
+    fp = viso_open_file(viso, entry);
+    if (!fp || (fseeko64(fp, offset, SEEK_SET) == -1))
+        return 0;
+
+    if (count >= VISO_EXTENT_SIZE)
+        return fread(buffer, 1, count, fp);
+
+    viso->extent_entry = NULL;
+    viso->extent_len   = fread(viso->extent, 1, VISO_EXTENT_SIZE, fp);
+    if (viso->extent_len == 0)
+        return 0;
+    viso->extent_entry = entry;
+    viso->extent_start = offset;
+
+#ifdef POSIX_FADV_WILLNEED
+    /* Have the host start on the next extent while the guest is busy with this one. */
+    if ((offset + viso->extent_len) < entry->stats.size)
+        posix_fadvise(fileno(fp), offset + viso->extent_len, VISO_EXTENT_SIZE, POSIX_FADV_WILLNEED);
+#endif
+
+    count = MIN(count, viso->extent_len);
+    memcpy(buffer, viso->extent, count);
+    return count;
+}
+
+int
+viso_read(void *priv, uint8_t *buffer, uint64_t seek, size_t count)
+{
+    track_file_t *tf            = (track_file_t *) priv;
+    viso_t       *viso          = (viso_t *) tf->priv;
+    uint64_t      metadata_size = ((uint64_t) viso->metadata_sectors) * viso->sector_size;
+
+    /* Handle reads in runs of metadata, file data, and padding. */
+    while (count > 0) {
+        size_t        remain;
+        viso_entry_t *entry;
+
+        if (seek < metadata_size) {
+            /* Copy metadata. */
+            remain = MIN(count, metadata_size - seek);
+            memcpy(buffer, viso->metadata + seek, remain);
+        } else if ((entry = viso_find_file(viso, seek))) {
+            /* Read file data. */
+            remain = viso_read_file(viso, entry, seek - entry->data_offset, buffer,
+                                    MIN(count, entry->data_offset + entry->stats.size - seek));
+            if (remain == 0)
+                return -1;
+        } else {
+            /* Fill the end of the last sector of a file with 00 bytes. */
+            remain = viso->sector_size - (seek % viso->sector_size);
+            remain = MIN(count, remain);
+            memset(buffer, 0x00, remain);
         }
 
-        /* Move on to the next sector. */
-        buffer += sector_remain;
-        seek += sector_remain;
-        count -= sector_remain;
+        buffer += remain;
+        seek += remain;
+        count -= remain;
     }
 
     return 1;
@@ -786,8 +875,10 @@ viso_close(void *priv)
 
     if (viso->metadata)
         free(viso->metadata);
-    if (viso->entry_map)
-        free(viso->entry_map);
+    if (viso->file_map)
+        free(viso->file_map);
+    if (viso->extent)
+        free(viso->extent);
 
     if (tf->log != NULL)
         log_close(tf->log);
@@ -943,10 +1034,8 @@ viso_init(const uint8_t id, const char *dirname, int *error)
 
                 /* Handle file size and El Torito boot code. */
                 if (!entry->stats.is_dir) {
-                    /* Increase entry map size. */
-                    viso->entry_map_size += entry->stats.size / viso->sector_size;
-                    if (entry->stats.size % viso->sector_size)
-                        viso->entry_map_size++; /* round up to the next sector */
+                    /* Increase file map size. */
+                    viso->file_map_size++;
 
                     /* Detect El Torito boot code file and set it accordingly. */
                     if (dir == eltorito_dir) {
@@ -1483,45 +1572,17 @@ next_entry:
         }
     }
 
-    /* Allocate entry map for sector->file lookups. */
-    size_t orig_sector_size = viso->sector_size;
-    while (1) {
-        image_viso_log(viso->tf.log, "Allocating entry map for %zu %zu-byte sectors\n",
-                       viso->entry_map_size, viso->sector_size);
-        viso->entry_map = (viso_entry_t **) calloc(viso->entry_map_size, sizeof(viso_entry_t *));
-        if (viso->entry_map) {
-            /* Successfully allocated. */
-            break;
-        } else {
-            /* Blank data buffer for padding if this is the first run. */
-            if (orig_sector_size == viso->sector_size)
-                memset(data, 0x00, orig_sector_size);
-
-            /* If we don't have enough memory, double the sector size. */
-            viso->sector_size *= 2;
-            if ((viso->sector_size < VISO_SECTOR_SIZE) || (viso->sector_size > (1 << 30))) /* give up if sectors become too large */
-                goto end;
-
-            /* Go through files, recalculating the entry map size. */
-            size_t orig_entry_map_size = viso->entry_map_size;
-            viso->entry_map_size       = 0;
-            entry                      = viso->root_dir;
-            while (LIKELY(entry)) {
-                if (!entry->stats.is_dir) {
-                    viso->entry_map_size += entry->stats.size / viso->sector_size;
-                    if (entry->stats.size % viso->sector_size)
-                        viso->entry_map_size++; /* round up to the next sector */
-                }
-                entry = entry->next;
-            }
-            if (viso->entry_map_size == orig_entry_map_size) /* give up if there was no change in map size */
-                goto end;
+    /* Allocate file map for sector->file lookups. Only one entry per file is
+       needed, as every file occupies a single run of sectors. */
+    image_viso_log(viso->tf.log, "Allocating file map for %zu files\n", viso->file_map_size);
+    viso->file_map = (viso_entry_t **) calloc(MAX(viso->file_map_size, 1), sizeof(viso_entry_t *));
+    if (viso->file_map == NULL)
+        goto end;
+    viso->max_open_files = (int) MAX(MIN(viso->file_map_size, VISO_OPEN_FILES), 1);
 
-            /* Pad metadata to the new size's next sector. */
-            while (ftello64(viso->tf.fp) % viso->sector_size)
-                fwrite(data, orig_sector_size, 1, viso->tf.fp);
-        }
-    }
+    viso->extent = (uint8_t *) malloc(VISO_EXTENT_SIZE);
+    if (viso->extent == NULL)
+        goto end;
 
     /* Start sector counts. */
     viso->metadata_sectors = ftello64(viso->tf.fp) / viso->sector_size;
@@ -1529,9 +1590,8 @@ next_entry:
 
     /* Go through files, assigning sectors to them. */
     image_viso_log(viso->tf.log, "Assigning sectors to files:\n");
-    size_t        base_factor  = viso->sector_size / orig_sector_size;
     viso_entry_t *prev_entry   = viso->root_dir;
-    viso_entry_t **entry_map_p = viso->entry_map;
+    viso_entry_t **file_map_p  = viso->file_map;
     entry                      = prev_entry->next;
     while (LIKELY(entry)) {
         /* Skip this entry if it corresponds to a directory. */
@@ -1557,11 +1617,11 @@ next_entry:
             } else { /* emulation */
                 AS_U16(data[0]) = cpu_to_le16(1);
             }
-            AS_U32(data[2]) = cpu_to_le32(viso->all_sectors * base_factor);
+            AS_U32(data[2]) = cpu_to_le32(viso->all_sectors);
             viso_pwrite(data, eltorito_offset, 6, 1, viso->tf.fp);
         } else {
             p = data;
-            VISO_LBE_32(p, viso->all_sectors * base_factor);
+            VISO_LBE_32(p, viso->all_sectors);
             for (int i = 0; i <= max_vd; i++)
                 viso_pwrite(data, entry->dr_offsets[i] + 2, 8, 1, viso->tf.fp);
         }
@@ -1578,14 +1638,16 @@ next_entry:
 
         /* Allocate sectors to this file. */
         viso->all_sectors += size;
-        while (size-- > 0)
-            *entry_map_p++ = entry;
+        if (size > 0)
+            *file_map_p++ = entry;
 
         /* Move on to the next entry. */
         prev_entry = entry;
         entry      = entry->next;
     }
 
+    viso->file_map_size = file_map_p - viso->file_map;
+
     /* Write final volume size to all volume descriptors. */
     p = data;
     VISO_LBE_32(p, viso->all_sectors);
@@ -66,6 +66,10 @@ typedef struct codeblock_t {
     /*First mem_block_t used by this block. Any subsequent mem_block_ts
       will be in the list starting at head_mem_block->next.*/
     struct mem_block_t *head_mem_block;
+
+    /*Block that was executed straight after this one last time. Only a hint,
+      the dispatcher still checks it matches the current CS:PC before use.*/
+    uint16_t succ_hint;
 } codeblock_t;
 
 extern codeblock_t *codeblock;
@@ -326,6 +330,17 @@ extern void codegen_delete_random_block(int required_mem_block);
 extern int      cpu_block_end;
 extern uint32_t codegen_endpc;
 
+/*Last compiled block executed, BLOCK_INVALID if something else ran since*/
+extern uint16_t codegen_succ_prev;
+
+/*Guest memory accesses from compiled code that hit or missed readlookup2 /
+  writelookup2. Misses are always counted, hits only when codegen_mem_stats
+  was set before the code was generated, as it costs an increment on the
+  inline fast path*/
+extern int      codegen_mem_stats;
+extern uint64_t codegen_mem_hits;
+extern uint64_t codegen_mem_misses;
+
 extern int cpu_reps;
 extern int cpu_notreps;
 
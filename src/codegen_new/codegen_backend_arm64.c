@@ -115,6 +115,8 @@ build_load_routine(codeblock_t *block, int size, int is_float)
         host_arm64_LDR_REG_F32(block, REG_V_TEMP, REG_W1, REG_W0);
     else if (size == 8)
         host_arm64_LDR_REG_F64(block, REG_V_TEMP, REG_W1, REG_W0);
+    if (codegen_mem_stats)
+        host_arm64_inc64_abs(block, REG_X2, REG_X3, &codegen_mem_hits);
     host_arm64_MOVZ_IMM(block, REG_W1, 0);
     host_arm64_RET(block, REG_X30);
 
@@ -122,6 +124,7 @@ build_load_routine(codeblock_t *block, int size, int is_float)
     if (size != 1)
         host_arm64_branch_set_offset(misaligned_offset, &block_write_data[block_pos]);
     host_arm64_STP_PREIDX_X(block, REG_X29, REG_X30, REG_XSP, -16);
+    host_arm64_inc64_abs(block, REG_X2, REG_X3, &codegen_mem_misses);
     if (size == 1)
         host_arm64_call(block, (void *) readmembl);
     else if (size == 2)
@@ -183,6 +186,8 @@ build_store_routine(codeblock_t *block, int size, int is_float)
         host_arm64_STR_REG_F32(block, REG_V_TEMP, REG_X2, REG_X0);
     else if (size == 8)
         host_arm64_STR_REG_F64(block, REG_V_TEMP, REG_X2, REG_X0);
+    if (codegen_mem_stats)
+        host_arm64_inc64_abs(block, REG_X2, REG_X3, &codegen_mem_hits);
     host_arm64_MOVZ_IMM(block, REG_X1, 0);
     host_arm64_RET(block, REG_X30);
 
@@ -190,6 +195,7 @@ build_store_routine(codeblock_t *block, int size, int is_float)
     if (size != 1)
         host_arm64_branch_set_offset(misaligned_offset, &block_write_data[block_pos]);
     host_arm64_STP_PREIDX_X(block, REG_X29, REG_X30, REG_XSP, -16);
+    host_arm64_inc64_abs(block, REG_X2, REG_X3, &codegen_mem_misses);
     if (size == 4 && is_float)
         host_arm64_FMOV_W_S(block, REG_W1, REG_V_TEMP);
     else if (size == 8)
@@ -484,6 +484,14 @@ host_arm64_B(codeblock_t *block, void *dest)
     codegen_addlong(block, OPCODE_B | OFFSET26(offset));
 }
 
+uint32_t *
+host_arm64_B_(codeblock_t *block)
+{
+    codegen_alloc(block, 4);
+    codegen_addlong(block, OPCODE_B);
+    return (uint32_t *) &block_write_data[block_pos - 4];
+}
+
 void
 host_arm64_BFI(codeblock_t *block, int dst_reg, int src_reg, int lsb, int width)
 {
@@ -1686,6 +1694,16 @@ host_arm64_call(codeblock_t *block, void *dst_addr)
     host_arm64_BLR(block, REG_X16);
 }
 
+/* Increment a 64-bit counter outside cpu_state, corrupting addr_reg and temp_reg. */
+void
+host_arm64_inc64_abs(codeblock_t *block, int addr_reg, int temp_reg, uint64_t *p)
+{
+    host_arm64_MOVX_IMM(block, addr_reg, (uint64_t) (uintptr_t) p);
+    host_arm64_LDR_IMM_X(block, temp_reg, addr_reg, 0);
+    host_arm64_ADDX_IMM(block, temp_reg, temp_reg, 1);
+    host_arm64_STR_IMM_Q(block, temp_reg, addr_reg, 0);
+}
+
 void
 host_arm64_jump(codeblock_t *block, uintptr_t dst_addr)
 {
@@ -20,7 +20,8 @@ void host_arm64_ANDS_IMM(codeblock_t *block, int dst_reg, int src_n_reg, uint32_
 
 void host_arm64_ASR(codeblock_t *block, int dst_reg, int src_n_reg, int shift_reg);
 
-void host_arm64_B(codeblock_t *block, void *dest);
+void      host_arm64_B(codeblock_t *block, void *dest);
+uint32_t *host_arm64_B_(codeblock_t *block);
 
 void host_arm64_BFI(codeblock_t *block, int dst_reg, int src_reg, int lsb, int width);
 
@@ -257,6 +258,7 @@ void host_arm64_ZIP2_V4H(codeblock_t *block, int dst_reg, int src_n_reg, int src
 void host_arm64_ZIP2_V2S(codeblock_t *block, int dst_reg, int src_n_reg, int src_m_reg);
 
 void host_arm64_call(codeblock_t *block, void *dst_addr);
+void host_arm64_inc64_abs(codeblock_t *block, int addr_reg, int temp_reg, uint64_t *p);
 void host_arm64_jump(codeblock_t *block, uintptr_t dst_addr);
 void host_arm64_mov_imm(codeblock_t *block, int reg, uint32_t imm_data);
 
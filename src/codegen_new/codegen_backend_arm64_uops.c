@@ -895,6 +895,94 @@ codegen_LOAD_SEG(codeblock_t *block, uop_t *uop)
     return 0;
 }
 
+/*Probe readlookup2 inline and access host memory directly on a hit, only
+  calling the load routine for misses and misaligned accesses.
+  In - W0 = address
+  Out - W0 = data
+  Corrupts X1-X3*/
+static void
+codegen_mem_load_inline(codeblock_t *block, int size)
+{
+    uint32_t *misaligned_offset = NULL;
+    uint32_t *miss_offset;
+    uint32_t *done_offset;
+
+    host_arm64_MOV_REG_LSR(block, REG_W1, REG_W0, 12);
+    host_arm64_MOVX_IMM(block, REG_X2, (uint64_t) readlookup2);
+    host_arm64_LDRX_REG_LSL3(block, REG_X1, REG_X2, REG_X1);
+    if (size != 1) {
+        host_arm64_TST_IMM(block, REG_W0, size - 1);
+        misaligned_offset = host_arm64_BNE_(block);
+    }
+    host_arm64_CMPX_IMM(block, REG_X1, -1);
+    miss_offset = host_arm64_BEQ_(block);
+    if (size == 1)
+        host_arm64_LDRB_REG(block, REG_W0, REG_W1, REG_W0);
+    else if (size == 2)
+        host_arm64_LDRH_REG(block, REG_W0, REG_W1, REG_W0);
+    else
+        host_arm64_LDR_REG(block, REG_W0, REG_W1, REG_W0);
+    if (codegen_mem_stats)
+        host_arm64_inc64_abs(block, REG_X2, REG_X3, &codegen_mem_hits);
+    done_offset = host_arm64_B_(block);
+
+    host_arm64_branch_set_offset(miss_offset, &block_write_data[block_pos]);
+    if (size != 1)
+        host_arm64_branch_set_offset(misaligned_offset, &block_write_data[block_pos]);
+    if (size == 1)
+        host_arm64_call(block, codegen_mem_load_byte);
+    else if (size == 2)
+        host_arm64_call(block, codegen_mem_load_word);
+    else
+        host_arm64_call(block, codegen_mem_load_long);
+    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+
+    host_arm64_branch_set_offset(done_offset, &block_write_data[block_pos]);
+}
+
+/*As codegen_mem_load_inline(), for stores.
+  In - W0 = address, W1 = data
+  Corrupts X1-X3*/
+static void
+codegen_mem_store_inline(codeblock_t *block, int size)
+{
+    uint32_t *misaligned_offset = NULL;
+    uint32_t *miss_offset;
+    uint32_t *done_offset;
+
+    host_arm64_MOV_REG_LSR(block, REG_W2, REG_W0, 12);
+    host_arm64_MOVX_IMM(block, REG_X3, (uint64_t) writelookup2);
+    host_arm64_LDRX_REG_LSL3(block, REG_X2, REG_X3, REG_X2);
+    if (size != 1) {
+        host_arm64_TST_IMM(block, REG_W0, size - 1);
+        misaligned_offset = host_arm64_BNE_(block);
+    }
+    host_arm64_CMPX_IMM(block, REG_X2, -1);
+    miss_offset = host_arm64_BEQ_(block);
+    if (size == 1)
+        host_arm64_STRB_REG(block, REG_X1, REG_X2, REG_X0);
+    else if (size == 2)
+        host_arm64_STRH_REG(block, REG_X1, REG_X2, REG_X0);
+    else
+        host_arm64_STR_REG(block, REG_X1, REG_X2, REG_X0);
+    if (codegen_mem_stats)
+        host_arm64_inc64_abs(block, REG_X2, REG_X3, &codegen_mem_hits);
+    done_offset = host_arm64_B_(block);
+
+    host_arm64_branch_set_offset(miss_offset, &block_write_data[block_pos]);
+    if (size != 1)
+        host_arm64_branch_set_offset(misaligned_offset, &block_write_data[block_pos]);
+    if (size == 1)
+        host_arm64_call(block, codegen_mem_store_byte);
+    else if (size == 2)
+        host_arm64_call(block, codegen_mem_store_word);
+    else
+        host_arm64_call(block, codegen_mem_store_long);
+    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+
+    host_arm64_branch_set_offset(done_offset, &block_write_data[block_pos]);
+}
+
 static int
 codegen_MEM_LOAD_ABS(codeblock_t *block, uop_t *uop)
 {
@@ -904,14 +992,13 @@ codegen_MEM_LOAD_ABS(codeblock_t *block, uop_t *uop)
 
     host_arm64_ADD_IMM(block, REG_X0, seg_reg, uop->imm_data);
     if (REG_IS_B(dest_size) || REG_IS_BH(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_byte);
+        codegen_mem_load_inline(block, 1);
     } else if (REG_IS_W(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_word);
+        codegen_mem_load_inline(block, 2);
     } else if (REG_IS_L(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_long);
+        codegen_mem_load_inline(block, 4);
     } else
         fatal("MEM_LOAD_ABS - %02x\n", uop->dest_reg_a_real);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
     if (REG_IS_B(dest_size)) {
         host_arm64_BFI(block, dest_reg, REG_X0, 0, 8);
     } else if (REG_IS_BH(dest_size)) {
@@ -938,16 +1025,16 @@ codegen_MEM_LOAD_REG(codeblock_t *block, uop_t *uop)
     if (uop->is_a16)
         host_arm64_AND_IMM(block, REG_X0, REG_X0, 0xffff);
     if (REG_IS_B(dest_size) || REG_IS_BH(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_byte);
+        codegen_mem_load_inline(block, 1);
     } else if (REG_IS_W(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_word);
+        codegen_mem_load_inline(block, 2);
     } else if (REG_IS_L(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_long);
+        codegen_mem_load_inline(block, 4);
     } else if (REG_IS_Q(dest_size)) {
         host_arm64_call(block, codegen_mem_load_quad);
+        host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
     } else
         fatal("MEM_LOAD_REG - %02x\n", uop->dest_reg_a_real);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
     if (REG_IS_B(dest_size)) {
         host_arm64_BFI(block, dest_reg, REG_X0, 0, 8);
     } else if (REG_IS_BH(dest_size)) {
@@ -1013,19 +1100,18 @@ codegen_MEM_STORE_ABS(codeblock_t *block, uop_t *uop)
     host_arm64_ADD_IMM(block, REG_W0, seg_reg, uop->imm_data);
     if (REG_IS_B(src_size)) {
         host_arm64_AND_IMM(block, REG_W1, src_reg, 0xff);
-        host_arm64_call(block, codegen_mem_store_byte);
+        codegen_mem_store_inline(block, 1);
     } else if (REG_IS_BH(src_size)) {
         host_arm64_UBFX(block, REG_W1, src_reg, 8, 8);
-        host_arm64_call(block, codegen_mem_store_byte);
+        codegen_mem_store_inline(block, 1);
     } else if (REG_IS_W(src_size)) {
         host_arm64_AND_IMM(block, REG_W1, src_reg, 0xffff);
-        host_arm64_call(block, codegen_mem_store_word);
+        codegen_mem_store_inline(block, 2);
     } else if (REG_IS_L(src_size)) {
         host_arm64_MOV_REG(block, REG_W1, src_reg, 0);
-        host_arm64_call(block, codegen_mem_store_long);
+        codegen_mem_store_inline(block, 4);
     } else
         fatal("MEM_STORE_ABS - %02x\n", uop->dest_reg_a_real);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
 
     return 0;
 }
@@ -1042,22 +1128,22 @@ codegen_MEM_STORE_REG(codeblock_t *block, uop_t *uop)
         host_arm64_ADD_IMM(block, REG_X0, REG_X0, uop->imm_data);
     if (REG_IS_B(src_size)) {
         host_arm64_AND_IMM(block, REG_W1, src_reg, 0xff);
-        host_arm64_call(block, codegen_mem_store_byte);
+        codegen_mem_store_inline(block, 1);
     } else if (REG_IS_BH(src_size)) {
         host_arm64_UBFX(block, REG_W1, src_reg, 8, 8);
-        host_arm64_call(block, codegen_mem_store_byte);
+        codegen_mem_store_inline(block, 1);
     } else if (REG_IS_W(src_size)) {
         host_arm64_AND_IMM(block, REG_W1, src_reg, 0xffff);
-        host_arm64_call(block, codegen_mem_store_word);
+        codegen_mem_store_inline(block, 2);
     } else if (REG_IS_L(src_size)) {
         host_arm64_MOV_REG(block, REG_W1, src_reg, 0);
-        host_arm64_call(block, codegen_mem_store_long);
+        codegen_mem_store_inline(block, 4);
     } else if (REG_IS_Q(src_size)) {
         host_arm64_FMOV_D_D(block, REG_V_TEMP, src_reg);
         host_arm64_call(block, codegen_mem_store_quad);
+        host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
     } else
         fatal("MEM_STORE_REG - %02x\n", uop->src_reg_c_real);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
 
     return 0;
 }
@@ -1070,8 +1156,7 @@ codegen_MEM_STORE_IMM_8(codeblock_t *block, uop_t *uop)
 
     host_arm64_ADD_REG(block, REG_W0, seg_reg, addr_reg, 0);
     host_arm64_mov_imm(block, REG_W1, uop->imm_data);
-    host_arm64_call(block, codegen_mem_store_byte);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_store_inline(block, 1);
 
     return 0;
 }
@@ -1083,8 +1168,7 @@ codegen_MEM_STORE_IMM_16(codeblock_t *block, uop_t *uop)
 
     host_arm64_ADD_REG(block, REG_W0, seg_reg, addr_reg, 0);
     host_arm64_mov_imm(block, REG_W1, uop->imm_data);
-    host_arm64_call(block, codegen_mem_store_word);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_store_inline(block, 2);
 
     return 0;
 }
@@ -1096,8 +1180,7 @@ codegen_MEM_STORE_IMM_32(codeblock_t *block, uop_t *uop)
 
     host_arm64_ADD_REG(block, REG_W0, seg_reg, addr_reg, 0);
     host_arm64_mov_imm(block, REG_W1, uop->imm_data);
-    host_arm64_call(block, codegen_mem_store_long);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_store_inline(block, 4);
 
     return 0;
 }
@@ -118,12 +118,18 @@ build_load_routine(codeblock_t *block, int size, int is_float)
         host_x86_MOVQ_XREG_BASE_INDEX(block, REG_XMM_TEMP, REG_RSI, REG_RCX);
     else
         fatal("build_load_routine: size=%i\n", size);
+    if (codegen_mem_stats) {
+        host_x86_MOV64_REG_IMM(block, REG_RDI, (uint64_t) (uintptr_t) &codegen_mem_hits);
+        host_x86_INC64_BASE(block, REG_RDI);
+    }
     host_x86_XOR32_REG_REG(block, REG_ESI, REG_ESI);
     host_x86_RET(block);
 
     *branch_offset = (uint8_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) branch_offset) - 1;
     if (size != 1)
         *misaligned_offset = (uint8_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) misaligned_offset) - 1;
+    host_x86_MOV64_REG_IMM(block, REG_RDI, (uint64_t) (uintptr_t) &codegen_mem_misses);
+    host_x86_INC64_BASE(block, REG_RDI);
     host_x86_PUSH(block, REG_RAX);
     host_x86_PUSH(block, REG_RDX);
 #    if _WIN64
@@ -212,12 +218,18 @@ build_store_routine(codeblock_t *block, int size, int is_float)
         host_x86_MOVQ_BASE_INDEX_XREG(block, REG_RSI, REG_RDI, REG_XMM_TEMP);
     else
         fatal("build_store_routine: size=%i\n", size);
+    if (codegen_mem_stats) {
+        host_x86_MOV64_REG_IMM(block, REG_R8, (uint64_t) (uintptr_t) &codegen_mem_hits);
+        host_x86_INC64_BASE(block, REG_R8);
+    }
     host_x86_XOR32_REG_REG(block, REG_ESI, REG_ESI);
     host_x86_RET(block);
 
     *branch_offset = (uint8_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) branch_offset) - 1;
     if (size != 1)
         *misaligned_offset = (uint8_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) misaligned_offset) - 1;
+    host_x86_MOV64_REG_IMM(block, REG_R8, (uint64_t) (uintptr_t) &codegen_mem_misses);
+    host_x86_INC64_BASE(block, REG_R8);
     host_x86_PUSH(block, REG_RAX);
     host_x86_PUSH(block, REG_RDX);
 #    if _WIN64
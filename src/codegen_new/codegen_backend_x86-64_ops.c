@@ -330,6 +330,17 @@ host_x86_CMP32_REG_REG(codeblock_t *block, int src_reg_a, int src_reg_b)
     codegen_addbyte2(block, 0x39, 0xc0 | src_reg_a | (src_reg_b << 3)); /*CMP src_reg_a, src_reg_b*/
 }
 
+void
+host_x86_INC64_BASE(codeblock_t *block, int base_reg)
+{
+#ifdef RECOMPILER_DEBUG
+    if (((base_reg & 7) == REG_ESP) || ((base_reg & 7) == REG_EBP))
+        fatal("host_x86_INC64_BASE - bad reg\n");
+#endif
+    codegen_alloc_bytes(block, 3);
+    codegen_addbyte3(block, (base_reg & 8) ? 0x49 : 0x48, 0xff, base_reg & 7); /*INC Q[base_reg]*/
+}
+
 void
 host_x86_JMP(codeblock_t *block, void *p)
 {
@@ -373,6 +384,14 @@ host_x86_JZ_short(codeblock_t *block)
     return &block_write_data[block_pos - 1];
 }
 
+uint32_t *
+host_x86_JMP_long(codeblock_t *block)
+{
+    codegen_alloc_bytes(block, 5);
+    codegen_addbyte(block, 0xe9); /*JMP*/
+    codegen_addlong(block, 0);
+    return (uint32_t *) &block_write_data[block_pos - 4];
+}
 uint32_t *
 host_x86_JNB_long(codeblock_t *block)
 {
@@ -25,6 +25,8 @@ void host_x86_CMP8_REG_REG(codeblock_t *block, int src_reg_a, int src_reg_b);
 void host_x86_CMP16_REG_REG(codeblock_t *block, int src_reg_a, int src_reg_b);
 void host_x86_CMP32_REG_REG(codeblock_t *block, int src_reg_a, int src_reg_b);
 
+void host_x86_INC64_BASE(codeblock_t *block, int base_reg);
+
 void host_x86_JMP(codeblock_t *block, void *p);
 
 void host_x86_JNZ(codeblock_t *block, void *p);
@@ -34,6 +36,7 @@ uint8_t *host_x86_JNZ_short(codeblock_t *block);
 uint8_t *host_x86_JS_short(codeblock_t *block);
 uint8_t *host_x86_JZ_short(codeblock_t *block);
 
+uint32_t *host_x86_JMP_long(codeblock_t *block);
 uint32_t *host_x86_JNB_long(codeblock_t *block);
 uint32_t *host_x86_JNBE_long(codeblock_t *block);
 uint32_t *host_x86_JNL_long(codeblock_t *block);
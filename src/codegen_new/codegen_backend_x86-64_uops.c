@@ -963,6 +963,104 @@ codegen_LOAD_SEG(codeblock_t *block, uop_t *uop)
     return 0;
 }
 
+/*Probe readlookup2 inline and access host memory directly on a hit, only
+  calling the load routine for misses and misaligned accesses.
+  In - ESI = address
+  Out - ECX = data
+  Corrupts RSI, RDI*/
+static void
+codegen_mem_load_inline(codeblock_t *block, int size)
+{
+    uint32_t *misaligned_offset = NULL;
+    uint32_t *miss_offset;
+    uint32_t *done_offset;
+
+    host_x86_MOV32_REG_REG(block, REG_ECX, REG_ESI);
+    host_x86_SHR32_IMM(block, REG_ESI, 12);
+    host_x86_MOV64_REG_IMM(block, REG_RDI, (uint64_t) (uintptr_t) readlookup2);
+    host_x86_MOV64_REG_BASE_INDEX_SHIFT(block, REG_RSI, REG_RDI, REG_RSI, 3);
+    if (size != 1) {
+        host_x86_TEST32_REG_IMM(block, REG_ECX, size - 1);
+        misaligned_offset = host_x86_JNZ_long(block);
+    }
+    host_x86_CMP64_REG_IMM(block, REG_RSI, (uint32_t) -1);
+    miss_offset = host_x86_JZ_long(block);
+    if (size == 1)
+        host_x86_MOVZX_BASE_INDEX_32_8(block, REG_ECX, REG_RSI, REG_RCX);
+    else if (size == 2)
+        host_x86_MOVZX_BASE_INDEX_32_16(block, REG_ECX, REG_RSI, REG_RCX);
+    else
+        host_x86_MOV32_REG_BASE_INDEX(block, REG_ECX, REG_RSI, REG_RCX);
+    if (codegen_mem_stats) {
+        host_x86_MOV64_REG_IMM(block, REG_RDI, (uint64_t) (uintptr_t) &codegen_mem_hits);
+        host_x86_INC64_BASE(block, REG_RDI);
+    }
+    done_offset = host_x86_JMP_long(block);
+
+    *miss_offset = (uint32_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) miss_offset) - 4;
+    if (size != 1)
+        *misaligned_offset = (uint32_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) misaligned_offset) - 4;
+    host_x86_MOV32_REG_REG(block, REG_ESI, REG_ECX);
+    if (size == 1)
+        host_x86_CALL(block, codegen_mem_load_byte);
+    else if (size == 2)
+        host_x86_CALL(block, codegen_mem_load_word);
+    else
+        host_x86_CALL(block, codegen_mem_load_long);
+    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
+    host_x86_JNZ(block, codegen_exit_rout);
+
+    *done_offset = (uint32_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) done_offset) - 4;
+}
+
+/*As codegen_mem_load_inline(), for stores.
+  In - ECX = data, ESI = address
+  Corrupts RSI, RDI, R8*/
+static void
+codegen_mem_store_inline(codeblock_t *block, int size)
+{
+    uint32_t *misaligned_offset = NULL;
+    uint32_t *miss_offset;
+    uint32_t *done_offset;
+
+    host_x86_MOV32_REG_REG(block, REG_EDI, REG_ESI);
+    host_x86_SHR32_IMM(block, REG_ESI, 12);
+    host_x86_MOV64_REG_IMM(block, REG_R8, (uint64_t) (uintptr_t) writelookup2);
+    host_x86_MOV64_REG_BASE_INDEX_SHIFT(block, REG_RSI, REG_R8, REG_RSI, 3);
+    if (size != 1) {
+        host_x86_TEST32_REG_IMM(block, REG_EDI, size - 1);
+        misaligned_offset = host_x86_JNZ_long(block);
+    }
+    host_x86_CMP64_REG_IMM(block, REG_RSI, (uint32_t) -1);
+    miss_offset = host_x86_JZ_long(block);
+    if (size == 1)
+        host_x86_MOV8_BASE_INDEX_REG(block, REG_RSI, REG_RDI, REG_ECX);
+    else if (size == 2)
+        host_x86_MOV16_BASE_INDEX_REG(block, REG_RSI, REG_RDI, REG_ECX);
+    else
+        host_x86_MOV32_BASE_INDEX_REG(block, REG_RSI, REG_RDI, REG_ECX);
+    if (codegen_mem_stats) {
+        host_x86_MOV64_REG_IMM(block, REG_R8, (uint64_t) (uintptr_t) &codegen_mem_hits);
+        host_x86_INC64_BASE(block, REG_R8);
+    }
+    done_offset = host_x86_JMP_long(block);
+
+    *miss_offset = (uint32_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) miss_offset) - 4;
+    if (size != 1)
+        *misaligned_offset = (uint32_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) misaligned_offset) - 4;
+    host_x86_MOV32_REG_REG(block, REG_ESI, REG_EDI);
+    if (size == 1)
+        host_x86_CALL(block, codegen_mem_store_byte);
+    else if (size == 2)
+        host_x86_CALL(block, codegen_mem_store_word);
+    else
+        host_x86_CALL(block, codegen_mem_store_long);
+    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
+    host_x86_JNZ(block, codegen_exit_rout);
+
+    *done_offset = (uint32_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) done_offset) - 4;
+}
+
 static int
 codegen_MEM_LOAD_ABS(codeblock_t *block, uop_t *uop)
 {
@@ -972,25 +1070,19 @@ codegen_MEM_LOAD_ABS(codeblock_t *block, uop_t *uop)
 
     host_x86_LEA_REG_IMM(block, REG_ESI, seg_reg, uop->imm_data);
     if (REG_IS_B(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_byte);
+        codegen_mem_load_inline(block, 1);
+        host_x86_MOV8_REG_REG(block, dest_reg, REG_ECX);
     } else if (REG_IS_W(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_word);
+        codegen_mem_load_inline(block, 2);
+        host_x86_MOV16_REG_REG(block, dest_reg, REG_ECX);
     } else if (REG_IS_L(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_long);
+        codegen_mem_load_inline(block, 4);
+        host_x86_MOV32_REG_REG(block, dest_reg, REG_ECX);
     }
 #    ifdef RECOMPILER_DEBUG
     else
         fatal("MEM_LOAD_ABS - %02x\n", uop->dest_reg_a_real);
 #    endif
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
-    if (REG_IS_B(dest_size)) {
-        host_x86_MOV8_REG_REG(block, dest_reg, REG_ECX);
-    } else if (REG_IS_W(dest_size)) {
-        host_x86_MOV16_REG_REG(block, dest_reg, REG_ECX);
-    } else if (REG_IS_L(dest_size)) {
-        host_x86_MOV32_REG_REG(block, dest_reg, REG_ECX);
-    }
 
     return 0;
 }
@@ -1010,29 +1102,24 @@ codegen_MEM_LOAD_REG(codeblock_t *block, uop_t *uop)
         }
     }
     if (REG_IS_B(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_byte);
+        codegen_mem_load_inline(block, 1);
+        host_x86_MOV8_REG_REG(block, dest_reg, REG_ECX);
     } else if (REG_IS_W(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_word);
+        codegen_mem_load_inline(block, 2);
+        host_x86_MOV16_REG_REG(block, dest_reg, REG_ECX);
     } else if (REG_IS_L(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_long);
+        codegen_mem_load_inline(block, 4);
+        host_x86_MOV32_REG_REG(block, dest_reg, REG_ECX);
     } else if (REG_IS_Q(dest_size)) {
         host_x86_CALL(block, codegen_mem_load_quad);
+        host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
+        host_x86_JNZ(block, codegen_exit_rout);
+        host_x86_MOVQ_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
     }
 #    ifdef RECOMPILER_DEBUG
     else
         fatal("MEM_LOAD_REG - %02x\n", uop->dest_reg_a_real);
 #    endif
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
-    if (REG_IS_B(dest_size)) {
-        host_x86_MOV8_REG_REG(block, dest_reg, REG_ECX);
-    } else if (REG_IS_W(dest_size)) {
-        host_x86_MOV16_REG_REG(block, dest_reg, REG_ECX);
-    } else if (REG_IS_L(dest_size)) {
-        host_x86_MOV32_REG_REG(block, dest_reg, REG_ECX);
-    } else if (REG_IS_Q(dest_size)) {
-        host_x86_MOVQ_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
-    }
 
     return 0;
 }
@@ -1091,20 +1178,18 @@ codegen_MEM_STORE_ABS(codeblock_t *block, uop_t *uop)
     host_x86_LEA_REG_IMM(block, REG_ESI, seg_reg, uop->imm_data);
     if (REG_IS_B(src_size)) {
         host_x86_MOV8_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_byte);
+        codegen_mem_store_inline(block, 1);
     } else if (REG_IS_W(src_size)) {
         host_x86_MOV16_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_word);
+        codegen_mem_store_inline(block, 2);
     } else if (REG_IS_L(src_size)) {
         host_x86_MOV32_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_long);
+        codegen_mem_store_inline(block, 4);
     }
 #    ifdef RECOMPILER_DEBUG
     else
         fatal("MEM_STORE_ABS - %02x\n", uop->src_reg_b_real);
 #    endif
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
 
     return 0;
 }
@@ -1117,9 +1202,7 @@ codegen_MEM_STORE_IMM_8(codeblock_t *block, uop_t *uop)
 
     host_x86_LEA_REG_REG(block, REG_ESI, seg_reg, addr_reg);
     host_x86_MOV8_REG_IMM(block, REG_ECX, uop->imm_data);
-    host_x86_CALL(block, codegen_mem_store_byte);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_store_inline(block, 1);
 
     return 0;
 }
@@ -1131,9 +1214,7 @@ codegen_MEM_STORE_IMM_16(codeblock_t *block, uop_t *uop)
 
     host_x86_LEA_REG_REG(block, REG_ESI, seg_reg, addr_reg);
     host_x86_MOV16_REG_IMM(block, REG_ECX, uop->imm_data);
-    host_x86_CALL(block, codegen_mem_store_word);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_store_inline(block, 2);
 
     return 0;
 }
@@ -1145,9 +1226,7 @@ codegen_MEM_STORE_IMM_32(codeblock_t *block, uop_t *uop)
 
     host_x86_LEA_REG_REG(block, REG_ESI, seg_reg, addr_reg);
     host_x86_MOV32_REG_IMM(block, REG_ECX, uop->imm_data);
-    host_x86_CALL(block, codegen_mem_store_long);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_store_inline(block, 4);
 
     return 0;
 }
@@ -1165,23 +1244,23 @@ codegen_MEM_STORE_REG(codeblock_t *block, uop_t *uop)
         host_x86_ADD32_REG_IMM(block, REG_ESI, uop->imm_data);
     if (REG_IS_B(src_size)) {
         host_x86_MOV8_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_byte);
+        codegen_mem_store_inline(block, 1);
     } else if (REG_IS_W(src_size)) {
         host_x86_MOV16_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_word);
+        codegen_mem_store_inline(block, 2);
     } else if (REG_IS_L(src_size)) {
         host_x86_MOV32_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_long);
+        codegen_mem_store_inline(block, 4);
     } else if (REG_IS_Q(src_size)) {
         host_x86_MOVQ_XREG_XREG(block, REG_XMM_TEMP, src_reg);
         host_x86_CALL(block, codegen_mem_store_quad);
+        host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
+        host_x86_JNZ(block, codegen_exit_rout);
     }
 #    ifdef RECOMPILER_DEBUG
     else
         fatal("MEM_STORE_REG - %02x\n", uop->src_reg_b_real);
 #    endif
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
 
     return 0;
 }
@@ -21,6 +21,7 @@
 #include "codegen_accumulate.h"
 #include "codegen_allocator.h"
 #include "codegen_backend.h"
+#include "codegen_cache.h"
 #include "codegen_ir.h"
 #include "codegen_reg.h"
 
@@ -45,6 +46,12 @@ int        block_pos;
 
 uint32_t codegen_endpc;
 
+uint16_t codegen_succ_prev = BLOCK_INVALID;
+
+int      codegen_mem_stats  = 0;
+uint64_t codegen_mem_hits   = 0;
+uint64_t codegen_mem_misses = 0;
+
 int        codegen_block_cycles;
 static int codegen_block_ins;
 static int codegen_block_full_ins;
@@ -61,6 +68,16 @@ static uint16_t block_free_list;
 static void     delete_block(codeblock_t *block);
 static void     delete_dirty_block(codeblock_t *block);
 
+/*Drop the successor hint of a block that is going away. Hints pointing at it
+  are left alone, as they are rechecked against CS:PC before being used.*/
+static void
+block_drop_succ(codeblock_t *block)
+{
+    block->succ_hint = BLOCK_INVALID;
+    if (codegen_succ_prev == get_block_nr(block))
+        codegen_succ_prev = BLOCK_INVALID;
+}
+
 /*Temporary list of code blocks that have recently been evicted. This allows for
   some historical state to be kept when a block is the target of self-modifying
   code.
@@ -249,6 +266,7 @@ codegen_reset(void)
     memset(codeblock, 0, BLOCK_SIZE * sizeof(codeblock_t));
     memset(codeblock_hash, 0, HASH_SIZE * sizeof(uint16_t));
     mem_reset_page_blocks();
+    codegen_succ_prev = BLOCK_INVALID;
 
     block_free_list = 0;
     for (c = 0; c < BLOCK_SIZE; c++) {
@@ -377,6 +395,7 @@ invalidate_block(codeblock_t *block)
     if (!block->valid)
         fatal("Invalidating deleted block\n");
 #endif
+    block_drop_succ(block);
     remove_from_block_list(block, old_pc);
     block_dirty_list_add(block);
     if (block->head_mem_block)
@@ -398,6 +417,7 @@ delete_block(codeblock_t *block)
 #endif
     block->valid = 0;
 
+    block_drop_succ(block);
     codeblock_tree_delete(block);
     if (block->flags & CODEBLOCK_IN_DIRTY_LIST)
         block_dirty_list_remove(block);
@@ -421,6 +441,7 @@ delete_dirty_block(codeblock_t *block)
 #endif
     block->valid = 0;
 
+    block_drop_succ(block);
     codeblock_tree_delete(block);
     block_free_list_add(block);
 }
@@ -539,6 +560,7 @@ codegen_block_init(uint32_t phys_addr)
     block->page_mask = block->page_mask2 = 0;
     block->flags                         = CODEBLOCK_STATIC_TOP;
     block->status                        = cpu_cur_status;
+    block->succ_hint                     = BLOCK_INVALID;
 
     recomp_page = block->phys & ~0xfff;
     codeblock_tree_add(block);
@@ -778,7 +800,7 @@ codegen_block_end_recompile(codeblock_t *block)
 
     if (block->flags & CODEBLOCK_IN_DIRTY_LIST)
         block_dirty_list_remove(block);
-    else
+    else if (block->prev || (pages[block->phys >> 12].block == get_block_nr(block)))
         remove_from_block_list(block, block->pc);
     block->next = block->prev = BLOCK_INVALID;
     block->next_2 = block->prev_2 = BLOCK_INVALID;
@@ -790,6 +812,9 @@ codegen_block_end_recompile(codeblock_t *block)
 
     codegen_accumulate_flush(ir_data);
     codegen_ir_compile(ir_data, block);
+
+    if (dynarec_cache)
+        codegen_cache_add(block);
 }
 
 void
@@ -0,0 +1,325 @@
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/mem.h>
+#include <86box/path.h>
+#include <86box/plat.h>
+
+#include "codegen.h"
+#include "codegen_cache.h"
+
+#define CODEGEN_CACHE_FILE    "dynarec.cache"
+#define CODEGEN_CACHE_MAGIC   0x43594438 /* "8DYC" */
+#define CODEGEN_CACHE_VERSION 2
+
+/*Entries are stored in an open-addressed hash table, which is never allowed to
+  fill past 3/4 of its size*/
+#define CODEGEN_CACHE_SIZE      65536
+#define CODEGEN_CACHE_MASK      (CODEGEN_CACHE_SIZE - 1)
+#define CODEGEN_CACHE_MAX_ITEMS ((CODEGEN_CACHE_SIZE * 3) / 4)
+
+#define CODEGEN_CACHE_USED 1
+
+typedef struct codegen_cache_header_t {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t cpu_key;
+    uint32_t nr_entries;
+    uint32_t pad;
+} codegen_cache_header_t;
+
+typedef struct codegen_cache_entry_t {
+    uint32_t phys;
+    uint32_t pc;
+    uint32_t cs_base;
+    uint32_t status;
+    uint64_t page_hash;
+    uint64_t code_mask;
+    uint32_t flags;
+    uint32_t pad;
+} codegen_cache_entry_t;
+
+static codegen_cache_entry_t *codegen_cache;
+static int                    codegen_cache_items;
+static int                    codegen_cache_loaded;
+static int                    codegen_cache_dirty;
+
+int codegen_cache_hits;
+int codegen_cache_misses;
+
+#ifdef ENABLE_CODEGEN_CACHE_LOG
+int codegen_cache_do_log = ENABLE_CODEGEN_CACHE_LOG;
+
+static void
+codegen_cache_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (codegen_cache_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define codegen_cache_log(fmt, ...)
+#endif
+
+static uint64_t
+codegen_cache_hash_bytes(uint64_t hash, const uint8_t *data, size_t len)
+{
+    /*FNV-1a*/
+    for (size_t c = 0; c < len; c++) {
+        hash ^= data[c];
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+static uint64_t
+codegen_cache_cpu_key(void)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+
+    hash = codegen_cache_hash_bytes(hash, (const uint8_t *) cpu_s->name, strlen(cpu_s->name));
+    hash = codegen_cache_hash_bytes(hash, (const uint8_t *) &cpu_s->cpu_type, sizeof(cpu_s->cpu_type));
+    hash = codegen_cache_hash_bytes(hash, (const uint8_t *) &fpu_type, sizeof(fpu_type));
+
+    return hash;
+}
+
+/*Mask of the 64 byte chunks of the first page covered by the block that was
+  just recompiled, in the same form as the mask the marking pass builds*/
+static uint64_t
+codegen_cache_code_mask(const codeblock_t *block)
+{
+    uint32_t start_pc = (block->pc & 0xfff) >> PAGE_MASK_SHIFT;
+    uint32_t end_pc;
+    uint64_t mask = 0;
+
+    if ((block->pc ^ codegen_endpc) & ~0xfff)
+        end_pc = 0xfff >> PAGE_MASK_SHIFT;
+    else
+        end_pc = (codegen_endpc & 0xfff) >> PAGE_MASK_SHIFT;
+    if (end_pc < start_pc)
+        end_pc = 0xfff >> PAGE_MASK_SHIFT;
+
+    for (; start_pc <= end_pc; start_pc++)
+        mask |= ((uint64_t) 1 << start_pc);
+
+    return mask;
+}
+
+/*Hashes only the chunks of the page that hold the block's code, so a lookup
+  costs about as much as the block is long rather than a full 4 kB. Returns 0
+  if the page is not backed by RAM, as its contents can not be hashed cheaply*/
+static int
+codegen_cache_page_hash(uint32_t phys_addr, uint64_t code_mask, uint64_t *hash)
+{
+    const page_t   *page = &pages[phys_addr >> 12];
+    const uint64_t *data;
+    uint64_t        h = 0xcbf29ce484222325ULL;
+
+    if ((page->mem == NULL) || (page->mem == page_ff))
+        return 0;
+
+    /*Hash a word at a time, the page is always 4 kB aligned in host memory*/
+    data = (const uint64_t *) page->mem;
+    for (int c = 0; c < 64; c++) {
+        if (!(code_mask & ((uint64_t) 1 << c)))
+            continue;
+
+        for (int d = 0; d < 8; d++) {
+            h ^= data[(c * 8) + d];
+            h *= 0x100000001b3ULL;
+        }
+    }
+
+    *hash = h;
+    return 1;
+}
+
+static __inline uint32_t
+codegen_cache_index(uint32_t phys, uint32_t pc, uint32_t cs_base)
+{
+    uint32_t h = phys * 0x9e3779b1;
+
+    h ^= (pc + (cs_base >> 4)) * 0x85ebca6b;
+    return (h ^ (h >> 16)) & CODEGEN_CACHE_MASK;
+}
+
+static codegen_cache_entry_t *
+codegen_cache_find(uint32_t phys, uint32_t pc, uint32_t cs_base, uint32_t status, int create)
+{
+    uint32_t idx = codegen_cache_index(phys, pc, cs_base);
+
+    while (codegen_cache[idx].flags & CODEGEN_CACHE_USED) {
+        codegen_cache_entry_t *entry = &codegen_cache[idx];
+
+        if ((entry->phys == phys) && (entry->pc == pc) && (entry->cs_base == cs_base) && (entry->status == status))
+            return entry;
+
+        idx = (idx + 1) & CODEGEN_CACHE_MASK;
+    }
+
+    if (!create || (codegen_cache_items >= CODEGEN_CACHE_MAX_ITEMS))
+        return NULL;
+
+    codegen_cache[idx].phys    = phys;
+    codegen_cache[idx].pc      = pc;
+    codegen_cache[idx].cs_base = cs_base;
+    codegen_cache[idx].status  = status;
+    codegen_cache[idx].flags   = CODEGEN_CACHE_USED;
+    codegen_cache_items++;
+
+    return &codegen_cache[idx];
+}
+
+void
+codegen_cache_load(void)
+{
+    codegen_cache_header_t header;
+    codegen_cache_entry_t  entry;
+    char                   fn[1024];
+    FILE                  *fp;
+
+    codegen_cache_loaded = 1;
+    codegen_cache_dirty  = 0;
+    codegen_cache_items  = 0;
+    codegen_cache_hits   = 0;
+    codegen_cache_misses = 0;
+
+    if (codegen_cache == NULL)
+        codegen_cache = calloc(CODEGEN_CACHE_SIZE, sizeof(codegen_cache_entry_t));
+    else
+        memset(codegen_cache, 0x00, CODEGEN_CACHE_SIZE * sizeof(codegen_cache_entry_t));
+
+    path_append_filename(fn, usr_path, CODEGEN_CACHE_FILE);
+    fp = plat_fopen(fn, "rb");
+    if (fp == NULL)
+        return;
+
+    if ((fread(&header, 1, sizeof(header), fp) != sizeof(header)) || (header.magic != CODEGEN_CACHE_MAGIC) ||
+        (header.version != CODEGEN_CACHE_VERSION) || (header.cpu_key != codegen_cache_cpu_key())) {
+        codegen_cache_log("codegen_cache_load(): Discarding stale cache %s\n", fn);
+        fclose(fp);
+        return;
+    }
+
+    for (uint32_t c = 0; c < header.nr_entries; c++) {
+        codegen_cache_entry_t *new_entry;
+
+        if (fread(&entry, 1, sizeof(entry), fp) != sizeof(entry))
+            break;
+
+        new_entry = codegen_cache_find(entry.phys, entry.pc, entry.cs_base, entry.status, 1);
+        if (new_entry == NULL)
+            break;
+        new_entry->page_hash = entry.page_hash;
+        new_entry->code_mask = entry.code_mask;
+    }
+
+    fclose(fp);
+
+    codegen_cache_log("codegen_cache_load(): %i entries loaded from %s\n", codegen_cache_items, fn);
+}
+
+void
+codegen_cache_save(void)
+{
+    codegen_cache_header_t header;
+    char                   fn[1024];
+    FILE                  *fp;
+
+    if (!codegen_cache_loaded || !codegen_cache_dirty)
+        return;
+
+    path_append_filename(fn, usr_path, CODEGEN_CACHE_FILE);
+    fp = plat_fopen(fn, "wb");
+    if (fp == NULL)
+        return;
+
+    memset(&header, 0x00, sizeof(header));
+    header.magic      = CODEGEN_CACHE_MAGIC;
+    header.version    = CODEGEN_CACHE_VERSION;
+    header.cpu_key    = codegen_cache_cpu_key();
+    header.nr_entries = codegen_cache_items;
+    fwrite(&header, 1, sizeof(header), fp);
+
+    for (int c = 0; c < CODEGEN_CACHE_SIZE; c++) {
+        if (codegen_cache[c].flags & CODEGEN_CACHE_USED)
+            fwrite(&codegen_cache[c], 1, sizeof(codegen_cache_entry_t), fp);
+    }
+
+    fclose(fp);
+
+    codegen_cache_dirty = 0;
+
+    codegen_cache_log("codegen_cache_save(): %i entries saved, %i hits, %i misses\n",
+                      codegen_cache_items, codegen_cache_hits, codegen_cache_misses);
+}
+
+void
+codegen_cache_close(void)
+{
+    codegen_cache_save();
+
+    free(codegen_cache);
+    codegen_cache        = NULL;
+    codegen_cache_items  = 0;
+    codegen_cache_loaded = 0;
+}
+
+int
+codegen_cache_lookup(uint32_t phys_addr)
+{
+    const codegen_cache_entry_t *entry;
+    uint64_t                     hash;
+
+    if (!codegen_cache_loaded)
+        codegen_cache_load();
+
+    if (!codegen_cache_items || (codegen_cache == NULL))
+        return 0;
+
+    entry = codegen_cache_find(phys_addr, cs + cpu_state.pc, cs, cpu_cur_status, 0);
+    if (entry == NULL)
+        return 0;
+
+    if (!codegen_cache_page_hash(phys_addr, entry->code_mask, &hash) || (hash != entry->page_hash)) {
+        codegen_cache_misses++;
+        return 0;
+    }
+
+    codegen_cache_hits++;
+    return 1;
+}
+
+void
+codegen_cache_add(codeblock_t *block)
+{
+    codegen_cache_entry_t *entry;
+    uint64_t               code_mask;
+    uint64_t               hash;
+
+    if (!codegen_cache_loaded)
+        codegen_cache_load();
+
+    code_mask = codegen_cache_code_mask(block);
+    if ((codegen_cache == NULL) || !codegen_cache_page_hash(block->phys, code_mask, &hash))
+        return;
+
+    entry = codegen_cache_find(block->phys, block->pc, block->_cs, block->status, 1);
+    if ((entry != NULL) && ((entry->page_hash != hash) || (entry->code_mask != code_mask))) {
+        entry->page_hash    = hash;
+        entry->code_mask    = code_mask;
+        codegen_cache_dirty = 1;
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef _CODEGEN_CACHE_H_
+#define _CODEGEN_CACHE_H_
+
+/*The warm-start cache remembers which code blocks were recompiled during a
+  previous session, so that they can be recompiled the first time they are
+  executed instead of going through the marking pass first.
+
+  Host code is not stored - generated code embeds absolute pointers to
+  cpu_state, the helper functions and the allocator arena, none of which are
+  stable between runs. An entry is only a hint: it is keyed on the physical
+  address, linear PC, CS base and CPU status of the block, and is only honoured
+  if a hash of the 64 byte chunks of the page holding the block still matches. The code is always
+  translated from guest memory as it is at that point, so a stale entry can
+  only cost an unnecessary recompile, never incorrect execution.
+
+  The cache is stored per machine in the VM directory, and is discarded if the
+  CPU model or FPU type changes.*/
+
+extern void codegen_cache_load(void);
+extern void codegen_cache_save(void);
+/*Save the cache and drop it from memory, it is loaded again on first use*/
+extern void codegen_cache_close(void);
+
+/*Returns 1 if the block about to be executed at phys_addr was recompiled in a
+  previous session and its page contents are unchanged*/
+extern int  codegen_cache_lookup(uint32_t phys_addr);
+/*Record a freshly recompiled block*/
+extern void codegen_cache_add(codeblock_t *block);
+
+extern int codegen_cache_hits;
+extern int codegen_cache_misses;
+
+#endif
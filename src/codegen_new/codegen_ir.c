@@ -85,6 +85,8 @@ codegen_ir_compile(ir_data_t *ir, codeblock_t *block)
     }
 
     codegen_reg_mark_as_required();
+    if (dynarec_ir_passes & CODEGEN_IR_PASS_CONST_FOLD)
+        codegen_ir_fold_constants(ir);
     codegen_reg_process_dead_list(ir);
     block_write_data = codeblock_allocator_get_ptr(block->head_mem_block);
     block_pos        = 0;
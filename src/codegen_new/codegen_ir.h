@@ -4,3 +4,8 @@ ir_data_t *codegen_ir_init(void);
 
 void codegen_ir_set_unroll(int count, int start, int first_instruction);
 void codegen_ir_compile(ir_data_t *ir, codeblock_t *block);
+
+/*Optional optimization passes, as enabled by the dynarec_ir_passes mask*/
+#define CODEGEN_IR_PASS_CONST_FOLD (1 << 0)
+
+int codegen_ir_fold_constants(ir_data_t *ir);
@@ -0,0 +1,256 @@
+#include <stdint.h>
+#include <string.h>
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/mem.h>
+#include <86box/plat_unused.h>
+
+#include "codegen.h"
+#include "codegen_ir.h"
+#include "codegen_reg.h"
+
+/*Constant folding and propagation.
+
+  Walks the uOP list once, after unrolling and before dead register removal. A
+  register version written by UOP_MOV_IMM is a known constant, so uOPs that
+  read it are rewritten to use the immediate form, or to a UOP_MOV_IMM of the
+  result when all their sources are known. The reads that go away drop the
+  refcount of the constant, which then goes on the dead list as usual.
+
+  Register versions are not a true SSA form - a barrier may change any
+  emulated register in memory without creating a new version, and a jump may
+  skip the uOP that wrote a version. So a constant is only used within the
+  same region, regions being split at every barrier and jump destination.
+
+  Only 32-bit accesses to 32-bit registers are handled, partial registers
+  depend on the previous version and are left alone.*/
+
+static uint16_t uop_region[UOP_NR_MAX];
+static uint8_t  uop_is_jump_dest[UOP_NR_MAX];
+
+static int
+reg_is_long(ir_reg_t ir_reg)
+{
+    return !ir_reg_is_invalid(ir_reg) && (IREG_GET_SIZE(ir_reg.reg) == IREG_SIZE_L) && reg_is_native_size(ir_reg);
+}
+
+static int
+reg_get_const(ir_data_t *ir, ir_reg_t ir_reg, int uop_nr, uint32_t *val)
+{
+    const reg_version_t *regv;
+    const uop_t         *parent;
+
+    if (!reg_is_long(ir_reg) || !ir_reg.version)
+        return 0;
+
+    regv = &reg_version[IREG_GET_REG(ir_reg.reg)][ir_reg.version];
+    if ((regv->flags & REG_FLAGS_DEAD) || (regv->parent_uop >= uop_nr))
+        return 0;
+
+    parent = &ir->uops[regv->parent_uop];
+    if (((parent->type & UOP_MASK) != (UOP_MOV_IMM & UOP_MASK)) || (parent->dest_reg_a.reg != ir_reg.reg) || (parent->dest_reg_a.version != ir_reg.version))
+        return 0;
+    if (uop_region[regv->parent_uop] != uop_region[uop_nr])
+        return 0;
+
+    *val = (uint32_t) parent->imm_data;
+    return 1;
+}
+
+/*Drop one read of a register version, queueing it for removal if that was the
+  last one and nothing else needs it.*/
+static void
+reg_release(ir_data_t *ir, ir_reg_t ir_reg)
+{
+    int            reg  = IREG_GET_REG(ir_reg.reg);
+    reg_version_t *regv = &reg_version[reg][ir_reg.version];
+
+    regv->refcount--;
+    if (regv->refcount || (regv->flags & (REG_FLAGS_REQUIRED | REG_FLAGS_DEAD)) || (reg <= IREG_EBX))
+        return;
+
+    /*A partial write of the next version still reads this one*/
+    if ((ir_reg.version < reg_last_version[reg]) && !reg_is_native_size(ir->uops[reg_version[reg][ir_reg.version + 1].parent_uop].dest_reg_a))
+        return;
+
+    add_to_dead_list(regv, reg, ir_reg.version);
+}
+
+static void
+uop_to_mov_imm(ir_data_t *ir, uop_t *uop, uint32_t val)
+{
+    if (!ir_reg_is_invalid(uop->src_reg_a))
+        reg_release(ir, uop->src_reg_a);
+    if (!ir_reg_is_invalid(uop->src_reg_b))
+        reg_release(ir, uop->src_reg_b);
+
+    uop->type      = UOP_MOV_IMM;
+    uop->src_reg_a = invalid_ir_reg;
+    uop->src_reg_b = invalid_ir_reg;
+    uop->imm_data  = val;
+}
+
+static void
+uop_to_imm(ir_data_t *ir, uop_t *uop, uint32_t type, ir_reg_t src, ir_reg_t const_reg, uint32_t val)
+{
+    reg_release(ir, const_reg);
+
+    uop->type      = type;
+    uop->src_reg_a = src;
+    uop->src_reg_b = invalid_ir_reg;
+    uop->imm_data  = val;
+}
+
+static int
+fold_alu(uint32_t type, uint32_t a, uint32_t b, uint32_t *res)
+{
+    switch (type & UOP_MASK) {
+        case (UOP_ADD & UOP_MASK):
+        case (UOP_ADD_IMM & UOP_MASK):
+            *res = a + b;
+            return 1;
+        case (UOP_SUB & UOP_MASK):
+        case (UOP_SUB_IMM & UOP_MASK):
+            *res = a - b;
+            return 1;
+        case (UOP_AND & UOP_MASK):
+        case (UOP_AND_IMM & UOP_MASK):
+            *res = a & b;
+            return 1;
+        case (UOP_OR & UOP_MASK):
+        case (UOP_OR_IMM & UOP_MASK):
+            *res = a | b;
+            return 1;
+        case (UOP_XOR & UOP_MASK):
+        case (UOP_XOR_IMM & UOP_MASK):
+            *res = a ^ b;
+            return 1;
+        case (UOP_SHL_IMM & UOP_MASK):
+            *res = a << b;
+            return (b < 32);
+        case (UOP_SHR_IMM & UOP_MASK):
+            *res = a >> b;
+            return (b < 32);
+        case (UOP_SAR_IMM & UOP_MASK):
+            *res = (uint32_t) ((int32_t) a >> b);
+            return (b < 32);
+
+        default:
+            return 0;
+    }
+}
+
+/*Immediate form of a two register uOP, or 0 if there is none.*/
+static uint32_t
+alu_imm_type(uint32_t type)
+{
+    switch (type & UOP_MASK) {
+        case (UOP_ADD & UOP_MASK):
+            return UOP_ADD_IMM;
+        case (UOP_SUB & UOP_MASK):
+            return UOP_SUB_IMM;
+        case (UOP_AND & UOP_MASK):
+            return UOP_AND_IMM;
+        case (UOP_OR & UOP_MASK):
+            return UOP_OR_IMM;
+        case (UOP_XOR & UOP_MASK):
+            return UOP_XOR_IMM;
+
+        default:
+            return 0;
+    }
+}
+
+int
+codegen_ir_fold_constants(ir_data_t *ir)
+{
+    int      folded = 0;
+    uint16_t region = 0;
+    int      c;
+
+    memset(uop_is_jump_dest, 0, ir->wr_pos);
+    for (c = 0; c < ir->wr_pos; c++) {
+        const uop_t *uop = &ir->uops[c];
+
+        if ((uop->type & UOP_TYPE_JUMP) && (uop->jump_dest_uop >= 0) && (uop->jump_dest_uop < ir->wr_pos))
+            uop_is_jump_dest[uop->jump_dest_uop] = 1;
+    }
+    for (c = 0; c < ir->wr_pos; c++) {
+        if (uop_is_jump_dest[c] || (ir->uops[c].type & UOP_TYPE_BARRIER))
+            region++;
+        uop_region[c] = region;
+    }
+
+    for (c = 0; c < ir->wr_pos; c++) {
+        uop_t   *uop = &ir->uops[c];
+        uint32_t type;
+        uint32_t imm_type;
+        uint32_t a;
+        uint32_t b;
+        uint32_t res;
+        int      a_const;
+        int      b_const;
+
+        if ((uop->type & UOP_MASK) == UOP_INVALID)
+            continue;
+        if (!(uop->type & UOP_TYPE_PARAMS_REGS) || !reg_is_long(uop->dest_reg_a))
+            continue;
+        if ((uop->type & (UOP_TYPE_BARRIER | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_JUMP)) || !ir_reg_is_invalid(uop->src_reg_c))
+            continue;
+
+        type = uop->type;
+
+        switch (type & UOP_MASK) {
+            case (UOP_MOV & UOP_MASK):
+                if (reg_get_const(ir, uop->src_reg_a, c, &a)) {
+                    uop_to_mov_imm(ir, uop, a);
+                    folded++;
+                }
+                break;
+
+            case (UOP_ADD_IMM & UOP_MASK):
+            case (UOP_SUB_IMM & UOP_MASK):
+            case (UOP_AND_IMM & UOP_MASK):
+            case (UOP_OR_IMM & UOP_MASK):
+            case (UOP_XOR_IMM & UOP_MASK):
+            case (UOP_SHL_IMM & UOP_MASK):
+            case (UOP_SHR_IMM & UOP_MASK):
+            case (UOP_SAR_IMM & UOP_MASK):
+                if (reg_get_const(ir, uop->src_reg_a, c, &a) && fold_alu(type, a, (uint32_t) uop->imm_data, &res)) {
+                    uop_to_mov_imm(ir, uop, res);
+                    folded++;
+                }
+                break;
+
+            case (UOP_ADD & UOP_MASK):
+            case (UOP_SUB & UOP_MASK):
+            case (UOP_AND & UOP_MASK):
+            case (UOP_OR & UOP_MASK):
+            case (UOP_XOR & UOP_MASK):
+                if (!reg_is_long(uop->src_reg_a) || !reg_is_long(uop->src_reg_b))
+                    break;
+
+                a_const  = reg_get_const(ir, uop->src_reg_a, c, &a);
+                b_const  = reg_get_const(ir, uop->src_reg_b, c, &b);
+                imm_type = alu_imm_type(type);
+
+                if (a_const && b_const) {
+                    fold_alu(type, a, b, &res);
+                    uop_to_mov_imm(ir, uop, res);
+                    folded++;
+                } else if (b_const) {
+                    uop_to_imm(ir, uop, imm_type, uop->src_reg_a, uop->src_reg_b, b);
+                    folded++;
+                } else if (a_const && ((type & UOP_MASK) != (UOP_SUB & UOP_MASK))) {
+                    uop_to_imm(ir, uop, imm_type, uop->src_reg_b, uop->src_reg_a, a);
+                    folded++;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return folded;
+}
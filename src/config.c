@@ -156,6 +156,11 @@ load_global_emulator(void)
     vmm_disabled = ini_section_get_int(cat, "vmm_disabled", 0);
 
     chd_precache_level = ini_section_get_int(cat, "chd_precache_level", 0);
+    chd_cache_hunks    = ini_section_get_int(cat, "chd_cache_hunks", 32);
+
+    hdd_image_cache_size = ini_section_get_int(cat, "hdd_image_cache_size", 32);
+    if (hdd_image_cache_size < 0)
+        hdd_image_cache_size = 0;
 
     p = ini_section_get_string(cat, "vmm_path", NULL);
     if (p != NULL) {
@@ -602,6 +607,11 @@ load_machine(void)
         mem_size = machine_get_max_ram(machine);
 
     cpu_use_dynarec = !!ini_section_get_int(cat, "cpu_use_dynarec", 0);
+    dynarec_cache   = !!ini_section_get_int(cat, "dynarec_cache", 0);
+    dynarec_ir_passes = ini_section_get_int(cat, "dynarec_ir_passes", -1);
+    dynarec_compile_budget = ini_section_get_int(cat, "dynarec_compile_budget", 32);
+    if (dynarec_compile_budget < 0)
+        dynarec_compile_budget = 0;
     fpu_softfloat = !!ini_section_get_int(cat, "fpu_softfloat", 0);
     if ((fpu_type != FPU_NONE) && machine_has_flags(machine, MACHINE_SOFTFLOAT_ONLY))
         fpu_softfloat = 1;
@@ -620,6 +630,10 @@ load_machine(void)
         time_sync = TIME_SYNC_ENABLED;
 
     pit_mode = ini_section_get_int(cat, "pit_mode", -1);
+
+    timer_sched = ini_section_get_int(cat, "timer_scheduler", TIMER_SCHED_LIST);
+    if ((timer_sched < TIMER_SCHED_LIST) || (timer_sched > TIMER_SCHED_HEAP))
+        timer_sched = TIMER_SCHED_LIST;
 }
 
 /* Load "Video" section. */
@@ -729,6 +743,10 @@ load_video(void)
     vid_cga_comp_hue        = ini_section_get_int(cat, "vid_cga_comp_hue", 0);
     vid_cga_comp_saturation = ini_section_get_int(cat, "vid_cga_comp_saturation", 100);
 
+    svga_render_threads = ini_section_get_int(cat, "svga_render_threads", 0);
+    if (svga_render_threads < 0)
+        svga_render_threads = 0;
+
     // TODO
     for (uint8_t i = 1; i < GFXCARD_MAX; i ++) {
         p = ini_section_get_string(cat, "gfxcard_2", NULL);
@@ -973,6 +991,7 @@ load_sound(void)
     } else {
         fm_driver = FM_DRV_NUKED;
     }
+    fm_thread = !!ini_section_get_int(cat, "fm_thread", 0);
 
     p = ini_section_get_string(cat, "sound_output_device", "");
     strncpy(sound_output_device, p, sizeof(sound_output_device) - 1);
@@ -1123,6 +1142,9 @@ load_network(void)
         p = ini_section_get_string(cat, temp, NULL);
         strncpy(nc->nrs_hostname, p ? p : "", sizeof(nc->nrs_hostname) - 1);
 
+        sprintf(temp, "net_%02i_queue_depth", c + 1);
+        nc->queue_depth = ini_section_get_int(cat, temp, NET_QUEUE_DEPTH_DEF);
+
         sprintf(temp, "net_%02i_link", c + 1);
         nc->link_state = ini_section_get_int(cat, temp,
                                              (NET_LINK_10_HD | NET_LINK_10_FD |
@@ -1744,6 +1766,10 @@ load_hard_disks(void)
         p = ini_section_get_string(cat, temp, "");
         strncpy(hdd[c].vhd_parent, p, sizeof(hdd[c].vhd_parent) - 1);
 
+        sprintf(temp, "hdd_%02i_base_fn", c + 1);
+        p = ini_section_get_string(cat, temp, "");
+        strncpy(hdd[c].base_fn, p, sizeof(hdd[c].base_fn) - 1);
+
         /* Raw device flag - when set, path is treated as block device */
         sprintf(temp, "hdd_%02i_raw_device", c + 1);
         hdd[c].raw_device = ini_section_get_int(cat, temp, 0) ? 1 : 0;
@@ -2881,6 +2907,16 @@ save_global_emulator(void)
     else
         ini_section_delete_var(cat, "chd_precache_level");
 
+    if (chd_cache_hunks != 32)
+        ini_section_set_int(cat, "chd_cache_hunks", chd_cache_hunks);
+    else
+        ini_section_delete_var(cat, "chd_cache_hunks");
+
+    if (hdd_image_cache_size != 32)
+        ini_section_set_int(cat, "hdd_image_cache_size", hdd_image_cache_size);
+    else
+        ini_section_delete_var(cat, "hdd_image_cache_size");
+
     if (vmm_disabled != 0)
         ini_section_set_int(cat, "vmm_disabled", vmm_disabled);
     else
@@ -3229,6 +3265,21 @@ save_machine(void)
 
     ini_section_set_int(cat, "cpu_use_dynarec", cpu_use_dynarec);
 
+    if (dynarec_cache == 0)
+        ini_section_delete_var(cat, "dynarec_cache");
+    else
+        ini_section_set_int(cat, "dynarec_cache", dynarec_cache);
+
+    if (dynarec_ir_passes == -1)
+        ini_section_delete_var(cat, "dynarec_ir_passes");
+    else
+        ini_section_set_int(cat, "dynarec_ir_passes", dynarec_ir_passes);
+
+    if (dynarec_compile_budget == 32)
+        ini_section_delete_var(cat, "dynarec_compile_budget");
+    else
+        ini_section_set_int(cat, "dynarec_compile_budget", dynarec_compile_budget);
+
     if (fpu_softfloat == 0)
         ini_section_delete_var(cat, "fpu_softfloat");
     else
@@ -3247,6 +3298,11 @@ save_machine(void)
     else
         ini_section_set_int(cat, "pit_mode", pit_mode);
 
+    if (timer_sched == TIMER_SCHED_LIST)
+        ini_section_delete_var(cat, "timer_scheduler");
+    else
+        ini_section_set_int(cat, "timer_scheduler", timer_sched);
+
     ini_delete_section_if_empty(config, cat);
 }
 
@@ -3294,6 +3350,11 @@ save_video(void)
     else
         ini_section_delete_var(cat, "vid_cga_comp_saturation");
 
+    if (svga_render_threads)
+        ini_section_set_int(cat, "svga_render_threads", svga_render_threads);
+    else
+        ini_section_delete_var(cat, "svga_render_threads");
+
     if (voodoo_enabled == 0)
         ini_section_delete_var(cat, "voodoo");
     else
@@ -3493,6 +3554,11 @@ save_sound(void)
     else
         ini_section_set_string(cat, "fm_driver", "ymfm");
 
+    if (fm_thread)
+        ini_section_set_int(cat, "fm_thread", fm_thread);
+    else
+        ini_section_delete_var(cat, "fm_thread");
+
     if (sound_output_device[0] == '\0')
         ini_section_delete_var(cat, "sound_output_device");
     else
@@ -3596,6 +3662,12 @@ save_network(void)
             ini_section_delete_var(cat, temp);
         else
             ini_section_set_string(cat, temp, net_cards_conf[c].nrs_hostname);
+
+        sprintf(temp, "net_%02i_queue_depth", c + 1);
+        if (nc->queue_depth == NET_QUEUE_DEPTH_DEF)
+            ini_section_delete_var(cat, temp);
+        else
+            ini_section_set_int(cat, temp, nc->queue_depth);
     }
 
     ini_delete_section_if_empty(config, cat);
@@ -4105,6 +4177,13 @@ save_hard_disks(void)
         } else
             ini_section_delete_var(cat, temp);
 
+        sprintf(temp, "hdd_%02i_base_fn", c + 1);
+        if (hdd_is_valid(c) && hdd[c].base_fn[0]) {
+            path_normalize(hdd[c].base_fn);
+            ini_section_set_string(cat, temp, hdd[c].base_fn);
+        } else
+            ini_section_delete_var(cat, temp);
+
         sprintf(temp, "hdd_%02i_raw_device", c + 1);
         if (hdd_is_valid(c) && hdd[c].raw_device)
             ini_section_set_int(cat, temp, 1);
@@ -300,6 +300,7 @@ exec386_2386(int32_t cycs)
                     in_lock = 1;
                 x86_2386_opcodes[(opcode | cpu_state.op32) & 0x3ff](fetchdat);
                 in_lock = 0;
+                cpu_ins_count++;
                 if (x86_was_reset)
                     break;
             }
@@ -36,6 +36,7 @@
 #    include "codegen.h"
 #    ifdef USE_NEW_DYNAREC
 #        include "codegen_backend.h"
+#        include "codegen_cache.h"
 #    endif
 #endif
 
@@ -256,6 +257,27 @@ int32_t         cycles_main = 0;
 static int32_t  cycles_old  = 0;
 static uint64_t tsc_old     = 0;
 
+/* Block statistics, for benchmarking. */
+uint64_t codegen_blocks_marked   = 0;
+uint64_t codegen_blocks_compiled = 0;
+uint64_t codegen_block_hits      = 0;
+uint64_t codegen_block_misses    = 0;
+#    ifdef USE_NEW_DYNAREC
+uint64_t codegen_succ_cache_hits   = 0;
+uint64_t codegen_succ_cache_misses = 0;
+uint64_t codegen_blocks_deferred   = 0;
+
+/* Blocks that may still be recompiled in this timeslice, once it runs out
+   hot blocks are interpreted until the next one. */
+static int codegen_recompile_budget = 0;
+
+/* An exception or interrupt is not the usual successor of the block it
+   interrupted, so don't let it replace the cached successor. */
+#        define SUCC_CACHE_RESET() codegen_succ_prev = BLOCK_INVALID
+#    else
+#        define SUCC_CACHE_RESET()
+#    endif
+
 #    ifdef USE_ACYCS
 int32_t acycs = 0;
 #    endif
@@ -360,6 +382,7 @@ exec386_dynarec_int(void)
             cpu_state.eflags &= ~(RF_FLAG);
 #    endif
             x86_opcodes[(opcode | cpu_state.op32) & 0x3ff](fetchdat);
+            cpu_ins_count++;
         }
 
 #    ifndef USE_NEW_DYNAREC
@@ -429,7 +452,28 @@ exec386_dynarec_dyn(void)
     uint32_t phys_addr = get_phys(cs + cpu_state.pc);
     int      hash      = HASH(phys_addr);
 #    ifdef USE_NEW_DYNAREC
-    codeblock_t *block = &codeblock[codeblock_hash[hash]];
+    codeblock_t *block      = NULL;
+    int          succ_hit   = 0;
+    int          warm_block = 0;
+
+    /* Successor lookup cache: try the block that followed the previous one
+       last time before going through the hash and the page tree. This only
+       saves the lookup, the block is still entered from here. */
+    if ((codegen_succ_prev != BLOCK_INVALID) && !cpu_state.abrt) {
+        uint16_t next = codeblock[codegen_succ_prev].succ_hint;
+
+        if (next != BLOCK_INVALID) {
+            codeblock_t *next_block = &codeblock[next];
+
+            /* Hints pointing at a block are not cleared when it is deleted,
+               so the target may since have been freed or reused. */
+            succ_hit = next_block->valid && !(next_block->flags & CODEBLOCK_IN_FREE_LIST) && (next_block->pc == cs + cpu_state.pc) && (next_block->_cs == cs) && (next_block->phys == phys_addr) && !((next_block->status ^ cpu_cur_status) & CPU_STATUS_FLAGS) && ((next_block->status & cpu_cur_status & CPU_STATUS_MASK) == (cpu_cur_status & CPU_STATUS_MASK));
+            if (succ_hit)
+                block = next_block;
+        }
+    }
+    if (!succ_hit)
+        block = &codeblock[codeblock_hash[hash]];
 #    else
     codeblock_t *block = codeblock_hash[hash];
 #    endif
@@ -446,7 +490,11 @@ exec386_dynarec_dyn(void)
         /* Block must match current CS, PC, code segment size,
            and physical address. The physical address check will
            also catch any page faults at this stage */
+#    ifdef USE_NEW_DYNAREC
+        valid_block = succ_hit || ((block->pc == cs + cpu_state.pc) && (block->_cs == cs) && (block->phys == phys_addr) && !((block->status ^ cpu_cur_status) & CPU_STATUS_FLAGS) && ((block->status & cpu_cur_status & CPU_STATUS_MASK) == (cpu_cur_status & CPU_STATUS_MASK)));
+#    else
         valid_block = (block->pc == cs + cpu_state.pc) && (block->_cs == cs) && (block->phys == phys_addr) && !((block->status ^ cpu_cur_status) & CPU_STATUS_FLAGS) && ((block->status & cpu_cur_status & CPU_STATUS_MASK) == (cpu_cur_status & CPU_STATUS_MASK));
+#    endif
         if (!valid_block) {
             uint64_t mask = (uint64_t) 1 << ((phys_addr >> PAGE_MASK_SHIFT) & PAGE_MASK_MASK);
 #    ifdef USE_NEW_DYNAREC
@@ -589,6 +637,16 @@ exec386_dynarec_dyn(void)
     }
 
 #    ifdef USE_NEW_DYNAREC
+    /* A block that was recompiled in a previous session, and whose page has
+       not changed since, is recompiled straight away instead of being marked
+       first. */
+    if (!valid_block && !cpu_state.abrt && dynarec_cache && codegen_cache_lookup(phys_addr)) {
+        codegen_block_init(phys_addr);
+        block       = &codeblock[block_current];
+        valid_block = 1;
+        warm_block  = 1;
+    }
+
     if (valid_block && (block->flags & CODEBLOCK_WAS_RECOMPILED))
 #    else
     if (valid_block && block->was_recompiled)
@@ -596,9 +654,20 @@ exec386_dynarec_dyn(void)
     {
         void (*code)(void) = (void *) &block->data[BLOCK_START];
 
-#    ifndef USE_NEW_DYNAREC
+#    ifdef USE_NEW_DYNAREC
+        if (succ_hit)
+            codegen_succ_cache_hits++;
+        else {
+            codegen_succ_cache_misses++;
+            if (codegen_succ_prev != BLOCK_INVALID)
+                codeblock[codegen_succ_prev].succ_hint = get_block_nr(block);
+        }
+        codegen_succ_prev = get_block_nr(block);
+#    else
         codeblock_hash[hash] = block;
 #    endif
+        codegen_block_hits++;
+        cpu_ins_count += block->ins;
         inrecomp = 1;
         code();
 #    ifdef USE_ACYCS
@@ -610,8 +679,20 @@ exec386_dynarec_dyn(void)
         if (!use32)
             cpu_state.pc &= 0xffff;
 #    endif
-    } else if (valid_block && !cpu_state.abrt) {
+    }
+#    ifdef USE_NEW_DYNAREC
+    else if (valid_block && !cpu_state.abrt && !warm_block && dynarec_compile_budget && (codegen_recompile_budget <= 0)) {
+        /* Spread bursts of recompilation over several timeslices - leave
+           the block marked and interpret it for now. */
+        SUCC_CACHE_RESET();
+        codegen_blocks_deferred++;
+        exec386_dynarec_int();
+    }
+#    endif
+    else if (valid_block && !cpu_state.abrt) {
+        SUCC_CACHE_RESET();
 #    ifdef USE_NEW_DYNAREC
+        codegen_recompile_budget--;
         start_pc                 = cs + cpu_state.pc;
         const int max_block_size = (block->flags & CODEBLOCK_BYTE_MASK) ? ((128 - 25) - (start_pc & 0x3f)) : 1000;
 #    else
@@ -628,6 +709,7 @@ exec386_dynarec_dyn(void)
 #    endif
         codegen_block_start_recompile(block);
         codegen_in_recompile = 1;
+        codegen_block_misses++;
 
         while (!cpu_block_end) {
             oldcs  = CS;
@@ -653,6 +735,7 @@ exec386_dynarec_dyn(void)
                 codegen_generate_call(opcode, x86_opcodes[(opcode | cpu_state.op32) & 0x3ff], fetchdat, cpu_state.pc, cpu_state.pc - 1);
 
                 x86_opcodes[(opcode | cpu_state.op32) & 0x3ff](fetchdat);
+                cpu_ins_count++;
 
                 if (x86_was_reset)
                     break;
@@ -703,8 +786,10 @@ exec386_dynarec_dyn(void)
 
         cpu_end_block_after_ins = 0;
 
-        if ((!cpu_state.abrt || (cpu_state.abrt & ABRT_EXPECTED)) && !new_ne && !x86_was_reset)
+        if ((!cpu_state.abrt || (cpu_state.abrt & ABRT_EXPECTED)) && !new_ne && !x86_was_reset) {
             codegen_block_end_recompile(block);
+            codegen_blocks_compiled++;
+        }
 
         if (x86_was_reset)
             codegen_reset();
@@ -717,6 +802,7 @@ exec386_dynarec_dyn(void)
 #    endif
     } else if (!cpu_state.abrt) {
         /* Mark block but do not recompile */
+        SUCC_CACHE_RESET();
 #    ifdef USE_NEW_DYNAREC
         start_pc                 = cs + cpu_state.pc;
         const int max_block_size = (block->flags & CODEBLOCK_BYTE_MASK) ? ((128 - 25) - (start_pc & 0x3f)) : 1000;
@@ -728,6 +814,8 @@ exec386_dynarec_dyn(void)
         x86_was_reset = 0;
 
         codegen_block_init(phys_addr);
+        codegen_blocks_marked++;
+        codegen_block_misses++;
 
         while (!cpu_block_end) {
             oldcs  = CS;
@@ -753,6 +841,7 @@ exec386_dynarec_dyn(void)
                 cpu_state.pc++;
 
                 x86_opcodes[(opcode | cpu_state.op32) & 0x3ff](fetchdat);
+                cpu_ins_count++;
 
                 if (x86_was_reset)
                     break;
@@ -810,8 +899,10 @@ exec386_dynarec_dyn(void)
             codegen_reset();
     }
 #    ifdef USE_NEW_DYNAREC
-    else
+    else {
+        SUCC_CACHE_RESET();
         cpu_state.oldpc = cpu_state.pc;
+    }
 #    endif
 
 }
@@ -829,6 +920,10 @@ exec386_dynarec(int32_t cycs)
 
     int32_t cyc_period = cycs / (force_10ms ? 2000 : 200); /*5us*/
 
+#    ifdef USE_NEW_DYNAREC
+    codegen_recompile_budget = dynarec_compile_budget * (force_10ms ? 10 : 1);
+#    endif
+
 #    ifdef USE_ACYCS
     acycs = 0;
 #    endif
@@ -854,6 +949,7 @@ exec386_dynarec(int32_t cycs)
             tsc_old          = tsc;
             if (cpu_force_interpreter || cpu_override_dynarec ||  (!CACHE_ON())) /*Interpret block*/
             {
+                SUCC_CACHE_RESET();
                 exec386_dynarec_int();
             } else {
                 exec386_dynarec_dyn();
@@ -865,6 +961,7 @@ exec386_dynarec(int32_t cycs)
             }
 
             if (cpu_state.abrt) {
+                SUCC_CACHE_RESET();
                 flags_rebuild();
                 tempi          = cpu_state.abrt & ABRT_MASK;
                 cpu_state.abrt = 0;
@@ -888,15 +985,18 @@ exec386_dynarec(int32_t cycs)
             }
 
             if (new_ne) {
+                SUCC_CACHE_RESET();
                 oldcs = CS;
                 cpu_state.oldpc = cpu_state.pc;
                 new_ne = 0;
                 x86_int(16);
             }
 
-            if (smi_line)
+            if (smi_line) {
+                SUCC_CACHE_RESET();
                 enter_smm_check(0);
-            else if (nmi && nmi_enable && nmi_mask) {
+            } else if (nmi && nmi_enable && nmi_mask) {
+                SUCC_CACHE_RESET();
                 oldcs = CS;
                 cpu_state.oldpc = cpu_state.pc;
                 x86_int(2);
@@ -912,6 +1012,7 @@ exec386_dynarec(int32_t cycs)
             } else if ((cpu_state.flags & I_FLAG) && pic.int_pending) {
                 vector = picinterrupt();
                 if (vector != -1) {
+                    SUCC_CACHE_RESET();
                     oldcs = CS;
                     cpu_state.oldpc = cpu_state.pc;
                     x86_int(vector);
@@ -1027,6 +1128,7 @@ exec386(int32_t cycs)
                 cpu_state.eflags &= ~(RF_FLAG);
 #endif
                 x86_opcodes[(opcode | cpu_state.op32) & 0x3ff](fetchdat);
+                cpu_ins_count++;
                 if (x86_was_reset)
                     break;
             }
@@ -51,6 +51,23 @@
 
 extern void codegen_init(void);
 extern void codegen_flush(void);
+#ifdef USE_NEW_DYNAREC
+extern void codegen_cache_close(void);
+#endif
+
+/* Block statistics, for benchmarking. */
+extern uint64_t codegen_blocks_marked;
+extern uint64_t codegen_blocks_compiled;
+extern uint64_t codegen_block_hits;
+extern uint64_t codegen_block_misses;
+#ifdef USE_NEW_DYNAREC
+extern uint64_t codegen_succ_cache_hits;
+extern uint64_t codegen_succ_cache_misses;
+extern uint64_t codegen_blocks_deferred;
+extern int      codegen_mem_stats;
+extern uint64_t codegen_mem_hits;
+extern uint64_t codegen_mem_misses;
+#endif
 
 /*Current physical page of block being recompiled. -1 if no recompilation taking place */
 extern uint32_t recomp_page;
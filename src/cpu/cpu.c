@@ -41,6 +41,7 @@
 #include <86box/pic.h>
 #include <86box/pci.h>
 #include <86box/smram.h>
+#include <86box/snapshot.h>
 #include <86box/timer.h>
 #include <86box/gdbstub.h>
 #include <86box/plat_fallthrough.h>
@@ -280,6 +281,7 @@ uint8_t  _cache[2048];
 
 uint64_t cpu_CR4_mask;
 uint64_t tsc = 0;
+uint64_t cpu_ins_count = 0;
 
 double cpu_dmulti;
 double cpu_busspeed;
@@ -4565,3 +4567,79 @@ cpu_update_waitstates(void)
             cpu_rom_prefetch_cycles = cpu_mem_prefetch_cycles;
     }
 }
+
+void
+cpu_save_state(snapshot_t *snap)
+{
+    snapshot_write_var(snap, cpu_state);
+    snapshot_write_var(snap, cpu_cur_status);
+    snapshot_write_var(snap, cr2);
+    snapshot_write_var(snap, cr3);
+    snapshot_write_var(snap, cr4);
+    snapshot_write_var(snap, dr);
+    snapshot_write_var(snap, msr);
+    snapshot_write_var(snap, amd_efer);
+    snapshot_write_var(snap, star);
+    snapshot_write_var(snap, gdt);
+    snapshot_write_var(snap, ldt);
+    snapshot_write_var(snap, idt);
+    snapshot_write_var(snap, tr);
+    snapshot_write_var(snap, use32);
+    snapshot_write_var(snap, stack32);
+    snapshot_write_var(snap, smi_latched);
+    snapshot_write_var(snap, smm_in_hlt);
+    snapshot_write_var(snap, nmi);
+    snapshot_write_var(snap, nmi_mask);
+    snapshot_write_var(snap, ccr0);
+    snapshot_write_var(snap, ccr1);
+    snapshot_write_var(snap, ccr2);
+    snapshot_write_var(snap, ccr3);
+    snapshot_write_var(snap, ccr4);
+    snapshot_write_var(snap, ccr5);
+    snapshot_write_var(snap, ccr6);
+    snapshot_write_var(snap, ccr7);
+    snapshot_write_var(snap, fpu_state);
+}
+
+void
+cpu_load_state(snapshot_t *snap)
+{
+    snapshot_read_var(snap, cpu_state);
+    snapshot_read_var(snap, cpu_cur_status);
+    snapshot_read_var(snap, cr2);
+    snapshot_read_var(snap, cr3);
+    snapshot_read_var(snap, cr4);
+    snapshot_read_var(snap, dr);
+    snapshot_read_var(snap, msr);
+    snapshot_read_var(snap, amd_efer);
+    snapshot_read_var(snap, star);
+    snapshot_read_var(snap, gdt);
+    snapshot_read_var(snap, ldt);
+    snapshot_read_var(snap, idt);
+    snapshot_read_var(snap, tr);
+    snapshot_read_var(snap, use32);
+    snapshot_read_var(snap, stack32);
+    snapshot_read_var(snap, smi_latched);
+    snapshot_read_var(snap, smm_in_hlt);
+    snapshot_read_var(snap, nmi);
+    snapshot_read_var(snap, nmi_mask);
+    snapshot_read_var(snap, ccr0);
+    snapshot_read_var(snap, ccr1);
+    snapshot_read_var(snap, ccr2);
+    snapshot_read_var(snap, ccr3);
+    snapshot_read_var(snap, ccr4);
+    snapshot_read_var(snap, ccr5);
+    snapshot_read_var(snap, ccr6);
+    snapshot_read_var(snap, ccr7);
+    snapshot_read_var(snap, fpu_state);
+
+    /* The state is always saved at an instruction boundary. */
+    cpu_state.ea_seg = &cpu_state.seg_ds;
+    cpu_state.abrt   = 0;
+
+    /* Paging may have changed, and any translated code is stale. */
+    flushmmucache();
+#ifdef USE_DYNAREC
+    codegen_reset();
+#endif
+}
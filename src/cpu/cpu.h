@@ -558,6 +558,7 @@ extern uint32_t cpu_cur_status;
 #endif
 extern uint64_t cpu_CR4_mask;
 extern uint64_t tsc;
+extern uint64_t cpu_ins_count; /* instructions executed, for benchmarking */
 extern msr_t    msr;
 extern uint8_t  opcode;
 extern int      cpl_override;
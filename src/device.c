@@ -53,6 +53,7 @@
 #include <86box/mem.h>
 #include <86box/plat.h>
 #include <86box/rom.h>
+#include <86box/snapshot.h>
 #include <86box/sound.h>
 #include <86box/ui.h>
 
@@ -928,6 +929,107 @@ device_force_redraw(void)
     }
 }
 
+/* Returns how many devices of the same type precede device slot c. */
+static int
+device_get_index(int c)
+{
+    int index = 0;
+
+    for (int i = 0; i < c; i++) {
+        if (devices[i] == devices[c])
+            index++;
+    }
+
+    return index;
+}
+
+/* Returns how many devices the machine has, or -1 if one of them can not be
+   saved and restored. */
+int
+device_state_supported(void)
+{
+    int count = 0;
+
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if (devices[c] == NULL)
+            continue;
+
+        /* Chunks are stored under the internal name of their device. */
+        if ((devices[c]->internal_name == NULL) || (devices[c]->save_state == NULL) ||
+            (devices[c]->load_state == NULL)) {
+            pclog("DEVICE: device '%s' has no save state support\n", devices[c]->name);
+            return -1;
+        }
+
+        count++;
+    }
+
+    return count;
+}
+
+void
+device_save_state_all(snapshot_t *snap)
+{
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if ((devices[c] == NULL) || (devices[c]->internal_name == NULL) || (devices[c]->save_state == NULL))
+            continue;
+
+        snapshot_begin_chunk(snap, devices[c]->internal_name, device_get_index(c), devices[c]->state_version);
+        devices[c]->save_state(device_priv[c], snap);
+        snapshot_end_chunk(snap);
+    }
+}
+
+static int
+device_find_state(const char *internal_name, int index)
+{
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if ((devices[c] == NULL) || (devices[c]->internal_name == NULL) ||
+            (devices[c]->load_state == NULL) || strcmp(devices[c]->internal_name, internal_name))
+            continue;
+
+        if (device_get_index(c) == index)
+            return c;
+    }
+
+    return -1;
+}
+
+/* Returns 1 if a chunk of the given version and size can be loaded into the
+   device, -1 if the device state has changed since, or 0 if there is no such
+   device. The size is what the device would write now. */
+int
+device_check_state(const char *internal_name, int index, uint32_t version, uint64_t size)
+{
+    int c = device_find_state(internal_name, index);
+
+    if (c < 0)
+        return 0;
+
+    if ((version != devices[c]->state_version) ||
+        (size != snapshot_state_size(devices[c]->save_state, device_priv[c]))) {
+        device_log("DEVICE: state of device '%s' does not match (version %u, %" PRIu64 " bytes)\n",
+                   devices[c]->name, version, size);
+        return -1;
+    }
+
+    return 1;
+}
+
+int
+device_load_state(const char *internal_name, int index, uint32_t version, uint64_t size, snapshot_t *snap)
+{
+    int ret = device_check_state(internal_name, index, version, size);
+
+    if (ret > 0) {
+        int c = device_find_state(internal_name, index);
+
+        devices[c]->load_state(device_priv[c], snap);
+    }
+
+    return ret;
+}
+
 int
 device_get_instance(void)
 {
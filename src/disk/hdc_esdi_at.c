@@ -37,8 +37,10 @@
 #include <86box/ui.h>
 #include <86box/hdc.h>
 #include <86box/hdd.h>
+#include <86box/hdd_aio.h>
 
 #define HDC_TIME            10.0
+#define AIO_TIME            10.0 /* How often to check on the image. */
 #define BIOS_FILE           "roms/hdd/esdi_at/62-000279-061.bin"
 
 #define STAT_ERR            0x01
@@ -98,6 +100,10 @@ typedef struct esdi_t {
 
     pc_timer_t callback_timer;
 
+    /* Image access of the current sector, the buffer is off limits while
+       it is running. */
+    hdd_aio_req_t aio;
+
     drive_t drives[2];
 
     rom_t bios_rom;
@@ -161,6 +167,21 @@ esdi_set_callback(esdi_t *esdi, double callback)
         timer_on_auto(&esdi->callback_timer, callback);
 }
 
+/* Start the image access on the first call, and push the callback back for as
+   long as it runs, so that the host I/O does not stall the emulation. Returns
+   non-zero while the access has not finished yet. */
+static int
+esdi_aio_pending(esdi_t *esdi, int op, const drive_t *drive, off64_t addr, int count, int *ret)
+{
+    if (hdd_aio_poll(&esdi->aio, op, drive->hdd_num, (uint32_t) addr, count,
+                     (op == HDD_AIO_ZERO) ? NULL : (uint8_t *) esdi->buffer, ret)) {
+        esdi_set_callback(esdi, AIO_TIME);
+        return 1;
+    }
+
+    return 0;
+}
+
 double
 esdi_get_xfer_time(UNUSED(esdi_t *esdi), int size)
 {
@@ -336,6 +357,9 @@ esdi_write(uint16_t port, uint8_t val, void *priv)
             return;
 
         case 0x1f7: /* command register */
+            /* A command issued while the image is still busy aborts the old one. */
+            (void) hdd_aio_finish(&esdi->aio);
+
             irq_lower(esdi);
             esdi->command = val;
             esdi->error   = 0;
@@ -580,8 +604,11 @@ esdi_callback(void *priv)
     drive_t *drive = &esdi->drives[esdi->drive_sel];
     off64_t  addr;
     double   seek_time;
+    int      ret;
 
     if (esdi->reset) {
+        (void) hdd_aio_finish(&esdi->aio);
+
         esdi->status   = STAT_READY | STAT_DSC;
         esdi->error    = 1;
         esdi->secount  = 1;
@@ -634,7 +661,9 @@ read_error:
                     break;
                 }
 
-                if (hdd_image_read(drive->hdd_num, addr, 1, (uint8_t *) esdi->buffer) < 0) {
+                if (esdi_aio_pending(esdi, HDD_AIO_READ, drive, addr, 1, &ret))
+                    return;
+                if (ret < 0) {
                     esdi->error = ERR_BAD_BLOCK;
                     goto read_error;
                 }
@@ -661,7 +690,9 @@ write_error:
                     break;
                 }
 
-                if (hdd_image_write(drive->hdd_num, addr, 1, (uint8_t *) esdi->buffer) < 0) {
+                if (esdi_aio_pending(esdi, HDD_AIO_WRITE, drive, addr, 1, &ret))
+                    return;
+                if (ret < 0) {
                     esdi->error = ERR_BAD_BLOCK;
                     goto write_error;
                 }
@@ -696,7 +727,9 @@ verify_error:
                     break;
                 }
 
-                if (hdd_image_read(drive->hdd_num, addr, 1, (uint8_t *) esdi->buffer) < 0) {
+                if (esdi_aio_pending(esdi, HDD_AIO_READ, drive, addr, 1, &ret))
+                    return;
+                if (ret < 0) {
                     esdi->error = ERR_BAD_BLOCK;
                     goto verify_error;
                 }
@@ -732,7 +765,9 @@ format_error:
                     break;
                 }
 
-                if (hdd_image_zero(drive->hdd_num, addr, esdi->secount) < 0) {
+                if (esdi_aio_pending(esdi, HDD_AIO_ZERO, drive, addr, esdi->secount, &ret))
+                    return;
+                if (ret < 0) {
                     esdi->error = ERR_BAD_BLOCK;
                     goto format_error;
                 }
@@ -971,6 +1006,8 @@ wd1007vse1_close(void *priv)
     esdi_t        *esdi = (esdi_t *) priv;
     const drive_t *drive;
 
+    (void) hdd_aio_finish(&esdi->aio);
+
     for (uint8_t d = 0; d < 2; d++) {
         drive = &esdi->drives[d];
 
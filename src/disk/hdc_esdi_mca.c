@@ -79,6 +79,7 @@
 #include <86box/ui.h>
 #include <86box/hdc.h>
 #include <86box/hdd.h>
+#include <86box/hdd_aio.h>
 #include <86box/plat_unused.h>
 
 /* These are hardwired. */
@@ -90,6 +91,7 @@
 #define BIOS_FILE_H     "roms/hdd/esdi/90x8970.bin"
 
 #define ESDI_TIME       500.0
+#define AIO_TIME        10.0 /* How often to check on the image. */
 #define CMD_ADAPTER     0
 
 typedef struct esdi_drive_t {
@@ -136,6 +138,10 @@ typedef struct esdi_t {
     int        in_reset;
     pc_timer_t timer;
 
+    /* Image access of the current sector, the buffer is off limits while
+       it is running. */
+    hdd_aio_req_t aio;
+
     uint32_t rba;
 
     struct cmds {
@@ -286,6 +292,21 @@ esdi_mca_set_callback(esdi_t *dev, double callback)
     }
 }
 
+/* Start the image access on the first call, and push the callback back for as
+   long as it runs, so that the host I/O does not stall the emulation. Returns
+   non-zero while the access has not finished yet. */
+static int
+esdi_aio_pending(esdi_t *dev, int op, const drive_t *drive, uint32_t rba, uint32_t count,
+                 uint8_t *buffer, double cmd_time, int *ret)
+{
+    if (hdd_aio_poll(&dev->aio, op, drive->hdd_num, rba, count, buffer, ret)) {
+        esdi_mca_set_callback(dev, AIO_TIME + cmd_time);
+        return 1;
+    }
+
+    return 0;
+}
+
 static double
 esdi_mca_get_xfer_time(UNUSED(esdi_t *esdi), int size)
 {
@@ -422,10 +443,12 @@ esdi_callback(void *priv)
     const drive_t *drive;
     int            val;
     double         cmd_time = 0.0;
+    int            ret;
 
     /* If we are returning from a RESET, handle this first. */
     if (dev->in_reset) {
         esdi_mca_log("ESDI reset.\n");
+        (void) hdd_aio_finish(&dev->aio);
         dev->in_reset   = 0;
         dev->status     = STATUS_IRQ | STATUS_TRANSFER_REQ | STATUS_STATUS_OUT_FULL;
         dev->status_len = 1; /*ToDo: better implementation for Xenix?*/
@@ -478,7 +501,10 @@ esdi_callback(void *priv)
                         if (!dev->data_pos) {
                             if (dev->rba >= drive->sectors)
                                 fatal("Read past end of drive\n");
-                            if (hdd_image_read(drive->hdd_num, dev->rba, 1, (uint8_t *) dev->data) < 0) {
+                            if (esdi_aio_pending(dev, HDD_AIO_READ, drive, dev->rba, 1,
+                                                 (uint8_t *) dev->data, cmd_time, &ret))
+                                return;
+                            if (ret < 0) {
                                 defective_block(dev);
                                 return;
                             }
@@ -570,7 +596,10 @@ esdi_callback(void *priv)
 
                         if (dev->rba >= drive->sectors)
                             fatal("Write past end of drive\n");
-                        if (hdd_image_write(drive->hdd_num, dev->rba, 1, (uint8_t *) dev->data) < 0) {
+                        if (esdi_aio_pending(dev, HDD_AIO_WRITE, drive, dev->rba, 1,
+                                             (uint8_t *) dev->data, cmd_time, &ret))
+                            return;
+                        if (ret < 0) {
                             defective_block(dev);
                             return;
                         }
@@ -1001,8 +1030,10 @@ esdi_callback(void *priv)
                         return;
                     }
 
-                    if (dev->command == CMD_FORMAT_UNIT)
-                        hdd_image_zero(drive->hdd_num, 0, hdd_image_get_last_sector(drive->hdd_num) + 1);
+                    if ((dev->command == CMD_FORMAT_UNIT) &&
+                        esdi_aio_pending(dev, HDD_AIO_ZERO, drive, 0, hdd_image_get_last_sector(drive->hdd_num) + 1,
+                                         NULL, 0.0, &ret))
+                        return;
 
                     dev->status    = STATUS_CMD_IN_PROGRESS;
                     dev->cmd_state = 2;
@@ -1220,6 +1251,8 @@ esdi_writew(uint16_t port, uint16_t val, void *priv)
 
                 if ((dev->cmd_data[0] & CMD_DEVICE_SEL) != dev->cmd_dev)
                     fatal("Command device mismatch with attn\n");
+                /* A command issued while the image is still busy aborts the old one. */
+                (void) hdd_aio_finish(&dev->aio);
                 dev->command = dev->cmd_data[0] & CMD_MASK;
                 esdi_mca_set_callback(dev, ESDI_TIME);
                 dev->status   = STATUS_BUSY;
@@ -1510,6 +1543,8 @@ esdi_close(void *priv)
 
     dev->drives[0].present = dev->drives[1].present = 0;
 
+    (void) hdd_aio_finish(&dev->aio);
+
     for (uint8_t d = 0; d < 2; d++) {
         drive = &dev->drives[d];
 
@@ -44,6 +44,7 @@
 #include <86box/hdc.h>
 #include <86box/hdc_ide.h>
 #include <86box/hdd.h>
+#include <86box/hdd_aio.h>
 #include <86box/rdisk.h>
 #include <86box/thread.h>
 #include <86box/version.h>
@@ -240,43 +241,21 @@ ide_t *ide_drives[IDE_NUM] = { 0 };
  * Host image reads are independent of guest-visible IDE state until the
  * emulated command-completion callback consumes their result.  Starting the
  * read when the command is issued lets host I/O overlap the emulated seek and
- * transfer delay without changing task-file, DMA, or IRQ ordering.
+ * transfer delay without changing task-file, DMA, or IRQ ordering.  DMA
+ * writes are handed to the same layer once the data has been transferred,
+ * and the command completes once the image has it.
  *
  * Keep this state outside ide_t: that structure is shared with controller and
- * chipset code, while the worker is an implementation detail of this module.
+ * chipset code, while the requests are an implementation detail of this module.
  */
 typedef struct ide_async_read_s {
-    ide_t    *ide;
-    thread_t *thread;
-    event_t  *request_event;
-    event_t  *complete_event;
-    volatile int running;
-    int          pending;
-    int          result;
-    uint32_t     sector;
-    uint32_t     count;
+    ide_t        *ide;
+    hdd_aio_req_t read;
+    hdd_aio_req_t write;
 } ide_async_read_t;
 
 static ide_async_read_t ide_async_reads[IDE_NUM];
 
-static void
-ide_async_read_worker(void *priv)
-{
-    ide_async_read_t *state = (ide_async_read_t *) priv;
-
-    while (state->running) {
-        thread_wait_event(state->request_event, -1);
-        thread_reset_event(state->request_event);
-
-        if (!state->running)
-            break;
-
-        state->result = hdd_image_read(state->ide->hdd_num, state->sector,
-                                       state->count, state->ide->sector_buffer);
-        thread_set_event(state->complete_event);
-    }
-}
-
 static void
 ide_async_read_init(ide_t *ide)
 {
@@ -286,15 +265,11 @@ ide_async_read_init(ide_t *ide)
         return;
 
     state = &ide_async_reads[ide->channel];
-    if (state->thread != NULL)
+    if (state->ide != NULL)
         return;
 
     memset(state, 0, sizeof(*state));
-    state->ide            = ide;
-    state->request_event  = thread_create_event();
-    state->complete_event = thread_create_event();
-    state->running        = 1;
-    state->thread         = thread_create_named(ide_async_read_worker, state, "ide-read");
+    state->ide = ide;
 }
 
 static void
@@ -306,15 +281,20 @@ ide_async_read_start(ide_t *ide, uint32_t sector, uint32_t count)
         return;
 
     state = &ide_async_reads[ide->channel];
-    if ((state->thread == NULL) || state->pending || (count == 0))
+    if ((state->ide == NULL) || (state->read.state != HDD_AIO_IDLE) || (count == 0))
         return;
 
-    state->sector  = sector;
-    state->count   = count;
-    state->result  = -1;
-    state->pending = 1;
-    thread_reset_event(state->complete_event);
-    thread_set_event(state->request_event);
+    hdd_aio_submit(&state->read, HDD_AIO_READ, ide->hdd_num, sector, count, ide->sector_buffer);
+}
+
+/* Return non-zero while a read started for the current command is still running. */
+static int
+ide_async_read_busy(ide_t *ide)
+{
+    if ((ide == NULL) || (ide->channel < 0) || (ide->channel >= IDE_NUM))
+        return 0;
+
+    return hdd_aio_busy(&ide_async_reads[ide->channel].read);
 }
 
 /* Return non-zero when an asynchronous result was consumed. */
@@ -322,27 +302,59 @@ static int
 ide_async_read_finish(ide_t *ide, int *result)
 {
     ide_async_read_t *state;
+    int               ret;
 
     if ((ide == NULL) || (ide->channel < 0) || (ide->channel >= IDE_NUM))
         return 0;
 
     state = &ide_async_reads[ide->channel];
-    if ((state->thread == NULL) || !state->pending)
+    if ((state->ide == NULL) || (state->read.state == HDD_AIO_IDLE))
         return 0;
 
-    thread_wait_event(state->complete_event, -1);
-    thread_reset_event(state->complete_event);
-    state->pending = 0;
+    ret = hdd_aio_finish(&state->read);
     if (result != NULL)
-        *result = state->result;
+        *result = ret;
 
     return 1;
 }
 
+static void
+ide_async_write_start(ide_t *ide, uint32_t sector, uint32_t count)
+{
+    ide_async_read_t *state = &ide_async_reads[ide->channel];
+
+    hdd_aio_submit(&state->write, HDD_AIO_WRITE, ide->hdd_num, sector, count, ide->sector_buffer);
+}
+
+/* Return non-zero when a DMA write was handed to the image and not collected yet. */
+static int
+ide_async_write_pending(ide_t *ide)
+{
+    if ((ide == NULL) || (ide->channel < 0) || (ide->channel >= IDE_NUM))
+        return 0;
+
+    return (ide_async_reads[ide->channel].write.state != HDD_AIO_IDLE);
+}
+
+static int
+ide_async_write_busy(ide_t *ide)
+{
+    return hdd_aio_busy(&ide_async_reads[ide->channel].write);
+}
+
+static int
+ide_async_write_finish(ide_t *ide)
+{
+    return hdd_aio_finish(&ide_async_reads[ide->channel].write);
+}
+
 static void
 ide_async_read_discard(ide_t *ide)
 {
     (void) ide_async_read_finish(ide, NULL);
+
+    if (ide_async_write_pending(ide))
+        (void) ide_async_write_finish(ide);
 }
 
 static void
@@ -354,15 +366,10 @@ ide_async_read_close(ide_t *ide)
         return;
 
     state = &ide_async_reads[ide->channel];
-    if (state->thread == NULL)
+    if (state->ide == NULL)
         return;
 
     ide_async_read_discard(ide);
-    state->running = 0;
-    thread_set_event(state->request_event);
-    thread_wait(state->thread);
-    thread_destroy_event(state->complete_event);
-    thread_destroy_event(state->request_event);
     memset(state, 0, sizeof(*state));
 }
 
@@ -372,7 +379,7 @@ ide_wait_for_async_reads(void)
     for (int channel = 0; channel < IDE_NUM; channel++) {
         ide_async_read_t *state = &ide_async_reads[channel];
 
-        if ((state->thread != NULL) && state->pending)
+        if (state->ide != NULL)
             ide_async_read_discard(state->ide);
     }
 }
@@ -2520,6 +2527,12 @@ ide_callback(void *priv)
 
     ide_log("ide_callback(%i): %02X\n", ide->channel, ide->command);
 
+    /* Do not stall the emulation on the host, check back later instead. */
+    if (ide->do_initial_read && ide_async_read_busy(ide)) {
+        ide_set_callback(ide, IDE_TIME);
+        return;
+    }
+
     switch (ide->command) {
         case WIN_SEEK ... 0x7f:
             chk_chs = !ide->tf->lba;
@@ -2765,6 +2778,21 @@ ide_callback(void *priv)
                        (ide_get_last_sector(ide) > hdd_image_get_last_sector(ide->hdd_num))) {
                 ide_log("IDE %i: DMA write aborted (SPECIFY failed)\n", ide->channel);
                 err = IDNF_ERR;
+            } else if (ide_async_write_pending(ide)) {
+                if (ide_async_write_busy(ide)) {
+                    ide_set_callback(ide, IDE_TIME);
+                    return;
+                }
+
+                ret = ide_async_write_finish(ide);
+
+                ide_log("IDE %i: DMA write %ssuccessful\n", ide->channel, (ret < 0) ? "un" : "");
+
+                ide->tf->atastat = DRDY_STAT | DSC_STAT;
+                if (ret < 0)
+                    err = UNC_ERR;
+
+                ide_irq_raise(ide);
             } else {
                 if (!ide_boards[ide->board]->force_ata3 && bm->dma) {
                     if (ide->tf->secount)
@@ -2782,16 +2810,12 @@ ide_callback(void *priv)
                     } else if (ret & 1) {
                         /* DMA successful */
                         ui_sb_update_icon_write(SB_HDD | hdd[ide->hdd_num].bus_type, 1);
-                        ret = hdd_image_write(ide->hdd_num, ide_get_sector(ide),
-                                              ide->sector_pos, ide->sector_buffer);
-
-                        ide_log("IDE %i: DMA write %ssuccessful\n", ide->channel, (ret < 0) ? "un" : "");
-
-                        ide->tf->atastat = DRDY_STAT | DSC_STAT;
-                        if (ret < 0)
-                            err = UNC_ERR;
+                        ide_async_write_start(ide, (uint32_t) ide_get_sector(ide), ide->sector_pos);
 
-                        ide_irq_raise(ide);
+                        /* The command completes once the image has the data. */
+                        ide->tf->atastat = BSY_STAT;
+                        ide_set_callback(ide, IDE_TIME);
+                        return;
                     } else {
                         /* Bus master DMA error, abort the command. */
                         ide_log("IDE %i: DMA read aborted (failed)\n", ide->channel);
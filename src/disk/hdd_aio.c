@@ -0,0 +1,331 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Asynchronous hard disk image I/O.
+ *
+ *          Requests are queued per image and carried out by a small pool
+ *          of worker threads, so that host I/O does not stall the
+ *          emulation thread. Devices submit a request when a command is
+ *          issued and collect the result from their completion callback,
+ *          pushing the callback back while the request is still busy.
+ *
+ *          Requests to one image are started in order, and a request only
+ *          starts once everything before it finished, except for reads of
+ *          raw images, which use positioned I/O and may run side by side.
+ *          Synchronous accesses through hdd_image_read() and friends wait
+ *          for the queue of the image first, so they stay ordered as well.
+ *          Idle workers also write the block cache back once the disks
+ *          have not been written to for a while.
+ *
+ *          Block devices that have their own image code, such as the
+ *          removable disks, get queues of their own, and their requests
+ *          call an I/O function of the device instead.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/thread.h>
+#include <86box/hdd.h>
+#include <86box/hdd_aio.h>
+#include <86box/plat_unused.h>
+
+#define HDD_AIO_THREADS 4
+
+typedef struct hdd_aio_queue_t {
+    hdd_aio_req_t *head;
+    hdd_aio_req_t *tail;
+    int            depth;   /* Queued and running requests. */
+    int            running; /* Requests handed to workers. */
+    int            exclusive;
+} hdd_aio_queue_t;
+
+static hdd_aio_queue_t queues[HDD_AIO_QUEUES];
+static thread_t       *workers[HDD_AIO_THREADS];
+static mutex_t        *aio_mutex;
+static event_t        *work_event;
+static event_t        *done_event;
+static volatile int    aio_running;
+
+#ifdef ENABLE_HDD_AIO_LOG
+int hdd_aio_do_log = ENABLE_HDD_AIO_LOG;
+
+static void
+hdd_aio_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (hdd_aio_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define hdd_aio_log(fmt, ...)
+#endif
+
+/* Take the next request that can start. Called with the mutex held. */
+static hdd_aio_req_t *
+hdd_aio_next(void)
+{
+    hdd_aio_queue_t *queue;
+    hdd_aio_req_t   *req;
+    int              parallel;
+
+    for (int i = 0; i < HDD_AIO_QUEUES; i++) {
+        queue = &queues[i];
+        req   = queue->head;
+
+        if ((req == NULL) || queue->exclusive)
+            continue;
+
+        parallel = (req->op == HDD_AIO_READ) && (req->io == NULL) && hdd_image_io_parallel(req->id);
+        if (!parallel && queue->running)
+            continue;
+
+        queue->head = req->next;
+        if (queue->head == NULL)
+            queue->tail = NULL;
+
+        queue->running++;
+        queue->exclusive = !parallel;
+
+        return req;
+    }
+
+    return NULL;
+}
+
+static void
+hdd_aio_worker(UNUSED(void *priv))
+{
+    hdd_aio_queue_t *queue;
+    hdd_aio_req_t   *req;
+    int              result;
+
+    while (aio_running) {
+        thread_wait_mutex(aio_mutex);
+        req = hdd_aio_next();
+        if (req == NULL)
+            thread_reset_event(work_event);
+        thread_release_mutex(aio_mutex);
+
+        if (req == NULL) {
+            if (thread_wait_event(work_event, hdd_image_cache_dirty() ? HDD_IMAGE_CACHE_IDLE_MS : -1) && aio_running)
+                hdd_image_cache_flush_idle();
+            continue;
+        }
+
+        if (req->io != NULL)
+            result = req->io(req->priv, req->op, req->sector, req->count, req->buffer);
+        else
+            result = hdd_image_io(req->id, req->op, req->sector, req->count, req->buffer);
+
+        thread_wait_mutex(aio_mutex);
+        queue = &queues[req->id];
+        queue->running--;
+        queue->depth--;
+        queue->exclusive = 0;
+        req->result      = result;
+        req->state       = HDD_AIO_DONE;
+        thread_release_mutex(aio_mutex);
+
+        /* The next request of the image may be able to start now. */
+        thread_set_event(done_event);
+        thread_set_event(work_event);
+    }
+}
+
+static void
+hdd_aio_init(void)
+{
+    memset(queues, 0, sizeof(queues));
+
+    aio_mutex   = thread_create_mutex();
+    work_event  = thread_create_event();
+    done_event  = thread_create_event();
+    aio_running = 1;
+
+    for (int i = 0; i < HDD_AIO_THREADS; i++)
+        workers[i] = thread_create_named(hdd_aio_worker, NULL, "hdd-aio");
+
+    hdd_aio_log("HDD AIO: Started %i workers\n", HDD_AIO_THREADS);
+}
+
+void
+hdd_aio_close(void)
+{
+    if (!aio_running)
+        return;
+
+    for (uint8_t i = 0; i < HDD_NUM; i++)
+        hdd_aio_drain(i);
+    for (uint8_t i = 0; i < HDD_AIO_OTHER_QUEUES; i++)
+        hdd_aio_drain_io(i);
+
+    aio_running = 0;
+    thread_set_event(work_event);
+    for (int i = 0; i < HDD_AIO_THREADS; i++) {
+        thread_wait(workers[i]);
+        workers[i] = NULL;
+    }
+
+    thread_destroy_event(done_event);
+    thread_destroy_event(work_event);
+    thread_close_mutex(aio_mutex);
+}
+
+void
+hdd_aio_kick(void)
+{
+    if (!aio_running)
+        hdd_aio_init();
+
+    thread_set_event(work_event);
+}
+
+static void
+hdd_aio_queue(hdd_aio_req_t *req)
+{
+    hdd_aio_queue_t *queue = &queues[req->id];
+
+    req->next   = NULL;
+    req->result = -1;
+    req->state  = HDD_AIO_QUEUED;
+
+    thread_wait_mutex(aio_mutex);
+    if (queue->tail != NULL)
+        queue->tail->next = req;
+    else
+        queue->head = req;
+    queue->tail = req;
+    queue->depth++;
+    thread_release_mutex(aio_mutex);
+
+    thread_set_event(work_event);
+}
+
+void
+hdd_aio_submit(hdd_aio_req_t *req, int op, uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    if (!aio_running)
+        hdd_aio_init();
+
+    req->id     = id;
+    req->op     = op;
+    req->sector = sector;
+    req->count  = count;
+    req->buffer = buffer;
+    req->io     = NULL;
+    req->priv   = NULL;
+
+    hdd_aio_queue(req);
+}
+
+void
+hdd_aio_submit_io(hdd_aio_req_t *req, int op, uint8_t queue,
+                  int (*io)(void *priv, int op, uint32_t sector, uint32_t count, uint8_t *buffer),
+                  void *priv, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    if (!aio_running)
+        hdd_aio_init();
+
+    req->id     = HDD_NUM + queue;
+    req->op     = op;
+    req->sector = sector;
+    req->count  = count;
+    req->buffer = buffer;
+    req->io     = io;
+    req->priv   = priv;
+
+    hdd_aio_queue(req);
+}
+
+int
+hdd_aio_busy(const hdd_aio_req_t *req)
+{
+    return (req->state == HDD_AIO_QUEUED);
+}
+
+int
+hdd_aio_finish(hdd_aio_req_t *req)
+{
+    if (req->state == HDD_AIO_IDLE)
+        return 0;
+
+    /* Another thread waiting at the same time can reset the event under us,
+       so do not wait for it forever. */
+    while (1) {
+        thread_reset_event(done_event);
+        if (req->state == HDD_AIO_DONE)
+            break;
+        thread_wait_event(done_event, 10);
+    }
+
+    req->state = HDD_AIO_IDLE;
+    return req->result;
+}
+
+int
+hdd_aio_poll(hdd_aio_req_t *req, int op, uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer, int *result)
+{
+    if (req->state == HDD_AIO_IDLE)
+        hdd_aio_submit(req, op, id, sector, count, buffer);
+
+    if (hdd_aio_busy(req))
+        return 1;
+
+    *result = hdd_aio_finish(req);
+    return 0;
+}
+
+static void
+hdd_aio_drain_queue(int id)
+{
+    int depth;
+
+    if (!aio_running)
+        return;
+
+    while (1) {
+        thread_reset_event(done_event);
+
+        thread_wait_mutex(aio_mutex);
+        depth = queues[id].depth;
+        thread_release_mutex(aio_mutex);
+
+        if (depth == 0)
+            break;
+        thread_wait_event(done_event, 10);
+    }
+}
+
+void
+hdd_aio_drain(uint8_t id)
+{
+    if (id < HDD_NUM)
+        hdd_aio_drain_queue(id);
+}
+
+void
+hdd_aio_drain_io(uint8_t queue)
+{
+    if (queue < HDD_AIO_OTHER_QUEUES)
+        hdd_aio_drain_queue(HDD_NUM + queue);
+}
@@ -35,8 +35,10 @@
 #include <86box/86box.h>
 #include <86box/path.h>
 #include <86box/plat.h>
+#include <86box/thread.h>
 #include <86box/random.h>
 #include <86box/hdd.h>
+#include <86box/hdd_aio.h>
 #include "minivhd/minivhd.h"
 #include "minivhd/internal.h"
 
@@ -48,6 +50,7 @@
 typedef struct hdd_image_t {
     FILE     *file; /* Used for HDD_IMAGE_RAW, HDD_IMAGE_HDI, and HDD_IMAGE_HDX. */
     MVHDMeta *vhd;  /* Used for HDD_IMAGE_VHD. */
+    hdd_overlay_t *overlay; /* Used instead of file for an overlay over a base image. */
     uint32_t  base;
     uint32_t  pos;
     uint32_t  last_sector;
@@ -59,6 +62,10 @@ typedef struct hdd_image_t {
 
 hdd_image_t hdd_images[HDD_NUM];
 
+/* Serializes access to images that are not read and written with positioned
+   I/O, see hdd_image_raw_io(). Kept out of hdd_image_t, which gets cleared. */
+static mutex_t *hdd_image_io_mutex[HDD_NUM];
+
 static char  empty_sector[512];
 #ifndef __unix__
 static char *empty_sector_1mb;
@@ -260,6 +267,84 @@ hdd_image_init(void)
         memset(&hdd_images[i], 0, sizeof(hdd_image_t));
 }
 
+/*
+ * Open an overlay over a shared base image. The base image is only read,
+ * so the geometry comes from its header, or from the configuration for a
+ * raw image, and the overlay is created to match if it does not exist.
+ */
+static int
+hdd_image_load_overlay(int id)
+{
+    FILE    *fp;
+    uint32_t base        = 0;
+    uint32_t sector_size = 512;
+    uint32_t spt         = hdd[id].spt;
+    uint32_t hpc         = hdd[id].hpc;
+    uint32_t tracks      = hdd[id].tracks;
+    uint64_t full_size;
+    int      type        = HDD_IMAGE_RAW;
+
+    path_normalize(hdd[id].base_fn);
+
+    if (image_is_vhd(hdd[id].base_fn, 0)) {
+        pclog("hdd_image_load(): Overlay: Use a differencing VHD over a VHD base image\n");
+        goto fail;
+    }
+
+    fp = plat_fopen(hdd[id].base_fn, "rb");
+    if (fp == NULL) {
+        pclog("hdd_image_load(): Overlay: Unable to open base image '%s'\n", hdd[id].base_fn);
+        goto fail;
+    }
+
+    if (image_is_hdi(hdd[id].base_fn)) {
+        if ((fseeko64(fp, 0x8, SEEK_SET) == -1) || (fread(&base, 1, 4, fp) != 4) ||
+            (fseeko64(fp, 0x10, SEEK_SET) == -1) || (fread(&sector_size, 1, 4, fp) != 4) ||
+            (fread(&spt, 1, 4, fp) != 4) || (fread(&hpc, 1, 4, fp) != 4) || (fread(&tracks, 1, 4, fp) != 4))
+            sector_size = 0;
+        type = HDD_IMAGE_HDI;
+    } else if (image_is_hdx(hdd[id].base_fn, 1)) {
+        base = 0x28;
+        if ((fseeko64(fp, 0x10, SEEK_SET) == -1) || (fread(&sector_size, 1, 4, fp) != 4) ||
+            (fread(&spt, 1, 4, fp) != 4) || (fread(&hpc, 1, 4, fp) != 4) || (fread(&tracks, 1, 4, fp) != 4))
+            sector_size = 0;
+        type = HDD_IMAGE_HDX;
+    }
+    fclose(fp);
+
+    if (sector_size != 512) {
+        pclog("hdd_image_load(): Overlay: Unsupported base image '%s'\n", hdd[id].base_fn);
+        goto fail;
+    }
+
+    full_size = ((uint64_t) spt) * ((uint64_t) hpc) * ((uint64_t) tracks) << 9LL;
+    if (full_size == 0) {
+        pclog("hdd_image_load(): Overlay: No geometry for base image '%s'\n", hdd[id].base_fn);
+        goto fail;
+    }
+
+    hdd_images[id].overlay = hdd_overlay_open(hdd[id].fn, hdd[id].base_fn, base, full_size >> 9, hdd[id].wp);
+    if (hdd_images[id].overlay == NULL)
+        goto fail;
+
+    hdd[id].spt                = spt;
+    hdd[id].hpc                = hpc;
+    hdd[id].tracks             = tracks;
+    hdd_images[id].type        = type;
+    hdd_images[id].base        = 0;
+    hdd_images[id].pos         = 0;
+    hdd_images[id].last_sector = (uint32_t) (full_size >> 9) - 1;
+    hdd_images[id].loaded      = 1;
+
+    return 1;
+
+fail:
+    /* Like a missing raw image, leave the drive without a medium. */
+    hdd_images[id].type        = HDD_IMAGE_RAW;
+    hdd_images[id].last_sector = (uint32_t) (((uint64_t) hdd[id].spt) * ((uint64_t) hdd[id].hpc) * ((uint64_t) hdd[id].tracks)) - 1;
+    return 1;
+}
+
 int
 hdd_image_load(int id)
 {
@@ -291,20 +376,33 @@ hdd_image_load(int id)
         path_normalize(fn);
     }
 
+    hdd_image_cache_init();
+    if (hdd_image_io_mutex[id] == NULL)
+        hdd_image_io_mutex[id] = thread_create_mutex();
+
     hdd_images[id].base = 0;
     hdd_images[id].is_block_device = 0;
 
     if (hdd_images[id].loaded) {
+        hdd_aio_drain(id);
+        hdd_image_cache_invalidate(id);
+
         if (hdd_images[id].file) {
             fclose(hdd_images[id].file);
             hdd_images[id].file = NULL;
         } else if (hdd_images[id].vhd) {
             mvhd_close(hdd_images[id].vhd);
             hdd_images[id].vhd = NULL;
+        } else if (hdd_images[id].overlay) {
+            hdd_overlay_close(hdd_images[id].overlay);
+            hdd_images[id].overlay = NULL;
         }
         hdd_images[id].loaded = 0;
     }
 
+    if (hdd[id].base_fn[0])
+        return hdd_image_load_overlay(id);
+
     if (hdd[id].raw_device || plat_is_block_device(fn)) {
         int64_t dev_size = plat_get_block_device_size(fn);
         if (dev_size <= 0) {
@@ -574,21 +672,24 @@ int
 hdd_image_seek(uint8_t id, uint32_t sector)
 {
     off64_t addr = sector;
+    int     ret  = 0;
     addr         = (uint64_t) sector << 9LL;
 
     hdd_images[id].pos = sector;
     if (hdd_images[id].type != HDD_IMAGE_VHD) {
+        thread_wait_mutex(hdd_image_io_mutex[id]);
         if (!hdd_images[id].file || (fseeko64(hdd_images[id].file, addr + hdd_images[id].base, SEEK_SET) == -1)) {
             hdd_image_log("hdd_image_seek(): Error seeking\n");
-            return -1;
+            ret = -1;
         }
+        thread_release_mutex(hdd_image_io_mutex[id]);
     }
 
-    return 0;
+    return ret;
 }
 
-int
-hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+static int
+hdd_image_do_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
     int    non_transferred_sectors;
     size_t num_read;
@@ -614,6 +715,14 @@ hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
     return 0;
 }
 
+int
+hdd_image_read(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_aio_drain(id);
+
+    return hdd_image_io(id, HDD_AIO_READ, sector, count, buffer);
+}
+
 uint32_t
 hdd_image_get_last_sector(uint8_t id)
 {
@@ -643,8 +752,8 @@ hdd_image_read_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
     return 0;
 }
 
-int
-hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+static int
+hdd_image_do_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
     int    non_transferred_sectors;
     size_t num_write;
@@ -671,6 +780,14 @@ hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
     return 0;
 }
 
+int
+hdd_image_write(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_aio_drain(id);
+
+    return hdd_image_io(id, HDD_AIO_WRITE, sector, count, buffer);
+}
+
 int
 hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
 {
@@ -688,8 +805,8 @@ hdd_image_write_ex(uint8_t id, uint32_t sector, uint32_t count, uint8_t *buffer)
     return 0;
 }
 
-int
-hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count)
+static int
+hdd_image_do_zero(uint8_t id, uint32_t sector, uint32_t count)
 {
     if (hdd_images[id].type == HDD_IMAGE_VHD) {
         hdd_images[id].vhd->error   = 0;
@@ -720,6 +837,107 @@ hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count)
     return 0;
 }
 
+int
+hdd_image_zero(uint8_t id, uint32_t sector, uint32_t count)
+{
+    hdd_aio_drain(id);
+
+    return hdd_image_io(id, HDD_AIO_ZERO, sector, count, NULL);
+}
+
+/*
+ * Raw, HDI and HDX images are plain files, which are read and written with
+ * positioned I/O, so several threads can access them at once. This never
+ * goes through the FILE buffer, which is only used to zero sectors and
+ * flushed right after.
+ */
+int
+hdd_image_io_parallel(uint8_t id)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    return (hdd_images[id].type != HDD_IMAGE_VHD) && (hdd_images[id].file != NULL);
+#else
+    return 0;
+#endif
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+static int
+hdd_image_pio(uint8_t id, int op, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    off64_t addr = ((off64_t) sector << 9) + hdd_images[id].base;
+    size_t  len  = (size_t) count << 9;
+    ssize_t ret;
+
+    while (len > 0) {
+        if (op == HDD_AIO_WRITE)
+            ret = pwrite(fileno(hdd_images[id].file), buffer, len, addr);
+        else
+            ret = pread(fileno(hdd_images[id].file), buffer, len, addr);
+
+        if ((ret < 0) && (errno == EINTR))
+            continue;
+        if (ret < 0) {
+            hdd_image_log("Hard disk image %i: Positioned I/O error %i\n", id, errno);
+            return -1;
+        }
+        /* Reading past the end of the file is not an error, as with fread(). */
+        if (ret == 0)
+            return (op == HDD_AIO_WRITE) ? -1 : 0;
+
+        buffer += ret;
+        addr += ret;
+        len -= ret;
+    }
+
+    hdd_images[id].pos = sector + count;
+    return 0;
+}
+#endif
+
+/*
+ * Carry out a request on the image itself, bypassing the block cache. The
+ * block cache, the AIO workers and the emulation thread may all get here
+ * for the same image at once. Positioned I/O is safe for that, but MiniVHD,
+ * overlays and stdio seek and then read or write a shared FILE, so those go
+ * through the per-image I/O mutex.
+ */
+int
+hdd_image_raw_io(uint8_t id, int op, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    int ret;
+
+#if defined(__unix__) || defined(__APPLE__)
+    if (hdd_image_io_parallel(id) && (op != HDD_AIO_ZERO))
+        return hdd_image_pio(id, op, sector, count, buffer);
+#endif
+
+    thread_wait_mutex(hdd_image_io_mutex[id]);
+
+    if (hdd_images[id].overlay != NULL)
+        ret = hdd_overlay_io(hdd_images[id].overlay, op, sector, count, buffer);
+    else if (op == HDD_AIO_READ)
+        ret = hdd_image_do_read(id, sector, count, buffer);
+    else if (op == HDD_AIO_WRITE)
+        ret = hdd_image_do_write(id, sector, count, buffer);
+    else if (op == HDD_AIO_ZERO)
+        ret = hdd_image_do_zero(id, sector, count);
+    else
+        ret = -1;
+
+    thread_release_mutex(hdd_image_io_mutex[id]);
+
+    return ret;
+}
+
+/* Carry out a request, without waiting for the queue of the asynchronous
+   I/O layer; its workers call this directly. */
+int
+hdd_image_io(uint8_t id, int op, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    return hdd_image_cache_io(id, op, sector, count, buffer);
+}
+
 int
 hdd_image_zero_ex(uint8_t id, uint32_t sector, uint32_t count)
 {
@@ -754,6 +972,9 @@ hdd_image_unload(uint8_t id, UNUSED(int fn_preserve))
     if (strlen(hdd[id].fn) == 0)
         return;
 
+    hdd_aio_drain(id);
+    hdd_image_cache_invalidate(id);
+
     if (hdd_images[id].loaded) {
         if (hdd_images[id].file != NULL) {
             fclose(hdd_images[id].file);
@@ -761,6 +982,9 @@ hdd_image_unload(uint8_t id, UNUSED(int fn_preserve))
         } else if (hdd_images[id].vhd != NULL) {
             mvhd_close(hdd_images[id].vhd);
             hdd_images[id].vhd = NULL;
+        } else if (hdd_images[id].overlay != NULL) {
+            hdd_overlay_close(hdd_images[id].overlay);
+            hdd_images[id].overlay = NULL;
         }
         hdd_images[id].loaded = 0;
     }
@@ -778,6 +1002,9 @@ hdd_image_close(uint8_t id)
     if (!hdd_images[id].loaded)
         return;
 
+    hdd_aio_drain(id);
+    hdd_image_cache_invalidate(id);
+
     if (hdd_images[id].locked_drives) {
         plat_unlock_volumes(hdd_images[id].locked_drives);
         hdd_images[id].locked_drives = NULL;
@@ -789,10 +1016,18 @@ hdd_image_close(uint8_t id)
     } else if (hdd_images[id].vhd != NULL) {
         mvhd_close(hdd_images[id].vhd);
         hdd_images[id].vhd = NULL;
+    } else if (hdd_images[id].overlay != NULL) {
+        hdd_overlay_close(hdd_images[id].overlay);
+        hdd_images[id].overlay = NULL;
     }
 
     memset(&hdd_images[id], 0, sizeof(hdd_image_t));
     hdd_images[id].loaded = 0;
+
+    if (hdd_image_io_mutex[id] != NULL) {
+        thread_close_mutex(hdd_image_io_mutex[id]);
+        hdd_image_io_mutex[id] = NULL;
+    }
 }
 
 void
@@ -801,9 +1036,13 @@ hdd_image_sync(uint8_t id)
     if (!hdd_images[id].loaded)
         return;
 
+    hdd_aio_drain(id);
+    (void) hdd_image_cache_flush(id);
+
     if (hdd_images[id].file != NULL) {
         fflush(hdd_images[id].file);
-    }
+    } else if (hdd_images[id].overlay != NULL)
+        hdd_overlay_sync(hdd_images[id].overlay);
 }
 
 void
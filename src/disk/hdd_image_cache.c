@@ -0,0 +1,543 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Hard disk image block cache.
+ *
+ *          A least recently used cache of 64 kB blocks, shared by all
+ *          hard disk images and placed in front of every image type.
+ *          A miss reads the whole block from the image, so sequential
+ *          and nearby accesses cost one host access per block instead
+ *          of one per request. Writes only go to the cache; dirty
+ *          blocks are written back when they are evicted, when the
+ *          image is synced or closed, and once the disks have been idle
+ *          for a while.
+ *
+ *          The mutex only guards the cache structures. Host reads and
+ *          write backs run without it, with the block marked busy so
+ *          that other threads wait for it rather than use or evict it.
+ *
+ *          A failed write back can not be reported to the request that
+ *          wrote the data, as that has already completed. It is kept
+ *          per image and returned by the next request or flush of that
+ *          image instead, much like a deferred write error of a drive
+ *          with its write cache enabled.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+#include <86box/hdd.h>
+#include <86box/hdd_aio.h>
+
+#define HDD_IMAGE_CACHE_BLOCK_SHIFT   7 /* 128 sectors, 64 kB. */
+#define HDD_IMAGE_CACHE_BLOCK_SECTORS (1 << HDD_IMAGE_CACHE_BLOCK_SHIFT)
+#define HDD_IMAGE_CACHE_BLOCK_SIZE    (HDD_IMAGE_CACHE_BLOCK_SECTORS << 9)
+
+typedef struct hdd_image_cache_block_t {
+    struct hdd_image_cache_block_t *prev; /* LRU list, most recently used first. */
+    struct hdd_image_cache_block_t *next;
+    struct hdd_image_cache_block_t *hash_next;
+
+    int      used;
+    int      busy;        /* Host I/O in progress without the mutex. */
+    uint8_t  id;
+    uint32_t block;
+    uint32_t sectors;     /* Less than a full block at the end of the image. */
+    uint32_t dirty_start; /* Sectors to write back, none if equal. */
+    uint32_t dirty_end;
+
+    uint8_t *data;
+} hdd_image_cache_block_t;
+
+typedef struct hdd_image_cache_stats_t {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t writebacks;
+} hdd_image_cache_stats_t;
+
+uint64_t hdd_image_cache_hits   = 0;
+uint64_t hdd_image_cache_misses = 0;
+
+static hdd_image_cache_block_t  *blocks;
+static hdd_image_cache_block_t **hash;
+static hdd_image_cache_block_t  *lru_head;
+static hdd_image_cache_block_t  *lru_tail;
+static hdd_image_cache_stats_t   stats[HDD_NUM];
+static mutex_t                  *cache_mutex;
+static event_t                  *cache_event;
+static int                       writeback_error[HDD_NUM];
+static int                       nr_blocks;
+static uint32_t                  hash_mask;
+static volatile int              dirty_blocks;
+static volatile uint32_t         last_write;
+
+#ifdef ENABLE_HDD_IMAGE_CACHE_LOG
+int hdd_image_cache_do_log = ENABLE_HDD_IMAGE_CACHE_LOG;
+
+static void
+hdd_image_cache_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (hdd_image_cache_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define hdd_image_cache_log(fmt, ...)
+#endif
+
+static uint32_t
+hdd_image_cache_hash(uint8_t id, uint32_t block)
+{
+    return ((block * 0x9e3779b1) ^ id) & hash_mask;
+}
+
+static void
+hdd_image_cache_lru_unlink(hdd_image_cache_block_t *blk)
+{
+    if (blk->prev != NULL)
+        blk->prev->next = blk->next;
+    else
+        lru_head = blk->next;
+
+    if (blk->next != NULL)
+        blk->next->prev = blk->prev;
+    else
+        lru_tail = blk->prev;
+
+    blk->prev = blk->next = NULL;
+}
+
+static void
+hdd_image_cache_lru_push(hdd_image_cache_block_t *blk)
+{
+    blk->prev = NULL;
+    blk->next = lru_head;
+    if (lru_head != NULL)
+        lru_head->prev = blk;
+    else
+        lru_tail = blk;
+    lru_head = blk;
+}
+
+static void
+hdd_image_cache_hash_remove(hdd_image_cache_block_t *blk)
+{
+    hdd_image_cache_block_t **p = &hash[hdd_image_cache_hash(blk->id, blk->block)];
+
+    while (*p != NULL) {
+        if (*p == blk) {
+            *p = blk->hash_next;
+            break;
+        }
+        p = &(*p)->hash_next;
+    }
+
+    blk->hash_next = NULL;
+}
+
+static hdd_image_cache_block_t *
+hdd_image_cache_find(uint8_t id, uint32_t block)
+{
+    hdd_image_cache_block_t *blk = hash[hdd_image_cache_hash(id, block)];
+
+    while ((blk != NULL) && ((blk->id != id) || (blk->block != block)))
+        blk = blk->hash_next;
+
+    return blk;
+}
+
+/* Wait for another thread to finish its host I/O on a block. Called and
+   returns with the mutex held; anything may have changed in between. */
+static void
+hdd_image_cache_wait(void)
+{
+    thread_reset_event(cache_event);
+    thread_release_mutex(cache_mutex);
+    thread_wait_event(cache_event, 10);
+    thread_wait_mutex(cache_mutex);
+}
+
+static void
+hdd_image_cache_unbusy(hdd_image_cache_block_t *blk)
+{
+    blk->busy = 0;
+    thread_set_event(cache_event);
+}
+
+/* Called with the mutex held, which is dropped around the host write. */
+static int
+hdd_image_cache_writeback(hdd_image_cache_block_t *blk)
+{
+    uint32_t sector;
+    uint32_t count;
+    int      ret;
+
+    if (blk->dirty_start == blk->dirty_end)
+        return 0;
+
+    sector    = (blk->block << HDD_IMAGE_CACHE_BLOCK_SHIFT) + blk->dirty_start;
+    count     = blk->dirty_end - blk->dirty_start;
+    blk->busy = 1;
+
+    thread_release_mutex(cache_mutex);
+    ret = hdd_image_raw_io(blk->id, HDD_AIO_WRITE, sector, count, blk->data + (blk->dirty_start << 9));
+    thread_wait_mutex(cache_mutex);
+
+    if (ret < 0) {
+        pclog("HDD cache: Error writing back sectors %" PRIu32 "-%" PRIu32 " of image %i\n",
+              sector, sector + count - 1, blk->id);
+        writeback_error[blk->id] = 1;
+    }
+
+    stats[blk->id].writebacks++;
+    blk->dirty_start = blk->dirty_end = 0;
+    dirty_blocks--;
+    hdd_image_cache_unbusy(blk);
+
+    return ret;
+}
+
+/* Returns the block holding the given part of an image, reading it in unless
+   the caller is about to overwrite all of it. Called with the mutex held. */
+static hdd_image_cache_block_t *
+hdd_image_cache_get(uint8_t id, uint32_t block, uint32_t sectors, int fill)
+{
+    hdd_image_cache_block_t *blk;
+    uint32_t                 h;
+    int                      ret;
+
+    while (1) {
+        blk = hdd_image_cache_find(id, block);
+        if (blk != NULL) {
+            if (blk->busy) {
+                hdd_image_cache_wait();
+                continue;
+            }
+
+            stats[id].hits++;
+            hdd_image_cache_hits++;
+
+            hdd_image_cache_lru_unlink(blk);
+            hdd_image_cache_lru_push(blk);
+            return blk;
+        }
+
+        /* The least recently used block that no other thread is using. */
+        blk = lru_tail;
+        while ((blk != NULL) && blk->busy)
+            blk = blk->prev;
+        if (blk == NULL) {
+            hdd_image_cache_wait();
+            continue;
+        }
+
+        if (blk->dirty_start == blk->dirty_end)
+            break;
+
+        /* Writing it back drops the mutex, so look again afterwards. */
+        (void) hdd_image_cache_writeback(blk);
+    }
+
+    stats[id].misses++;
+    hdd_image_cache_misses++;
+
+    if (blk->used) {
+        hdd_image_cache_hash_remove(blk);
+        blk->used = 0;
+    }
+
+    if (blk->data == NULL) {
+        blk->data = (uint8_t *) malloc(HDD_IMAGE_CACHE_BLOCK_SIZE);
+        if (blk->data == NULL)
+            return NULL;
+    }
+
+    blk->used        = 1;
+    blk->id          = id;
+    blk->block       = block;
+    blk->sectors     = sectors;
+    blk->dirty_start = blk->dirty_end = 0;
+
+    h              = hdd_image_cache_hash(id, block);
+    blk->hash_next = hash[h];
+    hash[h]        = blk;
+
+    hdd_image_cache_lru_unlink(blk);
+    hdd_image_cache_lru_push(blk);
+
+    if (fill) {
+        /* Sectors past the end of the file read as zeroes. */
+        memset(blk->data, 0x00, sectors << 9);
+        blk->busy = 1;
+
+        thread_release_mutex(cache_mutex);
+        ret = hdd_image_raw_io(id, HDD_AIO_READ, block << HDD_IMAGE_CACHE_BLOCK_SHIFT, sectors, blk->data);
+        thread_wait_mutex(cache_mutex);
+
+        hdd_image_cache_unbusy(blk);
+        if (ret < 0) {
+            hdd_image_cache_hash_remove(blk);
+            blk->used = 0;
+            return NULL;
+        }
+    }
+
+    return blk;
+}
+
+void
+hdd_image_cache_init(void)
+{
+    uint32_t nr_hash = 1;
+
+    if ((blocks != NULL) || (hdd_image_cache_size <= 0))
+        return;
+
+    nr_blocks = (int) (((uint64_t) hdd_image_cache_size << 20) / HDD_IMAGE_CACHE_BLOCK_SIZE);
+    if (nr_blocks < 2)
+        nr_blocks = 2;
+
+    while (nr_hash < (uint32_t) nr_blocks)
+        nr_hash <<= 1;
+    hash_mask = nr_hash - 1;
+
+    /* Block buffers are only allocated once they are needed. */
+    blocks = (hdd_image_cache_block_t *) calloc(nr_blocks, sizeof(hdd_image_cache_block_t));
+    hash   = (hdd_image_cache_block_t **) calloc(nr_hash, sizeof(hdd_image_cache_block_t *));
+
+    lru_head = lru_tail = NULL;
+    for (int i = 0; i < nr_blocks; i++)
+        hdd_image_cache_lru_push(&blocks[i]);
+
+    memset(stats, 0x00, sizeof(stats));
+    memset(writeback_error, 0x00, sizeof(writeback_error));
+    dirty_blocks = 0;
+    cache_mutex  = thread_create_mutex();
+    cache_event  = thread_create_event();
+
+    hdd_image_cache_log("HDD cache: %i blocks of %i kB\n", nr_blocks, HDD_IMAGE_CACHE_BLOCK_SIZE >> 10);
+}
+
+void
+hdd_image_cache_close(void)
+{
+    if (blocks == NULL)
+        return;
+
+    for (uint8_t i = 0; i < HDD_NUM; i++)
+        hdd_image_cache_invalidate(i);
+
+    for (int i = 0; i < nr_blocks; i++)
+        free(blocks[i].data);
+
+    free(hash);
+    free(blocks);
+    hash   = NULL;
+    blocks = NULL;
+
+    thread_destroy_event(cache_event);
+    thread_close_mutex(cache_mutex);
+    cache_event = NULL;
+    cache_mutex = NULL;
+}
+
+int
+hdd_image_cache_io(uint8_t id, int op, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    hdd_image_cache_block_t *blk;
+    uint32_t                 image_sectors;
+    uint32_t                 block;
+    uint32_t                 offset;
+    uint32_t                 sectors;
+    uint32_t                 n;
+    int                      was_dirty = 0;
+    int                      ret       = 0;
+
+    if (blocks == NULL)
+        return hdd_image_raw_io(id, op, sector, count, buffer);
+
+    image_sectors = hdd_image_get_last_sector(id) + 1;
+
+    thread_wait_mutex(cache_mutex);
+
+    /* Report a failed write back of earlier data to the guest now. */
+    if (writeback_error[id]) {
+        writeback_error[id] = 0;
+        ret                 = -1;
+    }
+
+    while ((count > 0) && (ret == 0)) {
+        /* Anything past the end of the image is not cached. */
+        if (sector >= image_sectors) {
+            thread_release_mutex(cache_mutex);
+            ret = hdd_image_raw_io(id, op, sector, count, buffer);
+            thread_wait_mutex(cache_mutex);
+            break;
+        }
+
+        block   = sector >> HDD_IMAGE_CACHE_BLOCK_SHIFT;
+        offset  = sector & (HDD_IMAGE_CACHE_BLOCK_SECTORS - 1);
+        sectors = MIN(HDD_IMAGE_CACHE_BLOCK_SECTORS, image_sectors - (block << HDD_IMAGE_CACHE_BLOCK_SHIFT));
+        n       = MIN(count, sectors - offset);
+
+        blk = hdd_image_cache_get(id, block, sectors, (op == HDD_AIO_READ) || (n != sectors));
+        if (blk == NULL) {
+            /* Could not read the block in, bypass the cache. */
+            thread_release_mutex(cache_mutex);
+            ret = hdd_image_raw_io(id, op, sector, n, buffer);
+            thread_wait_mutex(cache_mutex);
+        } else if (op == HDD_AIO_READ)
+            memcpy(buffer, blk->data + (offset << 9), n << 9);
+        else {
+            if (op == HDD_AIO_WRITE)
+                memcpy(blk->data + (offset << 9), buffer, n << 9);
+            else
+                memset(blk->data + (offset << 9), 0x00, n << 9);
+
+            if (blk->dirty_start == blk->dirty_end) {
+                blk->dirty_start = offset;
+                blk->dirty_end   = offset + n;
+                if (dirty_blocks++ == 0)
+                    was_dirty = 1;
+            } else {
+                blk->dirty_start = MIN(blk->dirty_start, offset);
+                blk->dirty_end   = MAX(blk->dirty_end, offset + n);
+            }
+        }
+
+        sector += n;
+        count -= n;
+        if (buffer != NULL)
+            buffer += (n << 9);
+    }
+
+    if (op != HDD_AIO_READ)
+        last_write = plat_get_ticks();
+
+    thread_release_mutex(cache_mutex);
+
+    /* Get the idle write back going. */
+    if (was_dirty)
+        hdd_aio_kick();
+
+    return ret;
+}
+
+int
+hdd_image_cache_flush(uint8_t id)
+{
+    int ret = 0;
+
+    if (blocks == NULL)
+        return 0;
+
+    thread_wait_mutex(cache_mutex);
+    for (int i = 0; i < nr_blocks; i++) {
+        hdd_image_cache_block_t *blk = &blocks[i];
+
+        if (!blk->used || (blk->id != id) || (blk->dirty_start == blk->dirty_end))
+            continue;
+
+        if (blk->busy) {
+            /* Look at the same block again once it is free. */
+            hdd_image_cache_wait();
+            i--;
+            continue;
+        }
+
+        (void) hdd_image_cache_writeback(blk);
+    }
+
+    if (writeback_error[id]) {
+        writeback_error[id] = 0;
+        ret                 = -1;
+    }
+    thread_release_mutex(cache_mutex);
+
+    return ret;
+}
+
+void
+hdd_image_cache_invalidate(uint8_t id)
+{
+    if (blocks == NULL)
+        return;
+
+    thread_wait_mutex(cache_mutex);
+    for (int i = 0; i < nr_blocks; i++) {
+        hdd_image_cache_block_t *blk = &blocks[i];
+
+        if (!blk->used || (blk->id != id))
+            continue;
+
+        /* Both of these drop the mutex, so look at the block again after. */
+        if (blk->busy) {
+            hdd_image_cache_wait();
+            i--;
+            continue;
+        }
+        if (blk->dirty_start != blk->dirty_end) {
+            (void) hdd_image_cache_writeback(blk);
+            i--;
+            continue;
+        }
+
+        hdd_image_cache_hash_remove(blk);
+        blk->used = 0;
+
+        /* Reuse it before any block that still holds data. */
+        hdd_image_cache_lru_unlink(blk);
+        blk->next = NULL;
+        blk->prev = lru_tail;
+        if (lru_tail != NULL)
+            lru_tail->next = blk;
+        else
+            lru_head = blk;
+        lru_tail = blk;
+    }
+
+    if ((stats[id].hits + stats[id].misses) > 0)
+        hdd_image_cache_log("HDD cache: Image %i: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " write backs\n",
+                      id, stats[id].hits, stats[id].misses, stats[id].writebacks);
+    memset(&stats[id], 0x00, sizeof(hdd_image_cache_stats_t));
+    writeback_error[id] = 0;
+    thread_release_mutex(cache_mutex);
+}
+
+int
+hdd_image_cache_dirty(void)
+{
+    return (dirty_blocks > 0);
+}
+
+void
+hdd_image_cache_flush_idle(void)
+{
+    if ((blocks == NULL) || !dirty_blocks || ((plat_get_ticks() - last_write) < HDD_IMAGE_CACHE_IDLE_MS))
+        return;
+
+    for (uint8_t i = 0; i < HDD_NUM; i++)
+        (void) hdd_image_cache_flush(i);
+}
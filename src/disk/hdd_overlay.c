@@ -0,0 +1,355 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Hard disk overlay images.
+ *
+ *          An overlay holds the changes made to a raw, HDI or HDX base
+ *          image, which is opened read-only and can be shared by any
+ *          number of machines. Where possible, the base image is mapped
+ *          into memory, so that all of them share one copy of it in the
+ *          host page cache.
+ *
+ *          The overlay file starts with a header sector, followed by a
+ *          map with one 32-bit entry per block of
+ *          HDD_OVERLAY_BLOCK_SECTORS sectors, and then the blocks that
+ *          were written to, in the order they were first written. A map
+ *          entry of 0 means the block is still read from the base image,
+ *          anything else is the number of the block in the overlay
+ *          plus one. A block is copied from the base image as a whole
+ *          the first time it is written to.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#ifndef _WIN32
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/plat.h>
+#include <86box/hdd.h>
+#include <86box/hdd_aio.h>
+
+#define HDD_OVERLAY_MAGIC         "86BOXOVL"
+#define HDD_OVERLAY_VERSION       1
+#define HDD_OVERLAY_BLOCK_SECTORS 128
+#define HDD_OVERLAY_BLOCK_SIZE    (HDD_OVERLAY_BLOCK_SECTORS << 9)
+
+typedef struct hdd_overlay_header_t {
+    char     magic[8];
+    uint32_t version;
+    uint32_t block_sectors;
+    uint64_t sectors;     /* Size of the disk. */
+    uint64_t base_size;   /* Size of the base image file when the overlay was created. */
+    uint64_t map_offset;
+    uint64_t data_offset;
+    uint32_t nr_blocks;
+    uint32_t allocated;   /* Blocks stored in the overlay. */
+} hdd_overlay_header_t;
+
+struct hdd_overlay_t {
+    FILE                *file;
+    FILE                *base;
+    const uint8_t       *base_map; /* The base image mapped into memory, if possible. */
+    uint64_t             base_size;
+    uint64_t             base_offset;
+    hdd_overlay_header_t hdr;
+    uint32_t            *map;
+    uint8_t             *block;
+};
+
+#ifdef ENABLE_HDD_OVERLAY_LOG
+int hdd_overlay_do_log = ENABLE_HDD_OVERLAY_LOG;
+
+static void
+hdd_overlay_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (hdd_overlay_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define hdd_overlay_log(fmt, ...)
+#endif
+
+/* Reads sectors from the base image, sectors past its end read as zeroes. */
+static int
+hdd_overlay_read_base(hdd_overlay_t *ov, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    uint64_t addr = ov->base_offset + ((uint64_t) sector << 9);
+    uint64_t len  = (uint64_t) count << 9;
+    uint64_t avail;
+
+    avail = (addr < ov->base_size) ? MIN(len, ov->base_size - addr) : 0;
+    if (avail < len)
+        memset(buffer + avail, 0x00, len - avail);
+    if (avail == 0)
+        return 0;
+
+    if (ov->base_map != NULL) {
+        memcpy(buffer, ov->base_map + addr, avail);
+        return 0;
+    }
+
+    if ((fseeko64(ov->base, addr, SEEK_SET) == -1) || (fread(buffer, 1, avail, ov->base) != avail))
+        return -1;
+
+    return 0;
+}
+
+static uint64_t
+hdd_overlay_block_addr(hdd_overlay_t *ov, uint32_t entry)
+{
+    return ov->hdr.data_offset + ((uint64_t) (entry - 1) * HDD_OVERLAY_BLOCK_SIZE);
+}
+
+static int
+hdd_overlay_write_header(hdd_overlay_t *ov)
+{
+    uint8_t sector[512] = { 0 };
+
+    memcpy(sector, &ov->hdr, sizeof(hdd_overlay_header_t));
+
+    if ((fseeko64(ov->file, 0, SEEK_SET) == -1) || (fwrite(sector, 1, 512, ov->file) != 512))
+        return -1;
+
+    return 0;
+}
+
+/* Moves a block from the base image into the overlay. */
+static int
+hdd_overlay_alloc_block(hdd_overlay_t *ov, uint32_t blk)
+{
+    uint32_t entry = ov->hdr.allocated + 1;
+
+    if (hdd_overlay_read_base(ov, blk * HDD_OVERLAY_BLOCK_SECTORS, HDD_OVERLAY_BLOCK_SECTORS, ov->block) < 0)
+        return -1;
+
+    /* Write the data, then count it in the header, and only then point the
+       map at it, flushing in between. A crash at any point leaves at worst
+       an unused block at the end of the file, never a map entry past the
+       allocated count. */
+    if ((fseeko64(ov->file, hdd_overlay_block_addr(ov, entry), SEEK_SET) == -1) ||
+        (fwrite(ov->block, 1, HDD_OVERLAY_BLOCK_SIZE, ov->file) != HDD_OVERLAY_BLOCK_SIZE) ||
+        (fflush(ov->file) != 0))
+        return -1;
+
+    ov->hdr.allocated++;
+    if ((hdd_overlay_write_header(ov) < 0) || (fflush(ov->file) != 0))
+        return -1;
+
+    if ((fseeko64(ov->file, ov->hdr.map_offset + ((uint64_t) blk << 2), SEEK_SET) == -1) ||
+        (fwrite(&entry, 1, 4, ov->file) != 4) || (fflush(ov->file) != 0))
+        return -1;
+
+    ov->map[blk] = entry;
+
+    return 0;
+}
+
+int
+hdd_overlay_io(hdd_overlay_t *ov, int op, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    uint32_t blk;
+    uint32_t offset;
+    uint32_t n;
+    size_t   len;
+    int      ret = 0;
+
+    if ((uint64_t) sector + count > ov->hdr.sectors)
+        return -1;
+
+    while ((count > 0) && (ret == 0)) {
+        blk    = sector / HDD_OVERLAY_BLOCK_SECTORS;
+        offset = sector % HDD_OVERLAY_BLOCK_SECTORS;
+        n      = MIN(count, HDD_OVERLAY_BLOCK_SECTORS - offset);
+        len    = (size_t) n << 9;
+
+        if ((op != HDD_AIO_READ) && (ov->map[blk] == 0))
+            ret = hdd_overlay_alloc_block(ov, blk);
+
+        if (ret < 0)
+            break;
+
+        if (ov->map[blk] == 0)
+            ret = hdd_overlay_read_base(ov, sector, n, buffer);
+        else if (fseeko64(ov->file, hdd_overlay_block_addr(ov, ov->map[blk]) + ((uint64_t) offset << 9), SEEK_SET) == -1)
+            ret = -1;
+        else if (op == HDD_AIO_READ) {
+            if (fread(buffer, 1, len, ov->file) != len)
+                ret = -1;
+        } else {
+            const uint8_t *src = buffer;
+
+            if (op == HDD_AIO_ZERO) {
+                memset(ov->block, 0x00, len);
+                src = ov->block;
+            }
+            if (fwrite(src, 1, len, ov->file) != len)
+                ret = -1;
+        }
+
+        sector += n;
+        count -= n;
+        if (buffer != NULL)
+            buffer += len;
+    }
+
+    return ret;
+}
+
+void
+hdd_overlay_sync(hdd_overlay_t *ov)
+{
+    fflush(ov->file);
+}
+
+void
+hdd_overlay_close(hdd_overlay_t *ov)
+{
+    if (ov == NULL)
+        return;
+
+#ifndef _WIN32
+    if (ov->base_map != NULL)
+        munmap((void *) ov->base_map, ov->base_size);
+#endif
+    if (ov->base != NULL)
+        fclose(ov->base);
+    if (ov->file != NULL)
+        fclose(ov->file);
+
+    free(ov->block);
+    free(ov->map);
+    free(ov);
+}
+
+static int
+hdd_overlay_create(hdd_overlay_t *ov, uint64_t sectors)
+{
+    uint8_t zero[512] = { 0 };
+    size_t  map_size;
+
+    memcpy(ov->hdr.magic, HDD_OVERLAY_MAGIC, 8);
+    ov->hdr.version       = HDD_OVERLAY_VERSION;
+    ov->hdr.block_sectors = HDD_OVERLAY_BLOCK_SECTORS;
+    ov->hdr.sectors       = sectors;
+    ov->hdr.base_size     = ov->base_size;
+    ov->hdr.nr_blocks     = (uint32_t) ((sectors + HDD_OVERLAY_BLOCK_SECTORS - 1) / HDD_OVERLAY_BLOCK_SECTORS);
+    ov->hdr.map_offset    = 512;
+    map_size              = (size_t) ov->hdr.nr_blocks << 2;
+    ov->hdr.data_offset   = (ov->hdr.map_offset + map_size + 4095) & ~4095ULL;
+    ov->hdr.allocated     = 0;
+
+    if (hdd_overlay_write_header(ov) < 0)
+        return -1;
+
+    /* An empty map, all blocks come from the base image. */
+    for (uint64_t i = 512; i < ov->hdr.data_offset; i += 512) {
+        if (fwrite(zero, 1, 512, ov->file) != 512)
+            return -1;
+    }
+
+    fflush(ov->file);
+    return 0;
+}
+
+hdd_overlay_t *
+hdd_overlay_open(const char *fn, const char *base_fn, uint64_t base_offset, uint64_t sectors, int wp)
+{
+    hdd_overlay_t *ov = (hdd_overlay_t *) calloc(1, sizeof(hdd_overlay_t));
+
+    ov->base_offset = base_offset;
+    ov->base        = plat_fopen(base_fn, "rb");
+    if (ov->base == NULL) {
+        pclog("HDD overlay: Unable to open base image %s\n", base_fn);
+        goto fail;
+    }
+
+    if (fseeko64(ov->base, 0, SEEK_END) == -1)
+        goto fail;
+    ov->base_size = ftello64(ov->base);
+
+#ifndef _WIN32
+    if (ov->base_size > 0) {
+        void *p = mmap(NULL, ov->base_size, PROT_READ, MAP_SHARED, fileno(ov->base), 0);
+
+        if (p != MAP_FAILED)
+            ov->base_map = (const uint8_t *) p;
+        else
+            hdd_overlay_log("HDD overlay: Unable to map %s, reading it instead\n", base_fn);
+    }
+#endif
+
+    ov->file = plat_fopen(fn, wp ? "rb" : "rb+");
+    if (ov->file == NULL) {
+        if (wp) {
+            pclog("HDD overlay: A write-protected overlay must exist\n");
+            goto fail;
+        }
+
+        ov->file = plat_fopen(fn, "wb+");
+        if ((ov->file == NULL) || (hdd_overlay_create(ov, sectors) < 0)) {
+            pclog("HDD overlay: Unable to create %s\n", fn);
+            goto fail;
+        }
+
+        pclog("HDD overlay: Created %s over %s\n", fn, base_fn);
+    } else if ((fread(&ov->hdr, 1, sizeof(hdd_overlay_header_t), ov->file) != sizeof(hdd_overlay_header_t)) ||
+               memcmp(ov->hdr.magic, HDD_OVERLAY_MAGIC, 8) || (ov->hdr.version != HDD_OVERLAY_VERSION) ||
+               (ov->hdr.block_sectors != HDD_OVERLAY_BLOCK_SECTORS)) {
+        pclog("HDD overlay: %s is not an overlay image\n", fn);
+        goto fail;
+    } else if (ov->hdr.sectors != sectors) {
+        pclog("HDD overlay: %s does not match the size of %s\n", fn, base_fn);
+        goto fail;
+    } else if (ov->hdr.base_size != ov->base_size) {
+        /* Like the timestamp of a differencing VHD parent, this is only a hint. */
+        pclog("HDD overlay: Base image %s changed size since %s was created\n", base_fn, fn);
+    }
+
+    ov->map   = (uint32_t *) calloc(ov->hdr.nr_blocks, sizeof(uint32_t));
+    ov->block = (uint8_t *) malloc(HDD_OVERLAY_BLOCK_SIZE);
+    if ((fseeko64(ov->file, ov->hdr.map_offset, SEEK_SET) == -1) ||
+        (fread(ov->map, 4, ov->hdr.nr_blocks, ov->file) != ov->hdr.nr_blocks)) {
+        pclog("HDD overlay: Unable to read the map of %s\n", fn);
+        goto fail;
+    }
+
+    for (uint32_t i = 0; i < ov->hdr.nr_blocks; i++) {
+        if (ov->map[i] > ov->hdr.allocated) {
+            pclog("HDD overlay: Bad map entry for block %" PRIu32 " in %s\n", i, fn);
+            goto fail;
+        }
+    }
+
+    hdd_overlay_log("HDD overlay: %s, %" PRIu32 " of %" PRIu32 " blocks in the overlay, base %s\n",
+                    fn, ov->hdr.allocated, ov->hdr.nr_blocks, ov->base_map ? "mapped" : "read");
+
+    return ov;
+
+fail:
+    hdd_overlay_close(ov);
+    return NULL;
+}
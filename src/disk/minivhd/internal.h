@@ -62,9 +62,8 @@
 
 
 typedef struct MVHDSectorBitmap {
-    uint8_t* curr_bitmap;
-    int      sector_count;
-    int      curr_block;
+    uint8_t** blocks;       /* Bitmap of each allocated block, read in on first use */
+    int       sector_count;
 } MVHDSectorBitmap;
 
 typedef struct MVHDFooter {
@@ -179,11 +179,11 @@ calc_sparse_values(MVHDMeta* vhdm)
 
 
 /**
- * \brief Allocate memory for a sector bitmap.
+ * \brief Allocate the sector bitmap index.
  *
  * Each data block is preceded by a sector bitmap. Each bit indicates whether the corresponding sector
  * is considered 'clean' or 'dirty' (for sparse VHD images), or whether to read from the parent or current
- * image (for differencing images).
+ * image (for differencing images). The bitmaps of the blocks are kept in memory once they were read.
  *
  * \param [in] vhdm MiniVHD data structure
  * \param [out] err this is populated with MVHD_ERR_MEM if the calloc fails
@@ -194,18 +194,35 @@ calc_sparse_values(MVHDMeta* vhdm)
 static int
 init_sector_bitmap(MVHDMeta* vhdm, MVHDError* err)
 {
-    vhdm->bitmap.curr_bitmap = calloc(vhdm->bitmap.sector_count, MVHD_SECTOR_SIZE);
-    if (vhdm->bitmap.curr_bitmap == NULL) {
+    vhdm->bitmap.blocks = calloc(vhdm->sparse.max_bat_ent, sizeof *vhdm->bitmap.blocks);
+    if (vhdm->bitmap.blocks == NULL) {
         *err = MVHD_ERR_MEM;
         return -1;
     }
 
-    vhdm->bitmap.curr_block = -1;
-
     return 0;
 }
 
 
+/**
+ * \brief Free the sector bitmaps read in so far.
+ *
+ * \param [in] vhdm MiniVHD data structure
+ */
+static void
+free_sector_bitmap(MVHDMeta* vhdm)
+{
+    if (vhdm->bitmap.blocks == NULL)
+        return;
+
+    for (uint32_t i = 0; i < vhdm->sparse.max_bat_ent; i++)
+        free(vhdm->bitmap.blocks[i]);
+
+    free(vhdm->bitmap.blocks);
+    vhdm->bitmap.blocks = NULL;
+}
+
+
 /**
  * \brief Check if the path for a given platform code exists
  *
@@ -595,8 +612,7 @@ cleanup_format_buff:
     vhdm->format_buffer.zero_data = NULL;
 
 cleanup_bitmap:
-    free(vhdm->bitmap.curr_bitmap);
-    vhdm->bitmap.curr_bitmap = NULL;
+    free_sector_bitmap(vhdm);
 
 cleanup_bat:
     free(vhdm->block_offset);
@@ -630,10 +646,7 @@ mvhd_close(MVHDMeta* vhdm)
         free(vhdm->block_offset);
         vhdm->block_offset = NULL;
     }
-    if (vhdm->bitmap.curr_bitmap != NULL) {
-        free(vhdm->bitmap.curr_bitmap);
-        vhdm->bitmap.curr_bitmap = NULL;
-    }
+    free_sector_bitmap(vhdm);
     if (vhdm->format_buffer.zero_data != NULL) {
         free(vhdm->format_buffer.zero_data);
         vhdm->format_buffer.zero_data = NULL;
@@ -97,42 +97,109 @@ mvhd_write_empty_sectors(FILE *f, int sector_count)
 }
 
 /**
- * \brief Read the sector bitmap for a block.
+ * \brief Get the sector bitmap for a block.
  *
- * If the block is sparse, the sector bitmap in memory will be
- * zeroed. Otherwise, the sector bitmap is read from the VHD file.
+ * If the block is sparse, NULL is returned, as none of its sectors are in use.
+ * Otherwise, the sector bitmap is read from the VHD file the first time it is
+ * needed, and kept in memory from then on.
  *
  * \param [in] vhdm MiniVHD data structure
- * \param [in] blk The block for which to read the sector bitmap from
+ * \param [in] blk The block for which to get the sector bitmap
+ *
+ * \return The sector bitmap, or NULL for a sparse block or if it could not be read
  */
-static void
-read_sect_bitmap(MVHDMeta *vhdm, int blk)
+static uint8_t*
+get_sect_bitmap(MVHDMeta *vhdm, int blk)
 {
-    if (vhdm->block_offset[blk] != MVHD_SPARSE_BLK) {
-        mvhd_fseeko64(vhdm->f, (uint64_t)vhdm->block_offset[blk] * MVHD_SECTOR_SIZE, SEEK_SET);
-        if (!fread(vhdm->bitmap.curr_bitmap, vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE, 1, vhdm->f))
-            vhdm->error = 1;
-    } else
-        memset(vhdm->bitmap.curr_bitmap, 0, vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE);
+    uint8_t* bitmap = vhdm->bitmap.blocks[blk];
+
+    if ((bitmap != NULL) || (vhdm->block_offset[blk] == MVHD_SPARSE_BLK))
+        return bitmap;
+
+    bitmap = malloc(vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE);
+    if (bitmap == NULL) {
+        vhdm->error = 1;
+        return NULL;
+    }
+
+    if ((mvhd_fseeko64(vhdm->f, (uint64_t)vhdm->block_offset[blk] * MVHD_SECTOR_SIZE, SEEK_SET) == -1) ||
+        !fread(bitmap, vhdm->bitmap.sector_count * MVHD_SECTOR_SIZE, 1, vhdm->f)) {
+        vhdm->error = 1;
+        free(bitmap);
+        return NULL;
+    }
 
-    vhdm->bitmap.curr_block = blk;
+    vhdm->bitmap.blocks[blk] = bitmap;
+    return bitmap;
 }
 
 /**
- * \brief Write the current sector bitmap in memory to file
+ * \brief Write the sector bitmap of a block from memory to file
  *
  * \param [in] vhdm MiniVHD data structure
+ * \param [in] blk The block for which to write the sector bitmap
  */
 static void
-write_curr_sect_bitmap(MVHDMeta* vhdm)
+write_sect_bitmap(MVHDMeta* vhdm, int blk)
 {
-    if (vhdm->bitmap.curr_block >= 0) {
-        int64_t abs_offset = (int64_t)vhdm->block_offset[vhdm->bitmap.curr_block] * MVHD_SECTOR_SIZE;
-        if (mvhd_fseeko64(vhdm->f, abs_offset, SEEK_SET) == -1)
-            vhdm->error = 1;
-        if (!fwrite(vhdm->bitmap.curr_bitmap, MVHD_SECTOR_SIZE, vhdm->bitmap.sector_count, vhdm->f))
-            vhdm->error = 1;
+    int64_t abs_offset = (int64_t)vhdm->block_offset[blk] * MVHD_SECTOR_SIZE;
+
+    if (mvhd_fseeko64(vhdm->f, abs_offset, SEEK_SET) == -1)
+        vhdm->error = 1;
+    if (!fwrite(vhdm->bitmap.blocks[blk], MVHD_SECTOR_SIZE, vhdm->bitmap.sector_count, vhdm->f))
+        vhdm->error = 1;
+}
+
+/**
+ * \brief Find a run of sectors which are either all in use or all unused
+ *
+ * \param [in] bitmap The sector bitmap of the block, NULL if the block is sparse
+ * \param [in] sib The first sector in the block
+ * \param [in] max The largest run to look for
+ * \param [out] in_use Whether the sectors of the run are in use
+ *
+ * \return The number of sectors in the run
+ */
+static int
+sect_run(const uint8_t *bitmap, int sib, int max, bool *in_use)
+{
+    int n = 1;
+
+    if (bitmap == NULL) {
+        *in_use = false;
+        return max;
+    }
+
+    *in_use = VHD_TESTBIT(bitmap, sib) != 0;
+
+    while (n < max) {
+        int k = sib + n;
+
+        /* Skip whole bytes at a time where possible. */
+        if (((k & 7) == 0) && ((max - n) >= 8) && (bitmap[k >> 3] == (*in_use ? 0xff : 0x00))) {
+            n += 8;
+            continue;
+        }
+
+        if ((VHD_TESTBIT(bitmap, k) != 0) != *in_use)
+            break;
+        n++;
     }
+
+    return n;
+}
+
+/**
+ * \brief Get the file offset of a sector in an allocated block
+ *
+ * \param [in] vhdm MiniVHD data structure
+ * \param [in] blk The block holding the sector
+ * \param [in] sib The sector in the block
+ */
+static int64_t
+sect_addr(MVHDMeta *vhdm, int blk, int sib)
+{
+    return (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) * MVHD_SECTOR_SIZE;
 }
 
 /**
@@ -215,6 +282,11 @@ create_block(MVHDMeta *vhdm, int blk)
     vhdm->block_offset[blk] = sect_offset;
     write_bat_entry(vhdm, blk);
 
+    /* The bitmap we just wrote is all zeroes, no need to read it back */
+    vhdm->bitmap.blocks[blk] = calloc(vhdm->bitmap.sector_count, MVHD_SECTOR_SIZE);
+    if (vhdm->bitmap.blocks[blk] == NULL)
+        vhdm->error = 1;
+
     fflush(vhdm->f);
 }
 
@@ -246,44 +318,65 @@ mvhd_sparse_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buf
     check_sectors(offset, num_sectors, total_sectors, &transfer_sectors, &truncated_sectors);
 
     uint8_t* buff = (uint8_t*)out_buff;
-    int64_t addr = 0ULL;
-    uint32_t s = 0;
-    uint32_t ls = 0;
-    int blk = 0;
-    int prev_blk = -1;
-    int sib = 0;
-    ls = offset + transfer_sectors;
-
-    for (s = offset; s < ls; s++) {
-        blk = s / vhdm->sect_per_block;
-        sib = s % vhdm->sect_per_block;
-        if (blk != prev_blk) {
-            prev_blk = blk;
-            if (vhdm->bitmap.curr_block != blk) {
-                read_sect_bitmap(vhdm, blk);
-                if (mvhd_fseeko64(vhdm->f, (uint64_t)sib * MVHD_SECTOR_SIZE, SEEK_CUR) == -1)
+    uint32_t s = offset;
+    uint32_t ls = offset + transfer_sectors;
+
+    /* Read every run of sectors in use with a single access, and zero the runs in between */
+    while (s < ls) {
+        int blk = s / vhdm->sect_per_block;
+        int sib = s % vhdm->sect_per_block;
+        int n = vhdm->sect_per_block - sib;
+        const uint8_t* bitmap = get_sect_bitmap(vhdm, blk);
+
+        if ((uint32_t) n > (ls - s))
+            n = ls - s;
+
+        while (n > 0) {
+            bool in_use;
+            int run = sect_run(bitmap, sib, n, &in_use);
+
+            if (in_use) {
+                if (mvhd_fseeko64(vhdm->f, sect_addr(vhdm, blk, sib), SEEK_SET) == -1)
                     vhdm->error = 1;
-            } else if (vhdm->block_offset[blk] != MVHD_SPARSE_BLK) {
-                addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
-                       MVHD_SECTOR_SIZE;
-                if (mvhd_fseeko64(vhdm->f, addr, SEEK_SET) == -1)
+                if (!fread(buff, (size_t) run * MVHD_SECTOR_SIZE, 1, vhdm->f) && !feof(vhdm->f))
                     vhdm->error = 1;
-            }
-        }
+            } else
+                memset(buff, 0, (size_t) run * MVHD_SECTOR_SIZE);
 
-        if (VHD_TESTBIT(vhdm->bitmap.curr_bitmap, sib)) {
-            if (!fread(buff, MVHD_SECTOR_SIZE, 1, vhdm->f) && !feof(vhdm->f))
-                vhdm->error = 1;
-        } else {
-            memset(buff, 0, MVHD_SECTOR_SIZE);
-            mvhd_fseeko64(vhdm->f, MVHD_SECTOR_SIZE, SEEK_CUR);
+            buff += (size_t) run * MVHD_SECTOR_SIZE;
+            sib += run;
+            s += run;
+            n -= run;
         }
-        buff += MVHD_SECTOR_SIZE;
     }
 
     return truncated_sectors;
 }
 
+/**
+ * \brief Find the image in a differencing chain that holds a sector
+ *
+ * \param [in] vhdm MiniVHD data structure of the differencing image
+ * \param [in] s The sector to look for
+ *
+ * \return The first image in the chain with the sector in use, or the
+ * image at the bottom of the chain if none of the differencing images have it
+ */
+static MVHDMeta*
+diff_sect_owner(MVHDMeta *vhdm, uint32_t s)
+{
+    while (vhdm->footer.disk_type == MVHD_TYPE_DIFF) {
+        const uint8_t* bitmap = get_sect_bitmap(vhdm, s / vhdm->sect_per_block);
+
+        if ((bitmap != NULL) && VHD_TESTBIT(bitmap, s % vhdm->sect_per_block))
+            break;
+
+        vhdm = vhdm->parent;
+    }
+
+    return vhdm;
+}
+
 int
 mvhd_diff_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buff)
 {
@@ -294,39 +387,32 @@ mvhd_diff_read(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *out_buff)
     check_sectors(offset, num_sectors, total_sectors, &transfer_sectors, &truncated_sectors);
 
     uint8_t *buff = (uint8_t*)out_buff;
-    MVHDMeta *curr_vhdm = vhdm;
-    uint32_t s = 0;
-    uint32_t ls = 0;
-    int blk = 0;
-    int sib = 0;
-    ls = offset + transfer_sectors;
-
-    for (s = offset; s < ls; s++) {
-        while (curr_vhdm->footer.disk_type == MVHD_TYPE_DIFF) {
-            blk = s / curr_vhdm->sect_per_block;
-            sib = s % curr_vhdm->sect_per_block;
-            if (curr_vhdm->bitmap.curr_block != blk) {
-                read_sect_bitmap(curr_vhdm, blk);
-            }
-            if (!VHD_TESTBIT(curr_vhdm->bitmap.curr_bitmap, sib)) {
-                curr_vhdm = curr_vhdm->parent;
-            } else { break; }
-        }
+    uint32_t s = offset;
+    uint32_t ls = offset + transfer_sectors;
+
+    /* Group the sectors into runs that come from the same image of the chain,
+       and read each run with one call */
+    while (s < ls) {
+        MVHDMeta *curr_vhdm = diff_sect_owner(vhdm, s);
+        uint32_t run = 1;
+
+        while (((s + run) < ls) && (diff_sect_owner(vhdm, s + run) == curr_vhdm))
+            run++;
 
         /* We handle actual sector reading using the fixed or sparse functions,
            as a differencing VHD is also a sparse VHD */
         if ((curr_vhdm->footer.disk_type == MVHD_TYPE_DIFF) ||
             (curr_vhdm->footer.disk_type == MVHD_TYPE_DYNAMIC))
-            mvhd_sparse_read(curr_vhdm, s, 1, buff);
+            mvhd_sparse_read(curr_vhdm, s, run, buff);
         else
-            mvhd_fixed_read(curr_vhdm, s, 1, buff);
+            mvhd_fixed_read(curr_vhdm, s, run, buff);
         if (curr_vhdm->error) {
             curr_vhdm->error = 0;
             vhdm->error = 1;
         }
 
-        curr_vhdm = vhdm;
-        buff += MVHD_SECTOR_SIZE;
+        s += run;
+        buff += (size_t) run * MVHD_SECTOR_SIZE;
     }
 
     return truncated_sectors;
@@ -362,53 +448,47 @@ mvhd_sparse_diff_write(MVHDMeta *vhdm, uint32_t offset, int num_sectors, void *i
     check_sectors(offset, num_sectors, total_sectors, &transfer_sectors, &truncated_sectors);
 
     uint8_t* buff = (uint8_t *) in_buff;
-    int64_t addr = 0ULL;
-    uint32_t s = 0;
-    uint32_t ls = 0;
-    int blk = 0;
-    int prev_blk = -1;
-    int sib = 0;
-    ls = offset + transfer_sectors;
-
-    if (offset < total_sectors) {
-        for (s = offset; s < ls; s++) {
-            blk = s / vhdm->sect_per_block;
-            sib = s % vhdm->sect_per_block;
-            if (vhdm->bitmap.curr_block != blk && prev_blk >= 0) {
-                /* Write the sector bitmap for the previous block, before we replace it. */
-                write_curr_sect_bitmap(vhdm);
-            }
+    uint32_t s = offset;
+    uint32_t ls = offset + transfer_sectors;
 
-            if (vhdm->block_offset[blk] == MVHD_SPARSE_BLK) {
-                /* "read" the sector bitmap first, before creating a new block, as the bitmap will be
-                   zero either way */
-                read_sect_bitmap(vhdm, blk);
-                create_block(vhdm, blk);
-            }
+    /* Write the part of each block with a single access, and only update the
+       sector bitmap if sectors came into use */
+    while ((offset < total_sectors) && (s < ls)) {
+        int blk = s / vhdm->sect_per_block;
+        int sib = s % vhdm->sect_per_block;
+        int n = vhdm->sect_per_block - sib;
+        bool bitmap_changed = false;
 
-            if (blk != prev_blk) {
-                if (vhdm->bitmap.curr_block != blk) {
-                    read_sect_bitmap(vhdm, blk);
-                    if (mvhd_fseeko64(vhdm->f, (uint64_t)sib * MVHD_SECTOR_SIZE, SEEK_CUR) == -1)
-                        vhdm->error = 1;
-                } else {
-                    addr = (((int64_t) vhdm->block_offset[blk]) + vhdm->bitmap.sector_count + sib) *
-                           MVHD_SECTOR_SIZE;
-                    if (mvhd_fseeko64(vhdm->f, addr, SEEK_SET) == -1)
-                        vhdm->error = 1;
-                }
-                prev_blk = blk;
-            }
+        if ((uint32_t) n > (ls - s))
+            n = ls - s;
 
-            if (!fwrite(buff, MVHD_SECTOR_SIZE, 1, vhdm->f))
-                vhdm->error = 1;
-            VHD_SETBIT(vhdm->bitmap.curr_bitmap, sib);
-            buff += MVHD_SECTOR_SIZE;
+        if (vhdm->block_offset[blk] == MVHD_SPARSE_BLK)
+            create_block(vhdm, blk);
+
+        uint8_t* bitmap = get_sect_bitmap(vhdm, blk);
+        if (bitmap == NULL) {
+            vhdm->error = 1;
+            break;
         }
-    }
 
-    /* And write the sector bitmap for the last block we visited to disk */
-    write_curr_sect_bitmap(vhdm);
+        if (mvhd_fseeko64(vhdm->f, sect_addr(vhdm, blk, sib), SEEK_SET) == -1)
+            vhdm->error = 1;
+        if (!fwrite(buff, (size_t) n * MVHD_SECTOR_SIZE, 1, vhdm->f))
+            vhdm->error = 1;
+
+        for (int i = sib; i < (sib + n); i++) {
+            if (!VHD_TESTBIT(bitmap, i)) {
+                VHD_SETBIT(bitmap, i);
+                bitmap_changed = true;
+            }
+        }
+
+        if (bitmap_changed)
+            write_sect_bitmap(vhdm, blk);
+
+        buff += (size_t) n * MVHD_SECTOR_SIZE;
+        s += n;
+    }
 
     fflush(vhdm->f);
 
@@ -33,11 +33,19 @@
 #include <86box/plat.h>
 #include <86box/ui.h>
 #include <86box/hdc_ide.h>
+#include <86box/hdd.h>
+#include <86box/hdd_aio.h>
 #include <86box/rdisk.h>
 #include <86box/version.h>
 
 #define IDE_ATAPI_IS_EARLY             id->sc->pad0
 
+#define RDISK_READ_AHEAD               128 /* Sectors, 64 kB. */
+
+#if RDISK_NUM > HDD_AIO_OTHER_QUEUES
+#    error Not enough asynchronous I/O queues for the removable disk drives
+#endif
+
 rdisk_drive_t rdisk_drives[RDISK_NUM];
 
 // clang-format off
@@ -143,6 +151,7 @@ static const mode_sense_pages_t zip_250_mode_sense_pages_changeable = {
 // clang-format on
 
 static void rdisk_command_complete(rdisk_t *dev);
+static void rdisk_aio_close(const rdisk_t *dev);
 static void rdisk_init(rdisk_t *dev);
 
 static uint32_t
@@ -201,6 +210,8 @@ rdisk_log(void *priv, const char *fmt, ...)
 static int
 rdisk_load_abort(const rdisk_t *dev)
 {
+    rdisk_aio_close(dev);
+
     if (dev->drv->fp)
         fclose(dev->drv->fp);
     dev->drv->fp           = NULL;
@@ -253,6 +264,8 @@ rdisk_load(const rdisk_t *dev, const char *fn, const int skip_insert)
         const int is_sdi = image_is_sdi(fn);
         const int is_zdi = image_is_zdi(fn);
 
+        rdisk_aio_close(dev);
+
         dev->drv->fp     = plat_fopen(fn, dev->drv->read_only ? "rb" : "rb+");
         ret              = 1;
 
@@ -336,6 +349,7 @@ static void
 rdisk_disk_unload(const rdisk_t *dev)
 {
     if ((dev->drv != NULL) && (dev->drv->fp != NULL)) {
+        rdisk_aio_close(dev);
         fclose(dev->drv->fp);
         dev->drv->fp = NULL;
     }
@@ -949,6 +963,183 @@ rdisk_data_phase_error(rdisk_t *dev, const uint32_t info)
     rdisk_cmd_error(dev);
 }
 
+/*
+ * Image accesses go through the asynchronous I/O layer, on a queue of their
+ * own, with the same read ahead and write behind as the SCSI hard disks: SCSI
+ * controllers take the data of a read as soon as the command returns, so a
+ * read can not be left running. Reads of up to RDISK_READ_AHEAD sectors have
+ * the layer fetch the next run of sectors in the background, for the next
+ * command to pick up. Writes are handed over once their data has been
+ * transferred and the command completes right away; a failed write is
+ * reported by the next command.
+ *
+ * Keep this state outside rdisk_t: that structure is shared with the
+ * controllers, while the requests are an implementation detail of this module.
+ */
+typedef struct rdisk_aio_t {
+    hdd_aio_req_t req;
+    hdd_aio_req_t write;
+    uint8_t      *write_buf;
+    uint32_t      write_buf_sz;
+    int           write_error;
+
+    hdd_aio_req_t read_ahead;
+    uint8_t      *read_ahead_buf;
+    uint32_t      read_ahead_sector;
+    uint32_t      read_ahead_count; /* 0 when there is nothing to pick up. */
+} rdisk_aio_t;
+
+static rdisk_aio_t rdisk_aio[RDISK_NUM];
+
+/* Carry out a request, called by a worker of the asynchronous I/O layer. */
+static int
+rdisk_image_io(void *priv, int op, uint32_t sector, uint32_t count, uint8_t *buffer)
+{
+    const rdisk_t *dev = (const rdisk_t *) priv;
+    const size_t   len = ((size_t) count) << 9;
+
+    if ((dev->drv->fp == NULL) ||
+        (fseek(dev->drv->fp, dev->drv->base + (sector << 9), SEEK_SET) == -1))
+        return -1;
+
+    if (op == HDD_AIO_WRITE) {
+        if (fwrite(buffer, 1, len, dev->drv->fp) != len)
+            return -1;
+        fflush(dev->drv->fp);
+    } else if (fread(buffer, 1, len, dev->drv->fp) != len)
+        return -1;
+
+    return 0;
+}
+
+/* Queue an access behind the ones already queued, and wait for it. */
+static int
+rdisk_aio_sync(const rdisk_t *dev, const int op, const uint32_t sector, const uint32_t count,
+               uint8_t *buffer)
+{
+    rdisk_aio_t *aio = &rdisk_aio[dev->id];
+
+    hdd_aio_submit_io(&aio->req, op, dev->id, rdisk_image_io, (void *) dev, sector, count, buffer);
+
+    return hdd_aio_finish(&aio->req);
+}
+
+/* Collect the write handed to the image by an earlier command. */
+static void
+rdisk_aio_write_collect(rdisk_aio_t *aio, const int wait)
+{
+    if ((aio->write.state == HDD_AIO_IDLE) || (!wait && hdd_aio_busy(&aio->write)))
+        return;
+
+    if (hdd_aio_finish(&aio->write) < 0)
+        aio->write_error = 1;
+}
+
+/* Return non-zero once if a write that already completed has failed since. */
+static int
+rdisk_aio_write_failed(const rdisk_t *dev)
+{
+    rdisk_aio_t *aio = &rdisk_aio[dev->id];
+    int          ret;
+
+    rdisk_aio_write_collect(aio, 0);
+
+    ret              = aio->write_error;
+    aio->write_error = 0;
+
+    return ret;
+}
+
+/* Whatever the read ahead brings in may be older than a write. */
+static void
+rdisk_aio_read_ahead_drop(rdisk_aio_t *aio)
+{
+    aio->read_ahead_count = 0;
+}
+
+static int
+rdisk_aio_write(const rdisk_t *dev, const uint32_t sector, const uint32_t count)
+{
+    rdisk_aio_t   *aio = &rdisk_aio[dev->id];
+    const uint32_t len = count << 9;
+    uint8_t       *buf;
+
+    rdisk_aio_read_ahead_drop(aio);
+    rdisk_aio_write_collect(aio, 1);
+
+    if (len > aio->write_buf_sz) {
+        buf = (uint8_t *) realloc(aio->write_buf, len);
+        if (buf == NULL)
+            return rdisk_aio_sync(dev, HDD_AIO_WRITE, sector, count, dev->buffer);
+
+        aio->write_buf    = buf;
+        aio->write_buf_sz = len;
+    }
+
+    memcpy(aio->write_buf, dev->buffer, len);
+    hdd_aio_submit_io(&aio->write, HDD_AIO_WRITE, dev->id, rdisk_image_io, (void *) dev,
+                      sector, count, aio->write_buf);
+
+    return 0;
+}
+
+static int
+rdisk_aio_read(const rdisk_t *dev, const uint32_t sector, const uint32_t count)
+{
+    rdisk_aio_t   *aio  = &rdisk_aio[dev->id];
+    const uint32_t next = sector + count;
+    const uint32_t end  = dev->drv->medium_size;
+    int            ret  = -1;
+    int            hit  = 0;
+
+    if (aio->read_ahead_count && (sector >= aio->read_ahead_sector) &&
+        (next <= (aio->read_ahead_sector + aio->read_ahead_count))) {
+        ret = hdd_aio_finish(&aio->read_ahead);
+        hit = (ret >= 0);
+        if (hit)
+            memcpy(dev->buffer, aio->read_ahead_buf + ((sector - aio->read_ahead_sector) << 9),
+                   count << 9);
+    }
+
+    /* This runs after everything queued to the image, read ahead included. */
+    if (!hit)
+        ret = rdisk_aio_sync(dev, HDD_AIO_READ, sector, count, dev->buffer);
+
+    rdisk_aio_read_ahead_drop(aio);
+    (void) hdd_aio_finish(&aio->read_ahead);
+
+    if ((ret >= 0) && (count <= RDISK_READ_AHEAD) && (next < end)) {
+        if (aio->read_ahead_buf == NULL)
+            aio->read_ahead_buf = (uint8_t *) malloc(RDISK_READ_AHEAD << 9);
+
+        if (aio->read_ahead_buf != NULL) {
+            aio->read_ahead_sector = next;
+            aio->read_ahead_count  = MIN(RDISK_READ_AHEAD, end - next);
+            hdd_aio_submit_io(&aio->read_ahead, HDD_AIO_READ, dev->id, rdisk_image_io, (void *) dev,
+                              aio->read_ahead_sector, aio->read_ahead_count, aio->read_ahead_buf);
+        }
+    }
+
+    return ret;
+}
+
+/* Wait for everything still running and let go of the buffers, this has to
+   be done before the image is touched directly. */
+static void
+rdisk_aio_close(const rdisk_t *dev)
+{
+    rdisk_aio_t *aio = &rdisk_aio[dev->id];
+
+    rdisk_aio_write_collect(aio, 1);
+    rdisk_aio_read_ahead_drop(aio);
+    (void) hdd_aio_finish(&aio->read_ahead);
+    hdd_aio_drain_io(dev->id);
+
+    free(aio->write_buf);
+    free(aio->read_ahead_buf);
+    memset(aio, 0x00, sizeof(rdisk_aio_t));
+}
+
 static int
 rdisk_blocks(rdisk_t *dev, int32_t *len, const int out)
 {
@@ -967,40 +1158,21 @@ rdisk_blocks(rdisk_t *dev, int32_t *len, const int out)
         } else {
             *len    = dev->requested_blocks << 9;
 
-            for (int i = 0; i < dev->requested_blocks; i++) {
-                if (fseek(dev->drv->fp, dev->drv->base + (dev->sector_pos << 9),
-                    SEEK_SET) == -1) {
-                    if (out)
-                        rdisk_write_error(dev);
-                    else
-                        rdisk_read_error(dev);
+            if (out) {
+                if (rdisk_aio_write(dev, dev->sector_pos, dev->requested_blocks) < 0) {
+                    rdisk_log(dev->log, "rdisk_blocks(): Error writing data\n");
+                    rdisk_write_error(dev);
                     ret = -1;
-                } else {
-                    if (feof(dev->drv->fp))
-                        break;
-
-                    if (out) {
-                        if (fwrite(dev->buffer + (i << 9), 1,
-                                   512, dev->drv->fp) != 512) {
-                            rdisk_log(dev->log, "rdisk_blocks(): Error writing data\n");
-                            rdisk_write_error(dev);
-                            ret = -1;
-                        } else
-                            fflush(dev->drv->fp);
-                    } else if (fread(dev->buffer + (i << 9), 1,
-                                     512, dev->drv->fp) != 512) {
-                        rdisk_log(dev->log, "rdisk_blocks(): Error reading data\n");
-                        rdisk_read_error(dev);
-                        ret = -1;
-                    }
                 }
-
-                if (ret == -1)
-                    break;
-
-                dev->sector_pos++;
+            } else if (rdisk_aio_read(dev, dev->sector_pos, dev->requested_blocks) < 0) {
+                rdisk_log(dev->log, "rdisk_blocks(): Error reading data\n");
+                rdisk_read_error(dev);
+                ret = -1;
             }
 
+            if (ret == 1)
+                dev->sector_pos += dev->requested_blocks;
+
             if (ret == 1) {
                 rdisk_log(dev->log, "%s %i bytes of blocks...\n", out ? "Written" :
                         "Read", *len);
@@ -1156,6 +1328,8 @@ rdisk_reset(scsi_common_t *sc)
 {
     rdisk_t *dev = (rdisk_t *) sc;
 
+    rdisk_aio_close(dev);
+
     rdisk_rezero(dev);
     dev->tf->status         = 0;
     dev->callback           = 0.0;
@@ -1299,6 +1473,14 @@ rdisk_command(scsi_common_t *sc, const uint8_t *cdb)
     if (rdisk_pre_execution_check(dev, cdb) == 0)
         return;
 
+    /* Report a write that failed after its command had completed. */
+    if ((cdb[0] != GPCMD_REQUEST_SENSE) && (cdb[0] != GPCMD_INQUIRY) &&
+        rdisk_aio_write_failed(dev)) {
+        rdisk_log(dev->log, "Deferred write error\n");
+        rdisk_write_error(dev);
+        return;
+    }
+
     switch (cdb[0]) {
         case GPCMD_SEND_DIAGNOSTIC:
             if (!(cdb[1] & (1 << 2))) {
@@ -2029,6 +2211,8 @@ rdisk_phase_data_out(scsi_common_t *sc)
                 rdisk_blocks(dev, &len, 1);
             break;
         case GPCMD_WRITE_SAME_10:
+            rdisk_aio_read_ahead_drop(&rdisk_aio[dev->id]);
+
             if (!dev->current_cdb[7] && !dev->current_cdb[8]) {
                 last_to_write = (dev->drv->medium_size - 1);
             } else
@@ -2054,14 +2238,9 @@ rdisk_phase_data_out(scsi_common_t *sc)
                     dev->buffer[6]   = (s >> 8) & 0xff;
                     dev->buffer[7]   = s & 0xff;
                 }
-                if (fseek(dev->drv->fp, dev->drv->base + (i << 9),
-                          SEEK_SET) == -1)
-                    log_fatal(dev->log, "rdisk_phase_data_out(): Error seeking\n");
-                if (fwrite(dev->buffer, 1, 512, dev->drv->fp) != 512)
+                if (rdisk_aio_sync(dev, HDD_AIO_WRITE, i, 1, dev->buffer) < 0)
                     log_fatal(dev->log, "rdisk_phase_data_out(): Error writing data\n");
             }
-
-            fflush(dev->drv->fp);
             break;
         case GPCMD_MODE_SELECT_6:
         case GPCMD_MODE_SELECT_10:
@@ -32,6 +32,7 @@
 #include <86box/io.h>
 #include <86box/pic.h>
 #include <86box/dma.h>
+#include <86box/snapshot.h>
 #include "808x_marty_86box.h"
 #include <86box/plat_unused.h>
 
@@ -2808,3 +2809,49 @@ dma_bm_write(uint32_t PhysAddress, const uint8_t *DataWrite, uint32_t TotalSize,
     if (dma_at)
         mem_invalidate_range(PhysAddress, PhysAddress + TotalSize - 1);
 }
+
+void
+dma_save_state(snapshot_t *snap)
+{
+    snapshot_write_var(snap, dma);
+    snapshot_write_var(snap, dma_e);
+    snapshot_write_var(snap, dma_m);
+    snapshot_write_var(snap, dmaregs);
+    snapshot_write_var(snap, dma_wp);
+    snapshot_write_var(snap, dma_stat);
+    snapshot_write_var(snap, dma_stat_rq);
+    snapshot_write_var(snap, dma_stat_rq_pc);
+    snapshot_write_var(snap, dma_stat_adv_pend);
+    snapshot_write_var(snap, dma_command);
+    snapshot_write_var(snap, dma_req_is_soft);
+    snapshot_write_var(snap, dma_advanced);
+    snapshot_write_var(snap, dma_sg_base);
+    snapshot_write_var(snap, dma_mask);
+    snapshot_write_var(snap, dma_ps2);
+    snapshot_write_var(snap, dma_xt8237);
+    snapshot_write_var(snap, dma_xt_refresh_queued);
+    snapshot_write_var(snap, dma_xt_refresh_scheduled);
+}
+
+void
+dma_load_state(snapshot_t *snap)
+{
+    snapshot_read_var(snap, dma);
+    snapshot_read_var(snap, dma_e);
+    snapshot_read_var(snap, dma_m);
+    snapshot_read_var(snap, dmaregs);
+    snapshot_read_var(snap, dma_wp);
+    snapshot_read_var(snap, dma_stat);
+    snapshot_read_var(snap, dma_stat_rq);
+    snapshot_read_var(snap, dma_stat_rq_pc);
+    snapshot_read_var(snap, dma_stat_adv_pend);
+    snapshot_read_var(snap, dma_command);
+    snapshot_read_var(snap, dma_req_is_soft);
+    snapshot_read_var(snap, dma_advanced);
+    snapshot_read_var(snap, dma_sg_base);
+    snapshot_read_var(snap, dma_mask);
+    snapshot_read_var(snap, dma_ps2);
+    snapshot_read_var(snap, dma_xt8237);
+    snapshot_read_var(snap, dma_xt_refresh_queued);
+    snapshot_read_var(snap, dma_xt_refresh_scheduled);
+}
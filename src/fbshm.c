@@ -0,0 +1,270 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Shared memory framebuffer export.
+ *
+ *          Publishes every blitted frame into a ring in POSIX shared
+ *          memory, so that other processes can look at the screen
+ *          without going through screenshots. Only the rows that changed
+ *          since a slot was last written are copied into it.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#ifndef _WIN32
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <unistd.h>
+#endif
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/video.h>
+#include <86box/fbshm.h>
+
+typedef struct fbshm_t {
+    char            name[80];
+    fbshm_header_t *hdr;
+    size_t          size;
+    uint64_t        seq;
+    int             slot;
+
+    /* Geometry of the previous frame. */
+    int             x;
+    int             y;
+    int             w;
+    int             h;
+
+    /* Rows of each slot that are older than the target buffer. */
+    int             slot_top[FBSHM_SLOTS];
+    int             slot_bottom[FBSHM_SLOTS];
+} fbshm_t;
+
+char fbshm_name[64] = { '\0' }; /* (O) export the monitors under this name */
+
+static fbshm_t *fbshm[MONITORS_NUM];
+static int      fbshm_failed[MONITORS_NUM];
+
+#ifdef ENABLE_FBSHM_LOG
+int fbshm_do_log = ENABLE_FBSHM_LOG;
+
+static void
+fbshm_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (fbshm_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define fbshm_log(fmt, ...)
+#endif
+
+static fbshm_frame_t *
+fbshm_get_frame(fbshm_t *dev, int slot)
+{
+    return (fbshm_frame_t *) (((uint8_t *) dev->hdr) + dev->hdr->frame_offset + ((size_t) slot * dev->hdr->frame_size));
+}
+
+static fbshm_t *
+fbshm_open(int monitor_index)
+{
+#ifdef _WIN32
+    pclog("FBSHM: Shared memory export is not supported on this platform\n");
+    return NULL;
+#else
+    fbshm_t *dev = (fbshm_t *) calloc(1, sizeof(fbshm_t));
+    size_t   frame_size;
+    int      fd;
+
+    snprintf(dev->name, sizeof(dev->name), "/%s-%i", fbshm_name, monitor_index);
+
+    frame_size = (sizeof(fbshm_frame_t) + 4095) & ~(size_t) 4095;
+    dev->size  = 4096 + (frame_size * FBSHM_SLOTS);
+
+    fd = shm_open(dev->name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (fd < 0) {
+        pclog("FBSHM: Unable to create %s\n", dev->name);
+        free(dev);
+        return NULL;
+    }
+
+    if (ftruncate(fd, (off_t) dev->size) != 0) {
+        pclog("FBSHM: Unable to size %s\n", dev->name);
+        close(fd);
+        shm_unlink(dev->name);
+        free(dev);
+        return NULL;
+    }
+
+    dev->hdr = (fbshm_header_t *) mmap(NULL, dev->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (dev->hdr == MAP_FAILED) {
+        pclog("FBSHM: Unable to map %s\n", dev->name);
+        shm_unlink(dev->name);
+        free(dev);
+        return NULL;
+    }
+
+    dev->hdr->version      = FBSHM_VERSION;
+    dev->hdr->nr_slots     = FBSHM_SLOTS;
+    dev->hdr->stride       = FBSHM_MAX_X;
+    dev->hdr->frame_offset = 4096;
+    dev->hdr->frame_size   = (uint32_t) frame_size;
+    dev->hdr->latest_seq   = 0;
+    dev->hdr->latest_slot  = 0;
+    atomic_thread_fence(memory_order_release);
+    dev->hdr->magic = FBSHM_MAGIC;
+
+    dev->slot = FBSHM_SLOTS - 1;
+    dev->w    = -1;
+
+    pclog("FBSHM: Exporting monitor %i as %s\n", monitor_index, dev->name);
+
+    return dev;
+#endif
+}
+
+void
+fbshm_blit(int x, int y, int w, int h, int monitor_index)
+{
+    fbshm_t            *dev;
+    fbshm_frame_t      *frame;
+    const video_rect_t *rects;
+    const bitmap_t     *buf = monitors[monitor_index].target_buffer;
+    int                 nr_rects;
+    int                 top;
+    int                 bottom;
+
+    if ((fbshm_name[0] == '\0') || (monitor_index >= MONITORS_NUM) || fbshm_failed[monitor_index] || (buf == NULL))
+        return;
+
+    if ((x < 0) || (y < 0) || (w <= 0) || (h <= 0) || ((x + w) > FBSHM_MAX_X) || ((y + h) > FBSHM_MAX_Y))
+        return;
+
+    dev = fbshm[monitor_index];
+    if (dev == NULL) {
+        dev = fbshm[monitor_index] = fbshm_open(monitor_index);
+        if (dev == NULL) {
+            fbshm_failed[monitor_index] = 1;
+            return;
+        }
+    }
+
+    /* Find the rows that changed in this frame. */
+    nr_rects = -1;
+    rects    = NULL;
+    if ((x == dev->x) && (y == dev->y) && (w == dev->w) && (h == dev->h)) {
+        nr_rects = video_blit_get_dirty_monitor(monitor_index, &rects);
+        if (nr_rects > FBSHM_MAX_DIRTY)
+            nr_rects = -1;
+    }
+
+    for (int i = 0; i < FBSHM_SLOTS; i++) {
+        if (nr_rects < 0) {
+            dev->slot_top[i]    = 0;
+            dev->slot_bottom[i] = h;
+            continue;
+        }
+
+        for (int j = 0; j < nr_rects; j++) {
+            top    = rects[j].y - y;
+            bottom = top + rects[j].h;
+
+            if (dev->slot_top[i] == dev->slot_bottom[i]) {
+                dev->slot_top[i]    = top;
+                dev->slot_bottom[i] = bottom;
+            } else {
+                dev->slot_top[i]    = MIN(dev->slot_top[i], top);
+                dev->slot_bottom[i] = MAX(dev->slot_bottom[i], bottom);
+            }
+        }
+    }
+    dev->x = x;
+    dev->y = y;
+    dev->w = w;
+    dev->h = h;
+
+    /* Bring the oldest slot up to date. */
+    dev->slot = (dev->slot + 1) % FBSHM_SLOTS;
+    dev->seq++;
+    frame = fbshm_get_frame(dev, dev->slot);
+
+    frame->seq = (dev->seq << 1) | 1;
+    atomic_thread_fence(memory_order_seq_cst);
+
+    /* The target buffer has the alpha byte set by some renderers (the 8, 15
+       and 16 bpp lookup tables) and clear with others, the export promises
+       0x00RRGGBB. */
+    for (int row = dev->slot_top[dev->slot]; row < dev->slot_bottom[dev->slot]; row++) {
+        const uint32_t *src = &buf->line[y + row][x];
+        uint32_t       *dst = &frame->pixels[row * FBSHM_MAX_X];
+
+        for (int col = 0; col < w; col++)
+            dst[col] = src[col] & 0x00ffffff;
+    }
+    dev->slot_top[dev->slot]    = 0;
+    dev->slot_bottom[dev->slot] = 0;
+
+    frame->w = w;
+    frame->h = h;
+    if (nr_rects < 0) {
+        frame->dirty[0].x = 0;
+        frame->dirty[0].y = 0;
+        frame->dirty[0].w = w;
+        frame->dirty[0].h = h;
+        frame->nr_dirty   = 1;
+    } else {
+        for (int i = 0; i < nr_rects; i++) {
+            frame->dirty[i].x = rects[i].x - x;
+            frame->dirty[i].y = rects[i].y - y;
+            frame->dirty[i].w = rects[i].w;
+            frame->dirty[i].h = rects[i].h;
+        }
+        frame->nr_dirty = nr_rects;
+    }
+
+    atomic_thread_fence(memory_order_release);
+    frame->seq = dev->seq << 1;
+
+    dev->hdr->latest_slot = dev->slot;
+    atomic_thread_fence(memory_order_release);
+    dev->hdr->latest_seq = dev->seq;
+
+    fbshm_log("FBSHM: Monitor %i frame %" PRIu64 ", %i dirty rectangles\n", monitor_index, dev->seq, frame->nr_dirty);
+}
+
+void
+fbshm_close(void)
+{
+    for (int i = 0; i < MONITORS_NUM; i++) {
+        if (fbshm[i] != NULL) {
+#ifndef _WIN32
+            munmap(fbshm[i]->hdr, fbshm[i]->size);
+            shm_unlink(fbshm[i]->name);
+#endif
+            free(fbshm[i]);
+            fbshm[i] = NULL;
+        }
+
+        fbshm_failed[i] = 0;
+    }
+}
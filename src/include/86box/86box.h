@@ -184,6 +184,7 @@ extern int      vid_cga_comp_sharpness;     /* (C) CGA composite sharpness */
 extern int      vid_cga_comp_hue;           /* (C) CGA composite hue */
 extern int      vid_cga_comp_saturation;    /* (C) CGA composite saturation */
 extern int      vid_cga_comp_contrast;      /* (C) CGA composite saturation */
+extern int      svga_render_threads;        /* (C) SVGA deferred rendering threads */
 extern int      video_fullscreen;           /* (C) video */
 extern int      video_fullscreen_scale;     /* (C) video */
 extern int      enable_overscan;            /* (C) video */
@@ -221,6 +222,8 @@ extern int      confirm_reset;              /* (G) enable reset confirmation */
 extern int      confirm_exit;               /* (G) enable exit confirmation */
 extern int      confirm_save;               /* (G) enable save confirmation */
 extern int      chd_precache_level;         /* (G) CHD precache level */
+extern int      chd_cache_hunks;            /* (G) CHD decompressed hunks to cache */
+extern int      hdd_image_cache_size;       /* (G) hard disk block cache size in MB */
 extern int      enable_discord;             /* (C) enable Discord integration */
 extern int      force_10ms;                 /* (C) force 10ms CPU frame interval */
 extern int      jumpered_internal_ecp_dma;  /* (C) Jumpered internal EPC DMA */
@@ -243,7 +246,12 @@ extern _Atomic double mouse_x_error;        /* Mouse error accumulator - Y */
 extern _Atomic double mouse_y_error;        /* Mouse error accumulator - Y */
 #endif
 extern int    pit_mode;                     /* (C) force setting PIT mode */
+extern int    timer_sched;                  /* (C) timer scheduler backend */
+extern int    dynarec_cache;                /* (C) persistent dynarec warm-start cache */
+extern int    dynarec_ir_passes;            /* (C) mask of dynarec IR optimization passes */
+extern int    dynarec_compile_budget;       /* (C) dynarec blocks recompiled per ms, 0 = unlimited */
 extern int    fm_driver;                    /* (C) select FM sound driver */
+extern int    fm_thread;                    /* (C) synthesize FM and EMU8000 on their own threads */
 extern int    hook_enabled;                 /* (C) Keyboard hook is enabled */
 extern int    vmm_disabled;                 /* (G) disable built-in manager */
 extern char   vmm_path_cfg[1024];           /* (G) VMs path (unless -E is used) */
@@ -338,7 +346,11 @@ struct accelKey {
 	char desc[64];
 	char seq[64];
 };
-#define NUM_ACCELS 17
+#ifdef USE_SNAPSHOT
+#    define NUM_ACCELS 19
+#else
+#    define NUM_ACCELS 17
+#endif
 extern struct accelKey acc_keys[NUM_ACCELS];
 extern struct accelKey def_acc_keys[NUM_ACCELS];
 extern int FindAccelerator(const char *name);
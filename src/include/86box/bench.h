@@ -0,0 +1,35 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the benchmark runner.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef EMU_BENCH_H
+#define EMU_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int bench_seconds; /* (O) run the benchmark for this many emulated seconds */
+
+/* Runs the machine unthrottled for bench_seconds emulated seconds, then
+   prints the statistics to the standard output as JSON. Called from the
+   emulation thread of the UI, in place of its paced main loop. */
+extern void bench_run(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_BENCH_H*/
@@ -167,6 +167,8 @@ typedef struct _device_config_ {
     const device_config_bios_t       bios[32];
 } device_config_t;
 
+struct snapshot_t;
+
 typedef struct _device_ {
     const char *name;
     const char *internal_name;
@@ -183,6 +185,12 @@ typedef struct _device_ {
     const char *alias;
     const char *machine;
     const device_config_t *config;
+
+    /* Optional save state support, see snapshot.h. Bump state_version
+       whenever the data written by save_state changes. */
+    void (*save_state)(void *priv, struct snapshot_t *snap);
+    void (*load_state)(void *priv, struct snapshot_t *snap);
+    uint32_t state_version;
 } device_t;
 
 typedef struct device_context_t {
@@ -221,6 +229,11 @@ extern void *device_get_priv(const device_t *dev);
 extern int   device_available(const device_t *dev);
 extern void  device_speed_changed(void);
 extern void  device_force_redraw(void);
+extern int   device_state_supported(void);
+extern void  device_save_state_all(struct snapshot_t *snap);
+extern int   device_check_state(const char *internal_name, int index, uint32_t version, uint64_t size);
+extern int   device_load_state(const char *internal_name, int index, uint32_t version, uint64_t size,
+                               struct snapshot_t *snap);
 extern const char *device_get_bus_name(const device_t *dev);
 extern void  device_get_name(const device_t *dev, int bus, char *name);
 extern int   device_has_config(const device_t *dev);
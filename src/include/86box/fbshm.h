@@ -0,0 +1,88 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the shared memory framebuffer export.
+ *
+ *          Every monitor is published as a POSIX shared memory object
+ *          named "/<name>-<monitor>", holding a header followed by a
+ *          ring of FBSHM_SLOTS frames, only accessible to the user
+ *          running the emulator. Readers map it read-only, pick the
+ *          slot named by latest_slot, and copy the frame out:
+ *
+ *              do {
+ *                  seq = frame->seq;       (retry while odd)
+ *                  ...copy the pixels...
+ *              } while (frame->seq != seq);
+ *
+ *          The dirty rectangles of a frame are relative to the frame
+ *          before it; a reader that skipped a frame (its sequence is not
+ *          the one it saw last plus one) has to take the whole frame.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef EMU_FBSHM_H
+#define EMU_FBSHM_H
+
+#include <stdint.h>
+
+#define FBSHM_MAGIC      0x4d485346 /* "FSHM" */
+#define FBSHM_VERSION    1
+#define FBSHM_SLOTS      3
+#define FBSHM_MAX_X      2048
+#define FBSHM_MAX_Y      2048
+#define FBSHM_MAX_DIRTY  32
+
+typedef struct fbshm_rect_t {
+    int32_t x;
+    int32_t y;
+    int32_t w;
+    int32_t h;
+} fbshm_rect_t;
+
+typedef struct fbshm_frame_t {
+    volatile uint64_t seq;      /* Frame sequence number times two, odd while being written. */
+    uint32_t          w;        /* Size of the frame in pixels. */
+    uint32_t          h;
+    uint32_t          nr_dirty; /* Rectangles changed since the previous frame. */
+    uint32_t          pad;
+    fbshm_rect_t      dirty[FBSHM_MAX_DIRTY];
+    uint32_t          pixels[FBSHM_MAX_X * FBSHM_MAX_Y]; /* 0x00RRGGBB, top byte always clear, FBSHM_MAX_X pixels per row. */
+} fbshm_frame_t;
+
+typedef struct fbshm_header_t {
+    uint32_t          magic;
+    uint32_t          version;
+    uint32_t          nr_slots;
+    uint32_t          stride;       /* Pixels per row. */
+    uint32_t          frame_offset; /* Offset of the first frame from the header. */
+    uint32_t          frame_size;   /* Distance between frames. */
+    volatile uint64_t latest_seq;   /* Sequence number of the newest complete frame, 0 if none. */
+    volatile uint32_t latest_slot;
+    uint32_t          pad;
+} fbshm_header_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern char fbshm_name[64]; /* (O) export the monitors under this name */
+
+/* Publishes the frame being blitted on a monitor. Called from the blit
+   thread, before the frame is handed to the UI. */
+extern void fbshm_blit(int x, int y, int w, int h, int monitor_index);
+extern void fbshm_close(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_FBSHM_H*/
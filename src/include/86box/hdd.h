@@ -166,6 +166,8 @@ typedef struct hard_disk_t {
     char               fn[MAX_IMAGE_PATH_LEN];     /* Name of current image file */
     /* Differential VHD parent file */
     char               vhd_parent[1280];
+    /* Shared base image, fn is then an overlay over it */
+    char               base_fn[1280];
 
     uint32_t           seek_pos;
     uint32_t           seek_len;
@@ -229,6 +231,31 @@ extern void     hdd_image_close(uint8_t id);
 extern void     hdd_image_sync(uint8_t id);
 extern void     hdd_image_sync_all(void);
 extern void     hdd_image_calc_chs(uint32_t *c, uint32_t *h, uint32_t *s, uint32_t size);
+extern int      hdd_image_io_parallel(uint8_t id);
+extern int      hdd_image_io(uint8_t id, int op, uint32_t sector, uint32_t count, uint8_t *buffer);
+extern int      hdd_image_raw_io(uint8_t id, int op, uint32_t sector, uint32_t count, uint8_t *buffer);
+
+typedef struct hdd_overlay_t hdd_overlay_t;
+
+extern hdd_overlay_t *hdd_overlay_open(const char *fn, const char *base_fn, uint64_t base_offset,
+                                       uint64_t sectors, int wp);
+extern int            hdd_overlay_io(hdd_overlay_t *ov, int op, uint32_t sector, uint32_t count, uint8_t *buffer);
+extern void           hdd_overlay_sync(hdd_overlay_t *ov);
+extern void           hdd_overlay_close(hdd_overlay_t *ov);
+
+/* Dirty cache blocks are written back once the disks were idle this long. */
+#define HDD_IMAGE_CACHE_IDLE_MS 1000
+
+extern uint64_t hdd_image_cache_hits;
+extern uint64_t hdd_image_cache_misses;
+
+extern void     hdd_image_cache_init(void);
+extern void     hdd_image_cache_close(void);
+extern int      hdd_image_cache_io(uint8_t id, int op, uint32_t sector, uint32_t count, uint8_t *buffer);
+extern int      hdd_image_cache_flush(uint8_t id);
+extern void     hdd_image_cache_invalidate(uint8_t id);
+extern int      hdd_image_cache_dirty(void);
+extern void     hdd_image_cache_flush_idle(void);
 
 extern int image_is_hdi(const char *s);
 extern int image_is_hdx(const char *s, int check_signature);
@@ -0,0 +1,97 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the asynchronous hard disk image I/O layer.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef EMU_HDD_AIO_H
+#define EMU_HDD_AIO_H
+
+/* Queues past those of the hard disk images, for other block devices that
+   bring their own I/O function, see hdd_aio_submit_io(). */
+#define HDD_AIO_OTHER_QUEUES 8
+#define HDD_AIO_QUEUES       (HDD_NUM + HDD_AIO_OTHER_QUEUES)
+
+enum {
+    HDD_AIO_READ = 0,
+    HDD_AIO_WRITE,
+    HDD_AIO_ZERO
+};
+
+enum {
+    HDD_AIO_IDLE = 0, /* Free to be submitted. */
+    HDD_AIO_QUEUED,   /* Waiting for, or being handled by, a worker. */
+    HDD_AIO_DONE      /* Finished, result not collected yet. */
+};
+
+/*
+ * A request, owned by the device that submits it. The buffer has to stay
+ * untouched until the result is collected with hdd_aio_finish().
+ */
+typedef struct hdd_aio_req_t {
+    struct hdd_aio_req_t *next;
+
+    uint8_t      id;
+    int          op;
+    uint32_t     sector;
+    uint32_t     count;
+    uint8_t     *buffer;
+
+    /* NULL for hard disk images. */
+    int        (*io)(void *priv, int op, uint32_t sector, uint32_t count, uint8_t *buffer);
+    void        *priv;
+
+    volatile int state;
+    int          result;
+} hdd_aio_req_t;
+
+extern void hdd_aio_close(void);
+
+/* Wakes the workers up, starting them if needed, so that they write the
+   block cache back once the disks go idle. */
+extern void hdd_aio_kick(void);
+
+/* Queue a request. Requests to the same image complete in order, except that
+   reads of raw images can overlap each other. */
+extern void hdd_aio_submit(hdd_aio_req_t *req, int op, uint8_t id, uint32_t sector,
+                           uint32_t count, uint8_t *buffer);
+
+/* Same, for a block device that is not a hard disk image. The request is
+   carried out by calling io() from a worker, in order with the other
+   requests of the queue, which is one of HDD_AIO_OTHER_QUEUES and has to be
+   drained before the device touches its image itself. */
+extern void hdd_aio_submit_io(hdd_aio_req_t *req, int op, uint8_t queue,
+                              int (*io)(void *priv, int op, uint32_t sector, uint32_t count, uint8_t *buffer),
+                              void *priv, uint32_t sector, uint32_t count, uint8_t *buffer);
+
+/* Returns non-zero while a request is still queued. Never blocks. */
+extern int  hdd_aio_busy(const hdd_aio_req_t *req);
+
+/* Waits for a request if needed, and returns its result, which is that of
+   hdd_image_read() and friends, and makes it idle again. Returns 0 for a
+   request that was never submitted. */
+extern int  hdd_aio_finish(hdd_aio_req_t *req);
+
+/* For device callbacks that run again until the access is done: submits the
+   request if it is idle, and returns non-zero while it is busy. Once it has
+   finished, stores its result and makes it idle again. */
+extern int  hdd_aio_poll(hdd_aio_req_t *req, int op, uint8_t id, uint32_t sector,
+                         uint32_t count, uint8_t *buffer, int *result);
+
+/* Waits for every queued request to an image. */
+extern void hdd_aio_drain(uint8_t id);
+
+/* Same, for one of HDD_AIO_OTHER_QUEUES. */
+extern void hdd_aio_drain_io(uint8_t queue);
+
+#endif /*EMU_HDD_AIO_H*/
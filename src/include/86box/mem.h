@@ -260,12 +260,7 @@ extern uint8_t *rom;
 extern uint32_t biosmask;
 extern uint32_t biosaddr;
 
-extern int        readlookup[512];
 extern uintptr_t  old_rl2;
-extern int        readlnext[2];
-extern int        writelookup[256];
-
-extern int        writelnext;
 extern uint32_t   ram_mapped_addr[64];
 extern uint8_t    page_ff[4096];
 
@@ -282,9 +277,16 @@ extern page_t  *pages;
 
 /* The lookup tables. */
 extern page_t *page_lookup[1048576];
-extern uintptr_t readlookup2[2097152];
+extern uintptr_t readlookup2[1048576];
 extern uintptr_t writelookup2[1048576];
 
+#ifdef ENABLE_MEM_LOG
+extern uint64_t mem_page_walks;
+extern uint64_t mem_tlb_evictions;
+extern uint64_t mem_cmp_tlb_hits;
+extern uint64_t mem_cmp_tlb_misses;
+#endif
+
 extern uint32_t get_phys_virt;
 extern uint32_t get_phys_phys;
 
@@ -354,6 +356,7 @@ extern uint8_t *getpccache(uint32_t a);
 extern uint64_t mmutranslatereal(uint32_t addr, int rw);
 extern uint32_t mmutranslatereal32(uint32_t addr, int rw);
 extern void     addreadlookup(uint32_t virt, uint32_t phys);
+extern uintptr_t readlookup_cmp(uint32_t virt);
 extern void     addwritelookup(uint32_t virt, uint32_t phys);
 
 extern void mem_mapping_set(mem_mapping_t *,
@@ -0,0 +1,49 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the shared memory network switch hub.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef EMU_NET_SWITCH_HUB_H
+#define EMU_NET_SWITCH_HUB_H
+
+typedef struct net_switch_hub_port_t net_switch_hub_port_t;
+
+extern char *net_switch_hub_secret; /* (O) run as the switch hub for this secret */
+
+/* Runs the hub for the given secret until interrupted. Returns 0 if the
+   hub could not be started. */
+extern int net_switch_hub_run(const char *secret);
+
+/* Attaches to the hub for the given secret, or returns NULL if none runs. */
+extern net_switch_hub_port_t *net_switch_hub_attach(const char *secret, int promisc);
+extern void                   net_switch_hub_detach(net_switch_hub_port_t *port);
+
+/* Becomes readable when the hub rang, or hangs up if the hub went away. */
+extern int net_switch_hub_get_fd(const net_switch_hub_port_t *port);
+
+/* Queues a frame for the hub. Returns 0 if the ring was full. Frames only
+   reach the hub once net_switch_hub_flush() is called after a batch. */
+extern int  net_switch_hub_send(net_switch_hub_port_t *port, const uint8_t *data, int len);
+extern void net_switch_hub_flush(net_switch_hub_port_t *port);
+
+/* Takes a frame from the hub, returning its length, or 0 if there is none. */
+extern int net_switch_hub_recv(net_switch_hub_port_t *port, uint8_t *data);
+
+/* To be called before sleeping on the descriptor. Returns non-zero if
+   frames arrived in the meantime, in which case sleeping is not safe. */
+extern int  net_switch_hub_prepare_wait(net_switch_hub_port_t *port);
+/* Clears the doorbell after waking up. Returns 0 if the hub went away. */
+extern int  net_switch_hub_ack(net_switch_hub_port_t *port);
+
+#endif /*EMU_NET_SWITCH_HUB_H*/
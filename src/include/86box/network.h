@@ -52,12 +52,16 @@
 #define NET_TYPE_TAP      4 /* use a linux TAP device */
 #define NET_TYPE_NLSWITCH 5 /* use the local switch provider */
 #define NET_TYPE_NRSWITCH 6 /* use the remote switch provider */
+#define NET_TYPE_BENCH    -1 /* generate traffic for --netbench, never saved */
 
 #define NET_MAX_FRAME  1518
-/* Queue size must be a power of 2 */
+/* Packets handed to or taken from the host drivers at a time. */
 #define NET_QUEUE_LEN      16
-#define NET_QUEUE_LEN_MASK (NET_QUEUE_LEN - 1)
-#define NET_QUEUE_COUNT    4
+/* Queue depths, rounded up to a power of 2 */
+#define NET_QUEUE_DEPTH_DEF 64
+#define NET_QUEUE_DEPTH_MIN 16
+#define NET_QUEUE_DEPTH_MAX 4096
+#define NET_QUEUE_COUNT    5
 #define NET_CARD_MAX       4
 #define NET_HOST_INTF_MAX  64
 
@@ -87,7 +91,8 @@ enum {
     NET_QUEUE_RX       = 0,
     NET_QUEUE_TX_VM    = 1,
     NET_QUEUE_TX_HOST  = 2,
-    NET_QUEUE_RX_ON_TX = 3
+    NET_QUEUE_RX_ON_TX = 3,
+    NET_QUEUE_RX_LOCAL = 4  /* Looped back by the card itself. */
 };
 
 typedef struct netcard_conf_t {
@@ -99,6 +104,7 @@ typedef struct netcard_conf_t {
     uint8_t  promisc_mode;
     char     slirp_net[16];
     char     nrs_hostname[128];
+    int      queue_depth;
 } netcard_conf_t;
 
 extern netcard_conf_t net_cards_conf[NET_CARD_MAX];
@@ -113,11 +119,7 @@ typedef struct netpkt {
     int      len;
 } netpkt_t;
 
-typedef struct netqueue_t {
-    netpkt_t packets[NET_QUEUE_LEN];
-    int      head;
-    int      tail;
-} netqueue_t;
+typedef struct netqueue_t netqueue_t;
 
 typedef struct _netcard_t netcard_t;
 
@@ -126,14 +128,29 @@ typedef struct netdrv_t {
     void *(*init)(const netcard_t *card, const uint8_t *mac_addr, void *priv, char *netdrv_errbuf);
     void (*close)(void *priv);
     void *priv;
+    /* Optional, called from the emulation thread once the card took a frame. */
+    void (*rx_done)(void *priv, const netpkt_t *pkt);
 } netdrv_t;
 
+typedef struct net_bench_stats_t {
+    uint64_t rx_offered;   /* Frames offered to the cards. */
+    uint64_t rx_skipped;   /* Frames not generated, as the generator fell behind. */
+    uint64_t rx_delivered; /* Frames the cards took. */
+    uint64_t rx_dropped;   /* Frames lost to full queues. */
+    uint64_t tx_packets;
+    uint64_t tx_bytes;
+    uint64_t tx_dropped;
+    uint64_t latency_sum_us; /* From being offered to being taken. */
+    uint64_t latency_max_us;
+} net_bench_stats_t;
+
 extern const netdrv_t net_pcap_drv;
 extern const netdrv_t net_slirp_drv;
 extern const netdrv_t net_vde_drv;
 extern const netdrv_t net_tap_drv;
 extern const netdrv_t net_null_drv;
 extern const netdrv_t net_switch_drv;
+extern const netdrv_t net_bench_drv;
 
 struct _netcard_t {
     const device_t *device;
@@ -141,10 +158,8 @@ struct _netcard_t {
     struct netdrv_t host_drv;
     NETRXCB         rx;
     NETSETLINKSTATE set_link_state;
-    netqueue_t      queues[NET_QUEUE_COUNT];
+    netqueue_t     *queues; /* NET_QUEUE_COUNT of them */
     netpkt_t        queued_pkt;
-    mutex_t        *tx_mutex;
-    mutex_t        *rx_mutex;
     pc_timer_t      timer;
     uint16_t        card_num;
     double          byte_period;
@@ -178,6 +193,8 @@ extern network_devmap_t network_devmap;
 extern int              network_ndev;   // Number of pcap devices
 extern network_devmap_t network_devmap; // Bitmap of available network types
 extern netdev_t         network_devs[NET_HOST_INTF_MAX];
+extern int              net_bench_rate; /* (O) offer the cards this many frames per second */
+extern int              net_bench_size; /* (O) of this size */
 
 
 /* Function prototypes. */
@@ -214,6 +231,9 @@ extern int network_rx_on_tx_popv(netcard_t *card, netpkt_t *pkt_vec, int vec_siz
 extern int network_rx_on_tx_put(netcard_t *card, uint8_t *bufp, int len);
 extern int network_rx_put_pkt(netcard_t *card, netpkt_t *pkt);
 extern int network_rx_on_tx_put_pkt(netcard_t *card, netpkt_t *pkt);
+extern void network_get_dropped(const netcard_t *card, uint32_t *rx, uint32_t *tx);
+
+extern void net_bench_get_stats(net_bench_stats_t *stats);
 
 #ifdef EMU_DEVICE_H
 /* 3Com Etherlink */
@@ -0,0 +1,99 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the machine save state module.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef EMU_SNAPSHOT_H
+#define EMU_SNAPSHOT_H
+
+/* Version of the container format; chunk contents are versioned by their owners. */
+#define SNAPSHOT_VERSION  2
+
+#define SNAPSHOT_NAME_LEN 64
+
+enum {
+    SNAPSHOT_NONE = 0,
+    SNAPSHOT_SAVE,
+    SNAPSHOT_LOAD
+};
+
+/*
+ * A save state is a header followed by a list of chunks. Each chunk has a
+ * name, an index (to tell apart several instances of the same device), the
+ * version of its owner's state layout and a size.
+ *
+ * Core modules that are not devices (CPU, memory, timers, PIC, DMA) store
+ * their chunks under names starting with '@'. Devices store their chunks
+ * under their internal name, using the save_state and load_state callbacks
+ * of device_t. Machines with a device that does not provide them can not be
+ * saved or loaded.
+ *
+ * A save state can only be loaded into the same configuration it was made
+ * with. Before anything is restored, every chunk is checked against its
+ * owner: the version must match, and the size must be what the owner would
+ * save now, so a layout change that was not given a new version is caught
+ * too. Loading then performs a hard reset, so that every device is recreated
+ * before its state is restored.
+ *
+ * Few devices have save state support yet, so the UI and command line entry
+ * points are only built with the SNAPSHOT option.
+ *
+ * The UI asks for a save or a load with snapshot_request(); the emulation
+ * thread carries it out between two blocks of code, in snapshot_process().
+ */
+typedef struct snapshot_t snapshot_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern int  snapshot_save(const char *fn);
+extern int  snapshot_load(const char *fn);
+extern void snapshot_request(int op, const char *fn);
+extern void snapshot_process(void);
+
+/* Chunk handling, used by the core modules and device_save_state_all(). */
+extern void snapshot_begin_chunk(snapshot_t *snap, const char *name, int index, uint32_t version);
+extern void snapshot_end_chunk(snapshot_t *snap);
+
+/* Serialization of data within a chunk. Reading past the end of a chunk
+   returns zeroes and flags an error. */
+extern void snapshot_write(snapshot_t *snap, const void *data, size_t size);
+extern void snapshot_read(snapshot_t *snap, void *data, size_t size);
+extern int  snapshot_error(snapshot_t *snap);
+extern uint64_t snapshot_state_size(void (*save)(void *priv, snapshot_t *snap), void *priv);
+
+#define snapshot_write_var(snap, var) snapshot_write(snap, &(var), sizeof(var))
+#define snapshot_read_var(snap, var)  snapshot_read(snap, &(var), sizeof(var))
+
+/* Timers are restored relative to the saved TSC, and re-enabled if needed. */
+struct pc_timer_t;
+extern void snapshot_write_timer(snapshot_t *snap, const struct pc_timer_t *timer);
+extern void snapshot_read_timer(snapshot_t *snap, struct pc_timer_t *timer);
+
+/* Core module state. */
+extern void cpu_save_state(snapshot_t *snap);
+extern void cpu_load_state(snapshot_t *snap);
+extern void mem_save_state(snapshot_t *snap);
+extern void mem_load_state(snapshot_t *snap);
+extern void pic_save_state(snapshot_t *snap);
+extern void pic_load_state(snapshot_t *snap);
+extern void dma_save_state(snapshot_t *snap);
+extern void dma_load_state(snapshot_t *snap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_SNAPSHOT_H*/
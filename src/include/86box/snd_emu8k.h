@@ -400,6 +400,11 @@ typedef struct emu8k_t {
     int32_t buffer[WTBUFLEN * 2];
 
     uint16_t addr;
+
+    /* Set when the chip is synthesized on its own thread, synth_ptr
+       then mirrors the pointer register for the emulation thread. */
+    struct synth_thread_t *synth;
+    uint16_t               synth_ptr;
 } emu8k_t;
 
 void emu8k_change_addr(emu8k_t *emu8k, uint16_t emu_addr);
@@ -407,7 +412,7 @@ void emu8k_init(emu8k_t *emu8k, uint16_t emu_addr, int onboard_ram);
 void emu8k_close(emu8k_t *emu8k);
 void emu8k_reset_buffer(emu8k_t *emu8k);
 
-void emu8k_update(emu8k_t *emu8k);
+int32_t *emu8k_get_buffer(emu8k_t *emu8k);
 
 #define EMU8K_ROM_PATH "roms/sound/creative/awe32.raw"
 
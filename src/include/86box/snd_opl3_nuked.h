@@ -235,6 +235,9 @@ typedef struct {
     int32_t buffer[MUSICBUFLEN * 2];
 
     int32_t *(*update)(void *priv);
+
+    struct synth_thread_t *synth; /* NULL if synthesizing inline */
+    uint8_t                newm;  /* Copy of opl.newm owned by the emulation thread */
 } nuked_opl3_drv_t;
 
 enum {
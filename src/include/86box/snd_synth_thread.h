@@ -0,0 +1,46 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the sound synthesis thread.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#ifndef SOUND_SYNTH_THREAD_H
+#define SOUND_SYNTH_THREAD_H
+
+typedef struct synth_thread_t synth_thread_t;
+
+/* Called on the synthesis thread, to apply a register write, and to
+   generate num stereo samples into buf. */
+typedef void (*synth_write_t)(void *priv, uint16_t reg, uint16_t val);
+typedef void (*synth_generate_t)(void *priv, int32_t *buf, int num);
+
+/* Buffers hold up to max_len stereo samples. */
+extern synth_thread_t *synth_thread_create(const char *name, synth_write_t write, synth_generate_t generate,
+                                           void *priv, int max_len);
+extern void            synth_thread_close(synth_thread_t *st);
+
+/* Queue a register write to happen pos samples into the current buffer. */
+extern void synth_thread_write(synth_thread_t *st, int pos, uint16_t reg, uint16_t val);
+
+/* End the current buffer after len samples, and start rendering it. */
+extern void synth_thread_flush(synth_thread_t *st, int len);
+
+/* Waits for every queued write to be applied, so the chip state can be
+   read from the emulation thread until the next write or flush. */
+extern void synth_thread_sync(synth_thread_t *st);
+
+/* Returns the previous buffer, waiting for it to be rendered if needed.
+   The output is therefore one buffer late. */
+extern int32_t *synth_thread_get_buffer(synth_thread_t *st);
+
+#endif /*SOUND_SYNTH_THREAD_H*/
@@ -92,6 +92,14 @@ extern void wavetable_add_handler(void (*get_buffer)(int32_t *buffer,
                                                      uint16_t len, void *priv),
                                   void *priv);
 
+extern void sound_set_handler_gain(void *priv, float gain);
+
+extern void   sound_mix_simd_init(void);
+extern void   sound_mix_accum(int32_t *dst, const int32_t *src, int count, float gain);
+extern void   sound_mix_to_int16(int16_t *dst, const int32_t *src, int count);
+extern void   sound_mix_to_float(float *dst, const int32_t *src, int count);
+extern double sound_mix_bench(int sources);
+
 extern void sound_set_cd_audio_filter(void (*filter)(int     channel,
                                                      double *buffer, void *priv),
                                       void *priv);
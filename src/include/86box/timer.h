@@ -19,6 +19,10 @@ extern uint64_t tsc;
 #define TIMER_SPLIT   2
 #define TIMER_ENABLED 1
 
+/* Scheduler backends, selected by timer_sched when timer_init() is called. */
+#define TIMER_SCHED_LIST 0 /* Sorted doubly-linked list, O(n) insertion. */
+#define TIMER_SCHED_HEAP 1 /* 4-ary min-heap, O(log n) insertion/removal. */
+
 /*Timers are based on the CPU Time Stamp Counter. Timer timestamps are in a
   32:32 fixed point format, with the integer part compared against the TSC. The
   fractional part is used when advancing the timestamp to ensure a more accurate
@@ -44,6 +48,9 @@ typedef struct pc_timer_t {
 
     struct pc_timer_t *prev;
     struct pc_timer_t *next;
+
+    uint32_t heap_idx; /* Position in the heap, only valid when enabled. */
+    uint32_t heap_seq; /* Insertion order, used to break heap ties. */
 } pc_timer_t;
 
 #ifdef __cplusplus
@@ -54,6 +61,9 @@ extern "C" {
   when TSC matches or exceeds this.*/
 extern uint64_t timer_target;
 
+/*Number of timer callbacks run, for benchmarking*/
+extern uint64_t timer_callbacks;
+
 /*Enable timer, without updating timestamp*/
 extern void timer_enable(pc_timer_t *timer);
 /*Disable timer*/
@@ -70,6 +80,10 @@ extern void timer_init(void);
   timestamp - this is useful for permanently enabled timers*/
 extern void timer_add(pc_timer_t *timer, void (*callback)(void *priv), void *priv, int start_timer);
 
+/*Time count recurring timers on the given backend, for benchmarking.
+  Returns nanoseconds per expiry*/
+extern double timer_sched_bench(int sched, int count);
+
 /*1us in 32:32 format*/
 extern uint64_t TIMER_USEC;
 
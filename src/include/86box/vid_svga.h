@@ -335,6 +335,17 @@ typedef struct svga_t {
     void *     priv_parent;
 
     void *     local;
+
+    /* Deferred rendering state, NULL if lines are rendered as they are reached. */
+    struct svga_render_mt_t *render_mt;
+
+    /* Bands of target buffer rows redrawn since the last blit. */
+    int          dirty_full;
+    int          dirty_nr;
+    video_rect_t dirty[VIDEO_MAX_DIRTY_RECTS];
+    video_rect_t dirty_blit;
+    uint32_t     dirty_overscan_color;
+    int          dirty_dpms;
 } svga_t;
 
 extern void     ibm8514_set_poll(svga_t *svga);
@@ -380,6 +391,8 @@ extern int  svga_init(const device_t *info, svga_t *svga, void *priv, int memsiz
 extern void svga_recalctimings(svga_t *svga);
 extern void svga_close(svga_t *svga);
 
+extern uint32_t svga_conv_16to32(struct svga_t *svga, uint16_t color, uint8_t bpp);
+
 uint8_t  svga_read(uint32_t addr, void *priv);
 uint16_t svga_readw(uint32_t addr, void *priv);
 uint32_t svga_readl(uint32_t addr, void *priv);
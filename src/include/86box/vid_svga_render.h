@@ -39,6 +39,16 @@ extern void svga_render_null(svga_t *svga);
 extern void svga_render_blank(svga_t *svga);
 extern void svga_render_overscan_left(svga_t *svga);
 extern void svga_render_overscan_right(svga_t *svga);
+
+extern void svga_render_mt_init(svga_t *svga, int threads);
+extern void svga_render_mt_close(svga_t *svga);
+extern int  svga_render_mt_line(svga_t *svga);
+extern void svga_render_mt_flush(svga_t *svga);
+
+extern void svga_render_simd_init(void);
+extern void svga_render_line_32bpp(uint32_t *p, const uint8_t *vram, uint32_t addr, uint32_t mask, int count);
+extern void svga_render_line_16bpp(uint32_t *p, const uint8_t *vram, uint32_t addr, uint32_t mask, int count, int bpp);
+
 extern void svga_render_text_40(svga_t *svga);
 extern void svga_render_text_80(svga_t *svga);
 extern void svga_render_text_80_ksc5601(svga_t *svga);
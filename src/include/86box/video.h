@@ -125,6 +125,16 @@ typedef struct dbcs_font_t {
     uint8_t chr[32];
 } dbcs_font_t;
 
+/* A region of the target buffer, used to report what changed in a frame. */
+typedef struct video_rect_t {
+    int x;
+    int y;
+    int w;
+    int h;
+} video_rect_t;
+
+#define VIDEO_MAX_DIRTY_RECTS 32
+
 struct blit_data_struct;
 
 typedef struct monitor_t {
@@ -295,6 +305,8 @@ extern void video_blit_memtoscreen_8(int x, int y, int w, int h);
 extern void video_blend_monitor(int x, int y, int monitor_index);
 extern void video_process_8_monitor(int x, int y, int monitor_index);
 extern void video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index);
+extern void video_blit_memtoscreen_dirty_monitor(int x, int y, int w, int h, const video_rect_t *rects, int nr_rects, int monitor_index);
+extern int  video_blit_get_dirty_monitor(int monitor_index, const video_rect_t **rects);
 extern void video_blit_complete_monitor(int monitor_index);
 extern void video_wait_for_blit_monitor(int monitor_index);
 extern void video_wait_for_buffer_monitor(int monitor_index);
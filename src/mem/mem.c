@@ -37,6 +37,7 @@
 #include <86box/mem.h>
 #include <86box/plat.h>
 #include <86box/rom.h>
+#include <86box/snapshot.h>
 #include <86box/gdbstub.h>
 #ifdef USE_DYNAREC
 #    include "codegen_public.h"
@@ -80,17 +81,47 @@ uint32_t biosaddr;
 uint32_t pccache;
 uint8_t *pccache2;
 
-int        readlnext[2];
-int        readlookup[512];
 uintptr_t  old_rl2;
-int        writelnext;
-int        writelookup[256];
 
 /* The lookup tables. */
 page_t *page_lookup[1048576] = { 0 };
-uintptr_t readlookup2[2097152] = { 0 };
+uintptr_t readlookup2[1048576] = { 0 };
 uintptr_t writelookup2[1048576] = { 0 };
 
+/* Translations are held in small set-associative TLBs tagged with the
+   virtual page. The read and write TLBs decide which pages are live, and
+   readlookup2, writelookup2 and page_lookup only mirror their entries, as
+   the readmem/writemem macros and the dynarecs index those directly. Read
+   lookups made while is_compare is set (the second operand of CMPS and
+   friends) only go into the compare TLB, which is probed through
+   readlookup_cmp() by the compare read macros in 386_common.h and by the
+   misaligned read paths in this file. */
+#define MEM_TLB_SETS 64
+#define MEM_TLB_WAYS 4
+#define MEM_TLB_INV  0xffffffff
+
+typedef struct mem_tlb_t {
+    uint32_t  tag[MEM_TLB_WAYS];
+    uintptr_t lookup[MEM_TLB_WAYS];
+    int       next;
+} mem_tlb_t;
+
+static mem_tlb_t read_tlb[MEM_TLB_SETS];
+static mem_tlb_t write_tlb[MEM_TLB_SETS];
+static mem_tlb_t cmp_tlb[MEM_TLB_SETS];
+static int       cmp_tlb_used;
+
+#ifdef ENABLE_MEM_LOG
+uint64_t mem_page_walks;
+uint64_t mem_tlb_evictions;
+uint64_t mem_cmp_tlb_hits;
+uint64_t mem_cmp_tlb_misses;
+
+#    define mem_stat_inc(x) (x)++
+#else
+#    define mem_stat_inc(x)
+#endif
+
 
 uint32_t mem_logical_addr;
 
@@ -98,7 +129,6 @@ int shadowbios = 0;
 int shadowbios_write;
 int readlnum  = 0;
 int writelnum = 0;
-int cachesize = 256;
 
 uint32_t get_phys_virt;
 uint32_t get_phys_phys;
@@ -165,28 +195,136 @@ mem_addr_is_ram(uint32_t addr)
            (mapping == &ram_mid_mapping2) || (mapping == &ram_remapped_mapping);
 }
 
-void
-resetreadlookup(void)
+static void
+mem_tlb_reset(mem_tlb_t *tlb)
 {
-    /* Initialize the page lookup table. */
-    memset(page_lookup, 0x00, (1 << 20) * sizeof(page_t *));
+    for (uint8_t c = 0; c < MEM_TLB_SETS; c++) {
+        for (uint8_t d = 0; d < MEM_TLB_WAYS; d++)
+            tlb[c].tag[d] = MEM_TLB_INV;
+        tlb[c].next = 0;
+    }
+}
+
+/* Returns the page that had to make room, or MEM_TLB_INV if none did. */
+static uint32_t
+mem_tlb_add(mem_tlb_t *tlb, uint32_t virt, uintptr_t lookup)
+{
+    mem_tlb_t *set = &tlb[(virt >> 12) & (MEM_TLB_SETS - 1)];
+    uint32_t   old;
+
+    for (uint8_t c = 0; c < MEM_TLB_WAYS; c++) {
+        if (set->tag[c] == (virt >> 12)) {
+            set->lookup[c] = lookup;
+            return MEM_TLB_INV;
+        }
+    }
+
+    old                    = set->tag[set->next];
+    set->tag[set->next]    = virt >> 12;
+    set->lookup[set->next] = lookup;
+    set->next              = (set->next + 1) & (MEM_TLB_WAYS - 1);
+
+    if (old != MEM_TLB_INV)
+        mem_stat_inc(mem_tlb_evictions);
+
+    return old;
+}
+
+static __inline void
+cmp_tlb_flush(void)
+{
+    if (cmp_tlb_used) {
+        mem_tlb_reset(cmp_tlb);
+        cmp_tlb_used = 0;
+    }
+}
+
+static __inline const uintptr_t *
+mem_tlb_find(const mem_tlb_t *tlb, uint32_t virt)
+{
+    const mem_tlb_t *set = &tlb[(virt >> 12) & (MEM_TLB_SETS - 1)];
+
+    for (uint8_t c = 0; c < MEM_TLB_WAYS; c++) {
+        if (set->tag[c] == (virt >> 12))
+            return &set->lookup[c];
+    }
+
+    return NULL;
+}
+
+static __inline uintptr_t
+cmp_tlb_lookup(uint32_t virt)
+{
+    const uintptr_t *lookup = mem_tlb_find(cmp_tlb, virt);
+
+    if (lookup) {
+        mem_stat_inc(mem_cmp_tlb_hits);
+        return *lookup;
+    }
 
-    /* Initialize the tables for lower (<= 1024K) RAM. */
-    for (uint16_t c = 0; c < 512; c++) {
-        readlookup[c]  = 0xffffffff;
+    mem_stat_inc(mem_cmp_tlb_misses);
+    return (uintptr_t) LOOKUP_INV;
+}
+
+uintptr_t
+readlookup_cmp(uint32_t virt)
+{
+    return cmp_tlb_lookup(virt);
+}
+
+static __inline uintptr_t
+readlookup_get(uint32_t virt)
+{
+    if (is_compare)
+        return cmp_tlb_lookup(virt);
+
+    return readlookup2[virt >> 12];
+}
+
+static void
+read_tlb_flush(void)
+{
+    for (uint8_t c = 0; c < MEM_TLB_SETS; c++) {
+        for (uint8_t d = 0; d < MEM_TLB_WAYS; d++) {
+            if (read_tlb[c].tag[d] != MEM_TLB_INV) {
+                readlookup2[read_tlb[c].tag[d]] = LOOKUP_INV;
+                read_tlb[c].tag[d]              = MEM_TLB_INV;
+            }
+        }
+    }
+}
 
-        if (c < 256)
-            writelookup[c] = 0xffffffff;
+static void
+write_tlb_flush(void)
+{
+    for (uint8_t c = 0; c < MEM_TLB_SETS; c++) {
+        for (uint8_t d = 0; d < MEM_TLB_WAYS; d++) {
+            if (write_tlb[c].tag[d] != MEM_TLB_INV) {
+                page_lookup[write_tlb[c].tag[d]]  = NULL;
+                writelookup2[write_tlb[c].tag[d]] = LOOKUP_INV;
+                write_tlb[c].tag[d]               = MEM_TLB_INV;
+            }
+        }
     }
+}
+
+void
+resetreadlookup(void)
+{
+    /* Clear the page lookup table. Every live entry is in the write TLB,
+       so walk that rather than dirtying all 8 MiB of the table. */
+    write_tlb_flush();
 
     /* Initialize the tables for high (> 1024K) RAM. */
-    memset(readlookup2, 0xff, (2 << 20) * sizeof(uintptr_t));
+    memset(readlookup2, 0xff, (1 << 20) * sizeof(uintptr_t));
 
     memset(writelookup2, 0xff, (1 << 20) * sizeof(uintptr_t));
 
-    readlnext[0] = 0;
-    readlnext[1] = 0;
-    writelnext   = 0;
+    mem_tlb_reset(read_tlb);
+    mem_tlb_reset(write_tlb);
+    mem_tlb_reset(cmp_tlb);
+    cmp_tlb_used = 0;
+
     pccache      = 0xffffffff;
     high_page    = 0;
 }
@@ -194,18 +332,9 @@ resetreadlookup(void)
 void
 flushmmucache(void)
 {
-    for (uint16_t c = 0; c < 512; c++) {
-        if (readlookup[c] != (int) 0xffffffff) {
-            readlookup2[readlookup[c]] = LOOKUP_INV;
-            readlookup2[readlookup[c] | 1048576] = LOOKUP_INV;
-            readlookup[c]              = 0xffffffff;
-        }
-        if ((c < 256) && (writelookup[c] != (int) 0xffffffff)) {
-            page_lookup[writelookup[c]]  = NULL;
-            writelookup2[writelookup[c]] = LOOKUP_INV;
-            writelookup[c]               = 0xffffffff;
-        }
-    }
+    read_tlb_flush();
+    write_tlb_flush();
+    cmp_tlb_flush();
     mmuflush++;
 
     pccache  = (uint32_t) 0xffffffff;
@@ -219,13 +348,7 @@ flushmmucache(void)
 void
 flushmmucache_write(void)
 {
-    for (uint16_t c = 0; c < 256; c++) {
-        if (writelookup[c] != (int) 0xffffffff) {
-            page_lookup[writelookup[c]]  = NULL;
-            writelookup2[writelookup[c]] = LOOKUP_INV;
-            writelookup[c]               = 0xffffffff;
-        }
-    }
+    write_tlb_flush();
     mmuflush++;
 }
 
@@ -245,32 +368,25 @@ flushmmucache_pc(void)
 void
 flushmmucache_nopc(void)
 {
-    for (uint16_t c = 0; c < 512; c++) {
-        if (readlookup[c] != (int) 0xffffffff) {
-            readlookup2[readlookup[c]] = LOOKUP_INV;
-            readlookup2[readlookup[c] | 1048576] = LOOKUP_INV;
-            readlookup[c]              = 0xffffffff;
-        }
-        if ((c < 256) && (writelookup[c] != (int) 0xffffffff)) {
-            page_lookup[writelookup[c]]  = NULL;
-            writelookup2[writelookup[c]] = LOOKUP_INV;
-            writelookup[c]               = 0xffffffff;
-        }
-    }
+    read_tlb_flush();
+    write_tlb_flush();
+    cmp_tlb_flush();
 }
 
 void
 mem_flush_write_page(uint32_t addr, uint32_t virt)
 {
-    const page_t *page_target = &pages[addr >> 12];
-
-    for (uint16_t c = 0; c < 256; c++) {
-        if (writelookup[c] != (int) 0xffffffff) {
-            uintptr_t target = (uintptr_t) &ram[(uintptr_t) (addr & ~0xfff) - (virt & ~0xfff)];
-            if (writelookup2[writelookup[c]] == target || page_lookup[writelookup[c]] == page_target) {
-                writelookup2[writelookup[c]] = LOOKUP_INV;
-                page_lookup[writelookup[c]]  = NULL;
-                writelookup[c]               = 0xffffffff;
+    const page_t   *page_target = &pages[addr >> 12];
+    const uintptr_t target      = (uintptr_t) &ram[(uintptr_t) (addr & ~0xfff) - (virt & ~0xfff)];
+    uint32_t        tag;
+
+    for (uint8_t c = 0; c < MEM_TLB_SETS; c++) {
+        for (uint8_t d = 0; d < MEM_TLB_WAYS; d++) {
+            tag = write_tlb[c].tag[d];
+            if ((tag != MEM_TLB_INV) && ((writelookup2[tag] == target) || (page_lookup[tag] == page_target))) {
+                writelookup2[tag]   = LOOKUP_INV;
+                page_lookup[tag]    = NULL;
+                write_tlb[c].tag[d] = MEM_TLB_INV;
             }
         }
     }
@@ -439,6 +555,8 @@ mmutranslatereal(uint32_t addr, int rw)
     if (cpu_state.abrt)
         return 0xffffffffffffffffULL;
 
+    mem_stat_inc(mem_page_walks);
+
     if (cr4 & CR4_PAE)
         return mmutranslatereal_pae(addr, rw);
     else
@@ -546,6 +664,8 @@ mmutranslate_noabrt(uint32_t addr, int rw)
     if (cpu_state.abrt)
         return 0xffffffffffffffffULL;
 
+    mem_stat_inc(mem_page_walks);
+
     if (cr4 & CR4_PAE)
         return mmutranslate_noabrt_pae(addr, rw);
     else
@@ -574,26 +694,31 @@ mem_addr_translate(uint32_t addr, uint32_t chunk_start, uint32_t len)
 void
 addreadlookup(uint32_t virt, uint32_t phys)
 {
-    uint32_t large_offset = is_compare ? 1048576 : 0;
-    uint32_t small_offset = is_compare ? 256 : 0;
-    uint32_t index        = large_offset | (virt >> 12);
-    int *    rln          = &(readlnext[is_compare]);
-    int      cur_rln      = *rln | (int) small_offset;
-
 #ifndef USE_DEBUG_REGS_486
+    uintptr_t lookup;
+    uint32_t  evicted;
+
     if (virt == 0xffffffff)
         return;
 
-    if (readlookup2[index] != (uintptr_t) LOOKUP_INV)
-        return;
+    lookup = (uintptr_t) &ram[(uintptr_t) (phys & ~0xFFF) - (uintptr_t) (virt & ~0xfff)];
+
+    if (is_compare) {
+        if (mem_tlb_find(cmp_tlb, virt))
+            return;
 
-    if (readlookup[cur_rln] != (int) 0xffffffff)
-        readlookup2[large_offset | readlookup[cur_rln]] = LOOKUP_INV;
+        mem_tlb_add(cmp_tlb, virt, lookup);
+        cmp_tlb_used = 1;
+    } else {
+        if (readlookup2[virt >> 12] != (uintptr_t) LOOKUP_INV)
+            return;
 
-    readlookup2[index] = (uintptr_t) &ram[(uintptr_t) (phys & ~0xFFF) - (uintptr_t) (virt & ~0xfff)];
+        evicted = mem_tlb_add(read_tlb, virt, lookup);
+        if (evicted != MEM_TLB_INV)
+            readlookup2[evicted] = LOOKUP_INV;
 
-    readlookup[cur_rln] = virt >> 12;
-    *rln = (*rln + 1) & (cachesize - 1);
+        readlookup2[virt >> 12] = lookup;
+    }
 #endif
 
     cycles -= 9;
@@ -603,15 +728,18 @@ void
 addwritelookup(uint32_t virt, uint32_t phys)
 {
 #ifndef USE_DEBUG_REGS_486
+    uint32_t evicted;
+
     if (virt == 0xffffffff)
         return;
 
     if (page_lookup[virt >> 12])
         return;
 
-    if (writelookup[writelnext] != -1) {
-        page_lookup[writelookup[writelnext]]  = NULL;
-        writelookup2[writelookup[writelnext]] = LOOKUP_INV;
+    evicted = mem_tlb_add(write_tlb, virt, 0);
+    if (evicted != MEM_TLB_INV) {
+        page_lookup[evicted]  = NULL;
+        writelookup2[evicted] = LOOKUP_INV;
     }
 
     /* A page holds code not only when a block starts in it (block) but also
@@ -636,9 +764,6 @@ addwritelookup(uint32_t virt, uint32_t phys)
 
         writelookup2[virt >> 12] = (uintptr_t) &ram[(uintptr_t) (phys & ~0xFFF) - (uintptr_t) (virt & ~0xfff)];
     }
-
-    writelookup[writelnext++] = virt >> 12;
-    writelnext &= (cachesize - 1);
 #endif
 
     cycles -= 9;
@@ -893,8 +1018,7 @@ readmemwl(uint32_t addr)
     high_page = 0;
 
     if (addr & 1) {
-        uint32_t       large_offset = is_compare ? 1048576 : 0;
-        uintptr_t     *rl2 = &(readlookup2[large_offset | (addr >> 12)]);
+        uintptr_t      rl2 = readlookup_get(addr);
 
         if (!cpu_cyrix_alignment || (addr & 7) == 7)
             cycles -= timing_misaligned;
@@ -910,8 +1034,8 @@ readmemwl(uint32_t addr)
             }
 
             return readmembl_no_mmut(addr, addr64a[0]) | (((uint16_t) readmembl_no_mmut(addr + 1, addr64a[1])) << 8);
-        } else if (*rl2 != (uintptr_t) LOOKUP_INV)
-            return *(uint16_t *) (*rl2 + addr);
+        } else if (rl2 != (uintptr_t) LOOKUP_INV)
+            return *(uint16_t *) (rl2 + addr);
     }
 
     if (cr0 >> 31) {
@@ -1024,8 +1148,7 @@ readmemwl_no_mmut(uint32_t addr, uint32_t *a64)
     mem_logical_addr = addr;
 
     if (addr & 1) {
-        uint32_t       large_offset = is_compare ? 1048576 : 0;
-        uintptr_t     *rl2 = &(readlookup2[large_offset | (addr >> 12)]);
+        uintptr_t      rl2 = readlookup_get(addr);
 
         if (!cpu_cyrix_alignment || (addr & 7) == 7)
             cycles -= timing_misaligned;
@@ -1036,8 +1159,8 @@ readmemwl_no_mmut(uint32_t addr, uint32_t *a64)
             }
 
             return readmembl_no_mmut(addr, a64[0]) | (((uint16_t) readmembl_no_mmut(addr + 1, a64[1])) << 8);
-        } else if (*rl2 != (uintptr_t) LOOKUP_INV)
-            return *(uint16_t *) (*rl2 + addr);
+        } else if (rl2 != (uintptr_t) LOOKUP_INV)
+            return *(uint16_t *) (rl2 + addr);
     }
 
     if (cr0 >> 31) {
@@ -1135,8 +1258,7 @@ readmemll(uint32_t addr)
     high_page = 0;
 
     if (addr & 3) {
-        uint32_t       large_offset = is_compare ? 1048576 : 0;
-        uintptr_t     *rl2 = &(readlookup2[large_offset | (addr >> 12)]);
+        uintptr_t      rl2 = readlookup_get(addr);
 
         if (!cpu_cyrix_alignment || (addr & 7) > 4)
             cycles -= timing_misaligned;
@@ -1166,8 +1288,8 @@ readmemll(uint32_t addr)
             /* No need to waste precious CPU host cycles on mmutranslate's that were already done, just pass
                their result as a parameter to be used if needed. */
             return readmemwl_no_mmut(addr, addr64a) | (((uint32_t) readmemwl_no_mmut(addr + 2, &(addr64a[2]))) << 16);
-        } else if (*rl2 != (uintptr_t) LOOKUP_INV)
-            return *(uint32_t *) (*rl2 + addr);
+        } else if (rl2 != (uintptr_t) LOOKUP_INV)
+            return *(uint32_t *) (rl2 + addr);
     }
 
     if (cr0 >> 31) {
@@ -1300,8 +1422,7 @@ readmemll_no_mmut(uint32_t addr, uint32_t *a64)
     mem_logical_addr = addr;
 
     if (addr & 3) {
-        uint32_t       large_offset = is_compare ? 1048576 : 0;
-        uintptr_t     *rl2 = &(readlookup2[large_offset | (addr >> 12)]);
+        uintptr_t      rl2 = readlookup_get(addr);
 
         if (!cpu_cyrix_alignment || (addr & 7) > 4)
             cycles -= timing_misaligned;
@@ -1312,8 +1433,8 @@ readmemll_no_mmut(uint32_t addr, uint32_t *a64)
             }
 
             return readmemwl_no_mmut(addr, a64) | ((uint32_t) (readmemwl_no_mmut(addr + 2, &(a64[2]))) << 16);
-        } else if (*rl2 != (uintptr_t) LOOKUP_INV)
-            return *(uint32_t *) (*rl2 + addr);
+        } else if (rl2 != (uintptr_t) LOOKUP_INV)
+            return *(uint32_t *) (rl2 + addr);
     }
 
     if (cr0 >> 31) {
@@ -1419,8 +1540,7 @@ readmemql(uint32_t addr)
     high_page = 0;
 
     if (addr & 7) {
-        uint32_t       large_offset = is_compare ? 1048576 : 0;
-        uintptr_t     *rl2 = &(readlookup2[large_offset | (addr >> 12)]);
+        uintptr_t      rl2 = readlookup_get(addr);
 
         cycles -= timing_misaligned;
         if ((addr & 0xfff) > 0xff8) {
@@ -1449,8 +1569,8 @@ readmemql(uint32_t addr)
             /* No need to waste precious CPU host cycles on mmutranslate's that were already done, just pass
                their result as a parameter to be used if needed. */
             return readmemll_no_mmut(addr, addr64a) | (((uint64_t) readmemll_no_mmut(addr + 4, &(addr64a[4]))) << 32);
-        } else if (*rl2 != (uintptr_t) LOOKUP_INV)
-            return *(uint64_t *) (*rl2 + addr);
+        } else if (rl2 != (uintptr_t) LOOKUP_INV)
+            return *(uint64_t *) (rl2 + addr);
     }
 
     if (cr0 >> 31) {
@@ -3113,3 +3233,46 @@ mem_a20_recalc(void)
 
     mem_a20_state = state;
 }
+
+void
+mem_save_state(snapshot_t *snap)
+{
+    snapshot_write_var(snap, ram_size);
+    snapshot_write(snap, ram, ram_size);
+
+    snapshot_write_var(snap, _mem_state);
+    snapshot_write_var(snap, rammask);
+    snapshot_write_var(snap, shadowbios);
+    snapshot_write_var(snap, shadowbios_write);
+    snapshot_write_var(snap, mem_a20_key);
+    snapshot_write_var(snap, mem_a20_alt);
+    snapshot_write_var(snap, mem_a20_chipset);
+    snapshot_write_var(snap, mem_a20_state);
+}
+
+void
+mem_load_state(snapshot_t *snap)
+{
+    size_t size;
+
+    snapshot_read_var(snap, size);
+    if (size != ram_size) {
+        fatal("mem_load_state(): RAM size mismatch (%" PRIu64 " != %" PRIu64 ")\n",
+              (uint64_t) size, (uint64_t) ram_size);
+        return;
+    }
+    snapshot_read(snap, ram, ram_size);
+
+    snapshot_read_var(snap, _mem_state);
+    snapshot_read_var(snap, rammask);
+    snapshot_read_var(snap, shadowbios);
+    snapshot_read_var(snap, shadowbios_write);
+    snapshot_read_var(snap, mem_a20_key);
+    snapshot_read_var(snap, mem_a20_alt);
+    snapshot_read_var(snap, mem_a20_chipset);
+    snapshot_read_var(snap, mem_a20_state);
+
+    /* Rebuild the mapping tables from the restored access states. */
+    mem_mapping_recalc(0x00000000ULL, 0x100000000ULL, 0);
+    flushmmucache();
+}
@@ -0,0 +1,291 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Benchmark network driver.
+ *
+ *          Offers the card a stream of broadcast frames at a fixed rate
+ *          and size, and throws away whatever the card transmits. Each
+ *          frame carries the time it was generated, so the time it took
+ *          to reach the card through the queues can be measured once the
+ *          card accepts it.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <wchar.h>
+#ifdef _WIN32
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+#else
+#    include <time.h>
+#endif
+
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/thread.h>
+#include <86box/timer.h>
+#include <86box/network.h>
+#include <86box/plat_unused.h>
+
+#define BENCH_PKT_BATCH NET_QUEUE_LEN
+#define BENCH_MAX_BURST 256      /* frames generated per wakeup at most */
+#define BENCH_ETHERTYPE 0x88b5   /* IEEE local experimental */
+#define BENCH_MAGIC     0x48434e42 /* "BNCH" */
+
+int net_bench_rate = 0; /* (O) offer the cards this many frames per second */
+int net_bench_size = 0; /* (O) of this size */
+
+typedef struct net_bench_t {
+    netcard_t        *card;
+    thread_t         *poll_tid;
+    event_t          *tx_event;
+    volatile int      running;
+    uint8_t           mac_addr[6];
+    netpkt_t          pkt;
+    netpkt_t          pktv[BENCH_PKT_BATCH];
+    net_bench_stats_t stats;
+} net_bench_t;
+
+static net_bench_t *benches[NET_CARD_MAX];
+
+#ifdef ENABLE_NET_BENCH_LOG
+int net_bench_do_log = ENABLE_NET_BENCH_LOG;
+
+static void
+net_bench_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (net_bench_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define net_bench_log(fmt, ...)
+#endif
+
+/* plat_timer_read() does not have the same unit on every platform. */
+static uint64_t
+net_bench_time_us(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER freq;
+    LARGE_INTEGER count;
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (uint64_t) ((count.QuadPart * 1000000.0) / freq.QuadPart);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000ULL) + (ts.tv_nsec / 1000);
+#endif
+}
+
+static void
+net_bench_fill(net_bench_t *bench, netpkt_t *pkt, uint64_t seq)
+{
+    uint8_t *p = pkt->data;
+    uint32_t magic = BENCH_MAGIC;
+    uint64_t ts    = net_bench_time_us();
+
+    memset(p, 0xff, 6);
+    memcpy(&p[6], bench->mac_addr, 6);
+    p[12] = BENCH_ETHERTYPE >> 8;
+    p[13] = BENCH_ETHERTYPE & 0xff;
+    memcpy(&p[14], &magic, sizeof(magic));
+    memcpy(&p[18], &seq, sizeof(seq));
+    memcpy(&p[26], &ts, sizeof(ts));
+    pkt->len = net_bench_size;
+}
+
+static void
+net_bench_thread(void *priv)
+{
+    net_bench_t *bench = (net_bench_t *) priv;
+    uint64_t     start = net_bench_time_us();
+    uint64_t     due;
+    uint64_t     sent;
+    int          packets;
+
+    net_bench_log("Benchmark Network: started, %i frames/s of %i bytes\n", net_bench_rate, net_bench_size);
+
+    while (bench->running) {
+        /* Wake up for transmitted frames, and at least every millisecond
+           to keep the offered rate smooth. */
+        thread_wait_event(bench->tx_event, 1);
+        thread_reset_event(bench->tx_event);
+
+        do {
+            packets = network_tx_popv(bench->card, bench->pktv, BENCH_PKT_BATCH);
+            for (int i = 0; i < packets; i++) {
+                bench->stats.tx_packets++;
+                bench->stats.tx_bytes += bench->pktv[i].len;
+            }
+        } while (packets == BENCH_PKT_BATCH);
+
+        if (net_cards_conf[bench->card->card_num].link_state & NET_LINK_DOWN)
+            continue;
+
+        /* Frames that fell more than a burst behind are skipped, not offered. */
+        due  = ((net_bench_time_us() - start) * net_bench_rate) / 1000000ULL;
+        sent = bench->stats.rx_offered + bench->stats.rx_skipped;
+        if ((due - sent) > BENCH_MAX_BURST) {
+            bench->stats.rx_skipped += due - sent - BENCH_MAX_BURST;
+            sent = due - BENCH_MAX_BURST;
+        }
+
+        for (; sent < due; sent++) {
+            /* The queue swaps a spare buffer in, so fill it every time. */
+            net_bench_fill(bench, &bench->pkt, sent);
+            network_rx_put_pkt(bench->card, &bench->pkt);
+            bench->stats.rx_offered++;
+        }
+    }
+
+    net_bench_log("Benchmark Network: stopped\n");
+}
+
+/* Called from the emulation thread once the card took a frame. */
+static void
+net_bench_rx_done(void *priv, const netpkt_t *pkt)
+{
+    net_bench_t *bench = (net_bench_t *) priv;
+    uint32_t     magic;
+    uint64_t     ts;
+    uint64_t     latency;
+
+    if ((pkt->len < 34) || (pkt->data[12] != (BENCH_ETHERTYPE >> 8)) || (pkt->data[13] != (BENCH_ETHERTYPE & 0xff)))
+        return;
+
+    memcpy(&magic, &pkt->data[14], sizeof(magic));
+    if (magic != BENCH_MAGIC)
+        return;
+
+    memcpy(&ts, &pkt->data[26], sizeof(ts));
+    latency = net_bench_time_us() - ts;
+
+    bench->stats.rx_delivered++;
+    bench->stats.latency_sum_us += latency;
+    if (latency > bench->stats.latency_max_us)
+        bench->stats.latency_max_us = latency;
+}
+
+void *
+net_bench_init(const netcard_t *card, const uint8_t *mac_addr, UNUSED(void *priv), char *netdrv_errbuf)
+{
+    net_bench_t *bench;
+
+    if (card->card_num >= NET_CARD_MAX) {
+        snprintf(netdrv_errbuf, NET_DRV_ERRBUF_SIZE, "Invalid card number");
+        return NULL;
+    }
+
+    net_bench_size = MIN(MAX(net_bench_size, 60), NET_MAX_FRAME);
+
+    bench       = calloc(1, sizeof(net_bench_t));
+    bench->card = (netcard_t *) card;
+    /* A locally administered address next to the card's own. */
+    memcpy(bench->mac_addr, mac_addr, sizeof(bench->mac_addr));
+    bench->mac_addr[0] |= 0x02;
+    bench->mac_addr[5] ^= 0x01;
+
+    for (int i = 0; i < BENCH_PKT_BATCH; i++)
+        bench->pktv[i].data = calloc(1, NET_MAX_FRAME);
+    bench->pkt.data = calloc(1, NET_MAX_FRAME);
+
+    bench->tx_event = thread_create_event();
+    bench->running  = 1;
+    bench->poll_tid = thread_create_named(net_bench_thread, bench, "net-bench");
+
+    benches[card->card_num] = bench;
+
+    return bench;
+}
+
+void
+net_bench_in_available(void *priv)
+{
+    net_bench_t *bench = (net_bench_t *) priv;
+
+    thread_set_event(bench->tx_event);
+}
+
+void
+net_bench_close(void *priv)
+{
+    net_bench_t *bench = (net_bench_t *) priv;
+
+    if (!bench)
+        return;
+
+    bench->running = 0;
+    thread_set_event(bench->tx_event);
+    thread_wait(bench->poll_tid);
+
+    pclog("Benchmark Network: card %i offered %" PRIu64 " frames (%" PRIu64 " skipped), %" PRIu64 " taken, %" PRIu64 " transmitted\n",
+          bench->card->card_num + 1, bench->stats.rx_offered, bench->stats.rx_skipped, bench->stats.rx_delivered,
+          bench->stats.tx_packets);
+
+    benches[bench->card->card_num] = NULL;
+
+    for (int i = 0; i < BENCH_PKT_BATCH; i++)
+        free(bench->pktv[i].data);
+    free(bench->pkt.data);
+
+    thread_destroy_event(bench->tx_event);
+
+    free(bench);
+}
+
+void
+net_bench_get_stats(net_bench_stats_t *stats)
+{
+    uint32_t rx_dropped;
+    uint32_t tx_dropped;
+
+    memset(stats, 0, sizeof(net_bench_stats_t));
+
+    for (int i = 0; i < NET_CARD_MAX; i++) {
+        if (benches[i] == NULL)
+            continue;
+
+        network_get_dropped(benches[i]->card, &rx_dropped, &tx_dropped);
+
+        stats->rx_offered += benches[i]->stats.rx_offered;
+        stats->rx_skipped += benches[i]->stats.rx_skipped;
+        stats->rx_delivered += benches[i]->stats.rx_delivered;
+        stats->rx_dropped += rx_dropped;
+        stats->tx_packets += benches[i]->stats.tx_packets;
+        stats->tx_bytes += benches[i]->stats.tx_bytes;
+        stats->tx_dropped += tx_dropped;
+        stats->latency_sum_us += benches[i]->stats.latency_sum_us;
+        stats->latency_max_us = MAX(stats->latency_max_us, benches[i]->stats.latency_max_us);
+    }
+}
+
+const netdrv_t net_bench_drv = {
+    .notify_in = &net_bench_in_available,
+    .init      = &net_bench_init,
+    .close     = &net_bench_close,
+    .priv      = NULL,
+    .rx_done   = &net_bench_rx_done
+};
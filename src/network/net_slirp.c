@@ -67,6 +67,7 @@ typedef struct net_slirp_t {
     net_evt_t      tx_event;
     net_evt_t      stop_event;
     netpkt_t       pkt;
+    mutex_t *      pkt_mutex; /* libslirp timers fire on the emulation thread */
     netpkt_t       pkt_tx_v[SLIRP_PKT_BATCH];
     int            during_tx;
     int            recv_on_tx;
@@ -192,6 +193,11 @@ net_slirp_send_packet(const void *qp, size_t pkt_len, void *opaque)
 
     slirp_log("SLiRP: received %d-byte packet\n", pkt_len);
 
+    /* Packets come from the polling thread and from libslirp timers, which
+       run on the emulation thread, while the receive rings only allow one
+       producer at a time. */
+    thread_wait_mutex(slirp->pkt_mutex);
+
     memcpy(slirp->pkt.data, (uint8_t *) qp, pkt_len);
     slirp->pkt.len = pkt_len;
 
@@ -203,6 +209,8 @@ net_slirp_send_packet(const void *qp, size_t pkt_len, void *opaque)
             network_rx_put_pkt(slirp->card, &slirp->pkt);
     }
 
+    thread_release_mutex(slirp->pkt_mutex);
+
     return pkt_len;
 }
 
@@ -363,7 +371,12 @@ net_slirp_rx_deferred_packets(net_slirp_t *slirp)
 {
     int packets = 0;
 
+    /* This puts into the same receive ring as net_slirp_send_packet(), and
+       must not miss a packet deferred while it runs, so hold the mutex. */
+    thread_wait_mutex(slirp->pkt_mutex);
+
     if (slirp->recv_on_tx) {
+        slirp->recv_on_tx = 0;
         do {
             packets = network_rx_on_tx_popv(slirp->card, slirp->pkt_tx_v, SLIRP_PKT_BATCH);
             if (!(net_cards_conf[slirp->card->card_num].link_state & NET_LINK_DOWN)) {
@@ -371,8 +384,9 @@ net_slirp_rx_deferred_packets(net_slirp_t *slirp)
                      network_rx_put_pkt(slirp->card, &(slirp->pkt_tx_v[i]));
             }
         } while (packets > 0);
-        slirp->recv_on_tx = 0;
     }
+
+    thread_release_mutex(slirp->pkt_mutex);
 }
 
 #ifdef _WIN32
@@ -408,11 +422,14 @@ net_slirp_thread(void *priv)
             case NET_EVENT_TX:
                 {
                     slirp->during_tx = 1;
-                    int packets = network_tx_popv(slirp->card, slirp->pkt_tx_v, SLIRP_PKT_BATCH);
-                    if (!(net_cards_conf[slirp->card->card_num].link_state & NET_LINK_DOWN)) {
-                        for (int i = 0; i < packets; i++)
-                            net_slirp_in(slirp, slirp->pkt_tx_v[i].data, slirp->pkt_tx_v[i].len);
-                    }
+                    int packets;
+                    do {
+                        packets = network_tx_popv(slirp->card, slirp->pkt_tx_v, SLIRP_PKT_BATCH);
+                        if (!(net_cards_conf[slirp->card->card_num].link_state & NET_LINK_DOWN)) {
+                            for (int i = 0; i < packets; i++)
+                                net_slirp_in(slirp, slirp->pkt_tx_v[i].data, slirp->pkt_tx_v[i].len);
+                        }
+                    } while (packets == SLIRP_PKT_BATCH);
                     slirp->during_tx = 0;
 
                     net_slirp_rx_deferred_packets(slirp);
@@ -463,11 +480,14 @@ net_slirp_thread(void *priv)
             net_event_clear(&slirp->tx_event);
 
             slirp->during_tx = 1;
-            int packets = network_tx_popv(slirp->card, slirp->pkt_tx_v, SLIRP_PKT_BATCH);
-            if (!(net_cards_conf[slirp->card->card_num].link_state & NET_LINK_DOWN)) {
-                for (int i = 0; i < packets; i++)
-                    net_slirp_in(slirp, slirp->pkt_tx_v[i].data, slirp->pkt_tx_v[i].len);
-            }
+            int packets;
+            do {
+                packets = network_tx_popv(slirp->card, slirp->pkt_tx_v, SLIRP_PKT_BATCH);
+                if (!(net_cards_conf[slirp->card->card_num].link_state & NET_LINK_DOWN)) {
+                    for (int i = 0; i < packets; i++)
+                        net_slirp_in(slirp, slirp->pkt_tx_v[i].data, slirp->pkt_tx_v[i].len);
+                }
+            } while (packets == SLIRP_PKT_BATCH);
             slirp->during_tx = 0;
 
             net_slirp_rx_deferred_packets(slirp);
@@ -599,7 +619,8 @@ net_slirp_init(const netcard_t *card, const uint8_t *mac_addr, UNUSED(void *priv
     for (int i = 0; i < SLIRP_PKT_BATCH; i++) {
         slirp->pkt_tx_v[i].data = calloc(1, NET_MAX_FRAME);
     }
-    slirp->pkt.data = calloc(1, NET_MAX_FRAME);
+    slirp->pkt.data  = calloc(1, NET_MAX_FRAME);
+    slirp->pkt_mutex = thread_create_mutex();
     net_event_init(&slirp->rx_event);
     net_event_init(&slirp->tx_event);
     net_event_init(&slirp->stop_event);
@@ -661,6 +682,7 @@ net_slirp_close(void *priv)
         free(slirp->pkt_tx_v[i].data);
     }
     free(slirp->pkt.data);
+    thread_close_mutex(slirp->pkt_mutex);
     free(slirp);
 }
 
@@ -48,6 +48,7 @@
 #include <86box/ini.h>
 #include <86box/config.h>
 #include <86box/net_event.h>
+#include <86box/net_switch_hub.h>
 #include <86box/bswap.h>
 #include <shathree.h>
 
@@ -55,6 +56,7 @@
 
 #define SWITCH_MULTICAST_GROUP 0xefff5056 /* 239.255.80.86 */
 #define SWITCH_MULTICAST_PORT  8086
+#define SWITCH_HUB_RETRY_MS    1000 /* how often to look for a restarted hub */
 
 enum {
     NET_EVENT_STOP = 0,
@@ -77,6 +79,9 @@ typedef struct net_switch_hostaddr_t {
 } net_switch_hostaddr_t;
 
 typedef struct net_switch_t {
+    net_switch_hub_port_t *hub; /* NULL if multicasting, or while the hub is gone */
+    char                   hub_secret[256];
+    uint32_t               hub_dropped; /* Frames the hub ring could not take. */
     int                    socket_rx;
     net_switch_hostaddr_t *hostaddrs;
     uint16_t               port_out;
@@ -126,6 +131,18 @@ net_switch_in_available(void *priv)
     net_event_set(&netswitch->tx_event);
 }
 
+/* Whether a received frame is meant for the card. */
+static int
+net_switch_rx_accept(net_switch_t *netswitch, const uint8_t *data)
+{
+    if ((AS_U64(data[6]) & le64_to_cpu(0xffffffffffffULL)) == netswitch->mac_addr_u64)
+        return 0; /* A packet we've sent has looped back, drop it. */
+
+    return !(net_cards_conf[netswitch->card->card_num].link_state & NET_LINK_DOWN) && (netswitch->promisc || /* promiscuous mode? */
+           (data[0] & 1) || /* broadcast packet? */
+           ((AS_U64(data[0]) & le64_to_cpu(0xffffffffffffULL)) == netswitch->mac_addr_u64)); /* packet for me? */
+}
+
 static void
 net_switch_secret_hash(const char *secret, uint8_t *hash)
 {
@@ -393,33 +410,35 @@ net_switch_thread(void *priv)
 #endif
             net_event_clear(&netswitch->tx_event);
             netswitch->during_tx = 1;
-            packets = network_tx_popv(netswitch->card, netswitch->pkt_tx_v, SWITCH_PKT_BATCH);
-            if (!(net_cards_conf[netswitch->card->card_num].link_state & NET_LINK_DOWN)) {
-                for (int i = 0; i < packets; i++) {
-                    int orig_len = netswitch->pkt_tx_v[i].len;
-                    int send_len = orig_len;
-                    uint8_t augmented[sizeof(netswitch->secret_hash) + NET_MAX_FRAME];
-                    if (netswitch->secret_enabled) {
-                        send_len = orig_len + sizeof(netswitch->secret_hash);
-
-                        /* Build header with secret hash */
-                        memcpy(augmented, netswitch->secret_hash, sizeof(netswitch->secret_hash));
-                        memcpy(augmented + sizeof(netswitch->secret_hash),
-                               netswitch->pkt_tx_v[i].data, orig_len);
-                    }
+            do {
+                packets = network_tx_popv(netswitch->card, netswitch->pkt_tx_v, SWITCH_PKT_BATCH);
+                if (!(net_cards_conf[netswitch->card->card_num].link_state & NET_LINK_DOWN)) {
+                    for (int i = 0; i < packets; i++) {
+                        int orig_len = netswitch->pkt_tx_v[i].len;
+                        int send_len = orig_len;
+                        uint8_t augmented[sizeof(netswitch->secret_hash) + NET_MAX_FRAME];
+                        if (netswitch->secret_enabled) {
+                            send_len = orig_len + sizeof(netswitch->secret_hash);
+
+                            /* Build header with secret hash */
+                            memcpy(augmented, netswitch->secret_hash, sizeof(netswitch->secret_hash));
+                            memcpy(augmented + sizeof(netswitch->secret_hash),
+                                   netswitch->pkt_tx_v[i].data, orig_len);
+                        }
 
 #define MAC_FORMAT "(%02X:%02X:%02X:%02X:%02X:%02X -> %02X:%02X:%02X:%02X:%02X:%02X)"
 #define MAC_FORMAT_ARGS(p) (p)[6], (p)[7], (p)[8], (p)[9], (p)[10], (p)[11], (p)[0], (p)[1], (p)[2], (p)[3], (p)[4], (p)[5]
-                    netswitch_log("Network Switch: sending %d-byte packet " MAC_FORMAT "\n",
-                                  netswitch->pkt_tx_v[i].len,
-                                  MAC_FORMAT_ARGS(netswitch->pkt_tx_v[i].data));
-
-                    /* Send through all known host interfaces. */
-                    for (net_switch_hostaddr_t *hostaddr = netswitch->hostaddrs; hostaddr; hostaddr = hostaddr->next)
-                        sendto(hostaddr->socket_tx, (char *) (netswitch->secret_enabled ? augmented : netswitch->pkt_tx_v[i].data),
-                               send_len, 0, &hostaddr->addr_tx.sa, sizeof(hostaddr->addr_tx.sa));
+                        netswitch_log("Network Switch: sending %d-byte packet " MAC_FORMAT "\n",
+                                      netswitch->pkt_tx_v[i].len,
+                                      MAC_FORMAT_ARGS(netswitch->pkt_tx_v[i].data));
+
+                        /* Send through all known host interfaces. */
+                        for (net_switch_hostaddr_t *hostaddr = netswitch->hostaddrs; hostaddr; hostaddr = hostaddr->next)
+                            sendto(hostaddr->socket_tx, (char *) (netswitch->secret_enabled ? augmented : netswitch->pkt_tx_v[i].data),
+                                   send_len, 0, &hostaddr->addr_tx.sa, sizeof(hostaddr->addr_tx.sa));
+                    }
                 }
-            }
+            } while (packets == SWITCH_PKT_BATCH);
             netswitch->during_tx = 0;
 
             if (netswitch->recv_on_tx) {
@@ -465,11 +484,7 @@ net_switch_thread(void *priv)
                 }
             }
 
-            if ((AS_U64(netswitch->pkt.data[6]) & le64_to_cpu(0xffffffffffffULL)) == netswitch->mac_addr_u64) {
-                /* A packet we've sent has looped back, drop it. */
-            } else if (!(net_cards_conf[netswitch->card->card_num].link_state & NET_LINK_DOWN) && (netswitch->promisc || /* promiscuous mode? */
-                       (netswitch->pkt.data[0] & 1) || /* broadcast packet? */
-                       ((AS_U64(netswitch->pkt.data[0]) & le64_to_cpu(0xffffffffffffULL)) == netswitch->mac_addr_u64))) { /* packet for me? */
+            if (net_switch_rx_accept(netswitch, netswitch->pkt.data)) {
                 netswitch_log("Network Switch: receiving %d-byte packet " MAC_FORMAT "\n",
                               len, MAC_FORMAT_ARGS(netswitch->pkt.data));
                 netswitch->pkt.len = len;
@@ -492,6 +507,82 @@ net_switch_thread(void *priv)
     netswitch_log("Network Switch: polling stopped\n");
 }
 
+#ifndef _WIN32
+/* Same as above, but exchanging frames with a hub on this host. */
+static void
+net_switch_hub_thread(void *priv)
+{
+    net_switch_t *netswitch = (net_switch_t *) priv;
+
+    netswitch_log("Network Switch: polling hub started\n");
+
+    struct pollfd pfd[NET_EVENT_MAX];
+    pfd[NET_EVENT_STOP].fd     = net_event_get_fd(&netswitch->stop_event);
+    pfd[NET_EVENT_STOP].events = POLLIN | POLLPRI;
+
+    pfd[NET_EVENT_TX].fd     = net_event_get_fd(&netswitch->tx_event);
+    pfd[NET_EVENT_TX].events = POLLIN | POLLPRI;
+
+    pfd[NET_EVENT_RX].fd     = net_switch_hub_get_fd(netswitch->hub);
+    pfd[NET_EVENT_RX].events = POLLIN | POLLPRI;
+
+    int packets;
+    int len;
+    while (1) {
+        if (netswitch->hub)
+            poll(pfd, NET_EVENT_MAX, net_switch_hub_prepare_wait(netswitch->hub) ? 0 : -1);
+        else
+            poll(pfd, NET_EVENT_MAX, SWITCH_HUB_RETRY_MS);
+        if (pfd[NET_EVENT_STOP].revents & POLLIN) {
+            net_event_clear(&netswitch->stop_event);
+            break;
+        }
+
+        /* Get back onto the hub once it is restarted. */
+        if (!netswitch->hub) {
+            netswitch->hub = net_switch_hub_attach(netswitch->hub_secret, netswitch->promisc);
+            if (netswitch->hub) {
+                pclog("Network Switch: reattached to the hub\n");
+                pfd[NET_EVENT_RX].fd = net_switch_hub_get_fd(netswitch->hub);
+            }
+        }
+
+        if (pfd[NET_EVENT_TX].revents & POLLIN)
+            net_event_clear(&netswitch->tx_event);
+        do {
+            packets = network_tx_popv(netswitch->card, netswitch->pkt_tx_v, SWITCH_PKT_BATCH);
+            if (!(net_cards_conf[netswitch->card->card_num].link_state & NET_LINK_DOWN)) {
+                for (int i = 0; i < packets; i++) {
+                    if (!netswitch->hub || !net_switch_hub_send(netswitch->hub, netswitch->pkt_tx_v[i].data, netswitch->pkt_tx_v[i].len))
+                        netswitch->hub_dropped++;
+                }
+            }
+        } while (packets == SWITCH_PKT_BATCH);
+
+        if (!netswitch->hub)
+            continue;
+        net_switch_hub_flush(netswitch->hub);
+
+        if ((pfd[NET_EVENT_RX].revents & (POLLIN | POLLHUP | POLLERR)) && !net_switch_hub_ack(netswitch->hub)) {
+            pclog("Network Switch: the hub went away, waiting for it to come back\n");
+            net_switch_hub_detach(netswitch->hub);
+            netswitch->hub       = NULL;
+            pfd[NET_EVENT_RX].fd = -1;
+            continue;
+        }
+
+        while ((len = net_switch_hub_recv(netswitch->hub, netswitch->pkt.data)) > 0) {
+            if ((len >= 12) && net_switch_rx_accept(netswitch, netswitch->pkt.data)) {
+                netswitch->pkt.len = len;
+                network_rx_put_pkt(netswitch->card, &netswitch->pkt);
+            }
+        }
+    }
+
+    netswitch_log("Network Switch: polling hub stopped\n");
+}
+#endif
+
 static void net_switch_close(void *priv);
 
 void *
@@ -511,6 +602,17 @@ net_switch_init(const netcard_t *card, const uint8_t *mac_addr, void *priv, char
         memcpy(netswitch->secret_hash, temp, sizeof(netswitch->secret_hash));
     }
 
+    /* Prefer a hub on this host, which needs no system call per frame. */
+    netswitch->socket_rx = -1;
+    if (netcard->net_type == NET_TYPE_NLSWITCH) {
+        netswitch->hub = net_switch_hub_attach((const char *) netcard->secret, netswitch->promisc);
+        if (netswitch->hub) {
+            netswitch_log("Network Switch: attached to the hub\n");
+            memcpy(netswitch->hub_secret, netcard->secret, sizeof(netswitch->hub_secret));
+            goto start;
+        }
+    }
+
     /* Initialize receive socket. */
     netswitch->socket_rx = socket(AF_INET, SOCK_DGRAM, 0);
     if (netswitch->socket_rx < 0) {
@@ -552,6 +654,7 @@ net_switch_init(const netcard_t *card, const uint8_t *mac_addr, void *priv, char
         goto fail;
     }
 
+start:
     for (int i = 0; i < SWITCH_PKT_BATCH; i++)
         netswitch->pkt_tx_v[i].data = calloc(1, NET_MAX_FRAME);
     netswitch->pkt.data = calloc(1, NET_MAX_FRAME);
@@ -562,7 +665,12 @@ net_switch_init(const netcard_t *card, const uint8_t *mac_addr, void *priv, char
 #endif
 
     netswitch_log("Network Switch: creating thread...\n");
-    netswitch->poll_tid = thread_create(net_switch_thread, netswitch);
+#ifndef _WIN32
+    if (netswitch->hub)
+        netswitch->poll_tid = thread_create(net_switch_hub_thread, netswitch);
+    else
+#endif
+        netswitch->poll_tid = thread_create(net_switch_thread, netswitch);
 
     return netswitch;
 
@@ -590,6 +698,9 @@ net_switch_close(void *priv)
         thread_wait(netswitch->poll_tid);
     }
 
+    if (netswitch->hub_dropped)
+        pclog("Network Switch: dropped %u packets the hub could not take\n", netswitch->hub_dropped);
+
     net_switch_hostaddr_t *hostaddr = netswitch->hostaddrs;
     while (hostaddr) {
         if (hostaddr->socket_tx >= 0)
@@ -600,6 +711,7 @@ net_switch_close(void *priv)
     }
     if (netswitch->socket_rx >= 0)
         close(netswitch->socket_rx);
+    net_switch_hub_detach(netswitch->hub);
     net_event_close(&netswitch->stop_event);
     net_event_close(&netswitch->tx_event);
     for (int i = 0; i < SWITCH_PKT_BATCH; i++)
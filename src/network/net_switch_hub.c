@@ -0,0 +1,683 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Shared memory network switch hub.
+ *
+ *          An instance started with --netswitchd acts as a switch for
+ *          the local switch network cards of every other instance on the
+ *          same host. Each attached card gets a port, which is a pair of
+ *          frame rings in shared memory, so frames move between instances
+ *          without a system call each. The hub learns which port every
+ *          MAC address lives behind, and only floods broadcasts and
+ *          frames to unknown addresses.
+ *
+ *          Each side only rings the other through the port's socket when
+ *          the other side announced that it is about to sleep, so busy
+ *          ports exchange whole batches per wakeup. Cards fall back to
+ *          multicast when no hub is running for their secret.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#ifdef __linux__
+#    include <errno.h>
+#    include <fcntl.h>
+#    include <signal.h>
+#    include <stdatomic.h>
+#    include <unistd.h>
+#    include <sys/epoll.h>
+#    include <sys/mman.h>
+#    include <sys/socket.h>
+#    include <sys/un.h>
+#endif
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/timer.h>
+#include <86box/network.h>
+#include <86box/net_switch_hub.h>
+#include <86box/plat_unused.h>
+#include <shathree.h>
+
+#define HUB_MAGIC   0x42485338 /* "8SHB" */
+#define HUB_VERSION 1
+#define HUB_PORTS   64
+#define HUB_RING    64         /* frames per direction and port, power of 2 */
+#define HUB_MACS    1024       /* learned addresses, power of 2 */
+#define HUB_EVENTS  64
+
+char *net_switch_hub_secret = NULL; /* (O) run as the switch hub for this secret */
+
+#ifdef ENABLE_SWITCH_HUB_LOG
+int switch_hub_do_log = ENABLE_SWITCH_HUB_LOG;
+
+static void
+switch_hub_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (switch_hub_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define switch_hub_log(fmt, ...)
+#endif
+
+#ifdef __linux__
+typedef struct hub_frame_t {
+    uint32_t len;
+    uint8_t  data[NET_MAX_FRAME];
+} hub_frame_t;
+
+/* Single producer, single consumer. The indices run freely. */
+typedef struct hub_ring_t {
+    atomic_uint head; /* Written by the producer. */
+    uint8_t     pad0[60];
+    atomic_uint tail; /* Written by the consumer. */
+    atomic_uint waiting; /* The consumer is about to sleep. */
+    uint8_t     pad1[56];
+    hub_frame_t frames[HUB_RING];
+} hub_ring_t;
+
+typedef struct hub_shm_port_t {
+    hub_ring_t to_hub;
+    hub_ring_t from_hub;
+} hub_shm_port_t;
+
+typedef struct hub_shm_t {
+    uint32_t       magic;
+    uint32_t       version;
+    uint32_t       nr_ports;
+    uint32_t       ring_size;
+    atomic_uint    waiting; /* The hub is about to sleep. */
+    uint8_t        pad[44];
+    hub_shm_port_t ports[HUB_PORTS];
+} hub_shm_t;
+
+/* Exchanged once over the socket when attaching. */
+typedef struct hub_hello_t {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t promisc;
+} hub_hello_t;
+
+struct net_switch_hub_port_t {
+    int             fd;
+    int             index;
+    hub_shm_t      *shm;
+    hub_shm_port_t *port;
+};
+
+typedef struct hub_mac_t {
+    uint64_t mac;
+    int      port; /* -1 once the port went away */
+} hub_mac_t;
+
+static volatile sig_atomic_t hub_quit;
+
+static void
+net_switch_hub_name(const char *secret, char *name, size_t size)
+{
+    SHA3Context    cx;
+    const uint8_t *hash;
+
+    if ((secret == NULL) || (secret[0] == '\0')) {
+        snprintf(name, size, "/86box-switch");
+        return;
+    }
+
+    SHA3Init(&cx, 256);
+    SHA3Update(&cx, (const uint8_t *) secret, strlen(secret));
+    hash = SHA3Final(&cx);
+    snprintf(name, size, "/86box-switch-%02x%02x%02x%02x%02x%02x%02x%02x",
+             hash[0], hash[1], hash[2], hash[3], hash[4], hash[5], hash[6], hash[7]);
+}
+
+/* The socket lives in the abstract namespace, so nothing is left behind. */
+static socklen_t
+net_switch_hub_sockaddr(const char *name, struct sockaddr_un *addr)
+{
+    memset(addr, 0, sizeof(struct sockaddr_un));
+    addr->sun_family = AF_UNIX;
+    snprintf(&addr->sun_path[1], sizeof(addr->sun_path) - 1, "%s", name);
+    return offsetof(struct sockaddr_un, sun_path) + 1 + strlen(name);
+}
+
+static void
+net_switch_hub_ring(int fd)
+{
+    uint8_t val = 0;
+
+    (void) !send(fd, &val, sizeof(val), MSG_DONTWAIT | MSG_NOSIGNAL);
+}
+
+static int
+net_switch_hub_ring_push(hub_ring_t *ring, const uint8_t *data, uint32_t len)
+{
+    unsigned int head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    hub_frame_t *frame;
+
+    if ((head - atomic_load_explicit(&ring->tail, memory_order_acquire)) >= HUB_RING)
+        return 0;
+
+    frame      = &ring->frames[head & (HUB_RING - 1)];
+    frame->len = len;
+    memcpy(frame->data, data, len);
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    return 1;
+}
+
+static hub_frame_t *
+net_switch_hub_ring_peek(hub_ring_t *ring)
+{
+    unsigned int tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    if (tail == atomic_load_explicit(&ring->head, memory_order_acquire))
+        return NULL;
+
+    return &ring->frames[tail & (HUB_RING - 1)];
+}
+
+static void
+net_switch_hub_ring_pop(hub_ring_t *ring)
+{
+    atomic_store_explicit(&ring->tail, atomic_load_explicit(&ring->tail, memory_order_relaxed) + 1, memory_order_release);
+}
+
+static int
+net_switch_hub_ring_empty(hub_ring_t *ring)
+{
+    return atomic_load_explicit(&ring->tail, memory_order_relaxed) == atomic_load_explicit(&ring->head, memory_order_acquire);
+}
+
+/* Hub side. */
+static int       hub_fds[HUB_PORTS];
+static uint8_t   hub_promisc[HUB_PORTS];
+static uint8_t   hub_touched[HUB_PORTS];
+static hub_mac_t hub_macs[HUB_MACS];
+static uint64_t  hub_forwarded;
+static uint64_t  hub_dropped;
+
+static uint64_t
+net_switch_hub_mac(const uint8_t *p)
+{
+    return ((uint64_t) p[0] << 40) | ((uint64_t) p[1] << 32) | ((uint64_t) p[2] << 24) |
+           ((uint64_t) p[3] << 16) | ((uint64_t) p[4] << 8) | p[5];
+}
+
+static hub_mac_t *
+net_switch_hub_find_mac(uint64_t mac, int add)
+{
+    uint32_t slot = (uint32_t) ((mac * 0x9e3779b97f4a7c15ULL) >> 54) & (HUB_MACS - 1);
+
+    /* Zero marks free entries. */
+    if (mac == 0)
+        return NULL;
+
+    for (int i = 0; i < HUB_MACS; i++, slot = (slot + 1) & (HUB_MACS - 1)) {
+        if (hub_macs[slot].mac == mac)
+            return &hub_macs[slot];
+        if (hub_macs[slot].mac == 0) {
+            if (!add)
+                return NULL;
+            hub_macs[slot].mac = mac;
+            return &hub_macs[slot];
+        }
+    }
+
+    return NULL;
+}
+
+static void
+net_switch_hub_send_to(hub_shm_t *shm, int port, const hub_frame_t *frame)
+{
+    if (net_switch_hub_ring_push(&shm->ports[port].from_hub, frame->data, frame->len)) {
+        hub_touched[port] = 1;
+        hub_forwarded++;
+    } else
+        hub_dropped++;
+}
+
+static void
+net_switch_hub_forward(hub_shm_t *shm, int src)
+{
+    hub_ring_t  *ring = &shm->ports[src].to_hub;
+    hub_frame_t *frame;
+    hub_mac_t   *entry;
+    int          dst;
+
+    for (int n = 0; (n < HUB_RING) && ((frame = net_switch_hub_ring_peek(ring)) != NULL); n++) {
+        if ((frame->len < 14) || (frame->len > NET_MAX_FRAME)) {
+            net_switch_hub_ring_pop(ring);
+            continue;
+        }
+
+        /* Learn where the sender lives. */
+        if (!(frame->data[6] & 1)) {
+            entry = net_switch_hub_find_mac(net_switch_hub_mac(&frame->data[6]), 1);
+            if (entry != NULL)
+                entry->port = src;
+        }
+
+        dst = -1;
+        if (!(frame->data[0] & 1)) {
+            entry = net_switch_hub_find_mac(net_switch_hub_mac(frame->data), 0);
+            if (entry != NULL)
+                dst = entry->port;
+        }
+
+        for (int i = 0; i < HUB_PORTS; i++) {
+            if ((i == src) || (hub_fds[i] < 0))
+                continue;
+            if ((dst < 0) || (i == dst) || hub_promisc[i])
+                net_switch_hub_send_to(shm, i, frame);
+        }
+
+        net_switch_hub_ring_pop(ring);
+    }
+}
+
+static void
+net_switch_hub_close_port(int epfd, int port)
+{
+    epoll_ctl(epfd, EPOLL_CTL_DEL, hub_fds[port], NULL);
+    close(hub_fds[port]);
+    hub_fds[port] = -1;
+
+    for (int i = 0; i < HUB_MACS; i++) {
+        if (hub_macs[i].port == port)
+            hub_macs[i].port = -1;
+    }
+
+    switch_hub_log("Switch Hub: port %i detached\n", port);
+}
+
+static void
+net_switch_hub_accept(hub_shm_t *shm, int epfd, int listen_fd)
+{
+    struct epoll_event ev;
+    hub_hello_t        hello;
+    int32_t            reply = -1;
+    int                fd;
+
+    fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0)
+        return;
+
+    if ((recv(fd, &hello, sizeof(hello), 0) != sizeof(hello)) ||
+        (hello.magic != HUB_MAGIC) || (hello.version != HUB_VERSION)) {
+        close(fd);
+        return;
+    }
+
+    for (int i = 0; i < HUB_PORTS; i++) {
+        if (hub_fds[i] < 0) {
+            reply = i;
+            break;
+        }
+    }
+
+    if (reply >= 0) {
+        memset(&shm->ports[reply], 0, offsetof(hub_ring_t, frames));
+        memset(&shm->ports[reply].from_hub, 0, offsetof(hub_ring_t, frames));
+        hub_promisc[reply] = !!hello.promisc;
+
+        ev.events   = EPOLLIN;
+        ev.data.u32 = reply;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+            reply = -1;
+    }
+
+    if ((send(fd, &reply, sizeof(reply), MSG_NOSIGNAL) != sizeof(reply)) && (reply >= 0)) {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+        reply = -1;
+    }
+
+    if (reply < 0) {
+        close(fd);
+        return;
+    }
+
+    hub_fds[reply] = fd;
+    switch_hub_log("Switch Hub: port %i attached%s\n", reply, hello.promisc ? " (promiscuous)" : "");
+}
+
+static void
+net_switch_hub_signal(UNUSED(int sig))
+{
+    hub_quit = 1;
+}
+
+int
+net_switch_hub_run(const char *secret)
+{
+    struct sigaction   sa;
+    struct sockaddr_un addr;
+    struct epoll_event ev;
+    struct epoll_event events[HUB_EVENTS];
+    hub_shm_t         *shm;
+    char               name[64];
+    uint8_t            buf[64];
+    socklen_t          addr_len;
+    ssize_t            len;
+    int                listen_fd;
+    int                shm_fd;
+    int                epfd;
+    int                busy;
+    int                n;
+
+    net_switch_hub_name(secret, name, sizeof(name));
+    addr_len = net_switch_hub_sockaddr(name, &addr);
+
+    /* Binding fails if another hub already serves this secret. */
+    listen_fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if ((listen_fd < 0) || (bind(listen_fd, (struct sockaddr *) &addr, addr_len) < 0) || (listen(listen_fd, 16) < 0)) {
+        pclog("Switch Hub: Unable to listen as %s, is another hub running?\n", name);
+        if (listen_fd >= 0)
+            close(listen_fd);
+        return 0;
+    }
+
+    shm_unlink(name);
+    shm_fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if ((shm_fd < 0) || (ftruncate(shm_fd, sizeof(hub_shm_t)) != 0)) {
+        pclog("Switch Hub: Unable to create %s\n", name);
+        if (shm_fd >= 0) {
+            close(shm_fd);
+            shm_unlink(name);
+        }
+        close(listen_fd);
+        return 0;
+    }
+
+    shm = (hub_shm_t *) mmap(NULL, sizeof(hub_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+    close(shm_fd);
+    if (shm == MAP_FAILED) {
+        pclog("Switch Hub: Unable to map %s\n", name);
+        shm_unlink(name);
+        close(listen_fd);
+        return 0;
+    }
+
+    shm->version   = HUB_VERSION;
+    shm->nr_ports  = HUB_PORTS;
+    shm->ring_size = HUB_RING;
+    atomic_thread_fence(memory_order_release);
+    shm->magic = HUB_MAGIC;
+
+    for (int i = 0; i < HUB_PORTS; i++)
+        hub_fds[i] = -1;
+    memset(hub_macs, 0, sizeof(hub_macs));
+
+    epfd        = epoll_create1(EPOLL_CLOEXEC);
+    ev.events   = EPOLLIN;
+    ev.data.u32 = HUB_PORTS;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listen_fd, &ev);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = net_switch_hub_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    pclog("Switch Hub: Serving %s with %i ports\n", name, HUB_PORTS);
+
+    while (!hub_quit) {
+        /* Announce the sleep first, so that no doorbell gets lost. */
+        atomic_store(&shm->waiting, 1);
+        atomic_thread_fence(memory_order_seq_cst);
+        busy = 0;
+        for (int i = 0; (i < HUB_PORTS) && !busy; i++)
+            busy = (hub_fds[i] >= 0) && !net_switch_hub_ring_empty(&shm->ports[i].to_hub);
+
+        n = epoll_wait(epfd, events, HUB_EVENTS, busy ? 0 : -1);
+        atomic_store(&shm->waiting, 0);
+        if ((n < 0) && (errno != EINTR))
+            break;
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.u32 == HUB_PORTS) {
+                net_switch_hub_accept(shm, epfd, listen_fd);
+                continue;
+            }
+
+            /* Doorbells only wake us up, the rings say what to do. */
+            do
+                len = recv(hub_fds[events[i].data.u32], buf, sizeof(buf), MSG_DONTWAIT);
+            while (len > 0);
+            if ((len == 0) || (events[i].events & (EPOLLHUP | EPOLLERR)) || ((len < 0) && (errno != EAGAIN)))
+                net_switch_hub_close_port(epfd, events[i].data.u32);
+        }
+
+        for (int i = 0; i < HUB_PORTS; i++) {
+            if (hub_fds[i] >= 0)
+                net_switch_hub_forward(shm, i);
+        }
+
+        for (int i = 0; i < HUB_PORTS; i++) {
+            if (hub_touched[i]) {
+                hub_touched[i] = 0;
+                if (atomic_exchange(&shm->ports[i].from_hub.waiting, 0))
+                    net_switch_hub_ring(hub_fds[i]);
+            }
+        }
+    }
+
+    pclog("Switch Hub: Stopping, %" PRIu64 " frames forwarded, %" PRIu64 " dropped\n", hub_forwarded, hub_dropped);
+
+    for (int i = 0; i < HUB_PORTS; i++) {
+        if (hub_fds[i] >= 0)
+            net_switch_hub_close_port(epfd, i);
+    }
+    close(epfd);
+    close(listen_fd);
+    munmap(shm, sizeof(hub_shm_t));
+    shm_unlink(name);
+
+    return 1;
+}
+
+/* Card side. */
+net_switch_hub_port_t *
+net_switch_hub_attach(const char *secret, int promisc)
+{
+    net_switch_hub_port_t *port;
+    struct sockaddr_un     addr;
+    hub_hello_t            hello = { .magic = HUB_MAGIC, .version = HUB_VERSION, .promisc = !!promisc };
+    char                   name[64];
+    socklen_t              addr_len;
+    int32_t                reply;
+    int                    shm_fd;
+    int                    fd;
+
+    net_switch_hub_name(secret, name, sizeof(name));
+    addr_len = net_switch_hub_sockaddr(name, &addr);
+
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return NULL;
+
+    if ((connect(fd, (struct sockaddr *) &addr, addr_len) < 0) ||
+        (send(fd, &hello, sizeof(hello), MSG_NOSIGNAL) != sizeof(hello)) ||
+        (recv(fd, &reply, sizeof(reply), 0) != sizeof(reply)) || (reply < 0) || (reply >= HUB_PORTS)) {
+        close(fd);
+        return NULL;
+    }
+
+    port        = (net_switch_hub_port_t *) calloc(1, sizeof(net_switch_hub_port_t));
+    port->fd    = fd;
+    port->index = reply;
+
+    shm_fd = shm_open(name, O_RDWR, 0);
+    if (shm_fd >= 0) {
+        port->shm = (hub_shm_t *) mmap(NULL, sizeof(hub_shm_t), PROT_READ | PROT_WRITE, MAP_SHARED, shm_fd, 0);
+        close(shm_fd);
+    }
+
+    if ((shm_fd < 0) || (port->shm == MAP_FAILED) || (port->shm->magic != HUB_MAGIC) ||
+        (port->shm->version != HUB_VERSION) || (port->shm->nr_ports != HUB_PORTS) || (port->shm->ring_size != HUB_RING)) {
+        if ((shm_fd >= 0) && (port->shm != MAP_FAILED))
+            munmap(port->shm, sizeof(hub_shm_t));
+        close(fd);
+        free(port);
+        return NULL;
+    }
+
+    port->port = &port->shm->ports[reply];
+    switch_hub_log("Switch Hub: attached to %s as port %i\n", name, reply);
+
+    return port;
+}
+
+void
+net_switch_hub_detach(net_switch_hub_port_t *port)
+{
+    if (port == NULL)
+        return;
+
+    munmap(port->shm, sizeof(hub_shm_t));
+    close(port->fd);
+    free(port);
+}
+
+int
+net_switch_hub_get_fd(const net_switch_hub_port_t *port)
+{
+    return port->fd;
+}
+
+int
+net_switch_hub_send(net_switch_hub_port_t *port, const uint8_t *data, int len)
+{
+    if ((len <= 0) || (len > NET_MAX_FRAME))
+        return 0;
+
+    return net_switch_hub_ring_push(&port->port->to_hub, data, len);
+}
+
+void
+net_switch_hub_flush(net_switch_hub_port_t *port)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&port->shm->waiting, memory_order_relaxed) && atomic_exchange(&port->shm->waiting, 0))
+        net_switch_hub_ring(port->fd);
+}
+
+int
+net_switch_hub_recv(net_switch_hub_port_t *port, uint8_t *data)
+{
+    hub_ring_t  *ring  = &port->port->from_hub;
+    hub_frame_t *frame = net_switch_hub_ring_peek(ring);
+    int          len;
+
+    if (frame == NULL)
+        return 0;
+
+    len = MIN(frame->len, NET_MAX_FRAME);
+    memcpy(data, frame->data, len);
+    net_switch_hub_ring_pop(ring);
+
+    return len;
+}
+
+int
+net_switch_hub_prepare_wait(net_switch_hub_port_t *port)
+{
+    hub_ring_t *ring = &port->port->from_hub;
+
+    atomic_store(&ring->waiting, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (net_switch_hub_ring_empty(ring))
+        return 0;
+
+    atomic_store(&ring->waiting, 0);
+    return 1;
+}
+
+int
+net_switch_hub_ack(net_switch_hub_port_t *port)
+{
+    uint8_t buf[64];
+    ssize_t len;
+
+    do
+        len = recv(port->fd, buf, sizeof(buf), MSG_DONTWAIT);
+    while (len > 0);
+
+    return (len < 0) && (errno == EAGAIN);
+}
+#else
+int
+net_switch_hub_run(UNUSED(const char *secret))
+{
+    pclog("Switch Hub: Not supported on this platform\n");
+    return 0;
+}
+
+net_switch_hub_port_t *
+net_switch_hub_attach(UNUSED(const char *secret), UNUSED(int promisc))
+{
+    return NULL;
+}
+
+void
+net_switch_hub_detach(UNUSED(net_switch_hub_port_t *port))
+{
+    //
+}
+
+int
+net_switch_hub_get_fd(UNUSED(const net_switch_hub_port_t *port))
+{
+    return -1;
+}
+
+int
+net_switch_hub_send(UNUSED(net_switch_hub_port_t *port), UNUSED(const uint8_t *data), UNUSED(int len))
+{
+    return 0;
+}
+
+void
+net_switch_hub_flush(UNUSED(net_switch_hub_port_t *port))
+{
+    //
+}
+
+int
+net_switch_hub_recv(UNUSED(net_switch_hub_port_t *port), UNUSED(uint8_t *data))
+{
+    return 0;
+}
+
+int
+net_switch_hub_prepare_wait(UNUSED(net_switch_hub_port_t *port))
+{
+    return 0;
+}
+
+int
+net_switch_hub_ack(UNUSED(net_switch_hub_port_t *port))
+{
+    return 0;
+}
+#endif
@@ -155,15 +155,18 @@ static void net_tap_thread(void *priv) {
         }
         if (pfd[NET_EVENT_TX].revents & POLLIN) {
             net_event_clear(&tap->tx_event);
-            int packets = network_tx_popv(tap->card, tap->pkts_tx,
+            int packets;
+            do {
+                packets = network_tx_popv(tap->card, tap->pkts_tx,
                                           NET_QUEUE_LEN);
-            for(int i = 0; i < packets; i++) {
-                netpkt_t *pkt = &tap->pkts_tx[i];
-                ssize_t ret = write(tap->fd, pkt->data, pkt->len);
-                if (ret < 0) {
-                    tap_log("TAP: write error: %s\n", strerror(errno));
+                for(int i = 0; i < packets; i++) {
+                    netpkt_t *pkt = &tap->pkts_tx[i];
+                    ssize_t ret = write(tap->fd, pkt->data, pkt->len);
+                    if (ret < 0) {
+                        tap_log("TAP: write error: %s\n", strerror(errno));
+                    }
                 }
-            }
+            } while (packets == NET_QUEUE_LEN);
         }
         if (pfd[NET_EVENT_RX].revents & POLLIN) {
             ssize_t len = read(tap->fd, tap->pkt_rx.data, NET_MAX_FRAME);
@@ -78,6 +78,20 @@ typedef struct {
     const device_t *device;
 } NETWORK_CARD;
 
+/*
+ * A single producer, single consumer ring. Only the producer moves the head
+ * and only the consumer moves the tail, so neither side needs a lock. A
+ * backend that can produce from more than one thread has to serialize its
+ * own puts, as SLiRP does.
+ */
+struct netqueue_t {
+    netpkt_t  *packets;
+    int        mask;
+    atomic_int head;
+    atomic_int tail;
+    uint32_t   dropped; /* Packets the producer could not queue. */
+};
+
 typedef struct net_card_migrate_t {
     const device_t *device;
     const char     *old_internal_name;
@@ -300,25 +314,66 @@ network_init(void)
 }
 
 void
-network_queue_init(netqueue_t *queue)
+network_queue_init(netqueue_t *queue, int depth)
 {
-    queue->head = queue->tail = 0;
-    for (int i = 0; i < NET_QUEUE_LEN; i++) {
+    int len = NET_QUEUE_DEPTH_MIN;
+
+    while ((len < depth) && (len < NET_QUEUE_DEPTH_MAX))
+        len <<= 1;
+
+    queue->packets = calloc(len, sizeof(netpkt_t));
+    queue->mask    = len - 1;
+    queue->dropped = 0;
+    atomic_init(&queue->head, 0);
+    atomic_init(&queue->tail, 0);
+    for (int i = 0; i < len; i++) {
         queue->packets[i].data = calloc(1, NET_MAX_FRAME);
         queue->packets[i].len  = 0;
     }
 }
 
-static bool
-network_queue_full(netqueue_t *queue)
+/* Returns the slot the producer can fill next, or NULL if the queue is full. */
+static netpkt_t *
+network_queue_head(netqueue_t *queue)
+{
+    int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    int tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+
+    if (((head + 1) & queue->mask) == tail)
+        return NULL;
+
+    return &queue->packets[head];
+}
+
+/* Publishes the slot returned by network_queue_head(). */
+static void
+network_queue_push(netqueue_t *queue)
+{
+    int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+
+    atomic_store_explicit(&queue->head, (head + 1) & queue->mask, memory_order_release);
+}
+
+/* Returns the oldest packet for the consumer, or NULL if the queue is empty. */
+static netpkt_t *
+network_queue_tail(netqueue_t *queue)
 {
-    return ((queue->head + 1) & NET_QUEUE_LEN_MASK) == queue->tail;
+    int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    int head = atomic_load_explicit(&queue->head, memory_order_acquire);
+
+    if (head == tail)
+        return NULL;
+
+    return &queue->packets[tail];
 }
 
-static bool
-network_queue_empty(netqueue_t *queue)
+/* Gives the slot returned by network_queue_tail() back to the producer. */
+static void
+network_queue_pop(netqueue_t *queue)
 {
-    return (queue->head == queue->tail);
+    int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+
+    atomic_store_explicit(&queue->tail, (tail + 1) & queue->mask, memory_order_release);
 }
 
 static inline void
@@ -332,21 +387,28 @@ network_swap_packet(netpkt_t *pkt1, netpkt_t *pkt2)
 int
 network_queue_put(netqueue_t *queue, uint8_t *data, int len)
 {
-    if (len == 0 || len > NET_MAX_FRAME || network_queue_full(queue)) {
+    netpkt_t *pkt;
+
+    if (len == 0 || len > NET_MAX_FRAME)
+        return 0;
+
+    if (!(pkt = network_queue_head(queue))) {
+        queue->dropped++;
         return 0;
     }
 
-    netpkt_t *pkt = &queue->packets[queue->head];
     memcpy(pkt->data, data, len);
-    pkt->len    = len;
-    queue->head = (queue->head + 1) & NET_QUEUE_LEN_MASK;
+    pkt->len = len;
+    network_queue_push(queue);
     return 1;
 }
 
 int
 network_queue_put_swap(netqueue_t *queue, netpkt_t *src_pkt)
 {
-    if (src_pkt->len == 0 || src_pkt->len > NET_MAX_FRAME || network_queue_full(queue)) {
+    netpkt_t *dst_pkt = NULL;
+
+    if (src_pkt->len == 0 || src_pkt->len > NET_MAX_FRAME || !(dst_pkt = network_queue_head(queue))) {
 #ifdef DEBUG
         if (src_pkt->len == 0) {
             network_log("Discarded zero length packet.\n");
@@ -356,44 +418,45 @@ network_queue_put_swap(netqueue_t *queue, netpkt_t *src_pkt)
             network_log("Discarded %d bytes packet because the queue is full.\n", src_pkt->len);
         }
 #endif
+        if ((src_pkt->len > 0) && (src_pkt->len <= NET_MAX_FRAME))
+            queue->dropped++;
         return 0;
     }
 
-    netpkt_t *dst_pkt = &queue->packets[queue->head];
     network_swap_packet(src_pkt, dst_pkt);
-
-    queue->head = (queue->head + 1) & NET_QUEUE_LEN_MASK;
+    network_queue_push(queue);
     return 1;
 }
 
 static int
 network_queue_get_swap(netqueue_t *queue, netpkt_t *dst_pkt)
 {
-    if (network_queue_empty(queue))
+    netpkt_t *src_pkt = network_queue_tail(queue);
+
+    if (src_pkt == NULL)
         return 0;
 
-    netpkt_t *src_pkt = &queue->packets[queue->tail];
     network_swap_packet(src_pkt, dst_pkt);
-    queue->tail = (queue->tail + 1) & NET_QUEUE_LEN_MASK;
+    network_queue_pop(queue);
     return 1;
 }
 
 static int
 network_queue_move(netqueue_t *dst_q, netqueue_t *src_q)
 {
-    if (network_queue_empty(src_q))
-        return 0;
+    netpkt_t *src_pkt = network_queue_tail(src_q);
+    netpkt_t *dst_pkt;
 
-    if (network_queue_full(dst_q)) {
+    if (src_pkt == NULL)
         return 0;
-    }
 
-    netpkt_t *src_pkt = &src_q->packets[src_q->tail];
-    netpkt_t *dst_pkt = &dst_q->packets[dst_q->head];
+    /* Leave the packet where it is until there is room for it. */
+    if (!(dst_pkt = network_queue_head(dst_q)))
+        return 0;
 
     network_swap_packet(src_pkt, dst_pkt);
-    dst_q->head = (dst_q->head + 1) & NET_QUEUE_LEN_MASK;
-    src_q->tail = (src_q->tail + 1) & NET_QUEUE_LEN_MASK;
+    network_queue_push(dst_q);
+    network_queue_pop(src_q);
 
     return dst_pkt->len;
 }
@@ -401,11 +464,15 @@ network_queue_move(netqueue_t *dst_q, netqueue_t *src_q)
 void
 network_queue_clear(netqueue_t *queue)
 {
-    for (int i = 0; i < NET_QUEUE_LEN; i++) {
+    if (queue->packets == NULL)
+        return;
+
+    for (int i = 0; i <= queue->mask; i++)
         free(queue->packets[i].data);
-        queue->packets[i].len = 0;
-    }
-    queue->tail = queue->head = 0;
+    free(queue->packets);
+    queue->packets = NULL;
+    atomic_store(&queue->head, 0);
+    atomic_store(&queue->tail, 0);
 }
 
 static void
@@ -420,13 +487,12 @@ network_rx_queue(void *priv)
         card->link_state = new_link_state;
     }
 
+    /* Hand the card as many packets as it takes, up to a full queue. */
     uint32_t rx_bytes = 0;
-    for (int i = 0; i < NET_QUEUE_LEN; i++) {
+    for (int i = 0; i <= card->queues[NET_QUEUE_RX].mask; i++) {
         if (card->queued_pkt.len == 0) {
-            thread_wait_mutex(card->rx_mutex);
-            int res = network_queue_get_swap(&card->queues[NET_QUEUE_RX], &card->queued_pkt);
-            thread_release_mutex(card->rx_mutex);
-            if (!res)
+            if (!network_queue_get_swap(&card->queues[NET_QUEUE_RX_LOCAL], &card->queued_pkt) &&
+                !network_queue_get_swap(&card->queues[NET_QUEUE_RX], &card->queued_pkt))
                 break;
         }
 
@@ -434,20 +500,20 @@ network_rx_queue(void *priv)
         int res = card->rx(card->card_drv, card->queued_pkt.data, card->queued_pkt.len);
         if (!res)
             break;
+        if (card->host_drv.rx_done)
+            card->host_drv.rx_done(card->host_drv.priv, &card->queued_pkt);
         rx_bytes += card->queued_pkt.len;
         card->queued_pkt.len = 0;
     }
 
     /* Transmission. */
     uint32_t tx_bytes = 0;
-    thread_wait_mutex(card->tx_mutex);
-    for (int i = 0; i < NET_QUEUE_LEN; i++) {
+    for (int i = 0; i <= card->queues[NET_QUEUE_TX_VM].mask; i++) {
         uint32_t bytes = network_queue_move(&card->queues[NET_QUEUE_TX_HOST], &card->queues[NET_QUEUE_TX_VM]);
         if (!bytes)
             break;
         tx_bytes += bytes;
     }
-    thread_release_mutex(card->tx_mutex);
     if (tx_bytes) {
         /* Notify host that a packet is available in the TX queue */
         card->host_drv.notify_in(card->host_drv.priv);
@@ -486,16 +552,18 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
     card->card_drv        = card_drv;
     card->rx              = rx;
     card->set_link_state  = set_link_state;
-    card->tx_mutex        = thread_create_mutex();
-    card->rx_mutex        = thread_create_mutex();
     card->card_num        = net_card_current;
     card->byte_period     = NET_PERIOD_10M;
 
     char net_drv_error[NET_DRV_ERRBUF_SIZE];
     char tempmsg[NET_DRV_ERRBUF_SIZE * 2];
 
+    int depth = net_cards_conf[net_card_current].queue_depth;
+    if (depth <= 0)
+        depth = NET_QUEUE_DEPTH_DEF;
+    card->queues = calloc(NET_QUEUE_COUNT, sizeof(netqueue_t));
     for (int i = 0; i < NET_QUEUE_COUNT; i++) {
-        network_queue_init(&card->queues[i]);
+        network_queue_init(&card->queues[i], depth);
     }
 
     const char *nic_name = network_card_get_internal_name(net_cards_conf[net_card_current].device_num);
@@ -504,7 +572,16 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
         net_type = NET_TYPE_SLIRP;
     }
 
+    /* A benchmark replaces whatever an Ethernet card is connected to. */
+    if ((net_bench_rate > 0) && strcmp(nic_name, "modem") && strcmp(nic_name, "plip"))
+        net_type = NET_TYPE_BENCH;
+
     switch (net_type) {
+        case NET_TYPE_BENCH:
+            card->host_drv      = net_bench_drv;
+            card->host_drv.priv = card->host_drv.init(card, mac, NULL, net_drv_error);
+            break;
+
         case NET_TYPE_SLIRP:
             card->host_drv      = net_slirp_drv;
             card->host_drv.priv = card->host_drv.init(card, mac, NULL, net_drv_error);
@@ -558,12 +635,11 @@ network_attach(void *card_drv, uint8_t *mac, NETRXCB rx, NETSETLINKSTATE set_lin
         // If null fails, something is very wrong
         // Clean up and fatal
         if(!card->host_drv.priv) {
-            thread_close_mutex(card->tx_mutex);
-            thread_close_mutex(card->rx_mutex);
             for (int i = 0; i < NET_QUEUE_COUNT; i++) {
                 network_queue_clear(&card->queues[i]);
             }
 
+            free(card->queues);
             free(card->queued_pkt.data);
             free(card);
             // Placeholder - insert the error message
@@ -585,11 +661,14 @@ netcard_close(netcard_t *card)
     timer_stop(&card->timer);
     card->host_drv.close(card->host_drv.priv);
 
-    thread_close_mutex(card->tx_mutex);
-    thread_close_mutex(card->rx_mutex);
+    if (card->queues[NET_QUEUE_RX].dropped || card->queues[NET_QUEUE_TX_VM].dropped)
+        pclog("NETWORK: Card %i dropped %u received and %u transmitted packets on full queues\n",
+              card->card_num + 1, card->queues[NET_QUEUE_RX].dropped, card->queues[NET_QUEUE_TX_VM].dropped);
+
     for (int i = 0; i < NET_QUEUE_COUNT; i++) {
         network_queue_clear(&card->queues[i]);
     }
+    free(card->queues);
 
     free(card->queued_pkt.data);
     free(card);
@@ -647,13 +726,7 @@ network_tx(netcard_t *card, uint8_t *bufp, int len)
 int
 network_tx_pop(netcard_t *card, netpkt_t *out_pkt)
 {
-    int ret = 0;
-
-    thread_wait_mutex(card->tx_mutex);
-    ret = network_queue_get_swap(&card->queues[NET_QUEUE_TX_HOST], out_pkt);
-    thread_release_mutex(card->tx_mutex);
-
-    return ret;
+    return network_queue_get_swap(&card->queues[NET_QUEUE_TX_HOST], out_pkt);
 }
 
 int
@@ -662,7 +735,6 @@ network_tx_popv(netcard_t *card, netpkt_t *pkt_vec, int vec_size)
     int pkt_count = 0;
 
     netqueue_t *queue = &card->queues[NET_QUEUE_TX_HOST];
-    thread_wait_mutex(card->tx_mutex);
     for (int i = 0; i < vec_size; i++) {
         if (!network_queue_get_swap(queue, pkt_vec))
             break;
@@ -670,21 +742,17 @@ network_tx_popv(netcard_t *card, netpkt_t *pkt_vec, int vec_size)
         pkt_count++;
         pkt_vec++;
     }
-    thread_release_mutex(card->tx_mutex);
 
     return pkt_count;
 }
 
+/* Loops a packet back from the card to itself. Called from the emulation
+   thread, so it has a queue of its own rather than share the one the host
+   driver fills. */
 int
 network_rx_put(netcard_t *card, uint8_t *bufp, int len)
 {
-    int ret = 0;
-
-    thread_wait_mutex(card->rx_mutex);
-    ret = network_queue_put(&card->queues[NET_QUEUE_RX], bufp, len);
-    thread_release_mutex(card->rx_mutex);
-
-    return ret;
+    return network_queue_put(&card->queues[NET_QUEUE_RX_LOCAL], bufp, len);
 }
 
 int
@@ -727,13 +795,14 @@ network_rx_on_tx_put_pkt(netcard_t *card, netpkt_t *pkt)
 int
 network_rx_put_pkt(netcard_t *card, netpkt_t *pkt)
 {
-    int ret = 0;
-
-    thread_wait_mutex(card->rx_mutex);
-    ret = network_queue_put_swap(&card->queues[NET_QUEUE_RX], pkt);
-    thread_release_mutex(card->rx_mutex);
+    return network_queue_put_swap(&card->queues[NET_QUEUE_RX], pkt);
+}
 
-    return ret;
+void
+network_get_dropped(const netcard_t *card, uint32_t *rx, uint32_t *tx)
+{
+    *rx = card->queues[NET_QUEUE_RX].dropped;
+    *tx = card->queues[NET_QUEUE_TX_VM].dropped;
 }
 
 void
@@ -33,6 +33,7 @@
 #include <86box/timer.h>
 #include <86box/pit.h>
 #include <86box/device.h>
+#include <86box/snapshot.h>
 #include <86box/apm.h>
 #include <86box/nvr.h>
 #include <86box/acpi.h>
@@ -961,3 +962,55 @@ picinterrupt(void)
 
     return ret;
 }
+
+static void
+pic_save_state_one(snapshot_t *snap, pic_t *dev)
+{
+    snapshot_write_var(snap, *dev);
+}
+
+static void
+pic_load_state_one(snapshot_t *snap, pic_t *dev)
+{
+    pic_t *slaves[8];
+
+    /* The slave pointers are set up by pic2_init(), keep them. */
+    memcpy(slaves, dev->slaves, sizeof(slaves));
+    snapshot_read_var(snap, *dev);
+    memcpy(dev->slaves, slaves, sizeof(slaves));
+}
+
+void
+pic_save_state(snapshot_t *snap)
+{
+    pic_save_state_one(snap, &pic);
+    pic_save_state_one(snap, &pic2);
+
+    snapshot_write_var(snap, shadow);
+    snapshot_write_var(snap, elcr_enabled);
+    snapshot_write_var(snap, kbd_latch);
+    snapshot_write_var(snap, mouse_latch);
+    snapshot_write_var(snap, smi_irq_mask);
+    snapshot_write_var(snap, smi_irq_status);
+    snapshot_write_var(snap, latched_irqs);
+    snapshot_write_timer(snap, &pic_timer);
+}
+
+void
+pic_load_state(snapshot_t *snap)
+{
+    pic_load_state_one(snap, &pic);
+    pic_load_state_one(snap, &pic2);
+
+    snapshot_read_var(snap, shadow);
+    snapshot_read_var(snap, elcr_enabled);
+    snapshot_read_var(snap, kbd_latch);
+    snapshot_read_var(snap, mouse_latch);
+    snapshot_read_var(snap, smi_irq_mask);
+    snapshot_read_var(snap, smi_irq_status);
+    snapshot_read_var(snap, latched_irqs);
+    snapshot_read_timer(snap, &pic_timer);
+
+    if (update_pending != NULL)
+        update_pending();
+}
@@ -38,6 +38,7 @@
 #include <86box/machine.h>
 #include <86box/sound.h>
 #include <86box/snd_speaker.h>
+#include <86box/snapshot.h>
 #include <86box/video.h>
 
 #define PIT_PS2          16  /* The PIT is the PS/2's second PIT. */
@@ -695,6 +696,42 @@ pitf_speed_changed(void *priv)
     pitf_set_pit_const(priv, PITCONST);
 }
 
+static void
+pitf_save_state(void *priv, snapshot_t *snap)
+{
+    const pitf_t *dev = (pitf_t *) priv;
+
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        snapshot_write_var(snap, dev->counters[i]);
+        snapshot_write_timer(snap, &dev->counters[i].timer);
+    }
+
+    snapshot_write_var(snap, dev->ctrl);
+}
+
+static void
+pitf_load_state(void *priv, snapshot_t *snap)
+{
+    pitf_t *dev = (pitf_t *) priv;
+    ctrf_t  ctr;
+
+    for (int i = 0; i < NUM_COUNTERS; i++) {
+        ctrf_t *cur = &dev->counters[i];
+
+        /* Keep the timer and the handlers installed by the machine. */
+        snapshot_read_var(snap, ctr);
+        ctr.timer     = cur->timer;
+        ctr.load_func = cur->load_func;
+        ctr.out_func  = cur->out_func;
+        ctr.priv      = cur->priv;
+        *cur          = ctr;
+
+        snapshot_read_timer(snap, &cur->timer);
+    }
+
+    snapshot_read_var(snap, dev->ctrl);
+}
+
 static void
 pitf_close(void *priv)
 {
@@ -754,7 +791,10 @@ const device_t i8253_fast_device = {
     .available     = NULL,
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pitf_save_state,
+    .load_state    = pitf_load_state,
+    .state_version = 1
 };
 
 const device_t i8253_ext_io_fast_device = {
@@ -768,7 +808,10 @@ const device_t i8253_ext_io_fast_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pitf_save_state,
+    .load_state    = pitf_load_state,
+    .state_version = 1
 };
 
 const device_t i8254_fast_device = {
@@ -782,7 +825,10 @@ const device_t i8254_fast_device = {
     .available     = NULL,
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pitf_save_state,
+    .load_state    = pitf_load_state,
+    .state_version = 1
 };
 
 const device_t i8254_sec_fast_device = {
@@ -796,7 +842,10 @@ const device_t i8254_sec_fast_device = {
     .available     = NULL,
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pitf_save_state,
+    .load_state    = pitf_load_state,
+    .state_version = 1
 };
 
 const device_t i8254_ext_io_fast_device = {
@@ -810,7 +859,10 @@ const device_t i8254_ext_io_fast_device = {
     .available     = NULL,
     .speed_changed = NULL,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pitf_save_state,
+    .load_state    = pitf_load_state,
+    .state_version = 1
 };
 
 const device_t i8254_ps2_fast_device = {
@@ -824,7 +876,10 @@ const device_t i8254_ps2_fast_device = {
     .available     = NULL,
     .speed_changed = pitf_speed_changed,
     .force_redraw  = NULL,
-    .config        = NULL
+    .config        = NULL,
+    .save_state    = pitf_save_state,
+    .load_state    = pitf_load_state,
+    .state_version = 1
 };
 
 const pit_intf_t pit_fast_intf = {
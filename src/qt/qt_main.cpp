@@ -99,6 +99,8 @@ extern "C" {
 #include "cpu.h"
 #include <86box/timer.h>
 #include <86box/nvr.h>
+#include <86box/bench.h>
+#include <86box/snapshot.h>
 extern int  qt_nvr_save(void);
 #ifndef Q_OS_MACOS
 extern void exit_pause(void);
@@ -462,6 +464,13 @@ main_thread_fn()
     frames                   = 0;
     debt_ns                  = 0;
     is_cpu_thread            = 1;
+
+    /* A benchmark runs unpaced, then powers the machine off. */
+    if (bench_seconds) {
+        bench_run();
+        plat_power_off();
+    }
+
     while (!is_quit && cpu_thread_run) {
         /* See if it is time to run a frame of code. */
         const qint64 new_ns = elapsed_timer.nsecsElapsed();
@@ -514,6 +523,9 @@ main_thread_fn()
                 pc_reset_hard_init();
             }
 
+            /* Save or load the machine state while paused. */
+            snapshot_process();
+
             if (dopause)
                 ack_pause();
 
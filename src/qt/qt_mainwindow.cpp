@@ -55,6 +55,7 @@ extern "C" {
 #include <86box/nvr.h>
 #include <86box/acpi.h>
 #include <86box/renderdefs.h>
+#include <86box/snapshot.h>
 
 #ifdef USE_VNC
 #    include <86box/vnc.h>
@@ -553,6 +554,12 @@ MainWindow::MainWindow(QWidget *parent)
     ui->actionApply_fullscreen_stretch_mode_when_maximized->setVisible(false);
 #endif
 
+#ifndef USE_SNAPSHOT
+    /* Few devices can be saved yet, see snapshot.h. */
+    ui->actionSave_state->setVisible(false);
+    ui->actionLoad_state->setVisible(false);
+#endif
+
 #ifndef DISCORD
     ui->actionEnable_Discord_integration->setVisible(false);
 #else
@@ -1080,6 +1087,8 @@ MainWindow::updateShortcuts()
     ui->actionCtrl_Alt_Esc->setShortcut(QKeySequence());
     ui->actionNon_maskable_interrupt->setShortcut(QKeySequence());
     ui->actionHard_Reset->setShortcut(QKeySequence());
+    ui->actionSave_state->setShortcut(QKeySequence());
+    ui->actionLoad_state->setShortcut(QKeySequence());
     ui->actionFast_forward->setShortcut(QKeySequence());
     ui->actionFullscreen->setShortcut(QKeySequence());
     ui->actionPause->setShortcut(QKeySequence());
@@ -1123,6 +1132,16 @@ MainWindow::updateShortcuts()
     seq   = QKeySequence::fromString(acc_keys[accID].seq);
     ui->actionHard_Reset->setShortcut(seq);
 
+#ifdef USE_SNAPSHOT
+    accID = FindAccelerator("save_state");
+    seq   = QKeySequence::fromString(acc_keys[accID].seq);
+    ui->actionSave_state->setShortcut(seq);
+
+    accID = FindAccelerator("load_state");
+    seq   = QKeySequence::fromString(acc_keys[accID].seq);
+    ui->actionLoad_state->setShortcut(seq);
+#endif
+
     accID = FindAccelerator("fast_forward");
     seq   = QKeySequence::fromString(acc_keys[accID].seq);
     ui->actionFast_forward->setShortcut(seq);
@@ -1328,6 +1347,19 @@ MainWindow::on_actionHard_Reset_triggered()
     pc_reset_hard();
 }
 
+/* The emulation thread carries out both at the end of its current block. */
+void
+MainWindow::on_actionSave_state_triggered()
+{
+    snapshot_request(SNAPSHOT_SAVE, QDir(usr_path).filePath("state.86s").toUtf8().constData());
+}
+
+void
+MainWindow::on_actionLoad_state_triggered()
+{
+    snapshot_request(SNAPSHOT_LOAD, QDir(usr_path).filePath("state.86s").toUtf8().constData());
+}
+
 void
 MainWindow::on_actionCtrl_Alt_Del_triggered()
 {
@@ -1734,6 +1766,16 @@ MainWindow::eventFilter(QObject *receiver, QEvent *event)
                 || (QKeySequence) (ke->key() | ke->modifiers()) == FindAcceleratorSeq("hard_reset")) {
                 ui->actionHard_Reset->trigger();
             }
+#ifdef USE_SNAPSHOT
+            if ((QKeySequence) (ke->key() | (ke->modifiers() & ~Qt::KeypadModifier)) == FindAcceleratorSeq("save_state")
+                || (QKeySequence) (ke->key() | ke->modifiers()) == FindAcceleratorSeq("save_state")) {
+                ui->actionSave_state->trigger();
+            }
+            if ((QKeySequence) (ke->key() | (ke->modifiers() & ~Qt::KeypadModifier)) == FindAcceleratorSeq("load_state")
+                || (QKeySequence) (ke->key() | ke->modifiers()) == FindAcceleratorSeq("load_state")) {
+                ui->actionLoad_state->trigger();
+            }
+#endif
             if ((QKeySequence) (ke->key() | (ke->modifiers() & ~Qt::KeypadModifier)) == FindAcceleratorSeq("fast_forward")
                 || (QKeySequence) (ke->key() | ke->modifiers()) == FindAcceleratorSeq("fast_forward")) {
                 ui->actionFast_forward->trigger();
@@ -31,11 +31,14 @@
 #include <86box/plat.h>
 #include <86box/ui.h>
 #include <86box/hdd.h>
+#include <86box/hdd_aio.h>
 #include <86box/scsi_disk.h>
 #include <86box/version.h>
 
 #define IDE_ATAPI_IS_EARLY             id->sc->pad0
 
+#define SCSI_DISK_READ_AHEAD           128 /* Sectors, 64 kB. */
+
 #define scsi_disk_sense_error dev->sense[0]
 #define scsi_disk_sense_key   dev->sense[2]
 #define scsi_disk_info        *(uint32_t *) &(dev->sense[3])
@@ -770,6 +773,145 @@ scsi_disk_data_phase_error(scsi_disk_t *dev, const uint32_t info)
     scsi_disk_cmd_error(dev);
 }
 
+/*
+ * SCSI controllers take the data of a read as soon as the command returns,
+ * so a read can not be left running the way IDE does. Instead, reads of up
+ * to SCSI_DISK_READ_AHEAD sectors have the asynchronous I/O layer fetch the
+ * next run of sectors in the background, for the next command to pick up.
+ * Writes are handed to the layer once their data has been transferred, and
+ * the command completes right away, like on a drive with its write cache
+ * enabled; a failed write is reported by the next command.
+ *
+ * Keep this state outside scsi_disk_t: that structure is shared with the
+ * controllers, while the requests are an implementation detail of this module.
+ */
+typedef struct scsi_disk_aio_t {
+    hdd_aio_req_t write;
+    uint8_t      *write_buf;
+    uint32_t      write_buf_sz;
+    int           write_error;
+
+    hdd_aio_req_t read_ahead;
+    uint8_t      *read_ahead_buf;
+    uint32_t      read_ahead_sector;
+    uint32_t      read_ahead_count; /* 0 when there is nothing to pick up. */
+} scsi_disk_aio_t;
+
+static scsi_disk_aio_t scsi_disk_aio[HDD_NUM];
+
+/* Collect the write handed to the image by an earlier command. */
+static void
+scsi_disk_aio_write_collect(scsi_disk_aio_t *aio, const int wait)
+{
+    if ((aio->write.state == HDD_AIO_IDLE) || (!wait && hdd_aio_busy(&aio->write)))
+        return;
+
+    if (hdd_aio_finish(&aio->write) < 0)
+        aio->write_error = 1;
+}
+
+/* Return non-zero once if a write that already completed has failed since. */
+static int
+scsi_disk_aio_write_failed(const scsi_disk_t *dev)
+{
+    scsi_disk_aio_t *aio = &scsi_disk_aio[dev->id];
+    int              ret;
+
+    scsi_disk_aio_write_collect(aio, 0);
+
+    ret              = aio->write_error;
+    aio->write_error = 0;
+
+    return ret;
+}
+
+/* Whatever the read ahead brings in may be older than a write. */
+static void
+scsi_disk_aio_read_ahead_drop(scsi_disk_aio_t *aio)
+{
+    aio->read_ahead_count = 0;
+}
+
+static int
+scsi_disk_aio_write(const scsi_disk_t *dev, const uint32_t sector, const uint32_t count)
+{
+    scsi_disk_aio_t *aio = &scsi_disk_aio[dev->id];
+    const uint32_t   len = count << 9;
+    uint8_t         *buf;
+
+    scsi_disk_aio_read_ahead_drop(aio);
+    scsi_disk_aio_write_collect(aio, 1);
+
+    if (len > aio->write_buf_sz) {
+        buf = (uint8_t *) realloc(aio->write_buf, len);
+        if (buf == NULL)
+            return hdd_image_write(dev->id, sector, count, dev->temp_buffer);
+
+        aio->write_buf    = buf;
+        aio->write_buf_sz = len;
+    }
+
+    memcpy(aio->write_buf, dev->temp_buffer, len);
+    hdd_aio_submit(&aio->write, HDD_AIO_WRITE, dev->id, sector, count, aio->write_buf);
+
+    return 0;
+}
+
+static int
+scsi_disk_aio_read(const scsi_disk_t *dev, const uint32_t sector, const uint32_t count)
+{
+    scsi_disk_aio_t *aio  = &scsi_disk_aio[dev->id];
+    const uint32_t   next = sector + count;
+    const uint32_t   end  = hdd_image_get_last_sector(dev->id) + 1;
+    int              ret  = -1;
+    int              hit  = 0;
+
+    if (aio->read_ahead_count && (sector >= aio->read_ahead_sector) &&
+        (next <= (aio->read_ahead_sector + aio->read_ahead_count))) {
+        ret = hdd_aio_finish(&aio->read_ahead);
+        hit = (ret >= 0);
+        if (hit)
+            memcpy(dev->temp_buffer, aio->read_ahead_buf + ((sector - aio->read_ahead_sector) << 9),
+                   count << 9);
+    }
+
+    /* This waits for everything queued to the image, read ahead included. */
+    if (!hit)
+        ret = hdd_image_read(dev->id, sector, count, dev->temp_buffer);
+
+    scsi_disk_aio_read_ahead_drop(aio);
+    (void) hdd_aio_finish(&aio->read_ahead);
+
+    if ((ret >= 0) && (count <= SCSI_DISK_READ_AHEAD) && (next < end)) {
+        if (aio->read_ahead_buf == NULL)
+            aio->read_ahead_buf = (uint8_t *) malloc(SCSI_DISK_READ_AHEAD << 9);
+
+        if (aio->read_ahead_buf != NULL) {
+            aio->read_ahead_sector = next;
+            aio->read_ahead_count  = MIN(SCSI_DISK_READ_AHEAD, end - next);
+            hdd_aio_submit(&aio->read_ahead, HDD_AIO_READ, dev->id, aio->read_ahead_sector,
+                           aio->read_ahead_count, aio->read_ahead_buf);
+        }
+    }
+
+    return ret;
+}
+
+/* Wait for everything still running and let go of the buffers. */
+static void
+scsi_disk_aio_close(const uint8_t id)
+{
+    scsi_disk_aio_t *aio = &scsi_disk_aio[id];
+
+    scsi_disk_aio_write_collect(aio, 1);
+    scsi_disk_aio_read_ahead_drop(aio);
+    (void) hdd_aio_finish(&aio->read_ahead);
+
+    free(aio->write_buf);
+    free(aio->read_ahead_buf);
+    memset(aio, 0x00, sizeof(scsi_disk_aio_t));
+}
+
 static int
 scsi_disk_blocks(scsi_disk_t *dev, int32_t *len, const int out)
 {
@@ -790,26 +932,21 @@ scsi_disk_blocks(scsi_disk_t *dev, int32_t *len, const int out)
         } else {
             *len    = dev->requested_blocks << 9;
 
-            for (int i = 0; i < dev->requested_blocks; i++) {
-                if (out) {
-                    if (hdd_image_write(dev->id, dev->sector_pos, 1, dev->temp_buffer +
-                                        (i << 9)) < 0) {
-                        scsi_disk_log(dev->log, "scsi_disk_blocks(): Error writing data\n");
-                        scsi_disk_write_error(dev);
-                        ret = -1;
-                    }
-                } else if (hdd_image_read(dev->id, dev->sector_pos, 1, dev->temp_buffer +
-                                          (i << 9)) < 0) {
-                    scsi_disk_log(dev->log, "scsi_disk_blocks(): Error reading data\n");
-                    scsi_disk_read_error(dev);
+            /* Hand the whole transfer to the image at once. */
+            if (out) {
+                if (scsi_disk_aio_write(dev, dev->sector_pos, dev->requested_blocks) < 0) {
+                    scsi_disk_log(dev->log, "scsi_disk_blocks(): Error writing data\n");
+                    scsi_disk_write_error(dev);
                     ret = -1;
                 }
-
-                if (ret == -1)
-                    break;
-
-                dev->sector_pos++;
+            } else if (scsi_disk_aio_read(dev, dev->sector_pos, dev->requested_blocks) < 0) {
+                scsi_disk_log(dev->log, "scsi_disk_blocks(): Error reading data\n");
+                scsi_disk_read_error(dev);
+                ret = -1;
             }
+
+            if (ret == 1)
+                dev->sector_pos += dev->requested_blocks;
         }
 
         if (ret == 1) {
@@ -895,6 +1032,8 @@ scsi_disk_reset(scsi_common_t *sc)
 {
     scsi_disk_t *dev = (scsi_disk_t *) sc;
 
+    scsi_disk_aio_close(dev->id);
+
     scsi_disk_rezero(dev);
     dev->tf->status         = 0;
     dev->callback           = 0.0;
@@ -1019,6 +1158,14 @@ scsi_disk_command(scsi_common_t *sc, const uint8_t *cdb)
     if (scsi_disk_pre_execution_check(dev, cdb) == 0)
         return;
 
+    /* Report a write that failed after its command had completed. */
+    if ((cdb[0] != GPCMD_REQUEST_SENSE) && (cdb[0] != GPCMD_INQUIRY) &&
+        scsi_disk_aio_write_failed(dev)) {
+        scsi_disk_log(dev->log, "Deferred write error\n");
+        scsi_disk_write_error(dev);
+        return;
+    }
+
     switch (cdb[0]) {
         case GPCMD_SEND_DIAGNOSTIC:
             if (!(cdb[1] & (1 << 2))) {
@@ -1584,6 +1731,8 @@ scsi_disk_phase_data_out(scsi_common_t *sc)
                 scsi_disk_blocks(dev, &len, 1);
             break;
         case GPCMD_WRITE_SAME_10:
+            scsi_disk_aio_read_ahead_drop(&scsi_disk_aio[dev->id]);
+
             if (!dev->current_cdb[7] && !dev->current_cdb[8])
                 last_to_write = last_sector;
             else
@@ -1923,6 +2072,7 @@ scsi_disk_close(void)
                 memset(&scsi_devices[scsi_bus][scsi_id], 0x00, sizeof(scsi_device_t));
             }
 
+            scsi_disk_aio_close(c);
             hdd_image_close(c);
 
             scsi_disk_t *dev = hdd[c].priv;
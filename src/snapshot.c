@@ -0,0 +1,414 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Implementation of the machine save state module.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/device.h>
+#include <86box/machine.h>
+#include <86box/plat.h>
+#include <86box/timer.h>
+#include <86box/snapshot.h>
+
+#define SNAPSHOT_MAGIC "86BXSNAP"
+
+typedef struct snapshot_header_t {
+    char     magic[8];
+    uint32_t version;
+    uint32_t flags;
+    char     machine[SNAPSHOT_NAME_LEN];
+    char     cpu[SNAPSHOT_NAME_LEN];
+    uint32_t mem_size;
+    uint32_t pad;
+} snapshot_header_t;
+
+typedef struct snapshot_chunk_t {
+    char     name[SNAPSHOT_NAME_LEN];
+    uint32_t index;
+    uint32_t version; /* Version of the owner's state layout. */
+    uint64_t size;
+} snapshot_chunk_t;
+
+struct snapshot_t {
+    FILE    *fp; /* NULL when only measuring the size of a chunk. */
+    int      error;
+
+    /* Chunk currently being written or read. */
+    int64_t  chunk_start;
+    uint64_t chunk_size;
+    uint64_t chunk_pos;
+};
+
+typedef struct snapshot_section_t {
+    const char *name;
+    uint32_t    version;
+    void (*save)(snapshot_t *snap);
+    void (*load)(snapshot_t *snap);
+} snapshot_section_t;
+
+static void snapshot_timer_save(snapshot_t *snap);
+static void snapshot_timer_load(snapshot_t *snap);
+
+/* Core sections, in the order they are saved and restored. The timer section
+   goes first, as it restores the TSC that the other timers are relative to. */
+static const snapshot_section_t snapshot_sections[] = {
+    { "@timer", 1, snapshot_timer_save, snapshot_timer_load },
+    { "@cpu",   1, cpu_save_state,      cpu_load_state      },
+    { "@mem",   1, mem_save_state,      mem_load_state      },
+    { "@pic",   1, pic_save_state,      pic_load_state      },
+    { "@dma",   1, dma_save_state,      dma_load_state      },
+    { NULL,     0, NULL,                NULL                }
+};
+
+#ifdef ENABLE_SNAPSHOT_LOG
+int snapshot_do_log = ENABLE_SNAPSHOT_LOG;
+
+static void
+snapshot_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (snapshot_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define snapshot_log(fmt, ...)
+#endif
+
+/* Request from the UI, carried out on the emulation thread by snapshot_process(). */
+static ATOMIC_INT snapshot_pending = SNAPSHOT_NONE;
+static char       snapshot_pending_fn[1024];
+
+void
+snapshot_begin_chunk(snapshot_t *snap, const char *name, int index, uint32_t version)
+{
+    snapshot_chunk_t chunk;
+
+    memset(&chunk, 0x00, sizeof(chunk));
+    strncpy(chunk.name, name, SNAPSHOT_NAME_LEN - 1);
+    chunk.index   = index;
+    chunk.version = version;
+
+    /* The size is filled in by snapshot_end_chunk(). */
+    snap->chunk_start = ftello64(snap->fp);
+    snap->chunk_size  = 0;
+    snap->chunk_pos   = 0;
+    if (fwrite(&chunk, 1, sizeof(chunk), snap->fp) != sizeof(chunk))
+        snap->error = 1;
+}
+
+void
+snapshot_end_chunk(snapshot_t *snap)
+{
+    int64_t end = ftello64(snap->fp);
+
+    fseeko64(snap->fp, snap->chunk_start + offsetof(snapshot_chunk_t, size), SEEK_SET);
+    if (fwrite(&snap->chunk_pos, 1, sizeof(snap->chunk_pos), snap->fp) != sizeof(snap->chunk_pos))
+        snap->error = 1;
+    fseeko64(snap->fp, end, SEEK_SET);
+}
+
+void
+snapshot_write(snapshot_t *snap, const void *data, size_t size)
+{
+    if ((snap->fp != NULL) && (fwrite(data, 1, size, snap->fp) != size))
+        snap->error = 1;
+    snap->chunk_pos += size;
+}
+
+/* Returns how many bytes a save callback writes, without writing them anywhere. */
+uint64_t
+snapshot_state_size(void (*save)(void *priv, snapshot_t *snap), void *priv)
+{
+    snapshot_t snap;
+
+    memset(&snap, 0x00, sizeof(snap));
+    save(priv, &snap);
+
+    return snap.chunk_pos;
+}
+
+static uint64_t
+snapshot_section_size(const snapshot_section_t *sect)
+{
+    snapshot_t snap;
+
+    memset(&snap, 0x00, sizeof(snap));
+    sect->save(&snap);
+
+    return snap.chunk_pos;
+}
+
+void
+snapshot_read(snapshot_t *snap, void *data, size_t size)
+{
+    size_t avail = 0;
+
+    if (snap->chunk_pos < snap->chunk_size)
+        avail = snap->chunk_size - snap->chunk_pos;
+    if (size > avail) {
+        memset((uint8_t *) data + avail, 0x00, size - avail);
+        snap->error = 1;
+    }
+
+    if (avail && (fread(data, 1, (size < avail) ? size : avail, snap->fp) != ((size < avail) ? size : avail)))
+        snap->error = 1;
+    snap->chunk_pos += (size < avail) ? size : avail;
+}
+
+int
+snapshot_error(snapshot_t *snap)
+{
+    return snap->error;
+}
+
+void
+snapshot_write_timer(snapshot_t *snap, const pc_timer_t *timer)
+{
+    snapshot_write_var(snap, timer->ts_integer);
+    snapshot_write_var(snap, timer->ts_frac);
+    snapshot_write_var(snap, timer->flags);
+    snapshot_write_var(snap, timer->period);
+}
+
+void
+snapshot_read_timer(snapshot_t *snap, pc_timer_t *timer)
+{
+    uint64_t ts_integer;
+    uint32_t ts_frac;
+    int      flags;
+    double   period;
+
+    snapshot_read_var(snap, ts_integer);
+    snapshot_read_var(snap, ts_frac);
+    snapshot_read_var(snap, flags);
+    snapshot_read_var(snap, period);
+
+    timer_disable(timer);
+
+    timer->ts_integer = ts_integer;
+    timer->ts_frac    = ts_frac;
+    timer->period     = period;
+    timer->flags      = flags & TIMER_SPLIT;
+
+    if (flags & TIMER_ENABLED)
+        timer_enable(timer);
+}
+
+static void
+snapshot_timer_save(snapshot_t *snap)
+{
+    snapshot_write_var(snap, tsc);
+}
+
+static void
+snapshot_timer_load(snapshot_t *snap)
+{
+    uint64_t new_tsc;
+
+    snapshot_read_var(snap, new_tsc);
+
+    /* Keep the timers of devices that are not restored relative to the new TSC. */
+    timer_set_new_tsc(new_tsc);
+}
+
+int
+snapshot_save(const char *fn)
+{
+    snapshot_header_t header;
+    snapshot_t        snap;
+
+    if (device_state_supported() < 0)
+        return 0;
+
+    memset(&snap, 0x00, sizeof(snap));
+    snap.fp = plat_fopen(fn, "wb");
+    if (snap.fp == NULL)
+        return 0;
+
+    memset(&header, 0x00, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version  = SNAPSHOT_VERSION;
+    header.mem_size = mem_size;
+    strncpy(header.machine, machine_get_internal_name(), SNAPSHOT_NAME_LEN - 1);
+    strncpy(header.cpu, cpu_s->name, SNAPSHOT_NAME_LEN - 1);
+    if (fwrite(&header, 1, sizeof(header), snap.fp) != sizeof(header))
+        snap.error = 1;
+
+    for (const snapshot_section_t *sect = snapshot_sections; sect->name != NULL; sect++) {
+        snapshot_begin_chunk(&snap, sect->name, 0, sect->version);
+        sect->save(&snap);
+        snapshot_end_chunk(&snap);
+    }
+
+    device_save_state_all(&snap);
+
+    fclose(snap.fp);
+
+    snapshot_log("Snapshot: saved to %s%s\n", fn, snap.error ? " with errors" : "");
+
+    return !snap.error;
+}
+
+/* Returns 1 if the chunk matches the version and size of its owner, -1 if it
+   does not, or 0 if nothing owns it. */
+static int
+snapshot_check_chunk(const snapshot_chunk_t *chunk)
+{
+    if (chunk->name[0] != '@')
+        return device_check_state(chunk->name, chunk->index, chunk->version, chunk->size);
+
+    for (const snapshot_section_t *sect = snapshot_sections; sect->name != NULL; sect++) {
+        if (!strcmp(sect->name, chunk->name))
+            return ((chunk->version == sect->version) && (chunk->size == snapshot_section_size(sect))) ? 1 : -1;
+    }
+
+    return 0;
+}
+
+int
+snapshot_load(const char *fn)
+{
+    snapshot_header_t header;
+    snapshot_chunk_t  chunk;
+    snapshot_t        snap;
+    int               expected;
+    int               chunks = 0;
+
+    expected = device_state_supported();
+    if (expected < 0)
+        return 0;
+    expected += (sizeof(snapshot_sections) / sizeof(snapshot_sections[0])) - 1;
+
+    memset(&snap, 0x00, sizeof(snap));
+    snap.fp = plat_fopen(fn, "rb");
+    if (snap.fp == NULL)
+        return 0;
+
+    if ((fread(&header, 1, sizeof(header), snap.fp) != sizeof(header)) ||
+        memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) || (header.version != SNAPSHOT_VERSION)) {
+        snapshot_log("Snapshot: %s is not a valid save state\n", fn);
+        fclose(snap.fp);
+        return 0;
+    }
+
+    header.machine[SNAPSHOT_NAME_LEN - 1] = '\0';
+    header.cpu[SNAPSHOT_NAME_LEN - 1]     = '\0';
+    if (strcmp(header.machine, machine_get_internal_name()) || strcmp(header.cpu, cpu_s->name) ||
+        (header.mem_size != mem_size)) {
+        snapshot_log("Snapshot: %s was made with a different configuration\n", fn);
+        fclose(snap.fp);
+        return 0;
+    }
+
+    /* Check every chunk against the current owners before touching the machine,
+       so that a save state that does not match is rejected as a whole. */
+    while (fread(&chunk, 1, sizeof(chunk), snap.fp) == sizeof(chunk)) {
+        chunk.name[SNAPSHOT_NAME_LEN - 1] = '\0';
+
+        if (snapshot_check_chunk(&chunk) <= 0) {
+            snapshot_log("Snapshot: chunk %s.%i of %s does not match this machine\n", chunk.name, chunk.index, fn);
+            fclose(snap.fp);
+            return 0;
+        }
+
+        chunks++;
+        fseeko64(snap.fp, (int64_t) chunk.size, SEEK_CUR);
+    }
+
+    if (chunks != expected) {
+        snapshot_log("Snapshot: %s does not cover all of this machine\n", fn);
+        fclose(snap.fp);
+        return 0;
+    }
+
+    /* Start from a freshly initialized machine. */
+    pc_reset_hard_close();
+    pc_reset_hard_init();
+
+    fseeko64(snap.fp, sizeof(header), SEEK_SET);
+    while (fread(&chunk, 1, sizeof(chunk), snap.fp) == sizeof(chunk)) {
+        chunk.name[SNAPSHOT_NAME_LEN - 1] = '\0';
+
+        snap.chunk_start = ftello64(snap.fp);
+        snap.chunk_size  = chunk.size;
+        snap.chunk_pos   = 0;
+
+        if (chunk.name[0] == '@') {
+            for (const snapshot_section_t *sect = snapshot_sections; sect->name != NULL; sect++) {
+                if (!strcmp(sect->name, chunk.name)) {
+                    sect->load(&snap);
+                    break;
+                }
+            }
+        } else if (device_load_state(chunk.name, chunk.index, chunk.version, chunk.size, &snap) <= 0)
+            snap.error = 1;
+
+        if (snap.chunk_pos != chunk.size)
+            snap.error = 1;
+
+        fseeko64(snap.fp, snap.chunk_start + chunk.size, SEEK_SET);
+    }
+
+    fclose(snap.fp);
+
+    /* Do not leave a half restored machine running. */
+    if (snap.error) {
+        snapshot_log("Snapshot: loading %s failed, resetting\n", fn);
+        pc_reset_hard_close();
+        pc_reset_hard_init();
+        return 0;
+    }
+
+    snapshot_log("Snapshot: loaded from %s\n", fn);
+
+    return 1;
+}
+
+void
+snapshot_request(int op, const char *fn)
+{
+    /* Drop requests made while another one is still pending. */
+    if (ATOMIC_LOAD(snapshot_pending) != SNAPSHOT_NONE)
+        return;
+
+    snprintf(snapshot_pending_fn, sizeof(snapshot_pending_fn), "%s", fn);
+    ATOMIC_STORE(snapshot_pending, op);
+}
+
+void
+snapshot_process(void)
+{
+    int op = ATOMIC_LOAD(snapshot_pending);
+
+    if (op == SNAPSHOT_NONE)
+        return;
+
+    if ((op == SNAPSHOT_SAVE) ? !snapshot_save(snapshot_pending_fn) : !snapshot_load(snapshot_pending_fn))
+        pclog("Snapshot: unable to %s %s\n", (op == SNAPSHOT_SAVE) ? "save" : "load", snapshot_pending_fn);
+
+    ATOMIC_STORE(snapshot_pending, SNAPSHOT_NONE);
+}
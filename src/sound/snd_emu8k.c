@@ -16,6 +16,7 @@
 #include <86box/rom.h>
 #include <86box/sound.h>
 #include <86box/snd_emu8k.h>
+#include <86box/snd_synth_thread.h>
 #include <86box/timer.h>
 #include <86box/plat_unused.h>
 
@@ -395,12 +396,26 @@ EMU8K_WRITE(emu8k_t *emu8k, uint32_t addr, uint16_t val)
     emu8k->ram[addr - EMU8K_RAM_MEM_START] = val;
 }
 
+static void emu8k_update(emu8k_t *emu8k);
+
 uint16_t
 emu8k_inw(uint16_t addr, void *priv)
 {
     emu8k_t *emu8k = (emu8k_t *) priv;
     uint16_t ret   = 0xffff;
 
+    if (emu8k->synth) {
+        /* The sample counter and the pointer are kept on this thread, anything
+           else needs the synthesis thread to have applied the queued writes. */
+        if (((addr & 0xF02) == 0xA02) && ((emu8k->synth_ptr & 0xff) == ((1 << 5) | 27)))
+            return emu8k->wc;
+        if ((addr & 0xF02) == 0xE02) {
+            random_helper = (random_helper + 1) & 0x1F;
+            return ((0x80 | random_helper) << 8) | (emu8k->synth_ptr & 0xff);
+        }
+        synth_thread_sync(emu8k->synth);
+    }
+
 #ifdef EMU8K_DEBUG_REGISTERS
     if (addr == 0xE22) {
         emu8k_log("EMU8K READ POINTER: %d\n",
@@ -788,15 +803,12 @@ emu8k_inw(uint16_t addr, void *priv)
     return 0xffff;
 }
 
-void
-emu8k_outw(uint16_t addr, uint16_t val, void *priv)
+/* Also called on the synthesis thread, to replay the queued writes. */
+static void
+emu8k_write(void *priv, uint16_t addr, uint16_t val)
 {
     emu8k_t *emu8k = (emu8k_t *) priv;
 
-    /*TODO: I would like to not call this here, but i found it was needed or else cubic player would not finish opening (take a looot more of time than usual).
-     * Basically, being here means that the audio is generated in the emulation thread, instead of the audio thread.*/
-    emu8k_update(emu8k);
-
 #ifdef EMU8K_DEBUG_REGISTERS
     if (addr == 0xE22) {
         // emu8k_log("EMU8K WRITE POINTER: %d\n", val);
@@ -1529,6 +1541,39 @@ emu8k_outw(uint16_t addr, uint16_t val, void *priv)
               emu8k->cur_reg, emu8k->cur_voice, val);
 }
 
+/* Advance the sample counter when the chip is on the synthesis thread. */
+static void
+emu8k_synth_clock(emu8k_t *emu8k)
+{
+    const int pos = MIN(wavetable_pos_global, WTBUFLEN);
+
+    if (emu8k->pos >= pos)
+        return;
+
+    emu8k->wc += pos - emu8k->pos;
+    emu8k->pos = pos;
+}
+
+void
+emu8k_outw(uint16_t addr, uint16_t val, void *priv)
+{
+    emu8k_t *emu8k = (emu8k_t *) priv;
+
+    if (emu8k->synth) {
+        emu8k_synth_clock(emu8k);
+        if ((addr & 0xF02) == 0xE02)
+            emu8k->synth_ptr = val;
+        synth_thread_write(emu8k->synth, emu8k->pos, addr, val);
+        return;
+    }
+
+    /*TODO: I would like to not call this here, but i found it was needed or else cubic player would not finish opening (take a looot more of time than usual).
+     * Basically, being here means that the audio is generated in the emulation thread, instead of the audio thread.*/
+    emu8k_update(emu8k);
+
+    emu8k_write(emu8k, addr, val);
+}
+
 uint8_t
 emu8k_inb(uint16_t addr, void *priv)
 {
@@ -1755,13 +1800,10 @@ int32_t old_pitch[32] = { 0 };
 int32_t old_cut[32]   = { 0 };
 int32_t old_vol[32]   = { 0 };
 #endif
-void
-emu8k_update(emu8k_t *emu8k)
+/* Generate num_samples into out, with the effect sends starting at start. */
+static void
+emu8k_generate(emu8k_t *emu8k, int32_t *out, int start, int num_samples)
 {
-    if (emu8k->pos >= wavetable_pos_global)
-        return;
-
-    const int      num_samples = wavetable_pos_global - emu8k->pos;
     int32_t       *buf;
     emu8k_voice_t *emu_voice;
     int            pos;
@@ -1770,12 +1812,12 @@ emu8k_update(emu8k_t *emu8k)
     /* Voices section  */
     for (uint8_t c = 0; c < 32; c++) {
         emu_voice = &emu8k->voice[c];
-        buf       = &emu8k->buffer[emu8k->pos * 2];
+        buf       = out;
 
         if (emu_voice->env_engine_on || emu_voice->cvcf_curr_volume)
             num_active++;
 
-        for (pos = emu8k->pos; pos < wavetable_pos_global; pos++) {
+        for (pos = start; pos < (start + num_samples); pos++) {
             int32_t dat;
 
             if (emu_voice->cvcf_curr_volume) {
@@ -2117,11 +2159,21 @@ emu8k_update(emu8k_t *emu8k)
 
     /* Only run reverb/chorus/EQ when at least one voice was active. */
     if (num_active > 0) {
-        buf = &emu8k->buffer[emu8k->pos * 2];
-        emu8k_work_reverb(&emu8k->reverb_in_buffer[emu8k->pos], buf, &emu8k->reverb_engine, num_samples);
-        emu8k_work_chorus(&emu8k->chorus_in_buffer[emu8k->pos], buf, &emu8k->chorus_engine, num_samples);
-        emu8k_work_eq(buf, num_samples);
+        emu8k_work_reverb(&emu8k->reverb_in_buffer[start], out, &emu8k->reverb_engine, num_samples);
+        emu8k_work_chorus(&emu8k->chorus_in_buffer[start], out, &emu8k->chorus_engine, num_samples);
+        emu8k_work_eq(out, num_samples);
     }
+}
+
+static void
+emu8k_update(emu8k_t *emu8k)
+{
+    if (emu8k->pos >= wavetable_pos_global)
+        return;
+
+    const int num_samples = wavetable_pos_global - emu8k->pos;
+
+    emu8k_generate(emu8k, &emu8k->buffer[emu8k->pos * 2], emu8k->pos, num_samples);
 
     /* Update EMU clock. */
     emu8k->wc += num_samples;
@@ -2129,9 +2181,41 @@ emu8k_update(emu8k_t *emu8k)
     emu8k->pos = wavetable_pos_global;
 }
 
+/* Called on the synthesis thread, the buffer and the effect sends start out clear. */
+static void
+emu8k_synth_generate(void *priv, int32_t *buf, int num)
+{
+    emu8k_t *emu8k = (emu8k_t *) priv;
+
+    memset(buf, 0, num * 2 * sizeof(int32_t));
+    memset(emu8k->chorus_in_buffer, 0, num * sizeof(int32_t));
+    memset(emu8k->reverb_in_buffer, 0, num * sizeof(int32_t));
+
+    emu8k_generate(emu8k, buf, 0, num);
+}
+
+int32_t *
+emu8k_get_buffer(emu8k_t *emu8k)
+{
+    if (emu8k->synth) {
+        emu8k_synth_clock(emu8k);
+        return synth_thread_get_buffer(emu8k->synth);
+    }
+
+    emu8k_update(emu8k);
+
+    return emu8k->buffer;
+}
+
 void
 emu8k_reset_buffer(emu8k_t *emu8k)
 {
+    if (emu8k->synth) {
+        synth_thread_flush(emu8k->synth, emu8k->pos);
+        emu8k->pos = 0;
+        return;
+    }
+
     emu8k->pos = 0;
     memset(emu8k->buffer, 0, sizeof(emu8k->buffer));
     memset(emu8k->chorus_in_buffer, 0, sizeof(emu8k->chorus_in_buffer));
@@ -2377,11 +2461,16 @@ emu8k_init(emu8k_t *emu8k, uint16_t emu_addr, int onboard_ram)
     emu8k->hwcf2 = 0x20;
     /* Initial state is muted. 0x04 is unmuted. */
     emu8k->hwcf3 = 0x00;
+
+    if (fm_thread)
+        emu8k->synth = synth_thread_create("emu8k-synth", emu8k_write, emu8k_synth_generate, emu8k, WTBUFLEN);
 }
 
 void
 emu8k_close(emu8k_t *emu8k)
 {
+    synth_thread_close(emu8k->synth);
+
     if (emu8k->rom)
         free(emu8k->rom);
     if (emu8k->ram)
@@ -0,0 +1,319 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Vectorized mixing kernels for the sound core.
+ *
+ *          The implementation is picked once at run time like the SVGA
+ *          pixel converters: AVX2 if the host supports it, otherwise
+ *          SSE2 on x86-64 and NEON on ARM64, with a scalar fallback.
+ *          All of them give the same results as the scalar code, which
+ *          matches what sound_poll() and friends used to do inline.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <math.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#if defined(__x86_64__) || defined(__amd64__) || defined(_M_X64)
+#    define SOUND_SIMD_X86
+#    include <immintrin.h>
+#    if defined(__GNUC__) || defined(__clang__)
+#        define SOUND_SIMD_AVX2
+#    endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#    define SOUND_SIMD_NEON
+#    include <arm_neon.h>
+#endif
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/plat.h>
+#include <86box/sound.h>
+
+#define SOUND_SCALE (1.0f / 32768.0f)
+
+static void sound_mix_accum_scalar(int32_t *dst, const int32_t *src, int count, float gain);
+static void sound_mix_to_int16_scalar(int16_t *dst, const int32_t *src, int count);
+static void sound_mix_to_float_scalar(float *dst, const int32_t *src, int count);
+
+static void (*mix_accum)(int32_t *dst, const int32_t *src, int count, float gain) = sound_mix_accum_scalar;
+static void (*mix_to_int16)(int16_t *dst, const int32_t *src, int count)          = sound_mix_to_int16_scalar;
+static void (*mix_to_float)(float *dst, const int32_t *src, int count)            = sound_mix_to_float_scalar;
+
+static const char *sound_simd_name = "scalar";
+
+static void
+sound_mix_accum_scalar(int32_t *dst, const int32_t *src, int count, float gain)
+{
+    for (int c = 0; c < count; c++)
+        dst[c] += (int32_t) lrintf((float) src[c] * gain);
+}
+
+static void
+sound_mix_to_int16_scalar(int16_t *dst, const int32_t *src, int count)
+{
+    for (int c = 0; c < count; c++) {
+        if (src[c] > 32767)
+            dst[c] = 32767;
+        else if (src[c] < -32768)
+            dst[c] = -32768;
+        else
+            dst[c] = (int16_t) src[c];
+    }
+}
+
+static void
+sound_mix_to_float_scalar(float *dst, const int32_t *src, int count)
+{
+    /* Scaling by a power of two is exact, so this is the same as dividing. */
+    for (int c = 0; c < count; c++)
+        dst[c] = (float) src[c] * SOUND_SCALE;
+}
+
+#ifdef SOUND_SIMD_X86
+static void
+sound_mix_accum_sse2(int32_t *dst, const int32_t *src, int count, float gain)
+{
+    const __m128 g = _mm_set1_ps(gain);
+    int          c = 0;
+
+    for (; (c + 4) <= count; c += 4) {
+        __m128i v = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) &src[c])), g));
+
+        _mm_storeu_si128((__m128i *) &dst[c], _mm_add_epi32(_mm_loadu_si128((const __m128i *) &dst[c]), v));
+    }
+
+    sound_mix_accum_scalar(&dst[c], &src[c], count - c, gain);
+}
+
+static void
+sound_mix_to_int16_sse2(int16_t *dst, const int32_t *src, int count)
+{
+    int c = 0;
+
+    for (; (c + 8) <= count; c += 8) {
+        __m128i lo = _mm_loadu_si128((const __m128i *) &src[c]);
+        __m128i hi = _mm_loadu_si128((const __m128i *) &src[c + 4]);
+
+        _mm_storeu_si128((__m128i *) &dst[c], _mm_packs_epi32(lo, hi));
+    }
+
+    sound_mix_to_int16_scalar(&dst[c], &src[c], count - c);
+}
+
+static void
+sound_mix_to_float_sse2(float *dst, const int32_t *src, int count)
+{
+    const __m128 scale = _mm_set1_ps(SOUND_SCALE);
+    int          c     = 0;
+
+    for (; (c + 4) <= count; c += 4)
+        _mm_storeu_ps(&dst[c], _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) &src[c])), scale));
+
+    sound_mix_to_float_scalar(&dst[c], &src[c], count - c);
+}
+#endif
+
+#ifdef SOUND_SIMD_AVX2
+__attribute__((target("avx2"))) static void
+sound_mix_accum_avx2(int32_t *dst, const int32_t *src, int count, float gain)
+{
+    const __m256 g = _mm256_set1_ps(gain);
+    int          c = 0;
+
+    for (; (c + 8) <= count; c += 8) {
+        __m256i v = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *) &src[c])), g));
+
+        _mm256_storeu_si256((__m256i *) &dst[c], _mm256_add_epi32(_mm256_loadu_si256((const __m256i *) &dst[c]), v));
+    }
+
+    sound_mix_accum_sse2(&dst[c], &src[c], count - c, gain);
+}
+
+__attribute__((target("avx2"))) static void
+sound_mix_to_int16_avx2(int16_t *dst, const int32_t *src, int count)
+{
+    int c = 0;
+
+    for (; (c + 16) <= count; c += 16) {
+        __m256i lo = _mm256_loadu_si256((const __m256i *) &src[c]);
+        __m256i hi = _mm256_loadu_si256((const __m256i *) &src[c + 8]);
+
+        /* The pack works within 128-bit lanes, so put the quarters back in order. */
+        _mm256_storeu_si256((__m256i *) &dst[c], _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8));
+    }
+
+    sound_mix_to_int16_sse2(&dst[c], &src[c], count - c);
+}
+
+__attribute__((target("avx2"))) static void
+sound_mix_to_float_avx2(float *dst, const int32_t *src, int count)
+{
+    const __m256 scale = _mm256_set1_ps(SOUND_SCALE);
+    int          c     = 0;
+
+    for (; (c + 8) <= count; c += 8)
+        _mm256_storeu_ps(&dst[c], _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i *) &src[c])), scale));
+
+    sound_mix_to_float_sse2(&dst[c], &src[c], count - c);
+}
+#endif
+
+#ifdef SOUND_SIMD_NEON
+static void
+sound_mix_accum_neon(int32_t *dst, const int32_t *src, int count, float gain)
+{
+    int c = 0;
+
+    for (; (c + 4) <= count; c += 4) {
+        int32x4_t v = vcvtnq_s32_f32(vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(&src[c])), gain));
+
+        vst1q_s32(&dst[c], vaddq_s32(vld1q_s32(&dst[c]), v));
+    }
+
+    sound_mix_accum_scalar(&dst[c], &src[c], count - c, gain);
+}
+
+static void
+sound_mix_to_int16_neon(int16_t *dst, const int32_t *src, int count)
+{
+    int c = 0;
+
+    for (; (c + 8) <= count; c += 8)
+        vst1q_s16(&dst[c], vcombine_s16(vqmovn_s32(vld1q_s32(&src[c])), vqmovn_s32(vld1q_s32(&src[c + 4]))));
+
+    sound_mix_to_int16_scalar(&dst[c], &src[c], count - c);
+}
+
+static void
+sound_mix_to_float_neon(float *dst, const int32_t *src, int count)
+{
+    int c = 0;
+
+    for (; (c + 4) <= count; c += 4)
+        vst1q_f32(&dst[c], vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(&src[c])), SOUND_SCALE));
+
+    sound_mix_to_float_scalar(&dst[c], &src[c], count - c);
+}
+#endif
+
+void
+sound_mix_simd_init(void)
+{
+    static int inited = 0;
+
+    if (inited)
+        return;
+    inited = 1;
+
+#if defined(SOUND_SIMD_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        mix_accum       = sound_mix_accum_avx2;
+        mix_to_int16    = sound_mix_to_int16_avx2;
+        mix_to_float    = sound_mix_to_float_avx2;
+        sound_simd_name = "AVX2";
+    } else
+#endif
+    {
+#if defined(SOUND_SIMD_X86)
+        mix_accum       = sound_mix_accum_sse2;
+        mix_to_int16    = sound_mix_to_int16_sse2;
+        mix_to_float    = sound_mix_to_float_sse2;
+        sound_simd_name = "SSE2";
+#elif defined(SOUND_SIMD_NEON)
+        mix_accum       = sound_mix_accum_neon;
+        mix_to_int16    = sound_mix_to_int16_neon;
+        mix_to_float    = sound_mix_to_float_neon;
+        sound_simd_name = "NEON";
+#endif
+    }
+
+    pclog("Sound: Using %s mixing kernels\n", sound_simd_name);
+}
+
+/* Add count samples of src scaled by gain to dst. */
+void
+sound_mix_accum(int32_t *dst, const int32_t *src, int count, float gain)
+{
+    mix_accum(dst, src, count, gain);
+}
+
+/* Saturate count mixed samples to 16 bits. */
+void
+sound_mix_to_int16(int16_t *dst, const int32_t *src, int count)
+{
+    mix_to_int16(dst, src, count);
+}
+
+/* Convert count mixed samples to floats in the -1.0 to 1.0 range. */
+void
+sound_mix_to_float(float *dst, const int32_t *src, int count)
+{
+    mix_to_float(dst, src, count);
+}
+
+/*
+ * Time mixing a 50 Hz buffer of the given number of sources, half of them
+ * at unity gain, and converting it to both output formats. Returns the
+ * average in nanoseconds.
+ */
+double
+sound_mix_bench(int sources)
+{
+    const int count = SOUNDBUFLEN * 2;
+    int32_t  *src   = calloc((size_t) count * sources, sizeof(int32_t));
+    int32_t  *mix   = calloc(count, sizeof(int32_t));
+    int16_t  *out16 = calloc(count, sizeof(int16_t));
+    float    *outf  = calloc(count, sizeof(float));
+    uint32_t  seed  = 1;
+    uint32_t  start;
+    uint32_t  elapsed;
+    int       rounds = 0;
+
+    sound_mix_simd_init();
+
+    for (int c = 0; c < (count * sources); c++) {
+        seed   = (seed * 1103515245) + 12345;
+        src[c] = (int32_t) (seed >> 16) - 32768;
+    }
+
+    start = plat_get_ticks();
+    do {
+        for (int i = 0; i < 64; i++) {
+            memset(mix, 0x00, count * sizeof(int32_t));
+            for (int s = 0; s < sources; s++) {
+                if (s & 1)
+                    sound_mix_accum(mix, &src[s * count], count, 0.5f);
+                else {
+                    for (int c = 0; c < count; c++)
+                        mix[c] += src[(s * count) + c];
+                }
+            }
+            sound_mix_to_int16(out16, mix, count);
+            sound_mix_to_float(outf, mix, count);
+        }
+        rounds += 64;
+        elapsed = plat_get_ticks() - start;
+    } while (elapsed < 200);
+
+    free(outf);
+    free(out16);
+    free(mix);
+    free(src);
+
+    return (elapsed * 1000000.0) / rounds;
+}
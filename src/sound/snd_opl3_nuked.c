@@ -53,6 +53,7 @@
 #include <86box/video.h>
 #include <86box/snd_opl.h>
 #include <86box/snd_opl3_nuked.h>
+#include <86box/snd_synth_thread.h>
 
 #if OPL3_WF_TABLE_RUNTIME
 
@@ -1857,22 +1858,50 @@ nuked_opl3_drv_set_do_cycles(void *priv, int8_t do_cycles)
         dev->flags &= ~FLAG_CYCLES;
 }
 
+static void
+nuked_opl3_generate(void *priv, int32_t *buf, int num)
+{
+    nuked_opl3_drv_t *dev = (nuked_opl3_drv_t *) priv;
+
+    if (dev->is_48k)
+        OPL3_GenerateResampledStream(&dev->opl, buf, num);
+    else
+        OPL3_GenerateStream(&dev->opl, buf, num);
+
+    for (int c = 0; c < (num * 2); c++)
+        buf[c] /= 2;
+}
+
+/* Register writes replayed on the synthesis thread. */
+static void
+nuked_opl3_synth_write(void *priv, uint16_t reg, uint16_t val)
+{
+    nuked_opl3_drv_t *dev = (nuked_opl3_drv_t *) priv;
+
+    OPL3_WriteRegBuffered(&dev->opl, reg, (uint8_t) val);
+    if (reg == 0x105)
+        dev->opl.newm = val & 0x01;
+}
+
+static int
+nuked_opl3_drv_pos(const nuked_opl3_drv_t *dev)
+{
+    return dev->is_48k ? sound_pos_global : music_pos_global;
+}
+
 static int32_t *
 nuked_opl3_drv_update(void *priv)
 {
     nuked_opl3_drv_t *dev = (nuked_opl3_drv_t *) priv;
 
+    if (dev->synth)
+        return synth_thread_get_buffer(dev->synth);
+
     if (dev->pos >= music_pos_global)
         return dev->buffer;
 
-    OPL3_GenerateStream(&dev->opl,
-                        &dev->buffer[dev->pos * 2],
-                        music_pos_global - dev->pos);
-
-    for (; dev->pos < music_pos_global; dev->pos++) {
-        dev->buffer[dev->pos * 2] /= 2;
-        dev->buffer[(dev->pos * 2) + 1] /= 2;
-    }
+    nuked_opl3_generate(dev, &dev->buffer[dev->pos * 2], music_pos_global - dev->pos);
+    dev->pos = music_pos_global;
 
     return dev->buffer;
 }
@@ -1882,17 +1911,14 @@ nuked_opl3_drv_update_48k(void *priv)
 {
     nuked_opl3_drv_t *dev = (nuked_opl3_drv_t *) priv;
 
+    if (dev->synth)
+        return synth_thread_get_buffer(dev->synth);
+
     if (dev->pos >= sound_pos_global)
         return dev->buffer;
 
-    OPL3_GenerateResampledStream(&dev->opl,
-                                 &dev->buffer[dev->pos * 2],
-                                 sound_pos_global - dev->pos);
-
-    for (; dev->pos < sound_pos_global; dev->pos++) {
-        dev->buffer[dev->pos * 2] /= 2;
-        dev->buffer[(dev->pos * 2) + 1] /= 2;
-    }
+    nuked_opl3_generate(dev, &dev->buffer[dev->pos * 2], sound_pos_global - dev->pos);
+    dev->pos = sound_pos_global;
 
     return dev->buffer;
 }
@@ -1905,7 +1931,8 @@ nuked_opl3_drv_read(uint16_t port, void *priv)
     if (dev->flags & FLAG_CYCLES)
         cycles -= ((int) (isa_timing * 8));
 
-    dev->update(dev);
+    if (!dev->synth)
+        dev->update(dev);
 
     uint8_t ret = 0xff;
 
@@ -1925,10 +1952,14 @@ nuked_opl3_drv_write(uint16_t port, uint8_t val, void *priv)
 {
     nuked_opl3_drv_t *dev = (nuked_opl3_drv_t *) priv;
 
-    dev->update(dev);
+    if (!dev->synth)
+        dev->update(dev);
 
     if ((port & 0x0001) == 0x0001) {
-        OPL3_WriteRegBuffered(&dev->opl, dev->port, val);
+        if (dev->synth)
+            synth_thread_write(dev->synth, nuked_opl3_drv_pos(dev), dev->port, val);
+        else
+            OPL3_WriteRegBuffered(&dev->opl, dev->port, val);
 
         switch (dev->port) {
             case 0x002: // Timer 1
@@ -1954,14 +1985,21 @@ nuked_opl3_drv_write(uint16_t port, uint8_t val, void *priv)
                 break;
 
             case 0x105:
-                dev->opl.newm = val & 0x01;
+                if (dev->synth)
+                    dev->newm = val & 0x01;
+                else
+                    dev->opl.newm = val & 0x01;
                 break;
 
             default:
                 break;
         }
     } else {
-        dev->port = nuked_opl3_write_addr(&dev->opl, port, val) & 0x01ff;
+        /* The chip belongs to the synthesis thread, decode with our copy of NEW. */
+        if (dev->synth)
+            dev->port = (val | (((port & 0x0002) && ((val == 0x05) || dev->newm)) ? 0x0100 : 0x0000)) & 0x01ff;
+        else
+            dev->port = nuked_opl3_write_addr(&dev->opl, port, val) & 0x01ff;
 
         if (!(dev->flags & FLAG_OPL3))
             dev->port &= 0x00ff;
@@ -1973,6 +2011,9 @@ nuked_opl3_drv_reset_buffer(void *priv)
 {
     nuked_opl3_drv_t *dev = (nuked_opl3_drv_t *) priv;
 
+    if (dev->synth)
+        synth_thread_flush(dev->synth, nuked_opl3_drv_pos(dev));
+
     dev->pos = 0;
 }
 
@@ -1981,6 +2022,8 @@ nuked_opl3_drv_close(void *priv)
 {
     nuked_opl3_drv_t *dev = (nuked_opl3_drv_t *) priv;
 
+    synth_thread_close(dev->synth);
+
     free(dev);
 }
 
@@ -2009,6 +2052,9 @@ nuked_opl3_drv_init(const device_t *info)
     timer_add(&dev->timers[0], nuked_opl3_timer_1, dev, 0);
     timer_add(&dev->timers[1], nuked_opl3_timer_2, dev, 0);
 
+    if (fm_thread)
+        dev->synth = synth_thread_create("opl3-synth", nuked_opl3_synth_write, nuked_opl3_generate, dev, MUSICBUFLEN);
+
     return dev;
 }
 
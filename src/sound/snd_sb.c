@@ -625,14 +625,14 @@ sb_get_wavetable_buffer_goldfinch(int32_t *buffer, const uint16_t len, void *pri
 {
     goldfinch_t *goldfinch = (goldfinch_t *) priv;
 
-    emu8k_update(&goldfinch->emu8k);
+    const int32_t *emu_buf = emu8k_get_buffer(&goldfinch->emu8k);
 
     for (uint16_t c = 0; c < len * 2; c += 2) {
         double out_l = 0.0;
         double out_r = 0.0;
 
-        out_l += ((double) goldfinch->emu8k.buffer[c]);
-        out_r += ((double) goldfinch->emu8k.buffer[c + 1]);
+        out_l += ((double) emu_buf[c]);
+        out_r += ((double) emu_buf[c + 1]);
 
         buffer[c] += (int32_t) out_l;
         buffer[c + 1] += (int32_t) out_r;
@@ -648,14 +648,14 @@ sb_get_wavetable_buffer_sb16_awe32(int32_t *buffer, const uint16_t len, void *pr
     const sb_ct1745_mixer_t *mixer = &sb->mixer_sb16;
     double                   bass_treble;
 
-    emu8k_update(&sb->emu8k);
+    const int32_t *emu_buf = emu8k_get_buffer(&sb->emu8k);
 
     for (uint16_t c = 0; c < len * 2; c += 2) {
         double out_l = 0.0;
         double out_r = 0.0;
 
-        out_l += (((double) sb->emu8k.buffer[c]) * mixer->fm_l);
-        out_r += (((double) sb->emu8k.buffer[c + 1]) * mixer->fm_r);
+        out_l += (((double) emu_buf[c]) * mixer->fm_l);
+        out_r += (((double) emu_buf[c + 1]) * mixer->fm_r);
 
         out_l *= mixer->master_l;
         out_r *= mixer->master_r;
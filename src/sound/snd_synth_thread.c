@@ -0,0 +1,228 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Sound synthesis thread.
+ *
+ *          Lets a sound chip be synthesized away from the emulation
+ *          thread. Register writes are stamped with the sample they
+ *          happened at, and go through a lock-free ring to the thread,
+ *          which generates up to that sample before applying each of
+ *          them, the same as the chip would inline. At the end of each
+ *          buffer the thread renders it while the emulation carries on,
+ *          and the result is handed out when the next buffer ends, so
+ *          the output is identical, only one buffer later.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#define HAVE_STDARG_H
+#include <86box/86box.h>
+#include <86box/plat.h>
+#include <86box/thread.h>
+#include <86box/snd_synth_thread.h>
+
+#define SYNTH_RING_SIZE 8192 /* power of 2 */
+
+typedef struct synth_cmd_t {
+    uint32_t pos;
+    uint16_t reg;
+    uint16_t val;
+    uint8_t  flush;
+} synth_cmd_t;
+
+struct synth_thread_t {
+    synth_write_t    write;
+    synth_generate_t generate;
+    void            *priv;
+    int              max_len;
+
+    synth_cmd_t      ring[SYNTH_RING_SIZE];
+    atomic_uint      head; /* Written by the emulation thread. */
+    atomic_uint      tail; /* Written by the synthesis thread. */
+
+    int32_t         *bufs[2];
+    unsigned int     flushed; /* Buffers ended, emulation thread only. */
+    atomic_uint      done;    /* Buffers rendered. */
+    int              pos;     /* Synthesis thread only. */
+
+    thread_t        *thread;
+    event_t         *work_event;
+    event_t         *done_event;
+    event_t         *idle_event;
+    atomic_int       running;
+};
+
+#ifdef ENABLE_SYNTH_THREAD_LOG
+int synth_thread_do_log = ENABLE_SYNTH_THREAD_LOG;
+
+static void
+synth_thread_log(const char *fmt, ...)
+{
+    va_list ap;
+
+    if (synth_thread_do_log) {
+        va_start(ap, fmt);
+        pclog_ex(fmt, ap);
+        va_end(ap);
+    }
+}
+#else
+#    define synth_thread_log(fmt, ...)
+#endif
+
+static void
+synth_thread_run(void *priv)
+{
+    synth_thread_t *st = (synth_thread_t *) priv;
+    unsigned int    tail;
+    synth_cmd_t    *cmd;
+    int32_t        *buf;
+
+    while (atomic_load(&st->running)) {
+        thread_wait_event(st->work_event, -1);
+        thread_reset_event(st->work_event);
+
+        tail = atomic_load_explicit(&st->tail, memory_order_relaxed);
+        while (tail != atomic_load_explicit(&st->head, memory_order_acquire)) {
+            cmd = &st->ring[tail & (SYNTH_RING_SIZE - 1)];
+            buf = st->bufs[atomic_load_explicit(&st->done, memory_order_relaxed) & 1];
+
+            if ((int) cmd->pos > st->pos) {
+                st->generate(st->priv, &buf[st->pos * 2], cmd->pos - st->pos);
+                st->pos = cmd->pos;
+            }
+
+            if (cmd->flush) {
+                st->pos = 0;
+                atomic_fetch_add_explicit(&st->done, 1, memory_order_release);
+                thread_set_event(st->done_event);
+            } else
+                st->write(st->priv, cmd->reg, cmd->val);
+
+            atomic_store_explicit(&st->tail, ++tail, memory_order_release);
+        }
+
+        thread_set_event(st->idle_event);
+    }
+}
+
+static void
+synth_thread_push(synth_thread_t *st, int pos, uint16_t reg, uint16_t val, int flush)
+{
+    unsigned int head = atomic_load_explicit(&st->head, memory_order_relaxed);
+    synth_cmd_t *cmd;
+
+    /* Only a flood of writes within one buffer gets here. */
+    while ((head - atomic_load_explicit(&st->tail, memory_order_acquire)) >= SYNTH_RING_SIZE) {
+        thread_set_event(st->work_event);
+        plat_delay_ms(1);
+    }
+
+    cmd        = &st->ring[head & (SYNTH_RING_SIZE - 1)];
+    cmd->pos   = MIN(MAX(pos, 0), st->max_len);
+    cmd->reg   = reg;
+    cmd->val   = val;
+    cmd->flush = flush;
+    atomic_store_explicit(&st->head, head + 1, memory_order_release);
+}
+
+void
+synth_thread_write(synth_thread_t *st, int pos, uint16_t reg, uint16_t val)
+{
+    synth_thread_push(st, pos, reg, val, 0);
+}
+
+void
+synth_thread_flush(synth_thread_t *st, int len)
+{
+    synth_thread_push(st, len, 0, 0, 1);
+    st->flushed++;
+
+    thread_set_event(st->work_event);
+}
+
+void
+synth_thread_sync(synth_thread_t *st)
+{
+    while (1) {
+        thread_reset_event(st->idle_event);
+        if (atomic_load_explicit(&st->tail, memory_order_acquire) == atomic_load_explicit(&st->head, memory_order_relaxed))
+            break;
+        thread_set_event(st->work_event);
+        thread_wait_event(st->idle_event, 10);
+    }
+}
+
+int32_t *
+synth_thread_get_buffer(synth_thread_t *st)
+{
+    /* Nothing ended yet, the second buffer is still silent. */
+    if (st->flushed == 0)
+        return st->bufs[1];
+
+    while (1) {
+        thread_reset_event(st->done_event);
+        if (atomic_load_explicit(&st->done, memory_order_acquire) >= st->flushed)
+            break;
+        thread_wait_event(st->done_event, 10);
+    }
+
+    return st->bufs[(st->flushed - 1) & 1];
+}
+
+synth_thread_t *
+synth_thread_create(const char *name, synth_write_t write, synth_generate_t generate, void *priv, int max_len)
+{
+    synth_thread_t *st = (synth_thread_t *) calloc(1, sizeof(synth_thread_t));
+
+    st->write    = write;
+    st->generate = generate;
+    st->priv     = priv;
+    st->max_len  = max_len;
+    st->bufs[0]  = calloc(max_len * 2, sizeof(int32_t));
+    st->bufs[1]  = calloc(max_len * 2, sizeof(int32_t));
+
+    st->work_event = thread_create_event();
+    st->done_event = thread_create_event();
+    st->idle_event = thread_create_event();
+    atomic_store(&st->running, 1);
+    st->thread = thread_create_named(synth_thread_run, st, name);
+
+    synth_thread_log("Synth thread: started %s\n", name);
+
+    return st;
+}
+
+void
+synth_thread_close(synth_thread_t *st)
+{
+    if (st == NULL)
+        return;
+
+    atomic_store(&st->running, 0);
+    thread_set_event(st->work_event);
+    thread_wait(st->thread);
+
+    thread_destroy_event(st->idle_event);
+    thread_destroy_event(st->done_event);
+    thread_destroy_event(st->work_event);
+
+    free(st->bufs[1]);
+    free(st->bufs[0]);
+    free(st);
+}
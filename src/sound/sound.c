@@ -44,6 +44,7 @@ typedef struct {
 typedef struct {
     void (*get_buffer)(int32_t *buffer, uint16_t len, void *priv);
     void *priv;
+    float gain;
 } sound_handler_t;
 
 int  sound_card_current[SOUND_CARD_MAX] = { 0, 0, 0, 0 };
@@ -89,6 +90,8 @@ static int16_t   *outbuffer_y_ex_int16;
 static int32_t   *outbuffer_w;
 static float     *outbuffer_w_ex;
 static int16_t   *outbuffer_w_ex_int16;
+static int32_t   *mix_scratch;
+static int        mix_scratch_len;
 static uint8_t    sound_handlers_num;
 static uint8_t    music_handlers_num;
 static uint8_t    ym2151_handlers_num;
@@ -576,6 +579,8 @@ sound_init(void)
     outbuffer_w = calloc(WTBUFLEN * 2, sizeof(int32_t));
     memset(outbuffer_w, 0x00, WTBUFLEN * 2 * sizeof(int32_t));
 
+    sound_mix_simd_init();
+
     for (uint16_t i = 0; i < 256; i++) {
         double di = (double) i;
 
@@ -622,6 +627,7 @@ sound_add_handler(void (*get_buffer)(int32_t *buffer, uint16_t len, void *priv),
 
     sound_handlers[sound_handlers_num].get_buffer = get_buffer;
     sound_handlers[sound_handlers_num].priv       = priv;
+    sound_handlers[sound_handlers_num].gain       = 1.0f;
     sound_handlers_num++;
 }
 
@@ -635,6 +641,7 @@ music_add_handler(void (*get_buffer)(int32_t *buffer, uint16_t len, void *priv),
 
     music_handlers[music_handlers_num].get_buffer = get_buffer;
     music_handlers[music_handlers_num].priv       = priv;
+    music_handlers[music_handlers_num].gain       = 1.0f;
     music_handlers_num++;
 }
 
@@ -648,6 +655,7 @@ ym2151_add_handler(void (*get_buffer)(int32_t *buffer, uint16_t len, void *priv)
 
     ym2151_handlers[ym2151_handlers_num].get_buffer = get_buffer;
     ym2151_handlers[ym2151_handlers_num].priv       = priv;
+    ym2151_handlers[ym2151_handlers_num].gain       = 1.0f;
     ym2151_handlers_num++;
 }
 
@@ -661,9 +669,25 @@ wavetable_add_handler(void (*get_buffer)(int32_t *buffer, uint16_t len, void *pr
 
     wavetable_handlers[wavetable_handlers_num].get_buffer = get_buffer;
     wavetable_handlers[wavetable_handlers_num].priv       = priv;
+    wavetable_handlers[wavetable_handlers_num].gain       = 1.0f;
     wavetable_handlers_num++;
 }
 
+/* Scale every source registered by a device, 1.0 leaving it untouched. */
+void
+sound_set_handler_gain(void *priv, float gain)
+{
+    sound_handler_t *tables[4] = { sound_handlers, music_handlers, ym2151_handlers, wavetable_handlers };
+    const int        nums[4]   = { sound_handlers_num, music_handlers_num, ym2151_handlers_num, wavetable_handlers_num };
+
+    for (uint8_t t = 0; t < 4; t++) {
+        for (int c = 0; c < nums[t]; c++) {
+            if (tables[t][c].priv == priv)
+                tables[t][c].gain = gain;
+        }
+    }
+}
+
 void
 sound_set_cd_audio_filter(void (*filter)(int channel, double *buffer, void *priv), void *priv)
 {
@@ -707,6 +731,45 @@ midi_poll_ex(UNUSED(void *priv))
     midi_poll();
 }
 
+/*
+ * Mix a buffer of len stereo samples from the given handlers, and convert
+ * it to the output format. Handlers at unity gain add into the mix by
+ * themselves, the others render on their own first, and are scaled while
+ * being added in.
+ */
+static void
+sound_mix(const sound_handler_t *handlers, int handler_count, int32_t *mix, int len, float *out_float, int16_t *out_int16)
+{
+    const int count = len * 2;
+
+    memset(mix, 0x00, count * sizeof(int32_t));
+
+    for (int c = 0; c < handler_count; c++) {
+        if (handlers[c].get_buffer == NULL)
+            continue;
+
+        if (handlers[c].gain == 1.0f) {
+            handlers[c].get_buffer(mix, len, handlers[c].priv);
+            continue;
+        }
+
+        if (mix_scratch_len < count) {
+            free(mix_scratch);
+            mix_scratch     = calloc(count, sizeof(int32_t));
+            mix_scratch_len = count;
+        }
+
+        memset(mix_scratch, 0x00, count * sizeof(int32_t));
+        handlers[c].get_buffer(mix_scratch, len, handlers[c].priv);
+        sound_mix_accum(mix, mix_scratch, count, handlers[c].gain);
+    }
+
+    if (sound_is_float)
+        sound_mix_to_float(out_float, mix, count);
+    else
+        sound_mix_to_int16(out_int16, mix, count);
+}
+
 void
 sound_poll(UNUSED(void *priv))
 {
@@ -716,24 +779,7 @@ sound_poll(UNUSED(void *priv))
 
     sound_pos_global++;
     if (sound_pos_global == sound_buf_len) {
-        memset(outbuffer, 0x00, sound_buf_len * 2 * sizeof(int32_t));
-
-        for (uint8_t c = 0; c < handler_count; c++)
-            if (sound_handlers[c].get_buffer != NULL)
-                sound_handlers[c].get_buffer(outbuffer, sound_buf_len, sound_handlers[c].priv);
-
-        for (uint32_t c = 0; c < (uint32_t) (sound_buf_len * 2); c++) {
-            if (sound_is_float)
-                outbuffer_ex[c] = ((float) outbuffer[c]) / (float) 32768.0;
-            else {
-                if (outbuffer[c] > 32767)
-                    outbuffer[c] = 32767;
-                if (outbuffer[c] < -32768)
-                    outbuffer[c] = -32768;
-
-                outbuffer_ex_int16[c] = (int16_t) outbuffer[c];
-            }
-        }
+        sound_mix(sound_handlers, handler_count, outbuffer, sound_buf_len, outbuffer_ex, outbuffer_ex_int16);
 
         if (sound_is_float)
             givealbuffer(outbuffer_ex);
@@ -760,24 +806,7 @@ music_poll(UNUSED(void *priv))
 
     music_pos_global++;
     if (music_pos_global == MUSICBUFLEN) {
-        memset(outbuffer_m, 0x00, MUSICBUFLEN * 2 * sizeof(int32_t));
-
-        for (uint8_t c = 0; c < handler_count; c++)
-            if (music_handlers[c].get_buffer != NULL)
-                music_handlers[c].get_buffer(outbuffer_m, MUSICBUFLEN, music_handlers[c].priv);
-
-        for (uint32_t c = 0; c < MUSICBUFLEN * 2; c++) {
-            if (sound_is_float)
-                outbuffer_m_ex[c] = ((float) outbuffer_m[c]) / (float) 32768.0;
-            else {
-                if (outbuffer_m[c] > 32767)
-                    outbuffer_m[c] = 32767;
-                if (outbuffer_m[c] < -32768)
-                    outbuffer_m[c] = -32768;
-
-                outbuffer_m_ex_int16[c] = (int16_t) outbuffer_m[c];
-            }
-        }
+        sound_mix(music_handlers, handler_count, outbuffer_m, MUSICBUFLEN, outbuffer_m_ex, outbuffer_m_ex_int16);
 
         if (sound_is_float)
             givealbuffer_music(outbuffer_m_ex);
@@ -797,24 +826,7 @@ ym2151_poll(UNUSED(void *priv))
 
     ym2151_pos_global++;
     if (ym2151_pos_global == YM2151BUFLEN) {
-        memset(outbuffer_y, 0x00, YM2151BUFLEN * 2 * sizeof(int32_t));
-
-        for (uint8_t c = 0; c < handler_count; c++)
-            if (ym2151_handlers[c].get_buffer != NULL)
-                ym2151_handlers[c].get_buffer(outbuffer_y, YM2151BUFLEN, ym2151_handlers[c].priv);
-
-        for (uint32_t c = 0; c < YM2151BUFLEN * 2; c++) {
-            if (sound_is_float)
-                outbuffer_y_ex[c] = ((float) outbuffer_y[c]) / (float) 32768.0;
-            else {
-                if (outbuffer_y[c] > 32767)
-                    outbuffer_y[c] = 32767;
-                if (outbuffer_y[c] < -32768)
-                    outbuffer_y[c] = -32768;
-
-                outbuffer_y_ex_int16[c] = (int16_t) outbuffer_y[c];
-            }
-        }
+        sound_mix(ym2151_handlers, handler_count, outbuffer_y, YM2151BUFLEN, outbuffer_y_ex, outbuffer_y_ex_int16);
 
         if (sound_is_float)
             givealbuffer_ym2151(outbuffer_y_ex);
@@ -834,24 +846,7 @@ wavetable_poll(UNUSED(void *priv))
 
     wavetable_pos_global++;
     if (wavetable_pos_global == WTBUFLEN) {
-        memset(outbuffer_w, 0x00, WTBUFLEN * 2 * sizeof(int32_t));
-
-        for (uint8_t c = 0; c < handler_count; c++)
-            if (wavetable_handlers[c].get_buffer != NULL)
-                wavetable_handlers[c].get_buffer(outbuffer_w, WTBUFLEN, wavetable_handlers[c].priv);
-
-        for (uint32_t c = 0; c < WTBUFLEN * 2; c++) {
-            if (sound_is_float)
-                outbuffer_w_ex[c] = ((float) outbuffer_w[c]) / (float) 32768.0;
-            else {
-                if (outbuffer_w[c] > 32767)
-                    outbuffer_w[c] = 32767;
-                if (outbuffer_w[c] < -32768)
-                    outbuffer_w[c] = -32768;
-
-                outbuffer_w_ex_int16[c] = (int16_t) outbuffer_w[c];
-            }
-        }
+        sound_mix(wavetable_handlers, handler_count, outbuffer_w, WTBUFLEN, outbuffer_w_ex, outbuffer_w_ex_int16);
 
         if (sound_is_float)
             givealbuffer_wt(outbuffer_w_ex);
@@ -1,10 +1,12 @@
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
 #include <86box/86box.h>
 #include "cpu.h"
 #include <86box/timer.h>
+#include <86box/plat.h>
 #include <86box/nv/vid_nv_rivatimer.h>
 
 uint64_t TIMER_USEC;
@@ -14,16 +16,155 @@ uint64_t timer_target;
   the head.*/
 pc_timer_t *timer_head = NULL;
 
+/*Alternatively, enabled timers are stored in a 4-ary min-heap, with the first
+  timer to expire at index 0. Each timer keeps its own index so that it can be
+  removed without searching.*/
+static pc_timer_t **timer_heap      = NULL;
+static uint32_t     timer_heap_cnt  = 0;
+static uint32_t     timer_heap_size = 0;
+static uint32_t     timer_heap_seq  = 0;
+
+/* Backend in use, latched from timer_sched by timer_init(). */
+static int timer_sched_cur = TIMER_SCHED_LIST;
+
 /* Are we initialized? */
 int timer_inited = 0;
 
+uint64_t timer_callbacks = 0;
+
 static void timer_advance_ex(pc_timer_t *timer, int start);
 
+#define TIMER_HEAP_ARITY 4
+
+/*True if timer a must be processed before timer b. Ties are broken so that
+  the most recently enabled timer goes first, matching the list backend.*/
+static __inline int
+timer_heap_before(pc_timer_t *a, pc_timer_t *b)
+{
+    int64_t diff = (int64_t) (a->ts_integer - b->ts_integer);
+
+    if (diff)
+        return diff < 0;
+
+    return (int32_t) (a->heap_seq - b->heap_seq) > 0;
+}
+
+static __inline void
+timer_heap_set(uint32_t idx, pc_timer_t *timer)
+{
+    timer_heap[idx] = timer;
+    timer->heap_idx = idx;
+}
+
+static void
+timer_heap_sift_up(uint32_t idx)
+{
+    pc_timer_t *timer = timer_heap[idx];
+
+    while (idx > 0) {
+        uint32_t parent = (idx - 1) / TIMER_HEAP_ARITY;
+
+        if (!timer_heap_before(timer, timer_heap[parent]))
+            break;
+
+        timer_heap_set(idx, timer_heap[parent]);
+        idx = parent;
+    }
+
+    timer_heap_set(idx, timer);
+}
+
+static void
+timer_heap_sift_down(uint32_t idx)
+{
+    pc_timer_t *timer = timer_heap[idx];
+
+    while (1) {
+        uint32_t first = (idx * TIMER_HEAP_ARITY) + 1;
+        uint32_t last  = first + TIMER_HEAP_ARITY;
+        uint32_t best  = idx;
+        pc_timer_t *best_timer = timer;
+
+        if (first >= timer_heap_cnt)
+            break;
+        if (last > timer_heap_cnt)
+            last = timer_heap_cnt;
+
+        for (uint32_t c = first; c < last; c++) {
+            if (timer_heap_before(timer_heap[c], best_timer)) {
+                best       = c;
+                best_timer = timer_heap[c];
+            }
+        }
+
+        if (best == idx)
+            break;
+
+        timer_heap_set(idx, best_timer);
+        idx = best;
+    }
+
+    timer_heap_set(idx, timer);
+}
+
+static __inline int
+timer_heap_contains(pc_timer_t *timer)
+{
+    return (timer->heap_idx < timer_heap_cnt) && (timer_heap[timer->heap_idx] == timer);
+}
+
+static void
+timer_heap_remove(pc_timer_t *timer)
+{
+    uint32_t    idx  = timer->heap_idx;
+    pc_timer_t *last = timer_heap[--timer_heap_cnt];
+
+    timer->heap_idx = 0;
+
+    if (idx == timer_heap_cnt)
+        return;
+
+    timer_heap_set(idx, last);
+    if ((idx > 0) && timer_heap_before(last, timer_heap[(idx - 1) / TIMER_HEAP_ARITY]))
+        timer_heap_sift_up(idx);
+    else
+        timer_heap_sift_down(idx);
+}
+
+static void
+timer_heap_enable(pc_timer_t *timer)
+{
+    if (timer_heap_contains(timer))
+        timer_heap_remove(timer);
+
+    if (timer_heap_cnt == timer_heap_size) {
+        timer_heap_size = timer_heap_size ? (timer_heap_size << 1) : 64;
+        timer_heap      = realloc(timer_heap, timer_heap_size * sizeof(pc_timer_t *));
+        if (timer_heap == NULL)
+            fatal("timer_enable(): Out of memory growing the timer heap\n");
+    }
+
+    timer->flags |= TIMER_ENABLED;
+    timer->heap_seq = timer_heap_seq++;
+
+    timer_heap[timer_heap_cnt] = timer;
+    timer->heap_idx            = timer_heap_cnt++;
+    timer_heap_sift_up(timer->heap_idx);
+
+    if (timer->heap_idx == 0)
+        timer_target = timer->ts_integer;
+}
+
 void
 timer_enable(pc_timer_t *timer)
 {
     pc_timer_t *timer_node = timer_head;
 
+    if (timer_sched_cur == TIMER_SCHED_HEAP) {
+        timer_heap_enable(timer);
+        return;
+    }
+
     if (timer->flags & TIMER_ENABLED)
         timer_disable(timer);
 
@@ -80,6 +221,15 @@ timer_disable(pc_timer_t *timer)
     if (!timer_inited || (timer == NULL) || !(timer->flags & TIMER_ENABLED))
         return;
 
+    if (timer_sched_cur == TIMER_SCHED_HEAP) {
+        /* A timer left enabled across timer_close() is no longer in the heap. */
+        if (timer_heap_contains(timer))
+            timer_heap_remove(timer);
+        timer->flags &= ~TIMER_ENABLED;
+        timer->in_callback = 0;
+        return;
+    }
+
     if (!timer->next && !timer->prev && timer != timer_head) {
         uint32_t *p = NULL;
         *p = 5;    /* Crash deliberately. */
@@ -102,7 +252,11 @@ timer_disable(pc_timer_t *timer)
 static void
 timer_remove_head(void)
 {
-    if (timer_head) {
+    if (timer_sched_cur == TIMER_SCHED_HEAP) {
+        pc_timer_t *timer = timer_heap[0];
+        timer_heap_remove(timer);
+        timer->flags &= ~TIMER_ENABLED;
+    } else if (timer_head) {
         pc_timer_t *timer = timer_head;
         timer_head = timer->next;
         timer_head->prev = NULL;
@@ -111,16 +265,25 @@ timer_remove_head(void)
     }
 }
 
+static __inline pc_timer_t *
+timer_get_first(void)
+{
+    if (timer_sched_cur == TIMER_SCHED_HEAP)
+        return timer_heap_cnt ? timer_heap[0] : NULL;
+
+    return timer_head;
+}
+
 void
 timer_process(void)
 {
-    if (!timer_head)
+    if (!timer_get_first())
         return;
 
     while (1) {
-        pc_timer_t *timer = timer_head;
+        pc_timer_t *timer = timer_get_first();
 
-        if (!TIMER_LESS_THAN_VAL(timer, (uint64_t) tsc))
+        if ((timer == NULL) || !TIMER_LESS_THAN_VAL(timer, (uint64_t) tsc))
             break;
 
         timer_remove_head();
@@ -135,12 +298,14 @@ timer_process(void)
                is needed.
              */
             timer->in_callback = 1;
+            timer_callbacks++;
             timer->callback(timer->priv);
             timer->in_callback = 0;
         }
     }
 
-    timer_target = timer_head->ts_integer;
+    if (timer_get_first())
+        timer_target = timer_get_first()->ts_integer;
 }
 
 void
@@ -160,6 +325,10 @@ timer_close(void)
 
     timer_head = NULL;
 
+    /* The heap does not own the timers, so just forget about them. */
+    timer_heap_cnt = 0;
+    timer_heap_seq = 0;
+
     timer_inited = 0;
 }
 
@@ -169,6 +338,9 @@ timer_init(void)
     timer_target = 0ULL;
     tsc          = 0;
 
+    /* The backend can only change while no timers are enabled. */
+    timer_sched_cur = timer_sched;
+
     /* Initialise the CPU-independent timer */
     rivatimer_init();
 
@@ -269,13 +441,25 @@ timer_set_new_tsc(uint64_t new_tsc)
         update_tsc();
 #endif
 
-    if (!timer_head) {
+    if (!timer_get_first()) {
+        tsc = new_tsc;
+        return;
+    }
+
+    timer_target = new_tsc + (int64_t)(timer_get_ts_int(timer_get_first()) - (uint64_t)tsc);
+
+    /* Every timestamp moves by the same amount, so the heap order is kept. */
+    if (timer_sched_cur == TIMER_SCHED_HEAP) {
+        for (uint32_t c = 0; c < timer_heap_cnt; c++) {
+            timer = timer_heap[c];
+            timer->ts_integer = new_tsc + (int64_t)(timer_get_ts_int(timer) - (uint64_t)tsc);
+        }
+
         tsc = new_tsc;
         return;
     }
 
     timer = timer_head;
-    timer_target = new_tsc + (int64_t)(timer_get_ts_int(timer_head) - (uint64_t)tsc);
 
     while (timer) {
         int64_t offset_from_current_tsc = (int64_t)(timer_get_ts_int(timer) - (uint64_t)tsc);
@@ -286,3 +470,83 @@ timer_set_new_tsc(uint64_t new_tsc)
 
     tsc = new_tsc;
 }
+
+typedef struct timer_bench_t {
+    pc_timer_t timer;
+    uint64_t   period;
+} timer_bench_t;
+
+static void
+timer_bench_callback(void *priv)
+{
+    timer_bench_t *dev = (timer_bench_t *) priv;
+
+    timer_advance_u64(&dev->timer, dev->period);
+}
+
+/*
+ * Time count recurring timers with periods of 1 to 1024 us, each re-armed
+ * from its callback, on the given backend. The scheduler state of the
+ * emulated machine is set aside meanwhile. Returns the average time per
+ * expiry in nanoseconds.
+ */
+double
+timer_sched_bench(int sched, int count)
+{
+    pc_timer_t    *old_head      = timer_head;
+    pc_timer_t   **old_heap      = timer_heap;
+    uint32_t       old_heap_cnt  = timer_heap_cnt;
+    uint32_t       old_heap_size = timer_heap_size;
+    uint32_t       old_heap_seq  = timer_heap_seq;
+    int            old_sched     = timer_sched_cur;
+    uint64_t       old_tsc       = tsc;
+    uint64_t       old_target    = timer_target;
+    uint64_t       old_callbacks = timer_callbacks;
+    timer_bench_t *timers        = calloc(count, sizeof(timer_bench_t));
+    uint32_t       seed          = 1;
+    uint32_t       start;
+    uint32_t       elapsed;
+    double         ns;
+
+    timer_head      = NULL;
+    timer_heap      = NULL;
+    timer_heap_cnt  = 0;
+    timer_heap_size = 0;
+    timer_heap_seq  = 0;
+    timer_sched_cur = sched;
+    tsc             = 0;
+
+    for (int c = 0; c < count; c++) {
+        seed             = (seed * 1103515245) + 12345;
+        timers[c].period = (1 + ((seed >> 16) & 1023)) * TIMER_USEC;
+        timer_add(&timers[c].timer, timer_bench_callback, &timers[c], 0);
+        timer_set_delay_u64(&timers[c].timer, timers[c].period);
+    }
+
+    timer_callbacks = 0;
+    start           = plat_get_ticks();
+    do {
+        for (int i = 0; i < 4096; i++) {
+            tsc = timer_target;
+            timer_process();
+        }
+        elapsed = plat_get_ticks() - start;
+    } while (elapsed < 200);
+
+    ns = (elapsed * 1000000.0) / timer_callbacks;
+
+    free(timer_heap);
+    free(timers);
+
+    timer_head      = old_head;
+    timer_heap      = old_heap;
+    timer_heap_cnt  = old_heap_cnt;
+    timer_heap_size = old_heap_size;
+    timer_heap_seq  = old_heap_seq;
+    timer_sched_cur = old_sched;
+    tsc             = old_tsc;
+    timer_target    = old_target;
+    timer_callbacks = old_callbacks;
+
+    return ns;
+}
@@ -40,6 +40,7 @@
 #include <86box/video.h>
 #include <86box/ui.h>
 #include <86box/gdbstub.h>
+#include <86box/bench.h>
 
 #include "sdl_monitor.h"
 #include "sdl_render.h"
@@ -210,6 +211,13 @@ main_thread(UNUSED(void *param))
     // title_update = 1;
     old_time = SDL_GetTicks();
     drawits = frames = 0;
+
+    /* A benchmark runs unpaced, then powers the machine off. */
+    if (bench_seconds) {
+        bench_run();
+        plat_power_off();
+    }
+
     while (!is_quit && cpu_thread_run)
     {
         /* See if it is time to run a frame of code. */
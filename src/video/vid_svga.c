@@ -1375,9 +1375,38 @@ svga_recalctimings(svga_t *svga)
     }
 }
 
+/* Record that a row of the target buffer was redrawn. Consecutive rows are
+   merged into bands, and once all bands are used, the last one is grown.
+   The horizontal extent is filled in by svga_doblit() from the blit area. */
+static void
+svga_dirty_row(svga_t *svga, int row)
+{
+    video_rect_t *band = (svga->dirty_nr > 0) ? &svga->dirty[svga->dirty_nr - 1] : NULL;
+    int           bottom;
+
+    if ((band != NULL) && (row >= band->y) && (row <= (band->y + band->h))) {
+        if (row == (band->y + band->h))
+            band->h++;
+        return;
+    }
+
+    if (svga->dirty_nr == VIDEO_MAX_DIRTY_RECTS) {
+        bottom  = MAX(band->y + band->h, row + 1);
+        band->y = MIN(band->y, row);
+        band->h = bottom - band->y;
+        return;
+    }
+
+    band    = &svga->dirty[svga->dirty_nr++];
+    band->y = row;
+    band->h = 1;
+}
+
 static void
 svga_do_render(svga_t *svga)
 {
+    int deferred = 0;
+
     /* Always render a blank screen and nothing else while in DPMS mode. */
     if (svga->dpms) {
         svga_render_blank(svga);
@@ -1386,7 +1415,14 @@ svga_do_render(svga_t *svga)
 
     if (!svga->override) {
         svga->render_line_offset = svga->start_retrace_latch - svga->crtc[0x4];
-        svga->render(svga);
+        if (svga->render_mt != NULL)
+            deferred = svga_render_mt_line(svga);
+        if (!deferred)
+            svga->render(svga);
+
+        /* The renderers only touch lines that changed, and note when they do. */
+        if (svga->lastline_draw == svga->displine)
+            svga_dirty_row(svga, svga->displine + svga->y_add);
     }
 
     if (svga->overlay_on) {
@@ -1398,16 +1434,20 @@ svga_do_render(svga_t *svga)
     }
 
     if (svga->dac_hwcursor_on) {
-        if (!svga->override && svga->dac_hwcursor_draw)
+        if (!svga->override && svga->dac_hwcursor_draw) {
             svga->dac_hwcursor_draw(svga, (svga->displine + svga->y_add + ((svga->dac_hwcursor_latch.y >= 0) ? 0 : svga->dac_hwcursor_latch.y)) & 2047);
+            svga_dirty_row(svga, (svga->displine + svga->y_add + ((svga->dac_hwcursor_latch.y >= 0) ? 0 : svga->dac_hwcursor_latch.y)) & 2047);
+        }
         svga->dac_hwcursor_on--;
         if (svga->dac_hwcursor_on && svga->interlace)
             svga->dac_hwcursor_on--;
     }
 
     if (svga->hwcursor_on) {
-        if (!svga->override && svga->hwcursor_draw)
+        if (!svga->override && svga->hwcursor_draw) {
             svga->hwcursor_draw(svga, (svga->displine + svga->y_add + ((svga->hwcursor_latch.y >= 0) ? 0 : svga->hwcursor_latch.y)) & 2047);
+            svga_dirty_row(svga, (svga->displine + svga->y_add + ((svga->hwcursor_latch.y >= 0) ? 0 : svga->hwcursor_latch.y)) & 2047);
+        }
 
         svga->hwcursor_on--;
         if (svga->hwcursor_on && svga->interlace)
@@ -1416,8 +1456,10 @@ svga_do_render(svga_t *svga)
 
     if (!svga->override) {
         svga->x_add = svga->left_overscan;
-        svga_render_overscan_left(svga);
-        svga_render_overscan_right(svga);
+        if (!deferred) {
+            svga_render_overscan_left(svga);
+            svga_render_overscan_right(svga);
+        }
         svga->x_add = svga->left_overscan - svga->scrollcache;
     }
 }
@@ -1656,6 +1698,10 @@ svga_poll(void *priv)
 
             wx = x;
 
+            /* Every line of the frame has to be drawn before it is blitted. */
+            if (svga->render_mt != NULL)
+                svga_render_mt_flush(svga);
+
             if (!svga->override) {
                 if (svga->vertical_linedbl) {
                     wy = (svga->lastline - svga->firstline) << 1;
@@ -1666,7 +1712,8 @@ svga_poll(void *priv)
                     svga->vdisp = wy + 1;
                     svga_doblit(wx, wy, svga);
                 }
-            }
+            } else
+                svga->dirty_full = 1;
 
             svga->firstline = 2000;
             svga->lastline  = 0;
@@ -1861,12 +1908,19 @@ svga_init(const device_t *info, svga_t *svga, void *priv, int memsize,
 
     svga->map8            = svga->pallook;
 
+    svga->dirty_full = 1;
+
+    svga_render_simd_init();
+    svga_render_mt_init(svga, svga_render_threads);
+
     return 0;
 }
 
 void
 svga_close(svga_t *svga)
 {
+    svga_render_mt_close(svga);
+
     free(svga->changedvram);
     free(svga->vram);
 
@@ -2288,6 +2342,7 @@ svga_doblit(int wx, int wy, svga_t *svga)
         /* Screen res has changed.. fix up, and let them know. */
         svga->monitor->mon_xsize = xs_temp;
         svga->monitor->mon_ysize = ys_temp;
+        svga->dirty_full         = 1;
 
         if ((svga->monitor->mon_xsize > 1984) || (svga->monitor->mon_ysize > 2016)) {
             /* 2048x2048 is the biggest safe render texture, to account for overscan,
@@ -2324,7 +2379,28 @@ svga_doblit(int wx, int wy, svga_t *svga)
         }
     }
 
-    video_blit_memtoscreen_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add, svga->monitor_index);
+    /* Only pass on the rows that were redrawn, unless anything else changed. */
+    if (svga->dirty_full || (x_start != svga->dirty_blit.x) || (y_start != svga->dirty_blit.y) ||
+        ((svga->monitor->mon_xsize + x_add) != svga->dirty_blit.w) || ((svga->monitor->mon_ysize + y_add) != svga->dirty_blit.h) ||
+        (svga->overscan_color != svga->dirty_overscan_color) || (svga->dpms != svga->dirty_dpms))
+        video_blit_memtoscreen_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add, svga->monitor_index);
+    else {
+        for (i = 0; i < svga->dirty_nr; i++) {
+            svga->dirty[i].x = x_start;
+            svga->dirty[i].w = svga->monitor->mon_xsize + x_add;
+        }
+        video_blit_memtoscreen_dirty_monitor(x_start, y_start, svga->monitor->mon_xsize + x_add, svga->monitor->mon_ysize + y_add,
+                                             svga->dirty, svga->dirty_nr, svga->monitor_index);
+    }
+
+    svga->dirty_full           = 0;
+    svga->dirty_nr             = 0;
+    svga->dirty_blit.x         = x_start;
+    svga->dirty_blit.y         = y_start;
+    svga->dirty_blit.w         = svga->monitor->mon_xsize + x_add;
+    svga->dirty_blit.h         = svga->monitor->mon_ysize + y_add;
+    svga->dirty_overscan_color = svga->overscan_color;
+    svga->dirty_dpms           = svga->dpms;
 
     if (svga->vertical_linedbl)
         svga->vertical_linedbl >>= 1;
@@ -1653,7 +1653,12 @@ svga_render_15bpp_highres(svga_t *svga)
                 svga->firstline_draw = svga->displine;
             svga->lastline_draw = svga->displine;
 
-            if (!svga->remap_required) {
+            if (!svga->remap_required && (svga->conv_16to32 == svga_conv_16to32) &&
+                ((svga->hdisp + svga->scrollcache) >= 0)) {
+                x = (((svga->hdisp + svga->scrollcache) >> 3) + 1) << 3;
+                svga_render_line_16bpp(p, svga->vram, svga->memaddr, svga->vram_display_mask, x, 15);
+                svga->memaddr += x << 1;
+            } else if (!svga->remap_required) {
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
                     dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
                     *p++ = svga->conv_16to32(svga, dat & 0xffff, 15);
@@ -1893,7 +1898,12 @@ svga_render_16bpp_highres(svga_t *svga)
                 svga->firstline_draw = svga->displine;
             svga->lastline_draw = svga->displine;
 
-            if (!svga->remap_required) {
+            if (!svga->remap_required && (svga->conv_16to32 == svga_conv_16to32) &&
+                ((svga->hdisp + svga->scrollcache) >= 0)) {
+                x = (((svga->hdisp + svga->scrollcache) >> 3) + 1) << 3;
+                svga_render_line_16bpp(p, svga->vram, svga->memaddr, svga->vram_display_mask, x, 16);
+                svga->memaddr += x << 1;
+            } else if (!svga->remap_required) {
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x += 8) {
                     dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 1)) & svga->vram_display_mask]);
                     *p++ = svga->conv_16to32(svga, dat & 0xffff, 16);
@@ -2190,7 +2200,11 @@ svga_render_32bpp_highres(svga_t *svga)
                 svga->firstline_draw = svga->displine;
             svga->lastline_draw = svga->displine;
 
-            if (!svga->remap_required) {
+            if (!svga->remap_required && !svga->lut_map && ((svga->hdisp + svga->scrollcache) >= 0)) {
+                x = svga->hdisp + svga->scrollcache + 1;
+                svga_render_line_32bpp(p, svga->vram, svga->memaddr, svga->vram_display_mask, x);
+                svga->memaddr += (x * 4);
+            } else if (!svga->remap_required) {
                 for (x = 0; x <= (svga->hdisp + svga->scrollcache); x++) {
                     dat  = *(uint32_t *) (&svga->vram[(svga->memaddr + (x << 2)) & svga->vram_display_mask]);
                     *p++ = lookup_lut(dat & 0xffffff);
@@ -0,0 +1,352 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Deferred SVGA scanline rendering.
+ *
+ *          Lines drawn by the common high resolution renderers are not
+ *          converted on the emulation thread. Instead, the emulation
+ *          thread does the changedvram bookkeeping and records what the
+ *          renderer would have needed (address, palette, overscan), and
+ *          batches of such lines are converted by a pool of worker
+ *          threads. Every pending line is finished before the frame is
+ *          blitted.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/mem.h>
+#include <86box/timer.h>
+#include <86box/thread.h>
+#include <86box/video.h>
+#include <86box/vid_svga.h>
+#include <86box/vid_svga_render.h>
+
+#define SVGA_MT_BATCH_LINES 64
+#define SVGA_MT_MAX_THREADS 8
+
+enum {
+    SVGA_MT_8BPP = 0,
+    SVGA_MT_32BPP
+};
+
+typedef struct svga_mt_line_t {
+    uint32_t *line;
+    uint32_t  memaddr;
+    int       x_add;
+    int       count;
+    int       left;
+    int       right_start;
+    int       right;
+} svga_mt_line_t;
+
+typedef struct svga_mt_batch_t {
+    svga_mt_line_t lines[SVGA_MT_BATCH_LINES];
+    int            nr_lines;
+
+    /* State shared by all lines of the batch. */
+    int            type;
+    int            lut_map;
+    uint8_t       *vram;
+    uint32_t       vram_mask;
+    uint32_t       dac_mask;
+    uint32_t       overscan_color;
+    uint32_t       pal[256];
+} svga_mt_batch_t;
+
+typedef struct svga_mt_worker_t {
+    struct svga_render_mt_t *mt;
+    int                      index;
+    thread_t                *thread;
+    event_t                 *wake;
+    event_t                 *done;
+    svga_mt_batch_t *volatile batch;
+} svga_mt_worker_t;
+
+typedef struct svga_render_mt_t {
+    svga_mt_batch_t  batch[2];
+    int              cur;
+    int              busy[2];
+
+    int              nr_threads;
+    volatile int     quit;
+    svga_mt_worker_t worker[SVGA_MT_MAX_THREADS];
+} svga_render_mt_t;
+
+static void
+svga_render_mt_line_8bpp(const svga_mt_batch_t *batch, const svga_mt_line_t *line)
+{
+    uint32_t *p       = &line->line[line->x_add];
+    uint32_t  memaddr = line->memaddr;
+    uint32_t  dat;
+
+    for (int x = 0; x < line->count; x += 8) {
+        dat  = *(uint32_t *) (&batch->vram[memaddr & batch->vram_mask]);
+        p[0] = batch->pal[dat & batch->dac_mask & 0xff];
+        p[1] = batch->pal[(dat >> 8) & batch->dac_mask & 0xff];
+        p[2] = batch->pal[(dat >> 16) & batch->dac_mask & 0xff];
+        p[3] = batch->pal[(dat >> 24) & batch->dac_mask & 0xff];
+
+        dat  = *(uint32_t *) (&batch->vram[(memaddr + 4) & batch->vram_mask]);
+        p[4] = batch->pal[dat & batch->dac_mask & 0xff];
+        p[5] = batch->pal[(dat >> 8) & batch->dac_mask & 0xff];
+        p[6] = batch->pal[(dat >> 16) & batch->dac_mask & 0xff];
+        p[7] = batch->pal[(dat >> 24) & batch->dac_mask & 0xff];
+
+        memaddr += 8;
+        p += 8;
+    }
+}
+
+static void
+svga_render_mt_line_32bpp(const svga_mt_batch_t *batch, const svga_mt_line_t *line)
+{
+    uint32_t *p = &line->line[line->x_add];
+    uint32_t  dat;
+
+    if (!batch->lut_map) {
+        svga_render_line_32bpp(p, batch->vram, line->memaddr, batch->vram_mask, line->count);
+        return;
+    }
+
+    for (int x = 0; x < line->count; x++) {
+        dat  = *(uint32_t *) (&batch->vram[(line->memaddr + (x << 2)) & batch->vram_mask]) & 0xffffff;
+        p[x] = makecol32(getcolr(batch->pal[getcolr(dat)]), getcolg(batch->pal[getcolg(dat)]),
+                         getcolb(batch->pal[getcolb(dat)]));
+    }
+}
+
+static void
+svga_render_mt_batch(const svga_mt_batch_t *batch, int first, int step)
+{
+    for (int i = first; i < batch->nr_lines; i += step) {
+        const svga_mt_line_t *line = &batch->lines[i];
+
+        if (batch->type == SVGA_MT_8BPP)
+            svga_render_mt_line_8bpp(batch, line);
+        else
+            svga_render_mt_line_32bpp(batch, line);
+
+        /* Overscan goes last, as svga_do_render() draws it over the line. */
+        for (int x = 0; x < line->left; x++)
+            line->line[x] = batch->overscan_color;
+        for (int x = 0; x < line->right; x++)
+            line->line[line->right_start + x] = batch->overscan_color;
+    }
+}
+
+static void
+svga_render_mt_thread(void *priv)
+{
+    svga_mt_worker_t *worker = (svga_mt_worker_t *) priv;
+
+    while (1) {
+        thread_wait_event(worker->wake, -1);
+        thread_reset_event(worker->wake);
+
+        if (worker->mt->quit)
+            break;
+
+        svga_render_mt_batch(worker->batch, worker->index, worker->mt->nr_threads);
+
+        thread_set_event(worker->done);
+    }
+}
+
+static void
+svga_render_mt_wait(svga_render_mt_t *mt, int idx)
+{
+    if (!mt->busy[idx])
+        return;
+
+    for (int i = 0; i < mt->nr_threads; i++)
+        thread_wait_event(mt->worker[i].done, -1);
+
+    mt->busy[idx] = 0;
+}
+
+/* Hand the batch being filled to the workers, and start filling the other one. */
+static void
+svga_render_mt_submit(svga_render_mt_t *mt)
+{
+    svga_mt_batch_t *batch = &mt->batch[mt->cur];
+
+    if (batch->nr_lines == 0)
+        return;
+
+    /* The workers can only work on one batch at a time. */
+    svga_render_mt_wait(mt, mt->cur ^ 1);
+
+    for (int i = 0; i < mt->nr_threads; i++) {
+        mt->worker[i].batch = batch;
+        thread_reset_event(mt->worker[i].done);
+        thread_set_event(mt->worker[i].wake);
+    }
+    mt->busy[mt->cur] = 1;
+
+    mt->cur ^= 1;
+    mt->batch[mt->cur].nr_lines = 0;
+}
+
+void
+svga_render_mt_flush(svga_t *svga)
+{
+    svga_render_mt_t *mt = svga->render_mt;
+
+    svga_render_mt_submit(mt);
+    svga_render_mt_wait(mt, 0);
+    svga_render_mt_wait(mt, 1);
+}
+
+/*
+ * Called by svga_do_render() in place of the renderer. Returns 1 if the line
+ * was deferred, in which case the overscan is drawn by the workers as well,
+ * or 0 if the line has to be rendered right away.
+ */
+int
+svga_render_mt_line(svga_t *svga)
+{
+    svga_render_mt_t *mt = svga->render_mt;
+    svga_mt_batch_t  *batch;
+    svga_mt_line_t   *line;
+    uint32_t          changed_addr;
+    const uint32_t   *pal;
+    int               type;
+    int               y = svga->displine + svga->y_add;
+
+    if (svga->render == svga_render_8bpp_highres)
+        type = SVGA_MT_8BPP;
+    else if (svga->render == svga_render_32bpp_highres)
+        type = SVGA_MT_32BPP;
+    else
+        return 0;
+
+    /* Cursors and overlays are drawn over the line right after it is rendered. */
+    if (svga->force_old_addr || svga->remap_required || svga->hwcursor_on || svga->dac_hwcursor_on ||
+        svga->overlay_on || ((svga->hdisp + svga->scrollcache) < 0))
+        return 0;
+
+    if ((y < 0) || (svga->monitor->target_buffer == NULL) || (svga->monitor->target_buffer->line[y] == NULL))
+        return 0;
+
+    changed_addr = svga->remap_func(svga, svga->memaddr);
+    if (!svga->changedvram[changed_addr >> 12] && !svga->changedvram[(changed_addr >> 12) + 1] && !svga->fullchange)
+        return 0;
+
+    pal = (type == SVGA_MT_8BPP) ? svga->map8 : svga->pallook;
+
+    /* Start a new batch if the palette or other shared state changed. */
+    batch = &mt->batch[mt->cur];
+    if (batch->nr_lines &&
+        ((batch->type != type) || (batch->vram != svga->vram) || (batch->vram_mask != svga->vram_display_mask) ||
+         (batch->dac_mask != svga->dac_mask) || (batch->lut_map != svga->lut_map) ||
+         (batch->overscan_color != svga->overscan_color) ||
+         (((type == SVGA_MT_8BPP) || svga->lut_map) && memcmp(batch->pal, pal, sizeof(batch->pal))))) {
+        svga_render_mt_submit(mt);
+        batch = &mt->batch[mt->cur];
+    }
+
+    if (batch->nr_lines == 0) {
+        batch->type           = type;
+        batch->vram           = svga->vram;
+        batch->vram_mask      = svga->vram_display_mask;
+        batch->dac_mask       = svga->dac_mask;
+        batch->lut_map        = svga->lut_map;
+        batch->overscan_color = svga->overscan_color;
+        memcpy(batch->pal, pal, sizeof(batch->pal));
+    }
+
+    line          = &batch->lines[batch->nr_lines++];
+    line->line    = svga->monitor->target_buffer->line[y];
+    line->memaddr = svga->memaddr;
+    line->x_add   = svga->x_add;
+
+    if (svga->firstline_draw == 2000)
+        svga->firstline_draw = svga->displine;
+    svga->lastline_draw = svga->displine;
+
+    /* Advance the address the same way the renderers do. */
+    if (type == SVGA_MT_8BPP) {
+        line->count = ((svga->hdisp / 8) + 1) * 8;
+        svga->memaddr += line->count;
+    } else {
+        line->count = svga->hdisp + svga->scrollcache + 1;
+        svga->memaddr += line->count * 4;
+    }
+    svga->memaddr &= svga->vram_display_mask;
+
+    /* Same as svga_render_overscan_left() and svga_render_overscan_right(). */
+    line->left  = 0;
+    line->right = 0;
+    if (!svga->scrblank && (svga->hdisp > 0)) {
+        line->left        = (svga->left_overscan > 0) ? svga->left_overscan : 0;
+        line->right_start = svga->left_overscan + svga->hdisp;
+        line->right       = overscan_x - svga->left_overscan;
+    }
+
+    if (batch->nr_lines == SVGA_MT_BATCH_LINES)
+        svga_render_mt_submit(mt);
+
+    return 1;
+}
+
+void
+svga_render_mt_init(svga_t *svga, int threads)
+{
+    svga_render_mt_t *mt;
+
+    if (threads > SVGA_MT_MAX_THREADS)
+        threads = SVGA_MT_MAX_THREADS;
+    if (threads <= 0)
+        return;
+
+    mt             = (svga_render_mt_t *) calloc(1, sizeof(svga_render_mt_t));
+    mt->nr_threads = threads;
+
+    for (int i = 0; i < threads; i++) {
+        mt->worker[i].mt     = mt;
+        mt->worker[i].index  = i;
+        mt->worker[i].wake   = thread_create_event();
+        mt->worker[i].done   = thread_create_event();
+        mt->worker[i].thread = thread_create(svga_render_mt_thread, &mt->worker[i]);
+    }
+
+    svga->render_mt = mt;
+}
+
+void
+svga_render_mt_close(svga_t *svga)
+{
+    svga_render_mt_t *mt = svga->render_mt;
+
+    if (mt == NULL)
+        return;
+
+    svga_render_mt_flush(svga);
+
+    mt->quit = 1;
+    for (int i = 0; i < mt->nr_threads; i++) {
+        thread_set_event(mt->worker[i].wake);
+        thread_wait(mt->worker[i].thread);
+        thread_destroy_event(mt->worker[i].wake);
+        thread_destroy_event(mt->worker[i].done);
+    }
+
+    free(mt);
+    svga->render_mt = NULL;
+}
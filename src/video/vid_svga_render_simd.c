@@ -0,0 +1,309 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Vectorized pixel converters for the SVGA renderers.
+ *
+ *          The implementation is picked once at run time: AVX2 if the
+ *          host supports it, otherwise SSE2 on x86-64 and NEON on ARM64,
+ *          both of which are always present there, with a scalar
+ *          fallback for everything else. The 15/16bpp converters compute
+ *          the same values as the video_15to32 and video_16to32 tables.
+ *
+ *
+ *
+ * Authors: 86Box contributors.
+ *
+ *          Copyright 2026 86Box contributors.
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <wchar.h>
+#if defined(__x86_64__) || defined(__amd64__) || defined(_M_X64)
+#    define SVGA_SIMD_X86
+#    include <immintrin.h>
+#    if defined(__GNUC__) || defined(__clang__)
+#        define SVGA_SIMD_AVX2
+#    endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#    define SVGA_SIMD_NEON
+#    include <arm_neon.h>
+#endif
+#include <86box/86box.h>
+#include <86box/device.h>
+#include <86box/mem.h>
+#include <86box/timer.h>
+#include <86box/video.h>
+#include <86box/vid_svga.h>
+#include <86box/vid_svga_render.h>
+
+/*
+ * Expanding a 5-bit channel to 8 bits with (c * 255) / 31 is exact with
+ * (c * 2106) >> 8 over the whole input range. There is no such multiplier
+ * for (c * 255) / 63 that fits in 16 bits, so 6-bit channels are expanded
+ * as (c << 2) + (c / 21), with c / 21 being (c * 49) >> 10.
+ */
+#define EXPAND5_MUL   2106
+#define EXPAND6_DIV21 49
+
+static void svga_conv_32bpp_scalar(uint32_t *p, const uint8_t *src, int count);
+static void svga_conv_16bpp_scalar(uint32_t *p, const uint8_t *src, int count, int bpp);
+
+static void (*conv_32bpp)(uint32_t *p, const uint8_t *src, int count)          = svga_conv_32bpp_scalar;
+static void (*conv_16bpp)(uint32_t *p, const uint8_t *src, int count, int bpp) = svga_conv_16bpp_scalar;
+
+static const char *svga_simd_name = "scalar";
+
+static void
+svga_conv_32bpp_scalar(uint32_t *p, const uint8_t *src, int count)
+{
+    for (int x = 0; x < count; x++)
+        p[x] = *(const uint32_t *) &src[x << 2] & 0xffffff;
+}
+
+static void
+svga_conv_16bpp_scalar(uint32_t *p, const uint8_t *src, int count, int bpp)
+{
+    const uint32_t *lut = (bpp == 15) ? video_15to32 : video_16to32;
+
+    for (int x = 0; x < count; x++)
+        p[x] = lut[*(const uint16_t *) &src[x << 1]];
+}
+
+#ifdef SVGA_SIMD_X86
+static void
+svga_conv_32bpp_sse2(uint32_t *p, const uint8_t *src, int count)
+{
+    const __m128i mask = _mm_set1_epi32(0x00ffffff);
+    int           x    = 0;
+
+    for (; (x + 4) <= count; x += 4)
+        _mm_storeu_si128((__m128i *) &p[x], _mm_and_si128(_mm_loadu_si128((const __m128i *) &src[x << 2]), mask));
+
+    svga_conv_32bpp_scalar(&p[x], &src[x << 2], count - x);
+}
+
+static void
+svga_conv_16bpp_sse2(uint32_t *p, const uint8_t *src, int count, int bpp)
+{
+    const __m128i m5    = _mm_set1_epi16(0x1f);
+    const __m128i alpha = _mm_set1_epi16((short) 0xff00);
+    const __m128i m6    = _mm_set1_epi16(0x3f);
+    const __m128i mul5  = _mm_set1_epi16(EXPAND5_MUL);
+    const __m128i div21 = _mm_set1_epi16(EXPAND6_DIV21);
+    int           x     = 0;
+
+    for (; (x + 8) <= count; x += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i *) &src[x << 1]);
+        __m128i b = _mm_and_si128(v, m5);
+        __m128i g;
+        __m128i r;
+
+        if (bpp == 15) {
+            g = _mm_and_si128(_mm_srli_epi16(v, 5), m5);
+            g = _mm_srli_epi16(_mm_mullo_epi16(g, mul5), 8);
+            r = _mm_and_si128(_mm_srli_epi16(v, 10), m5);
+        } else {
+            g = _mm_and_si128(_mm_srli_epi16(v, 5), m6);
+            g = _mm_add_epi16(_mm_slli_epi16(g, 2), _mm_srli_epi16(_mm_mullo_epi16(g, div21), 10));
+            r = _mm_srli_epi16(v, 11);
+        }
+
+        b = _mm_srli_epi16(_mm_mullo_epi16(b, mul5), 8);
+        r = _mm_srli_epi16(_mm_mullo_epi16(r, mul5), 8);
+
+        __m128i lo = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+        __m128i hi = _mm_or_si128(r, alpha);
+
+        _mm_storeu_si128((__m128i *) &p[x], _mm_unpacklo_epi16(lo, hi));
+        _mm_storeu_si128((__m128i *) &p[x + 4], _mm_unpackhi_epi16(lo, hi));
+    }
+
+    svga_conv_16bpp_scalar(&p[x], &src[x << 1], count - x, bpp);
+}
+#endif
+
+#ifdef SVGA_SIMD_AVX2
+__attribute__((target("avx2"))) static void
+svga_conv_32bpp_avx2(uint32_t *p, const uint8_t *src, int count)
+{
+    const __m256i mask = _mm256_set1_epi32(0x00ffffff);
+    int           x    = 0;
+
+    for (; (x + 8) <= count; x += 8)
+        _mm256_storeu_si256((__m256i *) &p[x], _mm256_and_si256(_mm256_loadu_si256((const __m256i *) &src[x << 2]), mask));
+
+    svga_conv_32bpp_sse2(&p[x], &src[x << 2], count - x);
+}
+
+__attribute__((target("avx2"))) static void
+svga_conv_16bpp_avx2(uint32_t *p, const uint8_t *src, int count, int bpp)
+{
+    const __m256i m5    = _mm256_set1_epi16(0x1f);
+    const __m256i alpha = _mm256_set1_epi16((short) 0xff00);
+    const __m256i m6    = _mm256_set1_epi16(0x3f);
+    const __m256i mul5  = _mm256_set1_epi16(EXPAND5_MUL);
+    const __m256i div21 = _mm256_set1_epi16(EXPAND6_DIV21);
+    int           x     = 0;
+
+    for (; (x + 16) <= count; x += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) &src[x << 1]);
+        __m256i b = _mm256_and_si256(v, m5);
+        __m256i g;
+        __m256i r;
+
+        if (bpp == 15) {
+            g = _mm256_and_si256(_mm256_srli_epi16(v, 5), m5);
+            g = _mm256_srli_epi16(_mm256_mullo_epi16(g, mul5), 8);
+            r = _mm256_and_si256(_mm256_srli_epi16(v, 10), m5);
+        } else {
+            g = _mm256_and_si256(_mm256_srli_epi16(v, 5), m6);
+            g = _mm256_add_epi16(_mm256_slli_epi16(g, 2), _mm256_srli_epi16(_mm256_mullo_epi16(g, div21), 10));
+            r = _mm256_srli_epi16(v, 11);
+        }
+
+        b = _mm256_srli_epi16(_mm256_mullo_epi16(b, mul5), 8);
+        r = _mm256_srli_epi16(_mm256_mullo_epi16(r, mul5), 8);
+
+        __m256i lo = _mm256_or_si256(b, _mm256_slli_epi16(g, 8));
+        __m256i hi = _mm256_or_si256(r, alpha);
+
+        /* The unpacks work within 128-bit lanes, so put the halves back in order. */
+        __m256i p0 = _mm256_unpacklo_epi16(lo, hi);
+        __m256i p1 = _mm256_unpackhi_epi16(lo, hi);
+
+        _mm256_storeu_si256((__m256i *) &p[x], _mm256_permute2x128_si256(p0, p1, 0x20));
+        _mm256_storeu_si256((__m256i *) &p[x + 8], _mm256_permute2x128_si256(p0, p1, 0x31));
+    }
+
+    svga_conv_16bpp_sse2(&p[x], &src[x << 1], count - x, bpp);
+}
+#endif
+
+#ifdef SVGA_SIMD_NEON
+static void
+svga_conv_32bpp_neon(uint32_t *p, const uint8_t *src, int count)
+{
+    const uint32x4_t mask = vdupq_n_u32(0x00ffffff);
+    int              x    = 0;
+
+    for (; (x + 4) <= count; x += 4)
+        vst1q_u32(&p[x], vandq_u32(vld1q_u32((const uint32_t *) &src[x << 2]), mask));
+
+    svga_conv_32bpp_scalar(&p[x], &src[x << 2], count - x);
+}
+
+static void
+svga_conv_16bpp_neon(uint32_t *p, const uint8_t *src, int count, int bpp)
+{
+    const uint16x8_t m5    = vdupq_n_u16(0x1f);
+    const uint16x8_t alpha = vdupq_n_u16(0xff00);
+    const uint16x8_t m6    = vdupq_n_u16(0x3f);
+    int              x     = 0;
+
+    for (; (x + 8) <= count; x += 8) {
+        uint16x8_t v = vld1q_u16((const uint16_t *) &src[x << 1]);
+        uint16x8_t b = vandq_u16(v, m5);
+        uint16x8_t g;
+        uint16x8_t r;
+
+        if (bpp == 15) {
+            g = vandq_u16(vshrq_n_u16(v, 5), m5);
+            g = vshrq_n_u16(vmulq_n_u16(g, EXPAND5_MUL), 8);
+            r = vandq_u16(vshrq_n_u16(v, 10), m5);
+        } else {
+            g = vandq_u16(vshrq_n_u16(v, 5), m6);
+            g = vaddq_u16(vshlq_n_u16(g, 2), vshrq_n_u16(vmulq_n_u16(g, EXPAND6_DIV21), 10));
+            r = vshrq_n_u16(v, 11);
+        }
+
+        b = vshrq_n_u16(vmulq_n_u16(b, EXPAND5_MUL), 8);
+        r = vshrq_n_u16(vmulq_n_u16(r, EXPAND5_MUL), 8);
+
+        uint16x8x2_t z = vzipq_u16(vorrq_u16(b, vshlq_n_u16(g, 8)), vorrq_u16(r, alpha));
+
+        vst1q_u32(&p[x], vreinterpretq_u32_u16(z.val[0]));
+        vst1q_u32(&p[x + 4], vreinterpretq_u32_u16(z.val[1]));
+    }
+
+    svga_conv_16bpp_scalar(&p[x], &src[x << 1], count - x, bpp);
+}
+#endif
+
+void
+svga_render_simd_init(void)
+{
+    static int inited = 0;
+
+    if (inited)
+        return;
+    inited = 1;
+
+#if defined(SVGA_SIMD_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        conv_32bpp     = svga_conv_32bpp_avx2;
+        conv_16bpp     = svga_conv_16bpp_avx2;
+        svga_simd_name = "AVX2";
+    } else
+#endif
+    {
+#if defined(SVGA_SIMD_X86)
+        conv_32bpp     = svga_conv_32bpp_sse2;
+        conv_16bpp     = svga_conv_16bpp_sse2;
+        svga_simd_name = "SSE2";
+#elif defined(SVGA_SIMD_NEON)
+        conv_32bpp     = svga_conv_32bpp_neon;
+        conv_16bpp     = svga_conv_16bpp_neon;
+        svga_simd_name = "NEON";
+#endif
+    }
+
+    pclog("SVGA: Using %s pixel converters\n", svga_simd_name);
+}
+
+/*
+ * Convert count 32bpp pixels starting at VRAM address addr, ignoring the
+ * top byte. Lines that wrap around the display mask take the scalar path.
+ */
+void
+svga_render_line_32bpp(uint32_t *p, const uint8_t *vram, uint32_t addr, uint32_t mask, int count)
+{
+    addr &= mask;
+
+    if (((uint64_t) addr + ((uint64_t) count << 2)) <= ((uint64_t) mask + 1)) {
+        conv_32bpp(p, &vram[addr], count);
+        return;
+    }
+
+    for (int x = 0; x < count; x++)
+        p[x] = *(const uint32_t *) &vram[(addr + (x << 2)) & mask] & 0xffffff;
+}
+
+/* Same for 15bpp (bpp = 15) or 16bpp pixels, as converted by svga_conv_16to32().
+   count has to be even. */
+void
+svga_render_line_16bpp(uint32_t *p, const uint8_t *vram, uint32_t addr, uint32_t mask, int count, int bpp)
+{
+    const uint32_t *lut = (bpp == 15) ? video_15to32 : video_16to32;
+
+    addr &= mask;
+
+    if (((uint64_t) addr + ((uint64_t) count << 1)) <= ((uint64_t) mask + 1)) {
+        conv_16bpp(p, &vram[addr], count, bpp);
+        return;
+    }
+
+    for (int x = 0; x < count; x += 2) {
+        uint32_t dat = *(const uint32_t *) &vram[(addr + (x << 1)) & mask];
+
+        p[x]     = lut[dat & 0xffff];
+        p[x + 1] = lut[dat >> 16];
+    }
+}
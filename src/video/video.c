@@ -42,6 +42,7 @@
 #include <86box/thread.h>
 #include <86box/video.h>
 #include <86box/vid_svga.h>
+#include <86box/fbshm.h>
 
 #include <minitrace/minitrace.h>
 
@@ -203,6 +204,7 @@ const uint32_t shade[5][256] = {
 
 typedef struct blit_data_struct {
     int x, y, w, h;
+    int nr_dirty;
     int busy;
     int buffer_in_use;
     int thread_run;
@@ -212,6 +214,8 @@ typedef struct blit_data_struct {
     event_t  *wake_blit_thread;
     event_t  *blit_complete;
     event_t  *buffer_not_in_use;
+
+    video_rect_t dirty[VIDEO_MAX_DIRTY_RECTS];
 } blit_data_t;
 
 static uint32_t cga_2_table[16];
@@ -417,6 +421,9 @@ blit_thread(void *param)
         thread_reset_event(data->wake_blit_thread);
         MTR_BEGIN("video", "blit_thread");
 
+        /* The export has to copy the frame before the UI releases the buffer. */
+        fbshm_blit(data->x, data->y, data->w, data->h, data->monitor_index);
+
         if (blit_func)
             blit_func(data->x, data->y, data->w, data->h, data->monitor_index);
 
@@ -427,9 +434,17 @@ blit_thread(void *param)
     }
 }
 
+/*
+ * Blit a frame, of which only the given rectangles of the target buffer
+ * changed since the previous one. The rectangles are clipped to the blitted
+ * area; if rects is NULL, the whole area is considered changed.
+ */
 void
-video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
+video_blit_memtoscreen_dirty_monitor(int x, int y, int w, int h, const video_rect_t *rects, int nr_rects, int monitor_index)
 {
+    blit_data_t  *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+    video_rect_t *r;
+
     MTR_BEGIN("video", "video_blit_memtoscreen");
 
     if ((w <= 0) || (h <= 0))
@@ -437,18 +452,65 @@ video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
 
     video_wait_for_blit_monitor(monitor_index);
 
-    monitors[monitor_index].mon_blit_data_ptr->busy          = 1;
-    monitors[monitor_index].mon_blit_data_ptr->buffer_in_use = 1;
-    monitors[monitor_index].mon_blit_data_ptr->x             = x;
-    monitors[monitor_index].mon_blit_data_ptr->y             = y;
-    monitors[monitor_index].mon_blit_data_ptr->w             = w;
-    monitors[monitor_index].mon_blit_data_ptr->h             = h;
+    blit_data_ptr->busy          = 1;
+    blit_data_ptr->buffer_in_use = 1;
+    blit_data_ptr->x             = x;
+    blit_data_ptr->y             = y;
+    blit_data_ptr->w             = w;
+    blit_data_ptr->h             = h;
+
+    if ((rects == NULL) || (nr_rects > VIDEO_MAX_DIRTY_RECTS)) {
+        blit_data_ptr->dirty[0].x = x;
+        blit_data_ptr->dirty[0].y = y;
+        blit_data_ptr->dirty[0].w = w;
+        blit_data_ptr->dirty[0].h = h;
+        blit_data_ptr->nr_dirty   = 1;
+    } else {
+        blit_data_ptr->nr_dirty = 0;
+        for (int i = 0; i < nr_rects; i++) {
+            int x1 = MAX(rects[i].x, x);
+            int y1 = MAX(rects[i].y, y);
+            int x2 = MIN(rects[i].x + rects[i].w, x + w);
+            int y2 = MIN(rects[i].y + rects[i].h, y + h);
+
+            if ((x2 <= x1) || (y2 <= y1))
+                continue;
+
+            r    = &blit_data_ptr->dirty[blit_data_ptr->nr_dirty++];
+            r->x = x1;
+            r->y = y1;
+            r->w = x2 - x1;
+            r->h = y2 - y1;
+        }
+    }
+
     monitors[monitor_index].mon_renderedframes++;
 
-    thread_set_event(monitors[monitor_index].mon_blit_data_ptr->wake_blit_thread);
+    thread_set_event(blit_data_ptr->wake_blit_thread);
     MTR_END("video", "video_blit_memtoscreen");
 }
 
+void
+video_blit_memtoscreen_monitor(int x, int y, int w, int h, int monitor_index)
+{
+    video_blit_memtoscreen_dirty_monitor(x, y, w, h, NULL, 0, monitor_index);
+}
+
+/*
+ * Called by the blit function to find out which parts of the area it was
+ * given changed since the previous frame. Returns the number of rectangles,
+ * which is 0 if nothing changed. Consumers that did not see the previous
+ * frame have to update the whole area regardless.
+ */
+int
+video_blit_get_dirty_monitor(int monitor_index, const video_rect_t **rects)
+{
+    blit_data_t *blit_data_ptr = monitors[monitor_index].mon_blit_data_ptr;
+
+    *rects = blit_data_ptr->dirty;
+    return blit_data_ptr->nr_dirty;
+}
+
 uint8_t
 pixels8(uint32_t *pixels)
 {
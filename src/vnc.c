@@ -44,6 +44,8 @@ static int              allowedY;
 static int              ptr_x;
 static int              ptr_y;
 static int              ptr_but;
+static int              full_update = 1;
+static video_rect_t     last_blit;
 
 #ifdef ENABLE_VNC_LOG
 int vnc_do_log = ENABLE_VNC_LOG;
@@ -175,21 +177,54 @@ vnc_display(rfbClientPtr cl)
 static void
 vnc_blit(int x, int y, int w, int h, int monitor_index)
 {
+    const video_rect_t *rects;
+    video_rect_t        whole = { x, y, w, h };
+    int                 nr_rects;
+
     if (monitor_index || (x < 0) || (y < 0) || (w < VNC_MIN_X) || (h < VNC_MIN_Y) || (w > VNC_MAX_X) || (h > VNC_MAX_Y) || (buffer32 == NULL)) {
+        full_update = 1;
         video_blit_complete_monitor(monitor_index);
         return;
     }
 
-    for (int row = 0; row < h; ++row)
-        video_copy(&(((uint8_t *) rfb->frameBuffer)[row * 2048 * sizeof(uint32_t)]), &(buffer32->line[y + row][x]), w * sizeof(uint32_t));
+    /*
+     * Only copy and send what changed since the last frame, which is all of
+     * it if the frame moved, or the clients were not told about some of the
+     * earlier changes.
+     */
+    if (full_update || updatingSize || (x != last_blit.x) || (y != last_blit.y) || (w != last_blit.w) || (h != last_blit.h)) {
+        rects    = &whole;
+        nr_rects = 1;
+    } else
+        nr_rects = video_blit_get_dirty_monitor(monitor_index, &rects);
+
+    for (int i = 0; i < nr_rects; i++) {
+        for (int row = rects[i].y; row < (rects[i].y + rects[i].h); ++row)
+            video_copy(&(((uint32_t *) rfb->frameBuffer)[((row - y) * 2048) + (rects[i].x - x)]), &(buffer32->line[row][rects[i].x]), rects[i].w * sizeof(uint32_t));
+    }
 
     if (screenshots)
         video_screenshot((uint32_t *) rfb->frameBuffer, 0, 0, VNC_MAX_X);
 
     video_blit_complete_monitor(monitor_index);
 
-    if (!updatingSize)
-        rfbMarkRectAsModified(rfb, 0, 0, allowedX, allowedY);
+    last_blit = whole;
+
+    if (updatingSize) {
+        full_update = 1;
+        return;
+    }
+
+    full_update = 0;
+    for (int i = 0; i < nr_rects; i++) {
+        int x1 = rects[i].x - x;
+        int y1 = rects[i].y - y;
+        int x2 = MIN(x1 + rects[i].w, allowedX);
+        int y2 = MIN(y1 + rects[i].h, allowedY);
+
+        if ((x2 > x1) && (y2 > y1))
+            rfbMarkRectAsModified(rfb, x1, y1, x2, y2);
+    }
 }
 
 /* Initialize VNC for operation. */
@@ -240,6 +275,7 @@ vnc_init(UNUSED(void *arg))
     }
 
     /* Set up our BLIT handlers. */
+    full_update = 1;
     video_setblit(vnc_blit);
 
     clients = 0;
@@ -287,6 +323,8 @@ vnc_resize(int x, int y)
         rfb->width  = x;
         rfb->height = y;
 
+        full_update = 1;
+
         iterator = rfbGetClientIterator(rfb);
         while ((cl = rfbClientIteratorNext(iterator)) != NULL) {
             LOCK(cl->updateMutex);